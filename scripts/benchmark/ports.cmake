@@ -0,0 +1,57 @@
+# A stand-in for scripts/ports.cmake that builds nothing, used to measure vcpkg's own overhead.
+#
+# Each port's portfile.cmake calls vcpkg_mock_port(), which writes the given number of files of the given size, in
+# bytes, into the package and sleeps for the given time, in milliseconds, in place of configuring and compiling. See
+# run.cmake.
+cmake_minimum_required(VERSION 3.5)
+
+if(NOT CMD STREQUAL "BUILD")
+    message(FATAL_ERROR "The mock ports.cmake only supports CMD=BUILD, not '${CMD}'")
+endif()
+
+function(vcpkg_mock_port)
+    cmake_parse_arguments(_vmp "" "FILE_COUNT;FILE_SIZE;SLEEP_MS" "" ${ARGN})
+
+    # Double a line until it reaches the size, as string(REPEAT) needs CMake 3.15
+    set(_vmp_line "0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcde\n")
+    set(_vmp_contents "")
+    while(_vmp_FILE_SIZE GREATER 0)
+        string(LENGTH "${_vmp_line}" _vmp_line_length)
+        if(_vmp_line_length GREATER _vmp_FILE_SIZE)
+            string(SUBSTRING "${_vmp_line}" 0 ${_vmp_FILE_SIZE} _vmp_line)
+            set(_vmp_line_length ${_vmp_FILE_SIZE})
+        endif()
+        string(APPEND _vmp_contents "${_vmp_line}")
+        math(EXPR _vmp_FILE_SIZE "${_vmp_FILE_SIZE} - ${_vmp_line_length}")
+        string(APPEND _vmp_line "${_vmp_line}")
+    endwhile()
+
+    if(_vmp_FILE_COUNT GREATER 0)
+        math(EXPR _vmp_last "${_vmp_FILE_COUNT} - 1")
+        foreach(_vmp_i RANGE ${_vmp_last})
+            file(WRITE "${CURRENT_PACKAGES_DIR}/include/${PORT}/file${_vmp_i}.h" "${_vmp_contents}")
+        endforeach()
+    endif()
+    file(WRITE "${CURRENT_PACKAGES_DIR}/share/${PORT}/copyright" "Generated by the vcpkg benchmark.\n")
+
+    if(_vmp_SLEEP_MS GREATER 0)
+        math(EXPR _vmp_seconds "${_vmp_SLEEP_MS} / 1000")
+        math(EXPR _vmp_milliseconds "${_vmp_SLEEP_MS} % 1000 + 1000")
+        string(SUBSTRING "${_vmp_milliseconds}" 1 3 _vmp_milliseconds)
+        execute_process(COMMAND "${CMAKE_COMMAND}" -E sleep "${_vmp_seconds}.${_vmp_milliseconds}")
+    endif()
+endfunction()
+
+# Mock ports download nothing
+if(VCPKG_DOWNLOAD_MODE)
+    return()
+endif()
+
+file(REMOVE_RECURSE "${CURRENT_PACKAGES_DIR}")
+file(MAKE_DIRECTORY "${CURRENT_BUILDTREES_DIR}" "${CURRENT_PACKAGES_DIR}")
+
+include("${TARGET_TRIPLET_FILE}")
+include("${CURRENT_PORT_DIR}/portfile.cmake")
+
+file(WRITE "${CURRENT_PACKAGES_DIR}/BUILD_INFO" "CRTLinkage: ${VCPKG_CRT_LINKAGE}\n")
+file(APPEND "${CURRENT_PACKAGES_DIR}/BUILD_INFO" "LibraryLinkage: ${VCPKG_LIBRARY_LINKAGE}\n")
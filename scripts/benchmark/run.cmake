@@ -0,0 +1,123 @@
+# Measures vcpkg's own overhead when installing many ports, apart from the time spent building them.
+#
+# Generates PORT_COUNT mock ports into a fresh vcpkg root, each depending on two ports before it and building with
+# the mock ports.cmake next to this script, then runs `vcpkg install` (or `vcpkg ci`) over all of them with
+# --x-phase-timings and reports where the time went.
+#
+#   cmake -DVCPKG=<path to vcpkg> [-DCOMMAND=install|ci] [-DPORT_COUNT=1000] [-DFILE_COUNT=10] [-DFILE_SIZE=1024]
+#         [-DSLEEP_MS=0] [-DTRIPLET=<triplet>] [-DWORK_DIR=<dir>] [-DEXTRA_ARGS=<args>] -P scripts/benchmark/run.cmake
+#
+# FILE_COUNT and FILE_SIZE, in bytes, give the files each port installs, and SLEEP_MS how long each pretends to
+# compile. WORK_DIR, by default vcpkg-benchmark in the current directory, is deleted first. Set VCPKG_DOWNLOADS to
+# share the tools vcpkg needs with another root.
+cmake_minimum_required(VERSION 3.5)
+
+if(NOT DEFINED VCPKG)
+    message(FATAL_ERROR "Pass the vcpkg executable to benchmark as -DVCPKG=<path>")
+endif()
+foreach(_setting COMMAND=install PORT_COUNT=1000 FILE_COUNT=10 FILE_SIZE=1024 SLEEP_MS=0)
+    string(REPLACE "=" ";" _setting "${_setting}")
+    list(GET _setting 0 _name)
+    list(GET _setting 1 _default)
+    if(NOT DEFINED ${_name})
+        set(${_name} ${_default})
+    endif()
+endforeach()
+if(NOT DEFINED WORK_DIR)
+    set(WORK_DIR "${CMAKE_BINARY_DIR}/vcpkg-benchmark")
+endif()
+if(NOT DEFINED TRIPLET)
+    if(CMAKE_HOST_WIN32)
+        set(TRIPLET x64-windows)
+    elseif(CMAKE_HOST_APPLE)
+        set(TRIPLET x64-osx)
+    else()
+        set(TRIPLET x64-linux)
+    endif()
+endif()
+if(NOT "${COMMAND}" MATCHES "^(install|ci)$")
+    message(FATAL_ERROR "COMMAND must be install or ci, not '${COMMAND}'")
+endif()
+if(FILE_COUNT LESS 1)
+    message(FATAL_ERROR "FILE_COUNT must be at least 1, as post-build checks reject empty include directories")
+endif()
+
+get_filename_component(_vcpkg_root "${CMAKE_CURRENT_LIST_DIR}/../.." ABSOLUTE)
+set(_root "${WORK_DIR}/root")
+
+message(STATUS "Generating ${PORT_COUNT} mock ports in ${_root}")
+file(REMOVE_RECURSE "${WORK_DIR}")
+file(WRITE "${_root}/.vcpkg-root" "")
+file(MAKE_DIRECTORY "${_root}/buildtrees")
+file(COPY "${_vcpkg_root}/triplets" "${_vcpkg_root}/scripts" DESTINATION "${_root}")
+configure_file("${CMAKE_CURRENT_LIST_DIR}/ports.cmake" "${_root}/scripts/ports.cmake" COPYONLY)
+
+# Port i depends on ports i/2 and i/3, so the graph is deep and the ports nothing depends on are the last half
+set(_leaves "")
+math(EXPR _last "${PORT_COUNT} - 1")
+foreach(_i RANGE ${_last})
+    set(_depends "")
+    if(_i GREATER 0)
+        math(EXPR _half "${_i} / 2")
+        math(EXPR _third "${_i} / 3")
+        set(_depends "mock-${_half}")
+        if(NOT _third EQUAL _half)
+            string(APPEND _depends ", mock-${_third}")
+        endif()
+    endif()
+    math(EXPR _double "${_i} * 2")
+    if(NOT _double LESS PORT_COUNT)
+        list(APPEND _leaves "mock-${_i}")
+    endif()
+
+    file(WRITE "${_root}/ports/mock-${_i}/CONTROL"
+        "Source: mock-${_i}\nVersion: 1\nDescription: A mock port\nBuild-Depends: ${_depends}\n")
+    file(WRITE "${_root}/ports/mock-${_i}/portfile.cmake"
+        "vcpkg_mock_port(FILE_COUNT ${FILE_COUNT} FILE_SIZE ${FILE_SIZE} SLEEP_MS ${SLEEP_MS})\n")
+endforeach()
+
+if("${COMMAND}" STREQUAL "install")
+    set(_command_args install ${_leaves})
+else()
+    set(_command_args ci ${TRIPLET})
+endif()
+
+message(STATUS "Running vcpkg ${COMMAND} over ${PORT_COUNT} ports for ${TRIPLET}")
+execute_process(
+    COMMAND "${VCPKG}" --vcpkg-root "${_root}" --triplet ${TRIPLET} --x-phase-timings ${EXTRA_ARGS} ${_command_args}
+    OUTPUT_FILE "${WORK_DIR}/vcpkg.log"
+    ERROR_FILE "${WORK_DIR}/vcpkg.log"
+    RESULT_VARIABLE _result
+)
+if(NOT _result EQUAL 0)
+    message(FATAL_ERROR "vcpkg ${COMMAND} failed with ${_result}; see ${WORK_DIR}/vcpkg.log")
+endif()
+
+# Each line of the summary reads "    <phase>: <milliseconds> ms[ in <count> calls]"
+file(STRINGS "${WORK_DIR}/vcpkg.log" _lines REGEX "^    [A-Za-z ]+: [0-9.-]+ ms")
+if(NOT _lines)
+    message(FATAL_ERROR "vcpkg printed no phase timings; see ${WORK_DIR}/vcpkg.log")
+endif()
+
+math(EXPR _sleep_total_ms "${SLEEP_MS} * ${PORT_COUNT}")
+set(_report "vcpkg ${COMMAND} over ${PORT_COUNT} ports, each installing ${FILE_COUNT} files of ${FILE_SIZE} bytes")
+string(APPEND _report " after ${SLEEP_MS} ms of pretending to build:\n")
+foreach(_line IN LISTS _lines)
+    string(REGEX MATCH "^    ([A-Za-z ]+): (-?[0-9]+)[.0-9]* ms( in ([0-9]+) calls)?" _ "${_line}")
+    set(_phase "${CMAKE_MATCH_1}")
+    set(_ms "${CMAKE_MATCH_2}")
+    math(EXPR _per_port_us "${_ms} * 1000 / ${PORT_COUNT}")
+    string(APPEND _report "    ${_phase}: ${_ms} ms, ${_per_port_us} us per port")
+    if(CMAKE_MATCH_4)
+        string(APPEND _report ", in ${CMAKE_MATCH_4} calls")
+    endif()
+    string(APPEND _report "\n")
+
+    # Both include the pretend builds, which are not vcpkg's overhead
+    if(SLEEP_MS GREATER 0 AND (_phase STREQUAL "child processes" OR _phase STREQUAL "total"))
+        math(EXPR _overhead_ms "${_ms} - ${_sleep_total_ms}")
+        math(EXPR _per_port_us "${_overhead_ms} * 1000 / ${PORT_COUNT}")
+        string(APPEND _report "        less building: ${_overhead_ms} ms, ${_per_port_us} us per port\n")
+    endif()
+endforeach()
+message("${_report}")
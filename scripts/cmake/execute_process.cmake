@@ -8,7 +8,11 @@
 if (NOT DEFINED OVERRIDEN_EXECUTE_PROCESS)
   set(OVERRIDEN_EXECUTE_PROCESS ON)
 
-  if (DEFINED VCPKG_DOWNLOAD_MODE)
+  if (DEFINED _VCPKG_DISTFILES_MANIFEST)
+    macro(execute_process)
+      _vcpkg_halt_distfile_capture()
+    endmacro()
+  elseif (DEFINED VCPKG_DOWNLOAD_MODE)
     macro(execute_process)
       message(FATAL_ERROR "This command cannot be executed in Download Mode.\nHalting portfile execution.\n")
     endmacro()
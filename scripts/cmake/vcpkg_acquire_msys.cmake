@@ -78,6 +78,10 @@ function(vcpkg_acquire_msys PATH_TO_ROOT_OUT)
         FILENAME ${ARCHIVE}
         SHA512 ${HASH}
     )
+    # The archive has only been recorded, not downloaded
+    if(DEFINED _VCPKG_DISTFILES_MANIFEST)
+      _vcpkg_halt_distfile_capture()
+    endif()
 
     file(REMOVE_RECURSE ${TOOLPATH}/${TOOLSUBPATH})
     file(MAKE_DIRECTORY ${TOOLPATH})
@@ -41,6 +41,10 @@ function(vcpkg_build_cmake)
 
     if(_VCPKG_CMAKE_GENERATOR MATCHES "Ninja")
         set(BUILD_ARGS "-v") # verbose output
+        # Ninja 1.13 and later take jobs from the jobserver vcpkg shares between builds, but only without -j
+        if(NOT "$ENV{MAKEFLAGS}" MATCHES "--jobserver-(auth|fds)=")
+            set(PARALLEL_ARG "-j${VCPKG_CONCURRENCY}")
+        endif()
         set(NO_PARALLEL_ARG "-j1")
     elseif(_VCPKG_CMAKE_GENERATOR MATCHES "Visual Studio")
         set(BUILD_ARGS
@@ -61,8 +61,14 @@ function(vcpkg_build_make)
             find_program(MAKE make REQUIRED)
             set(MAKE make)
             # Set make command and install command
-            set(MAKE_OPTS -j ${VCPKG_CONCURRENCY})
-            set(INSTALL_OPTS install -j ${VCPKG_CONCURRENCY})
+            if("$ENV{MAKEFLAGS}" MATCHES "--jobserver-(auth|fds)=")
+                # An explicit -j would make make leave the jobserver vcpkg shares between builds
+                set(MAKE_OPTS)
+                set(INSTALL_OPTS install)
+            else()
+                set(MAKE_OPTS -j ${VCPKG_CONCURRENCY})
+                set(INSTALL_OPTS install -j ${VCPKG_CONCURRENCY})
+            endif()
         endif()
     elseif (_VCPKG_MAKE_GENERATOR STREQUAL "nmake")
         find_program(NMAKE nmake REQUIRED)
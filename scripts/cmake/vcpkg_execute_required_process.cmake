@@ -39,6 +39,10 @@ function(vcpkg_execute_required_process)
     set(LOG_ERR "${CURRENT_BUILDTREES_DIR}/${vcpkg_execute_required_process_LOGNAME}-err.log")
 
     set(execute_process_function execute_process)
+    # Capturing distfiles runs no process at all, not even those allowed in Download Mode
+    if (DEFINED _VCPKG_DISTFILES_MANIFEST)
+        _vcpkg_halt_distfile_capture()
+    endif()
     if (DEFINED VCPKG_DOWNLOAD_MODE AND NOT vcpkg_execute_required_process_ALLOW_IN_DOWNLOAD_MODE)
         message(FATAL_ERROR 
 [[
@@ -296,6 +296,10 @@ function(vcpkg_find_acquire_program VAR)
         SHA512 ${HASH}
         FILENAME ${ARCHIVE}
     )
+    # The tool archive has only been recorded, not downloaded
+    if(DEFINED _VCPKG_DISTFILES_MANIFEST)
+      _vcpkg_halt_distfile_capture()
+    endif()
 
     set(PROG_PATH_SUBDIR "${DOWNLOADS}/tools/${PROGNAME}/${SUBDIR}")
     file(MAKE_DIRECTORY ${PROG_PATH_SUBDIR})
@@ -4,16 +4,22 @@ function(vcpkg_install_meson)
 
     unset(ENV{DESTDIR}) # installation directory was already specified with '--prefix' option
 
+    # Ninja 1.13 and later take jobs from the jobserver vcpkg shares between builds, but only without -j
+    set(PARALLEL_ARG)
+    if(NOT "$ENV{MAKEFLAGS}" MATCHES "--jobserver-(auth|fds)=")
+        set(PARALLEL_ARG "-j${VCPKG_CONCURRENCY}")
+    endif()
+
     message(STATUS "Package ${TARGET_TRIPLET}-rel")
     vcpkg_execute_required_process(
-        COMMAND ${NINJA} install -v
+        COMMAND ${NINJA} install -v ${PARALLEL_ARG}
         WORKING_DIRECTORY ${CURRENT_BUILDTREES_DIR}/${TARGET_TRIPLET}-rel
         LOGNAME package-${TARGET_TRIPLET}-rel
     )
 
     message(STATUS "Package ${TARGET_TRIPLET}-dbg")
     vcpkg_execute_required_process(
-        COMMAND ${NINJA} install -v
+        COMMAND ${NINJA} install -v ${PARALLEL_ARG}
         WORKING_DIRECTORY ${CURRENT_BUILDTREES_DIR}/${TARGET_TRIPLET}-dbg
         LOGNAME package-${TARGET_TRIPLET}-dbg
     )
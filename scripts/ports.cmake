@@ -36,12 +36,17 @@ set(PACKAGES_DIR ${VCPKG_ROOT_DIR}/packages CACHE PATH "Location to store packag
 set(BUILDTREES_DIR ${VCPKG_ROOT_DIR}/buildtrees CACHE PATH "Location to perform actual extract+config+build")
 
 if(PORT)
-    set(CURRENT_BUILDTREES_DIR ${BUILDTREES_DIR}/${PORT})
-    set(CURRENT_PACKAGES_DIR ${PACKAGES_DIR}/${PORT}_${TARGET_TRIPLET})
+    # vcpkg passes both when building; they may be namespaced per triplet
+    if(NOT DEFINED CURRENT_BUILDTREES_DIR)
+        set(CURRENT_BUILDTREES_DIR ${BUILDTREES_DIR}/${PORT})
+    endif()
+    if(NOT DEFINED CURRENT_PACKAGES_DIR)
+        set(CURRENT_PACKAGES_DIR ${PACKAGES_DIR}/${PORT}_${TARGET_TRIPLET})
+    endif()
 endif()
 
 
-if(CMD MATCHES "^BUILD$")
+if(CMD MATCHES "^(BUILD|CAPTURE_DISTFILES)$")
     set(CMAKE_TRIPLET_FILE ${TARGET_TRIPLET_FILE})
     if(NOT EXISTS ${CMAKE_TRIPLET_FILE})
         message(FATAL_ERROR "Unsupported target triplet. Triplet file does not exist: ${CMAKE_TRIPLET_FILE}")
@@ -64,17 +69,35 @@ if(CMD MATCHES "^BUILD$")
     unset(PACKAGES_DIR)
     unset(BUILDTREES_DIR)
 
-    if(EXISTS ${CURRENT_PACKAGES_DIR})
-        file(GLOB FILES_IN_CURRENT_PACKAGES_DIR "${CURRENT_PACKAGES_DIR}/*")
-        if(FILES_IN_CURRENT_PACKAGES_DIR)
-            file(REMOVE_RECURSE ${FILES_IN_CURRENT_PACKAGES_DIR})
+    if(CMD MATCHES "^CAPTURE_DISTFILES$")
+        # Only record the distfiles the portfile requests into _VCPKG_DISTFILES_MANIFEST. The package directory is
+        # left alone, and the portfile halts before it would run a process or acquire a tool.
+        if(NOT DEFINED _VCPKG_DISTFILES_MANIFEST)
+            message(FATAL_ERROR "_VCPKG_DISTFILES_MANIFEST was not defined")
+        endif()
+        set(CURRENT_PACKAGES_DIR ${CURRENT_BUILDTREES_DIR}/${TARGET_TRIPLET}-distfiles)
+        file(REMOVE "${_VCPKG_DISTFILES_MANIFEST}" "${_VCPKG_DISTFILES_MANIFEST}.part")
+        file(MAKE_DIRECTORY ${CURRENT_BUILDTREES_DIR})
+
+        # The manifest only appears once the portfile has halted, so vcpkg can tell a halt from a failure
+        function(_vcpkg_halt_distfile_capture)
+            file(APPEND "${_VCPKG_DISTFILES_MANIFEST}.part" "")
+            file(RENAME "${_VCPKG_DISTFILES_MANIFEST}.part" "${_VCPKG_DISTFILES_MANIFEST}")
+            message(FATAL_ERROR "The distfiles of ${PORT} have been recorded.\nHalting portfile execution.\n")
+        endfunction()
+    else()
+        if(EXISTS ${CURRENT_PACKAGES_DIR})
             file(GLOB FILES_IN_CURRENT_PACKAGES_DIR "${CURRENT_PACKAGES_DIR}/*")
             if(FILES_IN_CURRENT_PACKAGES_DIR)
-                message(FATAL_ERROR "Unable to empty directory: ${CURRENT_PACKAGES_DIR}\n  Files are likely in use.")
+                file(REMOVE_RECURSE ${FILES_IN_CURRENT_PACKAGES_DIR})
+                file(GLOB FILES_IN_CURRENT_PACKAGES_DIR "${CURRENT_PACKAGES_DIR}/*")
+                if(FILES_IN_CURRENT_PACKAGES_DIR)
+                    message(FATAL_ERROR "Unable to empty directory: ${CURRENT_PACKAGES_DIR}\n  Files are likely in use.")
+                endif()
             endif()
         endif()
+        file(MAKE_DIRECTORY ${CURRENT_BUILDTREES_DIR} ${CURRENT_PACKAGES_DIR})
     endif()
-    file(MAKE_DIRECTORY ${CURRENT_BUILDTREES_DIR} ${CURRENT_PACKAGES_DIR})
 
     include(${CMAKE_TRIPLET_FILE})
 
@@ -89,6 +112,10 @@ if(CMD MATCHES "^BUILD$")
     include(${SCRIPTS}/cmake/vcpkg_common_functions.cmake)
     include(${CURRENT_PORT_DIR}/portfile.cmake)
 
+    if(CMD MATCHES "^CAPTURE_DISTFILES$")
+        _vcpkg_halt_distfile_capture()
+    endif()
+
     set(BUILD_INFO_FILE_PATH ${CURRENT_PACKAGES_DIR}/BUILD_INFO)
     file(WRITE  ${BUILD_INFO_FILE_PATH} "CRTLinkage: ${VCPKG_CRT_LINKAGE}\n")
     file(APPEND ${BUILD_INFO_FILE_PATH} "LibraryLinkage: ${VCPKG_LIBRARY_LINKAGE}\n")
@@ -108,6 +135,12 @@ if(CMD MATCHES "^BUILD$")
     if (DEFINED VCPKG_POLICY_EMPTY_INCLUDE_FOLDER)
         file(APPEND ${BUILD_INFO_FILE_PATH} "PolicyEmptyIncludeFolder: ${VCPKG_POLICY_EMPTY_INCLUDE_FOLDER}\n")
     endif()
+    if (DEFINED VCPKG_POLICY_ALLOW_ABSOLUTE_RPATH)
+        file(APPEND ${BUILD_INFO_FILE_PATH} "PolicyAllowAbsoluteRpath: ${VCPKG_POLICY_ALLOW_ABSOLUTE_RPATH}\n")
+    endif()
+    if (DEFINED VCPKG_POLICY_ALLOW_MISSING_SONAME)
+        file(APPEND ${BUILD_INFO_FILE_PATH} "PolicyAllowMissingSoname: ${VCPKG_POLICY_ALLOW_MISSING_SONAME}\n")
+    endif()
     if (DEFINED VCPKG_HEAD_VERSION)
         file(APPEND ${BUILD_INFO_FILE_PATH} "Version: ${VCPKG_HEAD_VERSION}\n")
     endif()
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <vcpkg/base/files.h>
+
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <unordered_map>
+
+namespace vcpkg::Test
+{
+    /// <summary>
+    /// A Filesystem kept entirely in memory, for tests and benchmarks that should not depend on, or wait for, the
+    /// disk. It follows POSIX semantics: symlinks are resolved in every component but the last unless asked to,
+    /// rename replaces an existing file or empty directory atomically, hard links share their contents, and files
+    /// and directories without owner_write cannot be written or have entries added or removed, except by
+    /// remove_all.
+    ///
+    /// Paths are absolute, with relative ones taken from the root. find_from_PATH finds nothing. Every member may be
+    /// called from several threads at once.
+    /// </summary>
+    struct MemoryFilesystem final : Files::Filesystem
+    {
+        MemoryFilesystem();
+
+        /// <summary>
+        /// Creates a symlink at link pointing to target, which need not exist; relative targets are taken from the
+        /// directory holding link.
+        /// </summary>
+        void create_symlink(const fs::path& target, const fs::path& link, std::error_code& ec);
+
+        /// <summary>
+        /// Replaces the permissions of path itself, not of what it links to.
+        /// </summary>
+        void set_permissions(const fs::path& path, fs::perms permissions, std::error_code& ec);
+
+        // The overloads that exit on errors, hidden by the overrides below
+        using Filesystem::canonical;
+        using Filesystem::read_contents;
+        using Filesystem::remove;
+        using Filesystem::remove_all;
+        using Filesystem::rename;
+        using Filesystem::status;
+        using Filesystem::symlink_status;
+        using Filesystem::write_contents;
+        using Filesystem::write_lines;
+
+        virtual Expected<std::string> read_contents(const fs::path& file_path) const override;
+        virtual Expected<std::vector<std::string>> read_lines(const fs::path& file_path) const override;
+        virtual fs::path find_file_recursively_up(const fs::path& starting_dir,
+                                                  const std::string& filename) const override;
+        virtual std::vector<fs::path> get_files_recursive(const fs::path& dir) const override;
+        virtual std::vector<fs::path> get_files_non_recursive(const fs::path& dir) const override;
+        virtual void read_directory(const fs::path& dir,
+                                    const std::function<void(Files::DirectoryEntry&&)>& visit,
+                                    std::error_code& ec) const override;
+        virtual void write_lines(const fs::path& file_path,
+                                 const std::vector<std::string>& lines,
+                                 std::error_code& ec) override;
+        virtual void write_contents(const fs::path& file_path, const std::string& data, std::error_code& ec) override;
+        virtual void rename(const fs::path& oldpath, const fs::path& newpath, std::error_code& ec) override;
+        virtual void rename_or_copy(const fs::path& oldpath,
+                                    const fs::path& newpath,
+                                    StringLiteral temp_suffix,
+                                    std::error_code& ec) override;
+        virtual bool remove(const fs::path& path, std::error_code& ec) override;
+        virtual void remove_all(const fs::path& path, std::error_code& ec, fs::path& failure_point) override;
+        virtual bool is_directory(const fs::path& path) const override;
+        virtual bool is_regular_file(const fs::path& path) const override;
+        virtual bool is_empty(const fs::path& path) const override;
+        virtual std::uintmax_t file_size(const fs::path& path, std::error_code& ec) const override;
+        virtual std::uintmax_t hard_link_count(const fs::path& path, std::error_code& ec) const override;
+        virtual bool create_directory(const fs::path& path, std::error_code& ec) override;
+        virtual bool create_directories(const fs::path& path, std::error_code& ec) override;
+        virtual void copy(const fs::path& oldpath, const fs::path& newpath, fs::copy_options opts) override;
+        virtual bool copy_file(const fs::path& oldpath,
+                               const fs::path& newpath,
+                               fs::copy_options opts,
+                               std::error_code& ec) override;
+        virtual void copy_symlink(const fs::path& oldpath, const fs::path& newpath, std::error_code& ec) override;
+        virtual void create_hard_link(const fs::path& target, const fs::path& link, std::error_code& ec) override;
+        virtual fs::file_status status(const fs::path& path, std::error_code& ec) const override;
+        virtual fs::file_status symlink_status(const fs::path& path, std::error_code& ec) const override;
+        virtual fs::path canonical(const fs::path& path, std::error_code& ec) const override;
+        virtual std::vector<fs::path> find_from_PATH(const std::string& name) const override;
+
+    private:
+        /// <summary>
+        /// What hard links to one file share.
+        /// </summary>
+        struct FileData
+        {
+            std::string contents;
+            fs::perms permissions;
+        };
+
+        struct Node
+        {
+            fs::file_type type;
+            // Regular files only
+            std::shared_ptr<FileData> data;
+            // Symlinks only
+            std::string target;
+            // Directories only
+            std::set<std::string> children;
+            fs::perms permissions;
+        };
+
+        /// <summary>
+        /// Turns path into the key of the node it names, following symlinks in every component but the last, and in
+        /// the last too if follow is set. Fails if a component other than the last is missing or not a directory.
+        /// </summary>
+        std::string resolve(const fs::path& path, bool follow, std::error_code& ec) const;
+        const Node* find(const std::string& key) const;
+        Node* find(const std::string& key);
+        fs::perms permissions_of(const Node& node) const;
+
+        /// <summary>
+        /// Checks that the parent of key exists and may have entries added or removed.
+        /// </summary>
+        Node* writable_parent(const std::string& key, std::error_code& ec);
+        void insert(const std::string& key, Node&& node);
+        void erase_tree(const std::string& key);
+        void move_tree(const std::string& from, const std::string& to);
+        void copy_entry(const fs::path& from, const fs::path& to, fs::copy_options opts, bool nested);
+        bool create_directory_at(const std::string& key, std::error_code& ec);
+
+        // Recursive, so that members may be built on one another
+        mutable std::recursive_mutex m_mutex;
+        std::unordered_map<std::string, Node> m_nodes;
+    };
+}
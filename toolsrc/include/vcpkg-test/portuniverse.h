@@ -0,0 +1,71 @@
+#pragma once
+
+#include <vcpkg/cmakevars.h>
+#include <vcpkg/sourceparagraph.h>
+#include <vcpkg/statusparagraphs.h>
+#include <vcpkg/triplet.h>
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace vcpkg::Test
+{
+    struct PortUniverseOptions
+    {
+        size_t port_count = 10000;
+        /// <summary>
+        /// Each port depends directly on up to this many others.
+        /// </summary>
+        size_t max_dependencies = 6;
+        /// <summary>
+        /// Each port has up to this many features, each with one or two dependencies of its own.
+        /// </summary>
+        size_t max_features = 3;
+        /// <summary>
+        /// Share of dependencies, in percent, that only apply to some triplets, such as `zlib (!uwp)`.
+        /// </summary>
+        unsigned qualified_percent = 10;
+        /// <summary>
+        /// Share of features, in percent, that are default features.
+        /// </summary>
+        unsigned default_feature_percent = 30;
+        /// <summary>
+        /// Share of dependencies, in percent, that also ask for a feature of the port they depend on.
+        /// </summary>
+        unsigned feature_dependency_percent = 20;
+        std::uint64_t seed = 0;
+    };
+
+    /// <summary>
+    /// A synthetic ports tree shaped like the real one: ports only depend on ports generated before them, mostly on
+    /// the first few, as so many real ports depend on zlib or boost, so that the graph is both deep and has a few
+    /// very popular vertices. The same options always give the same ports, on every platform.
+    /// </summary>
+    struct PortUniverse
+    {
+        static PortUniverse generate(const PortUniverseOptions& options);
+
+        /// <summary>
+        /// Names of all ports, in the order generated: each may only depend on those before it.
+        /// </summary>
+        std::vector<std::string> names;
+        std::unordered_map<std::string, SourceControlFileLocation> ports;
+
+        std::vector<PackageSpec> specs(const Triplet& triplet) const;
+        std::vector<FullPackageSpec> full_specs(const Triplet& triplet) const;
+
+        /// <summary>
+        /// A status database in which every port is installed for triplet, without features, with the
+        /// dependencies its core has on that triplet.
+        /// </summary>
+        StatusParagraphs install_all(const Triplet& triplet) const;
+
+        /// <summary>
+        /// Gives every port dependency information for triplet, so that qualified dependencies are resolved
+        /// the first time the planner meets them rather than in a second pass.
+        /// </summary>
+        void provide_dep_info_vars(CMakeVars::MockCMakeVarProvider& var_provider, const Triplet& triplet) const;
+    };
+}
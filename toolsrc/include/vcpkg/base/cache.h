@@ -1,21 +1,50 @@
 #pragma once
 
-#include <map>
+#include <vcpkg/base/lazy.h>
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 
 namespace vcpkg
 {
-    template<class Key, class Value>
+    /// <summary>
+    /// Computes the value of each key the first time it is asked for, and keeps it for the lifetime of the cache.
+    /// Safe to use from several threads at once. Keys are spread over shards, each behind its own mutex which is
+    /// only held to find a key's entry, never while computing a value: computing one value holds up neither other
+    /// keys nor the computations of other values. Callers asking for a key being computed wait for that
+    /// computation rather than repeating it. Computing a value may ask the cache for other keys, but not for its own.
+    ///
+    /// Movable, so that the objects holding one are, but only while no other thread is using it.
+    /// </summary>
+    template<class Key, class Value, class Hash = std::hash<Key>>
     struct Cache
     {
+        Cache() : m_shards(std::make_unique<Shard[]>(SHARD_COUNT)) {}
+
         template<class F>
         Value const& get_lazy(const Key& k, const F& f) const
         {
-            auto it = m_cache.find(k);
-            if (it != m_cache.end()) return it->second;
-            return m_cache.emplace(k, f()).first->second;
+            Shard& shard = m_shards[Hash()(k) % SHARD_COUNT];
+            const Lazy<Value>* entry;
+            {
+                std::lock_guard<std::mutex> lock(shard.mutex);
+                // Entries of an unordered_map stay where they are as it grows
+                entry = &shard.entries[k];
+            }
+            return entry->get_lazy(f);
         }
 
     private:
-        mutable std::map<Key, Value> m_cache;
+        static constexpr size_t SHARD_COUNT = 16;
+
+        struct Shard
+        {
+            std::mutex mutex;
+            std::unordered_map<Key, Lazy<Value>, Hash> entries;
+        };
+
+        std::unique_ptr<Shard[]> m_shards;
     };
 }
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <vcpkg/base/files.h>
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+
+namespace vcpkg::Files
+{
+    /// <summary>
+    /// A Filesystem that passes everything on to another one, but remembers what status and symlink_status returned
+    /// for each path, so that exists, is_directory and is_regular_file ask about a path only once. Where every stat
+    /// is a round trip to a file server this saves most of them.
+    ///
+    /// Changes made through this object forget what they may have changed: the changed path, everything below it
+    /// and everything above it. Changes made by anything else are not seen, except that everything is forgotten
+    /// whenever a child process starts or finishes, as builds and extractions change files on their own. Changes
+    /// seen only through a link to the changed path are not noticed either.
+    ///
+    /// Safe to use from several threads at once.
+    /// </summary>
+    struct CachingFilesystem final : Filesystem
+    {
+        explicit CachingFilesystem(Filesystem& underlying);
+
+        /// <summary>
+        /// Number of lookups answered from what was remembered. The total over all instances is also counted in
+        /// Phases::Counter::FILE_STATUS_CACHE_HITS.
+        /// </summary>
+        std::uint64_t hits() const { return m_hits; }
+
+        /// <summary>
+        /// Number of lookups passed on to the underlying filesystem, also counted in
+        /// Phases::Counter::FILE_STATUS_CACHE_MISSES.
+        /// </summary>
+        std::uint64_t misses() const { return m_misses; }
+
+        /// <summary>
+        /// Forgets everything remembered so far.
+        /// </summary>
+        void clear();
+
+        virtual Expected<std::string> read_contents(const fs::path& file_path) const override;
+        virtual Expected<std::vector<std::string>> read_lines(const fs::path& file_path) const override;
+        virtual fs::path find_file_recursively_up(const fs::path& starting_dir,
+                                                  const std::string& filename) const override;
+        virtual std::vector<fs::path> get_files_recursive(const fs::path& dir) const override;
+        virtual std::vector<fs::path> get_files_non_recursive(const fs::path& dir) const override;
+        virtual void read_directory(const fs::path& dir,
+                                    const std::function<void(DirectoryEntry&&)>& visit,
+                                    std::error_code& ec) const override;
+        virtual void write_lines(const fs::path& file_path,
+                                 const std::vector<std::string>& lines,
+                                 std::error_code& ec) override;
+        virtual void write_contents(const fs::path& file_path, const std::string& data, std::error_code& ec) override;
+        virtual void rename(const fs::path& oldpath, const fs::path& newpath, std::error_code& ec) override;
+        virtual void rename_or_copy(const fs::path& oldpath,
+                                    const fs::path& newpath,
+                                    StringLiteral temp_suffix,
+                                    std::error_code& ec) override;
+        virtual bool remove(const fs::path& path, std::error_code& ec) override;
+        virtual void remove_all(const fs::path& path, std::error_code& ec, fs::path& failure_point) override;
+        virtual bool is_directory(const fs::path& path) const override;
+        virtual bool is_regular_file(const fs::path& path) const override;
+        virtual bool is_empty(const fs::path& path) const override;
+        virtual std::uintmax_t file_size(const fs::path& path, std::error_code& ec) const override;
+        virtual std::uintmax_t hard_link_count(const fs::path& path, std::error_code& ec) const override;
+        virtual bool create_directory(const fs::path& path, std::error_code& ec) override;
+        virtual bool create_directories(const fs::path& path, std::error_code& ec) override;
+        virtual void copy(const fs::path& oldpath, const fs::path& newpath, fs::copy_options opts) override;
+        virtual bool copy_file(const fs::path& oldpath,
+                               const fs::path& newpath,
+                               fs::copy_options opts,
+                               std::error_code& ec) override;
+        virtual void copy_symlink(const fs::path& oldpath, const fs::path& newpath, std::error_code& ec) override;
+        virtual void create_hard_link(const fs::path& target, const fs::path& link, std::error_code& ec) override;
+        virtual fs::file_status status(const fs::path& path, std::error_code& ec) const override;
+        virtual fs::file_status symlink_status(const fs::path& path, std::error_code& ec) const override;
+        virtual fs::path canonical(const fs::path& path, std::error_code& ec) const override;
+        virtual std::vector<fs::path> find_from_PATH(const std::string& name) const override;
+
+    private:
+        struct CachedStatus
+        {
+            fs::file_status status;
+            std::error_code ec;
+        };
+
+        using StatusMap = std::map<std::string, CachedStatus>;
+
+        fs::file_status lookup(StatusMap& cache,
+                               const fs::path& path,
+                               std::error_code& ec,
+                               fs::file_status (Filesystem::*query)(const fs::path&, std::error_code&) const) const;
+        void forget(const fs::path& path);
+
+        Filesystem& m_underlying;
+
+        mutable std::mutex m_mutex;
+        mutable StatusMap m_status;
+        mutable StatusMap m_symlink_status;
+        mutable std::uint64_t m_child_process_generation;
+        // Counts every time something was forgotten, so that a lookup racing with a change does not remember what
+        // it saw before the change
+        mutable std::uint64_t m_forget_count = 0;
+
+        mutable std::atomic<std::uint64_t> m_hits{0};
+        mutable std::atomic<std::uint64_t> m_misses{0};
+    };
+}
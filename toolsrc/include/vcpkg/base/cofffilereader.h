@@ -1,5 +1,6 @@
 #pragma once
 
+#include <vcpkg/base/expected.h>
 #include <vcpkg/base/files.h>
 #include <vcpkg/base/machinetype.h>
 
@@ -17,9 +18,13 @@ namespace vcpkg::CoffFileReader
         std::vector<MachineType> machine_types;
     };
 
-#if defined(_WIN32)
-    DllInfo read_dll(const fs::path& path);
+    /// <summary>
+    /// The error describes a file that could not be read or is not a valid DLL.
+    /// </summary>
+    ExpectedT<DllInfo, std::string> read_dll(const fs::path& path);
 
-    LibInfo read_lib(const fs::path& path);
-#endif
+    /// <summary>
+    /// The error describes a file that could not be read or is not a valid static or import library.
+    /// </summary>
+    ExpectedT<LibInfo, std::string> read_lib(const fs::path& path);
 }
@@ -1,16 +1,115 @@
 #pragma once
 
 #include <vcpkg/base/files.h>
+#include <vcpkg/base/stringview.h>
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
 
 namespace vcpkg::Downloads
 {
+    /// <summary>
+    /// Content-addressed store of downloaded files. Each file is kept once, as `<root>/<first two digits>/<sha512>`, and
+    /// hard linked (or copied, across file systems) to every file name it was requested as. The stores in
+    /// `read_only_roots`, such as the stores of other vcpkg roots on the same host, are consulted but never written to.
+    /// Both vcpkg and vcpkg_download_distfile verify a file before they rename it into a store, so stored files are
+    /// used without hashing them again.
+    /// </summary>
+    struct DownloadStore
+    {
+        /// <summary>
+        /// The store kept in `<downloads>/.sha512`, plus the read-only stores listed in the environment variable
+        /// VCPKG_READONLY_DOWNLOAD_STORES, separated like PATH entries
+        /// </summary>
+        static DownloadStore for_downloads_dir(const fs::path& downloads);
+
+        fs::path root;
+        std::vector<fs::path> read_only_roots;
+
+        static bool is_valid_sha512(const std::string& sha512);
+
+        fs::path object_path(const std::string& sha512) const;
+
+        /// <summary>
+        /// Make `download_path` refer to the stored file with the given hash.
+        /// Returns false if no store has that file.
+        /// </summary>
+        bool try_link(Files::Filesystem& fs, const std::string& sha512, const fs::path& download_path) const;
+
+        /// <summary>
+        /// Remove the stored files that no longer have another hard link. Files still linked from the downloads of
+        /// this root or of any other root stay, as do downloads in progress.
+        /// </summary>
+        void prune(Files::Filesystem& fs) const;
+    };
+
+    struct DownloadOptions
+    {
+        /// <summary>
+        /// Connections opened for a single file when its server accepts range requests
+        /// </summary>
+        unsigned max_segments = 4;
+
+        /// <summary>
+        /// Files smaller than twice this size are downloaded over one connection
+        /// </summary>
+        std::uint64_t min_segment_size = 8 * 1024 * 1024;
+
+        /// <summary>
+        /// Attempts per segment before giving up. Data received by failed attempts is kept, in a `.part` file next to
+        /// the download, and resumed by the next attempt or the next run.
+        /// </summary>
+        unsigned max_attempts = 4;
+
+        /// <summary>
+        /// Delay before the second attempt, growing linearly with each further attempt
+        /// </summary>
+        std::chrono::milliseconds retry_delay{1000};
+    };
+
     void verify_downloaded_file_hash(const Files::Filesystem& fs,
                                      const std::string& url,
                                      const fs::path& path,
                                      const std::string& sha512);
 
+    /// <summary>
+    /// Download `url` to `download_path` and verify its SHA512, splitting the transfer into concurrent range requests
+    /// and resuming interrupted transfers as described by `options`.
+    /// Files already in the store are linked instead of downloaded; new files are added to the store.
+    /// </summary>
     void download_file(Files::Filesystem& fs,
+                       const DownloadStore& store,
                        const std::string& url,
                        const fs::path& download_path,
-                       const std::string& sha512);
+                       const std::string& sha512,
+                       const DownloadOptions& options = {});
+
+    struct DownloadRequest
+    {
+        /// <summary>
+        /// Mirrors of the same file, tried in order
+        /// </summary>
+        std::vector<std::string> urls;
+        fs::path download_path;
+        std::string sha512;
+    };
+
+    /// <summary>
+    /// Returns the host component of `url`, without user information or port
+    /// </summary>
+    std::string get_url_host(StringView url);
+
+    /// <summary>
+    /// Download all requests concurrently, opening at most `max_connections` connections in total and at most
+    /// `max_connections_per_host` to any one host. A request whose host has no connection to spare waits without
+    /// holding up a thread. Returns an error message for each request that failed.
+    /// </summary>
+    std::vector<std::string> download_files(Files::Filesystem& fs,
+                                            const DownloadStore& store,
+                                            const std::vector<DownloadRequest>& requests,
+                                            unsigned max_connections,
+                                            unsigned max_connections_per_host,
+                                            const DownloadOptions& options = {});
 }
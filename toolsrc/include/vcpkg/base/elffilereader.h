@@ -0,0 +1,50 @@
+#pragma once
+
+#include <vcpkg/base/files.h>
+#include <vcpkg/base/optional.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace vcpkg::ElfFileReader
+{
+    enum class ElfType
+    {
+        OTHER,
+        RELOCATABLE,
+        EXECUTABLE,
+        SHARED_OBJECT,
+    };
+
+    struct ElfInfo
+    {
+        /// <summary>
+        /// e_machine, for example 62 for x86-64.
+        /// </summary>
+        uint16_t machine = 0;
+        ElfType type = ElfType::OTHER;
+        Optional<std::string> soname;
+        /// <summary>
+        /// Every directory listed in DT_RPATH and DT_RUNPATH.
+        /// </summary>
+        std::vector<std::string> search_paths;
+    };
+
+    /// <summary>
+    /// Reads the header and dynamic section of an ELF file. Returns nullopt when the file is not ELF, such as a
+    /// linker script named like a shared library, or is damaged.
+    /// </summary>
+    Optional<ElfInfo> read_elf(const fs::path& path);
+
+    /// <summary>
+    /// The distinct e_machine values of the ELF objects in an ar archive. Returns nullopt when the file is not an
+    /// archive; members that are not ELF, like the COFF objects of a mingw import library, are skipped.
+    /// </summary>
+    Optional<std::vector<uint16_t>> read_archive_machines(const fs::path& path);
+
+    /// <summary>
+    /// The VCPKG_TARGET_ARCHITECTURE for an e_machine value.
+    /// </summary>
+    std::string to_architecture(uint16_t machine);
+}
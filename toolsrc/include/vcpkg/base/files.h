@@ -2,6 +2,8 @@
 
 #include <vcpkg/base/expected.h>
 
+#include <functional>
+
 #define _SILENCE_EXPERIMENTAL_FILESYSTEM_DEPRECATION_WARNING
 #include <experimental/filesystem>
 
@@ -97,6 +99,15 @@ void is_directory(const fs::path& p, std::error_code& ec) = delete;
 
 namespace vcpkg::Files
 {
+    struct DirectoryEntry
+    {
+        fs::path path;
+        /// <summary>
+        /// The entry itself, not what a link points to.
+        /// </summary>
+        fs::file_type type;
+    };
+
     struct Filesystem
     {
         std::string read_contents(const fs::path& file_path, LineInfo linfo) const;
@@ -105,6 +116,29 @@ namespace vcpkg::Files
         virtual fs::path find_file_recursively_up(const fs::path& starting_dir, const std::string& filename) const = 0;
         virtual std::vector<fs::path> get_files_recursive(const fs::path& dir) const = 0;
         virtual std::vector<fs::path> get_files_non_recursive(const fs::path& dir) const = 0;
+
+        /// <summary>
+        /// Calls visit for each entry directly in dir, in no particular order, while the directory is being read.
+        /// The type comes from the directory listing itself wherever the platform provides it, so that most entries
+        /// cost no stat.
+        /// </summary>
+        virtual void read_directory(const fs::path& dir,
+                                    const std::function<void(DirectoryEntry&&)>& visit,
+                                    std::error_code& ec) const = 0;
+
+        /// <summary>
+        /// Calls visit for every entry below dir, each directory before its contents, without following links to
+        /// directories. Directories that cannot be read are skipped, as with get_files_recursive.
+        /// </summary>
+        void walk_directory(const fs::path& dir, const std::function<void(const DirectoryEntry&)>& visit) const;
+
+        /// <summary>
+        /// As walk_directory, but reads subdirectories on several threads, so visit may be called concurrently and
+        /// sees entries in no particular order.
+        /// </summary>
+        void walk_directory_parallel(const fs::path& dir,
+                                     const std::function<void(const DirectoryEntry&)>& visit) const;
+
         void write_lines(const fs::path& file_path, const std::vector<std::string>& lines, LineInfo linfo);
         virtual void write_lines(const fs::path& file_path,
                                  const std::vector<std::string>& lines,
@@ -130,6 +164,8 @@ namespace vcpkg::Files
         virtual bool is_directory(const fs::path& path) const = 0;
         virtual bool is_regular_file(const fs::path& path) const = 0;
         virtual bool is_empty(const fs::path& path) const = 0;
+        virtual std::uintmax_t file_size(const fs::path& path, std::error_code& ec) const = 0;
+        virtual std::uintmax_t hard_link_count(const fs::path& path, std::error_code& ec) const = 0;
         virtual bool create_directory(const fs::path& path, std::error_code& ec) = 0;
         virtual bool create_directories(const fs::path& path, std::error_code& ec) = 0;
         virtual void copy(const fs::path& oldpath, const fs::path& newpath, fs::copy_options opts) = 0;
@@ -138,6 +174,7 @@ namespace vcpkg::Files
                                fs::copy_options opts,
                                std::error_code& ec) = 0;
         virtual void copy_symlink(const fs::path& oldpath, const fs::path& newpath, std::error_code& ec) = 0;
+        virtual void create_hard_link(const fs::path& target, const fs::path& link, std::error_code& ec) = 0;
         virtual fs::file_status status(const fs::path& path, std::error_code& ec) const = 0;
         virtual fs::file_status symlink_status(const fs::path& path, std::error_code& ec) const = 0;
         fs::file_status status(LineInfo li, const fs::path& p) const noexcept;
@@ -150,6 +187,49 @@ namespace vcpkg::Files
 
     Filesystem& get_real_filesystem();
 
+    /// <summary>
+    /// A read-only view of a whole file, mapped into memory instead of read through a stream. Binary inspection jumps
+    /// around large files reading a few bytes at a time, which the page cache serves far better than seek and read.
+    /// </summary>
+    struct MappedFile
+    {
+        MappedFile(const fs::path& path, std::error_code& ec);
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+        ~MappedFile();
+
+        const char* data() const { return m_data; }
+        size_t size() const { return m_size; }
+
+    private:
+        const char* m_data = nullptr;
+        size_t m_size = 0;
+#if defined(_WIN32)
+        // The mapping object's HANDLE
+        void* m_mapping = nullptr;
+#endif
+    };
+
+    /// <summary>
+    /// An exclusive lock on a file, held until destroyed, which excludes other processes as well as other threads of
+    /// this one. Taking it waits while anyone else holds it. The file is created if it does not exist, and left behind.
+    /// </summary>
+    struct ExclusiveFileLock
+    {
+        ExclusiveFileLock(const fs::path& path, std::error_code& ec);
+        ExclusiveFileLock(const ExclusiveFileLock&) = delete;
+        ExclusiveFileLock& operator=(const ExclusiveFileLock&) = delete;
+        ~ExclusiveFileLock();
+
+    private:
+#if defined(_WIN32)
+        // The locked file's HANDLE
+        void* m_handle = nullptr;
+#else
+        int m_fd = -1;
+#endif
+    };
+
     static constexpr const char* FILESYSTEM_INVALID_CHARACTERS = R"(\/:*?"<>|)";
 
     bool has_invalid_chars_for_filesystem(const std::string& s);
@@ -1,10 +1,13 @@
 #pragma once
 
+#include <algorithm>
+#include <cstdint>
 #include <unordered_map>
-#include <unordered_set>
 #include <utility>
+#include <vector>
 
 #include <vcpkg/base/checks.h>
+#include <vcpkg/base/optional.h>
 #include <vcpkg/base/span.h>
 #include <vcpkg/base/system.print.h>
 
@@ -53,104 +56,441 @@ namespace vcpkg::Graphs
                 }
             }
         }
+    }
+
+    /// <summary>
+    /// Depth-first topological sort: every vertex comes after all vertices in its adjacency list.
+    /// Iterative, so that long dependency chains cannot exhaust the stack.
+    /// </summary>
+    template<class VertexContainer, class V, class U>
+    std::vector<U> topological_sort(VertexContainer starting_vertices,
+                                    const AdjacencyProvider<V, U>& f,
+                                    Randomizer* randomizer)
+    {
+        struct Frame
+        {
+            V vertex;
+            U vertex_data;
+            std::vector<V> neighbours;
+            std::size_t next;
+        };
 
-        template<class V, class U>
-        void topological_sort_internal(const V& vertex,
-                                       const AdjacencyProvider<V, U>& f,
-                                       std::unordered_map<V, ExplorationStatus>& exploration_status,
-                                       std::vector<U>& sorted,
-                                       Randomizer* randomizer)
+        std::vector<U> sorted;
+        std::unordered_map<V, ExplorationStatus> exploration_status;
+        std::vector<Frame> stack;
+
+        auto push = [&](const V& vertex) {
+            exploration_status[vertex] = ExplorationStatus::PARTIALLY_EXPLORED;
+            U vertex_data = f.load_vertex_data(vertex);
+            auto neighbours = f.adjacency_list(vertex_data);
+            details::shuffle(neighbours, randomizer);
+            stack.push_back(Frame{vertex, std::move(vertex_data), std::move(neighbours), 0});
+        };
+
+        details::shuffle(starting_vertices, randomizer);
+
+        for (auto&& start : starting_vertices)
         {
-            ExplorationStatus& status = exploration_status[vertex];
-            switch (status)
+            if (exploration_status[start] != ExplorationStatus::NOT_EXPLORED) continue;
+
+            push(start);
+            while (!stack.empty())
             {
-                case ExplorationStatus::FULLY_EXPLORED: return;
-                case ExplorationStatus::PARTIALLY_EXPLORED:
+                auto& frame = stack.back();
+                if (frame.next == frame.neighbours.size())
                 {
-                    System::print2("Cycle detected within graph at ", f.to_string(vertex), ":\n");
-                    for (auto&& node : exploration_status)
+                    exploration_status[frame.vertex] = ExplorationStatus::FULLY_EXPLORED;
+                    sorted.push_back(std::move(frame.vertex_data));
+                    stack.pop_back();
+                    continue;
+                }
+
+                const V neighbour = frame.neighbours[frame.next++];
+                switch (exploration_status[neighbour])
+                {
+                    case ExplorationStatus::FULLY_EXPLORED: break;
+                    case ExplorationStatus::PARTIALLY_EXPLORED:
                     {
-                        if (node.second == ExplorationStatus::PARTIALLY_EXPLORED)
+                        System::print2("Cycle detected within graph at ", f.to_string(neighbour), ":\n");
+                        for (auto&& node : stack)
                         {
-                            System::print2("    ", f.to_string(node.first), '\n');
+                            System::print2("    ", f.to_string(node.vertex), '\n');
                         }
+                        Checks::exit_fail(VCPKG_LINE_INFO);
                     }
-                    Checks::exit_fail(VCPKG_LINE_INFO);
-                }
-                case ExplorationStatus::NOT_EXPLORED:
-                {
-                    status = ExplorationStatus::PARTIALLY_EXPLORED;
-                    U vertex_data = f.load_vertex_data(vertex);
-                    auto neighbours = f.adjacency_list(vertex_data);
-                    details::shuffle(neighbours, randomizer);
-                    for (const V& neighbour : neighbours)
-                        topological_sort_internal(neighbour, f, exploration_status, sorted, randomizer);
-
-                    sorted.push_back(std::move(vertex_data));
-                    status = ExplorationStatus::FULLY_EXPLORED;
-                    return;
+                    case ExplorationStatus::NOT_EXPLORED: push(neighbour); break;
+                    default: Checks::unreachable(VCPKG_LINE_INFO);
                 }
-                default: Checks::unreachable(VCPKG_LINE_INFO);
             }
         }
+
+        return sorted;
     }
 
-    template<class VertexContainer, class V, class U>
-    std::vector<U> topological_sort(VertexContainer starting_vertices,
-                                    const AdjacencyProvider<V, U>& f,
-                                    Randomizer* randomizer)
+    /// <summary>
+    /// Assigns dense ids, in order of first appearance, to the values it is given.
+    /// </summary>
+    template<class T>
+    struct Interner
     {
-        std::vector<U> sorted;
-        std::unordered_map<V, ExplorationStatus> exploration_status;
+        /// <summary>
+        /// Returns the id of value and whether it was newly assigned by this call.
+        /// </summary>
+        std::pair<std::uint32_t, bool> intern(const T& value)
+        {
+            auto res = m_ids.emplace(value, static_cast<std::uint32_t>(m_values.size()));
+            if (res.second) m_values.push_back(&res.first->first);
+            return {res.first->second, res.second};
+        }
+
+        Optional<std::uint32_t> find(const T& value) const
+        {
+            auto it = m_ids.find(value);
+            if (it == m_ids.end()) return nullopt;
+            return it->second;
+        }
+
+        const T& operator[](std::uint32_t id) const { return *m_values[id]; }
+
+        std::size_t size() const { return m_values.size(); }
+
+    private:
+        std::unordered_map<T, std::uint32_t> m_ids;
+        std::vector<const T*> m_values;
+    };
+
+    /// <summary>
+    /// Directed graph over dense vertex ids. Edges are collected while the graph is built; freeze() then packs them
+    /// in compressed sparse-row form, so that the successors of a vertex are one sorted, duplicate-free slice of a
+    /// single array.
+    /// </summary>
+    struct CsrGraph
+    {
+        /// <summary>
+        /// Returns false if v was already a vertex of this graph.
+        /// </summary>
+        bool add_vertex(std::uint32_t v)
+        {
+            Checks::check_exit(VCPKG_LINE_INFO, !m_frozen, "Cannot add vertices to a frozen graph");
+            if (v >= m_present.size()) m_present.resize(static_cast<std::size_t>(v) + 1, false);
+            if (m_present[v]) return false;
+
+            m_present[v] = true;
+            m_vertices.push_back(v);
+            return true;
+        }
 
+        void add_edge(std::uint32_t u, std::uint32_t v)
+        {
+            add_vertex(u);
+            add_vertex(v);
+            m_edges.emplace_back(u, v);
+        }
+
+        void freeze()
+        {
+            if (m_frozen) return;
+            m_frozen = true;
+
+            std::sort(m_edges.begin(), m_edges.end());
+            m_edges.erase(std::unique(m_edges.begin(), m_edges.end()), m_edges.end());
+
+            m_offsets.assign(m_present.size() + 1, 0);
+            for (auto&& edge : m_edges)
+                ++m_offsets[edge.first + 1];
+            for (std::size_t i = 1; i < m_offsets.size(); ++i)
+                m_offsets[i] += m_offsets[i - 1];
+
+            m_targets.reserve(m_edges.size());
+            for (auto&& edge : m_edges)
+                m_targets.push_back(edge.second);
+
+            m_edges.clear();
+            m_edges.shrink_to_fit();
+        }
+
+        /// <summary>
+        /// Shuffle the successors of every vertex. Only valid once the graph is frozen.
+        /// </summary>
+        void shuffle_adjacency(Randomizer* randomizer)
+        {
+            Checks::check_exit(VCPKG_LINE_INFO, m_frozen, "Graph must be frozen");
+            if (!randomizer) return;
+            for (std::size_t v = 0; v + 1 < m_offsets.size(); ++v)
+            {
+                const auto first = m_targets.begin() + m_offsets[v];
+                std::vector<std::uint32_t> row(first, m_targets.begin() + m_offsets[v + 1]);
+                details::shuffle(row, randomizer);
+                std::copy(row.begin(), row.end(), first);
+            }
+        }
+
+        /// <summary>
+        /// Vertices in the order they were added.
+        /// </summary>
+        const std::vector<std::uint32_t>& vertex_list() const { return m_vertices; }
+
+        /// <summary>
+        /// One past the largest vertex id in the graph.
+        /// </summary>
+        std::size_t vertex_bound() const { return m_present.size(); }
+
+        Span<const std::uint32_t> adjacency_list(std::uint32_t v) const
+        {
+            Checks::check_exit(VCPKG_LINE_INFO, m_frozen, "Graph must be frozen");
+            return {m_targets.data() + m_offsets[v], m_targets.data() + m_offsets[v + 1]};
+        }
+
+        /// <summary>
+        /// The frozen graph with every edge turned around, over the same vertices in the same order.
+        /// </summary>
+        CsrGraph reversed() const
+        {
+            Checks::check_exit(VCPKG_LINE_INFO, m_frozen, "Graph must be frozen");
+            CsrGraph out;
+            for (std::uint32_t v : m_vertices)
+                out.add_vertex(v);
+            for (std::uint32_t v : m_vertices)
+            {
+                for (std::uint32_t w : adjacency_list(v))
+                    out.m_edges.emplace_back(w, v);
+            }
+            out.freeze();
+            return out;
+        }
+
+    private:
+        bool m_frozen = false;
+        std::vector<bool> m_present;
+        std::vector<std::uint32_t> m_vertices;
+        std::vector<std::pair<std::uint32_t, std::uint32_t>> m_edges;
+        std::vector<std::uint32_t> m_offsets;
+        std::vector<std::uint32_t> m_targets;
+    };
+
+    /// <summary>
+    /// Depth-first topological sort of a frozen graph: every vertex comes after all of its successors.
+    /// Iterative, so that long dependency chains cannot exhaust the stack.
+    /// </summary>
+    template<class ToString>
+    std::vector<std::uint32_t> topological_sort(const CsrGraph& graph,
+                                                const ToString& to_string,
+                                                Randomizer* randomizer)
+    {
+        const CsrGraph* g = &graph;
+        CsrGraph shuffled;
+        if (randomizer)
+        {
+            shuffled = graph;
+            shuffled.shuffle_adjacency(randomizer);
+            g = &shuffled;
+        }
+
+        auto starting_vertices = g->vertex_list();
         details::shuffle(starting_vertices, randomizer);
 
-        for (auto&& vertex : starting_vertices)
+        std::vector<std::uint32_t> sorted;
+        sorted.reserve(starting_vertices.size());
+        std::vector<ExplorationStatus> exploration_status(g->vertex_bound(), ExplorationStatus::NOT_EXPLORED);
+
+        // Each frame is a vertex and the index of the next successor to visit
+        std::vector<std::pair<std::uint32_t, std::size_t>> stack;
+
+        for (std::uint32_t start : starting_vertices)
         {
-            details::topological_sort_internal(vertex, f, exploration_status, sorted, randomizer);
+            if (exploration_status[start] != ExplorationStatus::NOT_EXPLORED) continue;
+
+            exploration_status[start] = ExplorationStatus::PARTIALLY_EXPLORED;
+            stack.emplace_back(start, 0);
+            while (!stack.empty())
+            {
+                auto& frame = stack.back();
+                const auto neighbours = g->adjacency_list(frame.first);
+                if (frame.second == neighbours.size())
+                {
+                    exploration_status[frame.first] = ExplorationStatus::FULLY_EXPLORED;
+                    sorted.push_back(frame.first);
+                    stack.pop_back();
+                    continue;
+                }
+
+                const std::uint32_t neighbour = neighbours[frame.second++];
+                switch (exploration_status[neighbour])
+                {
+                    case ExplorationStatus::FULLY_EXPLORED: break;
+                    case ExplorationStatus::PARTIALLY_EXPLORED:
+                    {
+                        System::print2("Cycle detected within graph at ", to_string(neighbour), ":\n");
+                        for (auto&& node : stack)
+                        {
+                            System::print2("    ", to_string(node.first), '\n');
+                        }
+                        Checks::exit_fail(VCPKG_LINE_INFO);
+                    }
+                    case ExplorationStatus::NOT_EXPLORED:
+                        exploration_status[neighbour] = ExplorationStatus::PARTIALLY_EXPLORED;
+                        stack.emplace_back(neighbour, 0);
+                        break;
+                    default: Checks::unreachable(VCPKG_LINE_INFO);
+                }
+            }
         }
 
         return sorted;
     }
 
-    template<class V>
-    struct Graph final : AdjacencyProvider<V, V>
+    /// <summary>
+    /// Hands out the vertices of a frozen graph as they become ready: a vertex is released once every vertex in
+    /// its adjacency list has been completed. Vertices without successors are ready from the start.
+    /// </summary>
+    struct TopologicalFrontier
     {
-    public:
-        bool add_vertex(const V& v)
+        explicit TopologicalFrontier(const CsrGraph& graph)
+            : m_predecessors(graph.reversed())
+            , m_pending(graph.vertex_bound(), 0)
+            , m_remaining(graph.vertex_list().size())
         {
-            return m_edges.emplace(std::piecewise_construct, std::forward_as_tuple(v), std::forward_as_tuple()).second;
+            const auto& vertices = graph.vertex_list();
+            // Reversed so that, popped from the back, ready vertices come out in insertion order
+            for (auto it = vertices.rbegin(); it != vertices.rend(); ++it)
+            {
+                m_pending[*it] = static_cast<std::uint32_t>(graph.adjacency_list(*it).size());
+                if (m_pending[*it] == 0) m_ready.push_back(*it);
+            }
         }
 
-        bool add_edge(const V& u, const V& v)
+        /// <summary>
+        /// Removes and returns every vertex released since the last call.
+        /// </summary>
+        std::vector<std::uint32_t> take_ready()
         {
-            auto vertex = m_edges.emplace(std::piecewise_construct, std::forward_as_tuple(v), std::forward_as_tuple());
-            auto edge = m_edges[u].emplace(v);
-
-            return vertex.second || edge.second;
+            std::vector<std::uint32_t> out;
+            out.swap(m_ready);
+            return out;
         }
 
-        std::vector<V> vertex_list() const
+        /// <summary>
+        /// Removes and returns the most recently released vertex, if there is one.
+        /// </summary>
+        Optional<std::uint32_t> pop_ready()
         {
-            std::vector<V> vertex_list;
-            for (auto&& vertex : this->m_edges)
-                vertex_list.emplace_back(vertex.first);
-            return vertex_list;
+            if (m_ready.empty()) return nullopt;
+            const std::uint32_t v = m_ready.back();
+            m_ready.pop_back();
+            return v;
         }
 
-        std::vector<V> adjacency_list(const V& vertex) const override
+        /// <summary>
+        /// Marks v as done, releasing every vertex that was only waiting on v.
+        /// </summary>
+        void complete(std::uint32_t v)
         {
-            const std::unordered_set<V>& as_set = this->m_edges.at(vertex);
-            return std::vector<V>(as_set.cbegin(), as_set.cend()); // TODO: Avoid redundant copy
+            Checks::check_exit(VCPKG_LINE_INFO, m_remaining > 0, "Completed more vertices than the graph has");
+            --m_remaining;
+            for (std::uint32_t pred : m_predecessors.adjacency_list(v))
+            {
+                if (--m_pending[pred] == 0) m_ready.push_back(pred);
+            }
         }
 
-        V load_vertex_data(const V& vertex) const override { return vertex; }
+        bool has_ready() const { return !m_ready.empty(); }
+
+        /// <summary>
+        /// Number of vertices that have not been completed yet.
+        /// </summary>
+        std::size_t remaining() const { return m_remaining; }
 
-        // Note: this function indicates how tied this template is to the exact type it will be templated upon.
-        // Possible fix: This type shouldn't implement to_string() and should instead be derived from?
-        std::string to_string(const V& spec) const override { return spec->m_spec.to_string(); }
+        /// <summary>
+        /// Vertices still waiting on successors. After the ready set has drained, these are the vertices on a cycle
+        /// or depending on one.
+        /// </summary>
+        std::vector<std::uint32_t> blocked() const
+        {
+            std::vector<std::uint32_t> out;
+            for (std::uint32_t v : m_predecessors.vertex_list())
+            {
+                if (m_pending[v] != 0) out.push_back(v);
+            }
+            return out;
+        }
 
     private:
-        std::unordered_map<V, std::unordered_set<V>> m_edges;
+        CsrGraph m_predecessors;
+        std::vector<std::uint32_t> m_pending;
+        std::vector<std::uint32_t> m_ready;
+        std::size_t m_remaining;
     };
+
+    struct LeveledOrder
+    {
+        /// <summary>
+        /// Every vertex comes after all vertices in its adjacency list.
+        /// </summary>
+        std::vector<std::uint32_t> order;
+
+        /// <summary>
+        /// Indexed by vertex id. 0 for vertices without successors, otherwise one more than the largest level among
+        /// the successors. Vertices on the same level never depend on each other.
+        /// </summary>
+        std::vector<std::uint32_t> level;
+
+        /// <summary>
+        /// Indexed by vertex id. The cost of the vertex plus the most expensive chain of predecessors waiting on it;
+        /// the largest value is the length of the critical path.
+        /// </summary>
+        std::vector<std::uint64_t> remaining_work;
+    };
+
+    /// <summary>
+    /// Kahn-style topological sort of a frozen graph that also annotates each vertex with its level and remaining
+    /// work. cost(v) gives the weight of vertex v for the remaining-work estimate.
+    /// </summary>
+    template<class Cost, class ToString>
+    LeveledOrder leveled_topological_sort(const CsrGraph& graph, const Cost& cost, const ToString& to_string)
+    {
+        LeveledOrder out;
+        out.order.reserve(graph.vertex_list().size());
+        out.level.assign(graph.vertex_bound(), 0);
+        out.remaining_work.assign(graph.vertex_bound(), 0);
+
+        TopologicalFrontier frontier(graph);
+        while (auto v = frontier.pop_ready())
+        {
+            const std::uint32_t vertex = *v.get();
+            for (std::uint32_t succ : graph.adjacency_list(vertex))
+                out.level[vertex] = std::max(out.level[vertex], out.level[succ] + 1);
+
+            out.order.push_back(vertex);
+            frontier.complete(vertex);
+        }
+
+        if (frontier.remaining() != 0)
+        {
+            const auto blocked = frontier.blocked();
+            System::print2("Cycle detected within graph at ", to_string(blocked.front()), ":\n");
+            for (std::uint32_t node : blocked)
+            {
+                System::print2("    ", to_string(node), '\n');
+            }
+            Checks::exit_fail(VCPKG_LINE_INFO);
+        }
+
+        // Predecessors of a vertex all come later in the order, so walking backwards sees them first
+        const CsrGraph predecessors = graph.reversed();
+        for (auto it = out.order.rbegin(); it != out.order.rend(); ++it)
+        {
+            std::uint64_t waiting = 0;
+            for (std::uint32_t pred : predecessors.adjacency_list(*it))
+                waiting = std::max(waiting, out.remaining_work[pred]);
+            out.remaining_work[*it] = static_cast<std::uint64_t>(cost(*it)) + waiting;
+        }
+
+        return out;
+    }
+
+    template<class ToString>
+    LeveledOrder leveled_topological_sort(const CsrGraph& graph, const ToString& to_string)
+    {
+        return leveled_topological_sort(graph, [](std::uint32_t) { return 1; }, to_string);
+    }
 }
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <vcpkg/base/expected.h>
+#include <vcpkg/base/optional.h>
+#include <vcpkg/base/stringview.h>
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace vcpkg::Http
+{
+    struct Response
+    {
+        int status_code = 0;
+
+        /// <summary>
+        /// Header names are lowercase, values have surrounding whitespace removed
+        /// </summary>
+        std::vector<std::pair<std::string, std::string>> headers;
+
+        Optional<const std::string&> get_header(StringView lowercase_name) const;
+    };
+
+    /// <summary>
+    /// Parse a status line and the header lines that follow it. When `head` holds several responses, such as the
+    /// redirects followed by curl, the last one is returned.
+    /// </summary>
+    Optional<Response> parse_response_head(StringView head);
+
+    struct ContentRange
+    {
+        std::uint64_t first = 0;
+        std::uint64_t last = 0;
+        Optional<std::uint64_t> complete_length;
+    };
+
+    /// <summary>
+    /// Parse the value of a `Content-Range: bytes first-last/complete_length` header
+    /// </summary>
+    Optional<ContentRange> parse_content_range(StringView value);
+
+#if !defined(_WIN32)
+    /// <summary>
+    /// GET a plain `http://` URL without leaving the process, following redirects to other `http://` URLs.
+    /// A redirect to any other scheme is returned as the response. No TLS library is linked, so callers hand
+    /// `https://` URLs to curl instead.
+    /// `on_response` is called before the body is read; unless it returns false, the body is passed to `data_cb` as
+    /// it arrives. Returns an error message if the connection failed or ended before the complete body was received.
+    /// </summary>
+    ExpectedT<Response, std::string> get(const std::string& url,
+                                         const std::vector<std::string>& request_headers,
+                                         const std::function<bool(const Response&)>& on_response,
+                                         const std::function<void(StringView)>& data_cb);
+#endif
+}
@@ -1,26 +1,38 @@
 #pragma once
 
+#include <memory>
+#include <mutex>
+
 namespace vcpkg
 {
+    /// <summary>
+    /// A value computed the first time it is asked for, and kept from then on. Safe to ask for from several threads
+    /// at once: one of them computes the value while the others wait for it. If computing throws, the next caller
+    /// tries again. Computing the value must not ask for it again.
+    ///
+    /// Movable, so that the objects holding one are, but only while no other thread is using it.
+    /// </summary>
     template<typename T>
     class Lazy
     {
     public:
-        Lazy() : value(T()), initialized(false) {}
+        Lazy() : m_state(std::make_unique<State>()) {}
 
         template<class F>
         T const& get_lazy(const F& f) const
         {
-            if (!initialized)
-            {
-                value = f();
-                initialized = true;
-            }
-            return value;
+            State& state = *m_state;
+            std::call_once(state.once, [&]() { state.value = std::make_unique<T>(f()); });
+            return *state.value;
         }
 
     private:
-        mutable T value;
-        mutable bool initialized;
+        struct State
+        {
+            std::once_flag once;
+            std::unique_ptr<T> value;
+        };
+
+        std::unique_ptr<State> m_state;
     };
 }
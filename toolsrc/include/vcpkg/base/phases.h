@@ -0,0 +1,81 @@
+#pragma once
+
+#include <vcpkg/base/stringliteral.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace vcpkg::Phases
+{
+    /// <summary>
+    /// The parts of vcpkg's own work worth telling apart from the time spent in build tools.
+    /// </summary>
+    enum class Phase
+    {
+        CHILD_PROCESSES,
+        ABI_HASHING,
+        STATUS_WRITES,
+        FILE_INSTALLS,
+        COUNT
+    };
+
+    StringLiteral to_string(Phase phase);
+
+    /// <summary>
+    /// Events counted for the summary next to the phases.
+    /// </summary>
+    enum class Counter
+    {
+        FILE_STATUS_CACHE_HITS,
+        FILE_STATUS_CACHE_MISSES,
+        COUNT
+    };
+
+    StringLiteral to_string(Counter counter);
+
+    void increment(Counter counter);
+
+    std::uint64_t get_count(Counter counter);
+
+    /// <summary>
+    /// Whether to print the time spent in each phase on exit, as asked for by --x-phase-timings.
+    /// </summary>
+    extern std::atomic<bool> g_print_summary;
+
+    struct Totals
+    {
+        std::chrono::nanoseconds elapsed;
+        std::uint64_t count;
+    };
+
+    Totals get_totals(Phase phase);
+
+    /// <summary>
+    /// Adds the time from its construction to its destruction to a phase, on any thread. Time spent in a scope
+    /// nested on the same thread counts only towards the inner phase, so that the totals never overlap: the
+    /// processes spawned while hashing count as child processes, not as hashing.
+    /// </summary>
+    struct Scope
+    {
+        explicit Scope(Phase phase);
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+        ~Scope();
+
+    private:
+        using clock = std::chrono::steady_clock;
+
+        Phase m_phase;
+        Scope* m_outer;
+        clock::time_point m_resumed;
+        clock::duration m_elapsed;
+    };
+
+    /// <summary>
+    /// Prints the totals of every phase, and the wall-clock time since startup that none of them account for. The
+    /// totals add up the time of every thread, so with phases running in parallel they may exceed the wall clock.
+    /// Counters follow, leaving out those that never moved.
+    /// </summary>
+    void print_summary(std::chrono::nanoseconds wall_time);
+}
@@ -5,10 +5,18 @@
 #include <vcpkg/base/stringview.h>
 #include <vcpkg/base/zstringview.h>
 
+#include <chrono>
+#include <cstdint>
+
 namespace vcpkg::System
 {
     Optional<std::string> get_environment_variable(ZStringView varname) noexcept;
 
+    /// <summary>
+    /// Sets a variable of this process's environment, which child processes inherit; nullopt removes it.
+    /// </summary>
+    void set_environment_variable(ZStringView varname, Optional<std::string> value) noexcept;
+
     Optional<std::string> get_registry_string(void* base_hkey, StringView subkey, StringView valuename);
 
     enum class CPUArchitecture
@@ -30,4 +38,30 @@ namespace vcpkg::System
     const Optional<fs::path>& get_program_files_platform_bitness();
 
     int get_num_logical_cores();
+
+    std::string get_host_name();
+
+    int get_process_id();
+
+    /// <summary>
+    /// Whether a process with the given id runs on this host.
+    /// </summary>
+    bool is_process_running(int process_id);
+
+    /// <summary>
+    /// Resources used by one child process and the descendants it waited for. CPU time is summed. On Linux,
+    /// peak_rss_kb is the largest total resident set of the whole process tree, sampled from /proc every 250ms while
+    /// it runs; pages shared between processes count once per process. Elsewhere it is only the largest peak of any
+    /// single process among them, which understates a build running several compilers at once.
+    /// </summary>
+    struct ChildResourceUsage
+    {
+        std::chrono::milliseconds cpu_time;
+        std::uint64_t peak_rss_kb;
+    };
+
+    /// <summary>
+    /// Physical memory that can be handed to new processes without swapping. Not available on macOS and the BSDs.
+    /// </summary>
+    Optional<std::uint64_t> get_available_memory_kb();
 }
@@ -1,8 +1,11 @@
 #pragma once
 
 #include <vcpkg/base/files.h>
+#include <vcpkg/base/system.h>
 #include <vcpkg/base/zstringview.h>
 
+#include <cstdint>
+#include <functional>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -30,10 +33,60 @@ namespace vcpkg::System
         std::string output;
     };
 
+    /// <summary>
+    /// A GNU make jobserver: a pipe holding one token for every job beyond the first that may run at once. Builds
+    /// started with its environment() draw from one shared budget however many of them run together. When vcpkg
+    /// itself runs under a jobserver, for example as a recipe of `make -j`, builds join that one instead.
+    /// </summary>
+    struct Jobserver
+    {
+        explicit Jobserver(int jobs);
+
+        /// <summary>
+        /// Joins the jobserver kept in the named pipe `fifo`, which every process on this host naming the same path
+        /// shares, and fills it with `jobs` jobs if no process has it open. Where there are no named pipes, this is
+        /// Jobserver(jobs).
+        /// </summary>
+        Jobserver(int jobs, const fs::path& fifo);
+
+        Jobserver(const Jobserver&) = delete;
+        Jobserver& operator=(const Jobserver&) = delete;
+        ~Jobserver();
+
+        /// <summary>
+        /// Variables that hand the jobserver to make, and to Ninja versions that understand it, and the job count
+        /// to `cmake --build`.
+        /// </summary>
+        const std::unordered_map<std::string, std::string>& environment() const { return m_environment; }
+
+    private:
+        bool join_inherited();
+        void create_pipe(int jobs);
+        bool fill(int jobs);
+        void hand_out();
+
+        int m_read_fd = -1;
+        int m_write_fd = -1;
+        std::unordered_map<std::string, std::string> m_environment;
+    };
+
+    /// <summary>
+    /// Runs cmd_line with a minimal environment on Windows and the inherited one elsewhere, plus extra_env; PATH in
+    /// extra_env is appended to the search path and prepend_to_path is put in front of it. Returns the exit code.
+    /// </summary>
     int cmd_execute_clean(const ZStringView cmd_line,
                           const std::unordered_map<std::string, std::string>& extra_env = {},
                           const std::string& prepend_to_path = {});
 
+    /// <summary>
+    /// Like cmd_execute_clean() above, and also reports what the command and its descendants used. `usage` is left
+    /// empty on Windows.
+    /// </summary>
+    int cmd_execute_clean(const ZStringView cmd_line,
+                          const std::unordered_map<std::string, std::string>& extra_env,
+                          const std::string& prepend_to_path,
+                          Optional<ChildResourceUsage>& usage);
+
     int cmd_execute(const ZStringView cmd_line);
 
 #if defined(_WIN32)
@@ -42,5 +95,17 @@ namespace vcpkg::System
 
     ExitCodeAndOutput cmd_execute_and_capture_output(const ZStringView cmd_line);
 
+    /// <summary>
+    /// Runs the command and passes its standard output to `data_cb` chunk by chunk, as it arrives.
+    /// Returns the exit code of the command.
+    /// </summary>
+    int cmd_execute_and_stream_data(const ZStringView cmd_line, const std::function<void(StringView)>& data_cb);
+
     void register_console_ctrl_handler();
+
+    /// <summary>
+    /// Changes whenever a child process started by one of the functions above starts or finishes, so that anything
+    /// remembering the state of files can tell that a child may have changed them since.
+    /// </summary>
+    std::uint64_t get_child_process_generation();
 }
@@ -8,12 +8,18 @@
 #include <vcpkg/vcpkgpaths.h>
 
 #include <vcpkg/base/cstringview.h>
+#include <vcpkg/base/downloads.h>
 #include <vcpkg/base/files.h>
 #include <vcpkg/base/optional.h>
+#include <vcpkg/base/system.h>
 
 #include <array>
+#include <condition_variable>
+#include <deque>
 #include <map>
+#include <mutex>
 #include <set>
+#include <thread>
 #include <vector>
 
 namespace vcpkg::Build
@@ -151,6 +157,11 @@ namespace vcpkg::Build
 
     std::string make_build_env_cmd(const PreBuildInfo& pre_build_info, const Toolset& toolset);
 
+    /// <summary>
+    /// Jobs each build may run at once: VCPKG_MAX_CONCURRENCY, or one more than there are logical cores.
+    /// </summary>
+    int get_concurrency();
+
     enum class VcpkgTripletVar
     {
         TARGET_ARCHITECTURE = 0,
@@ -185,8 +196,70 @@ namespace vcpkg::Build
         BuildResult code;
         std::vector<FeatureSpec> unmet_dependencies;
         std::unique_ptr<BinaryControlFile> binary_control_file;
+        bool restored_from_cache = false;
+        /// <summary>
+        /// What the port's build process used, where it ran and the platform reports it
+        /// </summary>
+        Optional<System::ChildResourceUsage> resource_usage;
+    };
+
+    /// <summary>
+    /// Compresses built packages and stores them in the binary cache on a background thread, so that the next package
+    /// can start building meanwhile. A single worker keeps at most one temporary archive on disk, and enqueue() blocks
+    /// while `max_pending` packages are waiting to be stored.
+    /// </summary>
+    struct ArchiveUploadQueue
+    {
+        explicit ArchiveUploadQueue(const VcpkgPaths& paths, size_t max_pending = 4);
+        ArchiveUploadQueue(const ArchiveUploadQueue&) = delete;
+        ArchiveUploadQueue& operator=(const ArchiveUploadQueue&) = delete;
+        ~ArchiveUploadQueue();
+
+        void enqueue(const PackageSpec& spec, const fs::path& archive_path);
+
+        /// <summary>
+        /// Remove the package directory of `spec` once its archive has been stored.
+        /// Returns false if no upload of `spec` is outstanding; the caller then owns the removal.
+        /// </summary>
+        bool remove_package_dir_after_upload(const PackageSpec& spec);
+
+        /// <summary>
+        /// Wait for every outstanding upload. Returns a warning for each one that failed.
+        /// </summary>
+        std::vector<std::string> drain();
+
+        /// <summary>
+        /// Wait for the uploads of every live queue and print their warnings. The shutdown handler calls this, so that
+        /// exiting through Checks::exit_fail still stores the packages that were already built instead of tearing down
+        /// the process under a running upload.
+        /// </summary>
+        static void drain_all();
+
+    private:
+        struct Upload
+        {
+            PackageSpec spec;
+            fs::path archive_path;
+            std::string compress_cmd;
+            bool remove_package_dir;
+        };
+
+        void run();
+
+        const VcpkgPaths& m_paths;
+        size_t m_max_pending;
+
+        std::mutex m_mutex;
+        std::condition_variable m_cv;
+        // the front element is the upload in progress
+        std::deque<Upload> m_uploads;
+        std::vector<std::string> m_warnings;
+        bool m_stopping = false;
+        std::thread m_worker;
     };
 
+    struct PrecomputedAbi;
+
     struct BuildPackageConfig
     {
         BuildPackageConfig(const SourceControlFileLocation& scfl,
@@ -218,12 +291,36 @@ namespace vcpkg::Build
         const std::unordered_map<std::string, std::vector<FeatureSpec>>& feature_dependencies;
         const std::vector<PackageSpec>& package_dependencies;
         const std::vector<std::string>& feature_list;
+
+        /// <summary>
+        /// Set when the binary cache archive for this ABI tag was already restored into packages/
+        /// </summary>
+        Optional<const std::string&> prefetched_abi_tag;
+
+        /// <summary>
+        /// Set when the ABI tag was computed before the build loop started, so that it need not be hashed again
+        /// </summary>
+        Optional<const PrecomputedAbi&> precomputed_abi;
+
+        /// <summary>
+        /// When set, successful builds are stored in the binary cache asynchronously through this queue
+        /// </summary>
+        Optional<ArchiveUploadQueue&> archive_uploads;
     };
 
     ExtendedBuildResult build_package(const VcpkgPaths& paths,
                                       const BuildPackageConfig& config,
                                       const StatusParagraphs& status_db);
 
+    /// <summary>
+    /// Run the portfiles in capture mode, several at once, and collect the distfiles they request instead of letting
+    /// CMake download them. Capture mode never touches packages/, runs a process or acquires a tool: a portfile halts
+    /// at the first of these, so distfiles requested after that point are still downloaded by the build itself. Ports
+    /// that fail before halting are reported as warnings.
+    /// </summary>
+    std::vector<Downloads::DownloadRequest> capture_distfiles(const VcpkgPaths& paths,
+                                                              const std::vector<BuildPackageConfig>& configs);
+
     enum class BuildPolicy
     {
         EMPTY_PACKAGE,
@@ -231,6 +328,8 @@ namespace vcpkg::Build
         ONLY_RELEASE_CRT,
         EMPTY_INCLUDE_FOLDER,
         ALLOW_OBSOLETE_MSVCRT,
+        ALLOW_ABSOLUTE_RPATH,
+        ALLOW_MISSING_SONAME,
         // Must be last
         COUNT,
     };
@@ -241,6 +340,8 @@ namespace vcpkg::Build
         BuildPolicy::ONLY_RELEASE_CRT,
         BuildPolicy::EMPTY_INCLUDE_FOLDER,
         BuildPolicy::ALLOW_OBSOLETE_MSVCRT,
+        BuildPolicy::ALLOW_ABSOLUTE_RPATH,
+        BuildPolicy::ALLOW_MISSING_SONAME,
     };
 
     const std::string& to_string(BuildPolicy policy);
@@ -294,6 +395,8 @@ namespace vcpkg::Build
         {
             return key < other.key || (key == other.key && value < other.value);
         }
+
+        bool operator==(const AbiEntry& other) const { return key == other.key && value == other.value; }
     };
 
     struct AbiTagAndFile
@@ -302,8 +405,27 @@ namespace vcpkg::Build
         fs::path tag_file;
     };
 
+    /// <summary>
+    /// An ABI tag computed ahead of the build, from the ABIs its dependencies were expected to be installed with
+    /// </summary>
+    struct PrecomputedAbi
+    {
+        AbiTagAndFile tag_and_file;
+        std::vector<AbiEntry> dependency_abis;
+    };
+
     Optional<AbiTagAndFile> compute_abi_tag(const VcpkgPaths& paths,
                                             const BuildPackageConfig& config,
                                             const PreBuildInfo& pre_build_info,
                                             Span<const AbiEntry> dependency_abis);
+
+    fs::path get_archive_path(const VcpkgPaths& paths, const std::string& abi_tag);
+    fs::path get_archive_tombstone_path(const VcpkgPaths& paths, const std::string& abi_tag);
+
+    /// <summary>
+    /// Extract binary cache archives into the package directories of their specs, several at a time.
+    /// Returns the exit code of each extraction, in the order of the input.
+    /// </summary>
+    std::vector<int> decompress_archives(const VcpkgPaths& paths,
+                                         const std::vector<std::pair<PackageSpec, fs::path>>& archives);
 }
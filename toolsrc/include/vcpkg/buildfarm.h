@@ -0,0 +1,207 @@
+#pragma once
+
+#include <vcpkg/base/files.h>
+#include <vcpkg/base/optional.h>
+#include <vcpkg/base/system.h>
+#include <vcpkg/build.h>
+#include <vcpkg/dependencies.h>
+#include <vcpkg/install.h>
+#include <vcpkg/packagespec.h>
+#include <vcpkg/vcpkgcmdarguments.h>
+#include <vcpkg/vcpkgpaths.h>
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace vcpkg::BuildFarm
+{
+    struct WorkItem
+    {
+        PackageSpec spec;
+        std::vector<std::string> features;
+
+        /// <summary>
+        /// How many times the coordinator has queued the item, counting this one.
+        /// </summary>
+        int attempt = 1;
+
+        /// <summary>
+        /// Names the claim a worker took the item under, made of the item, its attempt and the worker. Empty unless
+        /// the item came from claim().
+        /// </summary>
+        std::string claim_token;
+    };
+
+    struct WorkResult
+    {
+        PackageSpec spec;
+        Build::BuildResult result;
+        std::chrono::milliseconds duration;
+        bool restored_from_cache = false;
+
+        /// <summary>
+        /// Peak memory of the build as recorded in the build history, when the worker measured one.
+        /// </summary>
+        Optional<std::uint64_t> peak_rss_kb;
+    };
+
+    /// <summary>
+    /// A directory through which one coordinator hands builds out to any number of worker processes, on this host
+    /// or on others sharing the filesystem. Items wait in pending/ until a worker claims one by renaming it into
+    /// claimed/ under its claim token; the rename is atomic, so exactly one worker wins each item. While building,
+    /// the worker keeps rewriting its lease in leases/; a claim whose lease stops changing belongs to a worker that
+    /// died or lost the filesystem, and the coordinator takes it back. Workers report into done/. Leases, results and
+    /// their temporary names are filed under the claim token, so a worker whose claim was taken back cannot renew
+    /// or complete the claim of the worker building the item next. Every file is written under a temporary name first
+    /// and renamed into place, so nobody reads a partial file.
+    /// </summary>
+    struct QueueDirectory
+    {
+        /// <summary>
+        /// Workers renew the lease on the item they build this often.
+        /// </summary>
+        static constexpr std::chrono::seconds HEARTBEAT_INTERVAL{15};
+
+        QueueDirectory(Files::Filesystem& fs, fs::path root);
+
+        /// <summary>
+        /// Coordinator: drops everything left by an earlier run and opens the queue to workers.
+        /// </summary>
+        void reset();
+
+        /// <summary>
+        /// Coordinator: makes an item available to workers. Its dependencies must already be in the binary cache.
+        /// </summary>
+        void push(const WorkItem& item);
+
+        /// <summary>
+        /// Coordinator: results reported since the last call, each returned once.
+        /// </summary>
+        std::vector<WorkResult> take_results();
+
+        /// <summary>
+        /// Coordinator: takes back the claimed items whose lease has not been renewed for lease_timeout, so that they
+        /// can be pushed again. Leases are compared by contents as seen over successive calls rather than by
+        /// timestamps, so the clocks of other hosts do not matter; a claim first seen by this call starts its lease.
+        /// </summary>
+        std::vector<WorkItem> take_expired(std::chrono::milliseconds lease_timeout);
+
+        /// <summary>
+        /// Coordinator: tells workers no more items will come.
+        /// </summary>
+        void close();
+
+        /// <summary>
+        /// Worker: takes a pending item, if there is one.
+        /// </summary>
+        Optional<WorkItem> claim();
+
+        /// <summary>
+        /// Worker: renews the lease on a claimed item. May be called from a thread of its own; failures are ignored,
+        /// as the next renewal may succeed.
+        /// </summary>
+        void renew(const WorkItem& item);
+
+        /// <summary>
+        /// Worker: reports the result of a claimed item, and gives up the claim.
+        /// </summary>
+        void complete(const WorkItem& item, const WorkResult& result);
+
+        bool is_closed() const;
+
+        /// <summary>
+        /// Worker: a directory shared by the workers running on the given host. Unlike the rest of the queue it
+        /// survives reset(), as workers may outlive a run.
+        /// </summary>
+        fs::path host_dir(const std::string& host_name) const;
+
+    private:
+        struct Lease
+        {
+            std::string contents;
+            std::chrono::steady_clock::time_point renewed;
+        };
+
+        void publish(const std::string& contents, const fs::path& destination);
+
+        Files::Filesystem& m_fs;
+        fs::path m_root;
+        fs::path m_pending;
+        fs::path m_claimed;
+        fs::path m_leases;
+        fs::path m_done;
+        fs::path m_incoming;
+        fs::path m_closed_marker;
+
+        // Coordinator: the lease of each claimed file name as last seen
+        std::map<std::string, Lease> m_seen_leases;
+    };
+
+    /// <summary>
+    /// Limits on how much memory the builds in flight may use together. Zero disables a limit.
+    /// </summary>
+    struct MemoryBudget
+    {
+        /// <summary>
+        /// Sum of the predicted peaks of all builds in flight that a new build may not push past.
+        /// </summary>
+        std::uint64_t budget_kb = 0;
+
+        /// <summary>
+        /// No build is started while less memory than this is available on this host.
+        /// </summary>
+        std::uint64_t min_available_kb = 0;
+
+        /// <summary>
+        /// Predicted peak resident set of each build; builds without a prediction count as needing none.
+        /// </summary>
+        std::map<PackageSpec, std::uint64_t> predicted_peak_kb;
+
+        std::function<Optional<std::uint64_t>()> available_memory_kb = System::get_available_memory_kb;
+
+        /// <summary>
+        /// Whether a build predicted to peak at candidate_kb may start next to in_flight_count builds predicted to
+        /// peak at in_flight_kb together. A build always starts when nothing else is in flight, even if it alone
+        /// exceeds the budget, so that every plan finishes.
+        /// </summary>
+        bool admits(std::uint64_t candidate_kb, std::uint64_t in_flight_kb, size_t in_flight_count) const;
+    };
+
+    /// <summary>
+    /// How long a worker may go without renewing its lease before the coordinator takes its item back.
+    /// </summary>
+    constexpr std::chrono::milliseconds DEFAULT_LEASE_TIMEOUT = std::chrono::minutes(2);
+
+    /// <summary>
+    /// An item taken back from workers this many times fails instead of being queued again.
+    /// </summary>
+    constexpr int MAX_CLAIMS = 3;
+
+    /// <summary>
+    /// Runs the install actions of a plan on workers attached to queue, queueing each as soon as everything it
+    /// depends on has been built and it fits in the memory budget, and waits for all of them. Actions depending on a
+    /// failed one are not queued. An item whose lease expires is queued again, and fails once MAX_CLAIMS workers have
+    /// lost it. The builds reported by workers are appended to the build history of paths, like those of a local
+    /// install. Leaves the queue open for further plans.
+    /// </summary>
+    Install::InstallSummary coordinate(std::vector<Dependencies::AnyAction>& action_plan,
+                                       const VcpkgPaths& paths,
+                                       QueueDirectory& queue,
+                                       const MemoryBudget& memory = {},
+                                       std::chrono::milliseconds lease_timeout = DEFAULT_LEASE_TIMEOUT);
+
+    /// <summary>
+    /// Claims and builds items until the coordinator closes the queue. Each item is installed by a child vcpkg process
+    /// into installed/, packages/ and buildtrees/ under worker_root with binary caching on, which restores the
+    /// item's dependencies from the binary cache and publishes the item to it. The workers of one host share a
+    /// jobserver kept in their host_dir(), and each build is allowed an even share of its jobs.
+    /// </summary>
+    void run_worker(const VcpkgCmdArguments& args,
+                    const VcpkgPaths& paths,
+                    QueueDirectory& queue,
+                    const fs::path& worker_root);
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <vcpkg/base/files.h>
+#include <vcpkg/base/optional.h>
+#include <vcpkg/build.h>
+#include <vcpkg/packagespec.h>
+
+#include <chrono>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace vcpkg::BuildHistory
+{
+    struct BuildRecord
+    {
+        PackageSpec spec;
+        std::chrono::milliseconds duration;
+
+        std::string abi;
+        std::vector<std::string> features;
+        Build::BuildResult result = Build::BuildResult::SUCCEEDED;
+        bool restored_from_cache = false;
+
+        /// <summary>
+        /// CPU time used by the processes the build started.
+        /// </summary>
+        Optional<std::chrono::milliseconds> cpu_time;
+
+        /// <summary>
+        /// Peak memory of the build, as System::ChildResourceUsage measures it: the processes it runs together on
+        /// Linux, the largest single one elsewhere.
+        /// </summary>
+        Optional<std::uint64_t> peak_rss_kb;
+
+        /// <summary>
+        /// Identifies the run that appended this record; runs sort in the order they happened. Set on load.
+        /// </summary>
+        std::string run;
+
+        /// <summary>
+        /// Whether this record measures a build from source that succeeded, i.e. is usable for predictions.
+        /// </summary>
+        bool is_successful_build() const
+        {
+            return result == Build::BuildResult::SUCCEEDED && !restored_from_cache;
+        }
+    };
+
+    /// <summary>
+    /// Past builds, read from installed/vcpkg/history. Every run appends one file of records, so the directory
+    /// only ever grows and concurrent runs never write to the same file.
+    /// </summary>
+    struct BuildHistory
+    {
+        static BuildHistory load(const Files::Filesystem& fs, const fs::path& history_dir);
+
+        /// <summary>
+        /// Average of the most recent successful builds of spec, or of the same port on other triplets if spec
+        /// itself has never been built.
+        /// </summary>
+        Optional<std::chrono::milliseconds> predict_duration(const PackageSpec& spec) const;
+
+        /// <summary>
+        /// Largest peak resident set among the most recent successful builds of spec, or of the same port on other
+        /// triplets if spec itself has never been built. The largest rather than the average, since running short of
+        /// memory costs far more than leaving some unused.
+        /// </summary>
+        Optional<std::uint64_t> predict_peak_rss_kb(const PackageSpec& spec) const;
+
+        /// <summary>
+        /// Records in the order they were appended.
+        /// </summary>
+        const std::vector<BuildRecord>& records() const { return m_records; }
+
+    private:
+        std::vector<BuildRecord> m_records;
+        std::unordered_map<PackageSpec, std::vector<size_t>> m_by_spec;
+        std::unordered_map<std::string, std::vector<size_t>> m_by_name;
+    };
+
+    void append_records(Files::Filesystem& fs, const fs::path& history_dir, const std::vector<BuildRecord>& records);
+
+    struct Regression
+    {
+        PackageSpec spec;
+        std::chrono::milliseconds previous;
+        std::chrono::milliseconds latest;
+    };
+
+    /// <summary>
+    /// Specs whose latest successful build took more than threshold_percent longer, and at least min_increase
+    /// longer, than their successful build in an earlier run. Largest increase first.
+    /// </summary>
+    std::vector<Regression> find_regressions(const BuildHistory& history,
+                                             int threshold_percent,
+                                             std::chrono::milliseconds min_increase);
+
+    /// <summary>
+    /// Inclusive nearest-rank percentile of durations, which must not be empty. Reorders durations.
+    /// </summary>
+    std::chrono::milliseconds percentile(std::vector<std::chrono::milliseconds>& durations, int percent);
+}
@@ -9,6 +9,7 @@
 #include <vcpkg/statusparagraphs.h>
 #include <vcpkg/vcpkgpaths.h>
 
+#include <cstdint>
 #include <functional>
 #include <vector>
 
@@ -67,6 +68,17 @@ namespace vcpkg::Dependencies
         std::vector<PackageSpec> package_dependencies;
 
         std::vector<std::string> feature_list;
+
+        /// <summary>
+        /// ABI tag whose binary cache archive was restored into packages/ before the build loop started
+        /// </summary>
+        Optional<std::string> prefetched_abi_tag;
+
+        /// <summary>
+        /// ABI tag computed while prefetching binary caches, which the build reuses if the dependencies were
+        /// installed with the ABIs it was computed from
+        /// </summary>
+        Optional<Build::PrecomputedAbi> precomputed_abi;
     };
 
     enum class RemovePlanType
@@ -130,6 +142,7 @@ namespace vcpkg::Dependencies
 
     struct ClusterGraph;
     struct GraphPlan;
+    struct ClusterFeature;
 
     struct CreateInstallPlanOptions
     {
@@ -172,9 +185,9 @@ namespace vcpkg::Dependencies
 
         std::vector<AnyAction> serialize(const CreateInstallPlanOptions& options = {}) const;
 
-        std::vector<FeatureSpec> graph_removals(const PackageSpec& spec);
-        std::vector<FeatureSpec> graph_installs(const PackageSpec& spec,
-                                                const std::vector<FeatureSpec>& new_dependencies);
+        std::vector<ClusterFeature> graph_removals(std::uint32_t cluster);
+        std::vector<ClusterFeature> graph_installs(std::uint32_t cluster,
+                                                   const std::vector<ClusterFeature>& new_dependencies);
 
         const CMakeVars::CMakeVarProvider& m_var_provider;
 
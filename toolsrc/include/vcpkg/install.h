@@ -4,6 +4,7 @@
 #include <vcpkg/build.h>
 #include <vcpkg/dependencies.h>
 #include <vcpkg/vcpkgcmdarguments.h>
+#include <vcpkg/vcpkglib.h>
 #include <vcpkg/vcpkgpaths.h>
 
 #include <vector>
@@ -35,8 +36,10 @@ namespace vcpkg::Install
     {
         std::vector<SpecSummary> results;
         std::string total_elapsed_time;
+        std::vector<std::string> warnings;
 
         void print() const;
+        void print_warnings() const;
         std::string xunit_results() const;
     };
 
@@ -60,7 +63,8 @@ namespace vcpkg::Install
     Build::ExtendedBuildResult perform_install_plan_action(const VcpkgPaths& paths,
                                                            Dependencies::InstallPlanAction& action,
                                                            StatusParagraphs& status_db,
-                                                           const CMakeVars::CMakeVarProvider& var_provider);
+                                                           const CMakeVars::CMakeVarProvider& var_provider,
+                                                           Build::ArchiveUploadQueue& archive_uploads);
 
     enum class InstallResult
     {
@@ -71,6 +75,17 @@ namespace vcpkg::Install
     std::vector<std::string> get_all_port_names(const VcpkgPaths& paths);
 
     void install_files_and_write_listfile(Files::Filesystem& fs, const fs::path& source_dir, const InstallDir& dirs);
+
+    /// <summary>
+    /// The files of the package in package_dir that packages installed for the same triplet already own, each paired
+    /// with the display name of its owner and sorted by owner.
+    /// </summary>
+    std::vector<std::pair<std::string, std::string>> find_file_conflicts(
+        const Files::Filesystem& fs,
+        const fs::path& package_dir,
+        const Triplet& triplet,
+        const std::vector<StatusParagraphAndAssociatedFiles>& installed_files);
+
     InstallResult install_package(const VcpkgPaths& paths,
                                   const BinaryControlFile& binary_paragraph,
                                   StatusParagraphs* status_db);
@@ -6,6 +6,44 @@
 
 namespace vcpkg
 {
+    struct NameInstance;
+
+    ///
+    /// <summary>
+    /// Name of a port or a feature. Like Triplet, names are interned in a process-wide pool, so copies are
+    /// pointer-sized and equality and hashing don't look at the characters.
+    /// </summary>
+    ///
+    struct InternedName
+    {
+        /// <summary>
+        /// The empty name. It has no pool entry, so a default-constructed name needs no initialization at runtime.
+        /// </summary>
+        constexpr InternedName() noexcept : m_instance(nullptr) {}
+
+        static InternedName from_string(const std::string& name);
+
+        const std::string& to_string() const;
+        size_t hash_code() const;
+
+        bool operator==(const InternedName& other) const { return m_instance == other.m_instance; }
+        bool operator!=(const InternedName& other) const { return m_instance != other.m_instance; }
+
+        /// <summary>
+        /// Alphabetical, because sorted output and the numbering of ports for sharding depend on it. Containers
+        /// which are only searched should hash instead, which compares pointers.
+        /// </summary>
+        bool operator<(const InternedName& other) const
+        {
+            return m_instance != other.m_instance && to_string() < other.to_string();
+        }
+
+    private:
+        constexpr InternedName(const NameInstance* ptr) : m_instance(ptr) {}
+
+        const NameInstance* m_instance;
+    };
+
     struct ParsedSpecifier
     {
         std::string name;
@@ -37,15 +75,16 @@ namespace vcpkg
         std::string to_string() const;
         void to_string(std::string& s) const;
 
+        const InternedName& interned_name() const { return m_name; }
+
         bool operator<(const PackageSpec& other) const
         {
-            if (name() < other.name()) return true;
-            if (name() > other.name()) return false;
+            if (m_name != other.m_name) return m_name < other.m_name;
             return triplet() < other.triplet();
         }
 
     private:
-        std::string m_name;
+        InternedName m_name;
         Triplet m_triplet;
     };
 
@@ -57,13 +96,17 @@ namespace vcpkg
     ///
     struct FeatureSpec
     {
-        FeatureSpec(const PackageSpec& spec, const std::string& feature) : m_spec(spec), m_feature(feature) {}
+        FeatureSpec(const PackageSpec& spec, const std::string& feature)
+            : m_spec(spec), m_feature(InternedName::from_string(feature))
+        {
+        }
 
         const std::string& name() const { return m_spec.name(); }
-        const std::string& feature() const { return m_feature; }
+        const std::string& feature() const { return m_feature.to_string(); }
         const Triplet& triplet() const { return m_spec.triplet(); }
 
         const PackageSpec& spec() const { return m_spec; }
+        const InternedName& interned_feature() const { return m_feature; }
 
         std::string to_string() const;
         void to_string(std::string& out) const;
@@ -73,23 +116,23 @@ namespace vcpkg
 
         bool operator<(const FeatureSpec& other) const
         {
-            if (name() < other.name()) return true;
-            if (name() > other.name()) return false;
-            if (feature() < other.feature()) return true;
-            if (feature() > other.feature()) return false;
+            if (m_spec.interned_name() != other.m_spec.interned_name())
+                return m_spec.interned_name() < other.m_spec.interned_name();
+            if (m_feature != other.m_feature) return m_feature < other.m_feature;
             return triplet() < other.triplet();
         }
 
         bool operator==(const FeatureSpec& other) const
         {
-            return triplet() == other.triplet() && name() == other.name() && feature() == other.feature();
+            return m_feature == other.m_feature && m_spec.interned_name() == other.m_spec.interned_name() &&
+                   triplet() == other.triplet();
         }
 
         bool operator!=(const FeatureSpec& other) const { return !(*this == other); }
 
     private:
         PackageSpec m_spec;
-        std::string m_feature;
+        InternedName m_feature;
     };
 
     ///
@@ -129,13 +172,19 @@ namespace vcpkg
 
 namespace std
 {
+    template<>
+    struct hash<vcpkg::InternedName>
+    {
+        size_t operator()(const vcpkg::InternedName& name) const { return name.hash_code(); }
+    };
+
     template<>
     struct hash<vcpkg::PackageSpec>
     {
         size_t operator()(const vcpkg::PackageSpec& value) const
         {
             size_t hash = 17;
-            hash = hash * 31 + std::hash<std::string>()(value.name());
+            hash = hash * 31 + value.interned_name().hash_code();
             hash = hash * 31 + std::hash<vcpkg::Triplet>()(value.triplet());
             return hash;
         }
@@ -153,7 +202,7 @@ namespace std
         size_t operator()(const vcpkg::FeatureSpec& value) const
         {
             size_t hash = std::hash<vcpkg::PackageSpec>()(value.spec());
-            hash = hash * 31 + std::hash<std::string>()(value.feature());
+            hash = hash * 31 + std::hash<vcpkg::InternedName>()(value.interned_feature());
             return hash;
         }
     };
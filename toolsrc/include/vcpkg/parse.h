@@ -13,6 +13,7 @@ namespace vcpkg::Parse
         std::string name;
         std::vector<std::string> missing_fields;
         std::vector<std::string> extra_fields;
+        std::vector<std::string> invalid_fields;
         std::error_code error;
     };
 
@@ -27,11 +28,13 @@ namespace vcpkg::Parse
 
         void required_field(const std::string& fieldname, std::string& out);
         std::string optional_field(const std::string& fieldname) const;
+        void invalid_field(const std::string& fieldname);
         std::unique_ptr<ParseControlErrorInfo> error_info(const std::string& name) const;
 
     private:
         RawParagraph&& fields;
         std::vector<std::string> missing_fields;
+        std::vector<std::string> invalid_fields;
     };
 
     std::vector<std::string> parse_comma_list(const std::string& str);
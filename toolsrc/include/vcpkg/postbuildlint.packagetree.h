@@ -0,0 +1,81 @@
+#pragma once
+
+#include <vcpkg/base/files.h>
+#include <vcpkg/base/stringview.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace vcpkg::PostBuildLint
+{
+    enum class FileClass
+    {
+        OTHER,
+        LIB,
+        DLL,
+        EXE,
+        CMAKE,
+        IFC,
+        /// <summary>
+        /// .so, and versioned names like .so.1.2
+        /// </summary>
+        SHARED_OBJECT,
+        STATIC_ARCHIVE,
+    };
+
+    struct PackageTreeEntry
+    {
+        fs::path path;
+        /// <summary>
+        /// Path below the package directory, with '/' separators.
+        /// </summary>
+        std::string relative_path;
+        bool is_directory = false;
+        /// <summary>
+        /// Set only for directories that were walked, not for links to directories.
+        /// </summary>
+        bool is_walked_directory = false;
+        bool is_symlink = false;
+        /// <summary>
+        /// Only filled in for binaries.
+        /// </summary>
+        std::uintmax_t size = 0;
+        FileClass file_class = FileClass::OTHER;
+        size_t child_count = 0;
+    };
+
+    /// <summary>
+    /// Everything below a package directory, read in a single walk so that the post-build checks do not each walk
+    /// the tree again.
+    /// </summary>
+    struct PackageTree
+    {
+        static PackageTree scan(const Files::Filesystem& fs, const fs::path& package_dir);
+
+        const fs::path& package_dir() const { return m_package_dir; }
+        const std::vector<PackageTreeEntry>& entries() const { return m_entries; }
+
+        bool exists(StringView relative_path) const;
+        bool is_empty_directory(StringView relative_path) const;
+
+        /// <summary>
+        /// Files of a class anywhere below relative_dir.
+        /// </summary>
+        std::vector<fs::path> files_below(StringView relative_dir, FileClass file_class) const;
+
+        /// <summary>
+        /// Non-directories directly in relative_dir; an empty relative_dir means the package directory.
+        /// </summary>
+        std::vector<fs::path> files_directly_in(StringView relative_dir) const;
+
+        std::vector<fs::path> empty_directories() const;
+
+    private:
+        fs::path m_package_dir;
+        /// <summary>
+        /// Sorted by relative path.
+        /// </summary>
+        std::vector<PackageTreeEntry> m_entries;
+    };
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <vcpkg/base/graphs.h>
+#include <vcpkg/base/optional.h>
+#include <vcpkg/base/stringview.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace vcpkg::Sharding
+{
+    struct ShardIndex
+    {
+        /// <summary>
+        /// Zero-based index of this shard.
+        /// </summary>
+        size_t index;
+        size_t count;
+    };
+
+    /// <summary>
+    /// Parses "i/N" as written on the command line, where i counts from 1 up to N.
+    /// </summary>
+    Optional<ShardIndex> parse_shard(StringView text);
+
+    /// <summary>
+    /// Splits the vertices of a frozen graph, whose edges point from each package to its dependencies, between
+    /// shard_count shards. Every vertex is owned by exactly one shard; a shard installs its own vertices and all
+    /// of their dependencies, so dependencies owned elsewhere may be built more than once unless they arrive
+    /// through the binary cache.
+    ///
+    /// Vertices are handed out largest dependency closure first, each to the shard whose load grows least by
+    /// taking it, so shared dependencies tend to stay together. The result depends only on the graph and the
+    /// costs, so every machine computes the same split.
+    /// </summary>
+    std::vector<size_t> assign_owners(const Graphs::CsrGraph& graph,
+                                      const std::vector<std::uint64_t>& costs,
+                                      size_t shard_count);
+
+    /// <summary>
+    /// Per vertex, whether the given shard has to install it: it owns the vertex or one of the vertex's
+    /// dependents.
+    /// </summary>
+    std::vector<bool> shard_closure(const Graphs::CsrGraph& graph, const std::vector<size_t>& owners, size_t shard);
+
+    /// <summary>
+    /// Combines the documents written by `ci --x-xunit` on each shard into one. Tests of collections with the same
+    /// name are concatenated, and each collection and the assembly keep the longest time of any shard.
+    /// </summary>
+    std::string merge_xunit(const std::vector<std::string>& documents);
+}
@@ -74,6 +74,12 @@ namespace vcpkg
         std::vector<Dependency> depends;
         std::vector<std::string> default_features;
         Type type;
+
+        /// <summary>
+        /// Hint from the Peak-Memory-Mb field for ports whose builds need a lot of memory, used until the build
+        /// history knows better.
+        /// </summary>
+        Optional<std::uint64_t> peak_memory_mb;
     };
 
     /// <summary>
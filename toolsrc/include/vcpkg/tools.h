@@ -1,7 +1,9 @@
 #pragma once
 
 #include <vcpkg/base/files.h>
+#include <vcpkg/base/optional.h>
 
+#include <map>
 #include <string>
 #include <utility>
 
@@ -18,4 +20,44 @@ namespace vcpkg
     };
 
     std::unique_ptr<ToolCache> get_tool_cache();
+
+    struct PathAndVersion
+    {
+        fs::path path;
+        std::string version;
+    };
+
+    /// <summary>
+    /// The tools found by earlier runs, so that later ones need not run every candidate to learn its version. Each
+    /// is trusted only while its executable keeps the size and modification time it had when found, and all of them
+    /// only while PATH and vcpkgTools.xml stay the same.
+    /// </summary>
+    struct PersistedTools
+    {
+        /// <summary>
+        /// Reads the tools stored in file, keeping none if path_variable or tools_xml changed since they were stored.
+        /// </summary>
+        static PersistedTools load(const Files::Filesystem& fs,
+                                   const fs::path& file,
+                                   const std::string& path_variable,
+                                   const fs::path& tools_xml);
+
+        Optional<PathAndVersion> find(const std::string& tool) const;
+
+        /// <summary>
+        /// Remembers a tool and rewrites the file. Failures are ignored.
+        /// </summary>
+        void store(Files::Filesystem& fs, const std::string& tool, const PathAndVersion& path_and_version);
+
+    private:
+        struct Entry
+        {
+            PathAndVersion path_and_version;
+            std::string stamp;
+        };
+
+        fs::path m_file;
+        std::string m_context;
+        std::map<std::string, Entry> m_entries;
+    };
 }
@@ -87,12 +87,18 @@ namespace vcpkg
 
         std::unique_ptr<std::string> vcpkg_root_dir;
         std::unique_ptr<std::string> scripts_root_dir;
+        std::unique_ptr<std::string> install_root_dir;
+        std::unique_ptr<std::string> packages_root_dir;
+        std::unique_ptr<std::string> buildtrees_root_dir;
         std::unique_ptr<std::string> triplet;
         std::unique_ptr<std::vector<std::string>> overlay_ports;
         std::unique_ptr<std::vector<std::string>> overlay_triplets;
         Optional<bool> debug = nullopt;
         Optional<bool> sendmetrics = nullopt;
         Optional<bool> printmetrics = nullopt;
+        Optional<bool> buildtrees_per_spec = nullopt;
+        Optional<bool> cache_file_status = nullopt;
+        Optional<bool> phase_timings = nullopt;
 
         // feature flags
         Optional<bool> featurepackages = nullopt;
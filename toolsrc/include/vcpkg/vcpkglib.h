@@ -8,6 +8,11 @@ namespace vcpkg
 {
     StatusParagraphs database_load_check(const VcpkgPaths& paths);
 
+    /// <summary>
+    /// Load the status database of the tree `installed`, folding in its pending updates.
+    /// </summary>
+    StatusParagraphs database_load_check(Files::Filesystem& fs, const fs::path& installed);
+
     void write_update(const VcpkgPaths& paths, const StatusParagraph& p);
 
     struct StatusParagraphAndAssociatedFiles
@@ -20,5 +25,12 @@ namespace vcpkg
     std::vector<StatusParagraphAndAssociatedFiles> get_installed_files(const VcpkgPaths& paths,
                                                                        const StatusParagraphs& status_db);
 
+    /// <summary>
+    /// The files of each package installed into the tree `installed`, from its list file.
+    /// </summary>
+    std::vector<StatusParagraphAndAssociatedFiles> get_installed_files(Files::Filesystem& fs,
+                                                                       const fs::path& installed,
+                                                                       const StatusParagraphs& status_db);
+
     std::string shorten_text(const std::string& desc, const size_t length);
 } // namespace vcpkg
@@ -5,6 +5,7 @@
 #include <vcpkg/tools.h>
 
 #include <vcpkg/base/cache.h>
+#include <vcpkg/base/cachingfilesystem.h>
 #include <vcpkg/base/expected.h>
 #include <vcpkg/base/files.h>
 #include <vcpkg/base/lazy.h>
@@ -45,14 +46,23 @@ namespace vcpkg
         struct PreBuildInfo;
     }
 
+    struct VcpkgCmdArguments;
+
     struct VcpkgPaths
     {
         static Expected<VcpkgPaths> create(const fs::path& vcpkg_root_dir,
                                            const Optional<fs::path>& vcpkg_scripts_root_dir,
                                            const std::string& default_vs_path,
-                                           const std::vector<std::string>* triplets_dirs);
+                                           const VcpkgCmdArguments& args);
 
         fs::path package_dir(const PackageSpec& spec) const;
+
+        /// <summary>
+        /// Where spec is built and its logs are kept: buildtrees/<port>, shared by all triplets, or
+        /// buildtrees/<port>_<triplet> with --x-buildtrees-per-spec so that one port can be built for several
+        /// triplets at once.
+        /// </summary>
+        fs::path buildtrees_dir(const PackageSpec& spec) const;
         fs::path build_info_file_path(const PackageSpec& spec) const;
         fs::path listfile_path(const BinaryParagraph& pgh) const;
 
@@ -60,6 +70,12 @@ namespace vcpkg
         const std::vector<std::string>& get_available_triplets() const;
         const fs::path get_triplet_file_path(const Triplet& triplet) const;
 
+        /// <summary>
+        /// The working directory vcpkg was started in. vcpkg changes into root once the paths are known, so relative
+        /// paths from the command line are resolved against this one.
+        /// </summary>
+        fs::path original_cwd;
+
         fs::path root;
         fs::path packages;
         fs::path buildtrees;
@@ -77,6 +93,7 @@ namespace vcpkg
         fs::path vcpkg_dir_status_file;
         fs::path vcpkg_dir_info;
         fs::path vcpkg_dir_updates;
+        fs::path vcpkg_dir_history;
 
         fs::path ports_cmake;
 
@@ -89,6 +106,10 @@ namespace vcpkg
         /// </remarks>
         const Toolset& get_toolset(const Build::PreBuildInfo& prebuildinfo) const;
 
+        /// <summary>
+        /// The real filesystem, or with --x-cache-file-status one that remembers the status of every path it has
+        /// been asked about.
+        /// </summary>
         Files::Filesystem& get_filesystem() const;
 
     private:
@@ -98,8 +119,10 @@ namespace vcpkg
 
         fs::path default_vs_path;
         std::vector<fs::path> triplets_dirs;
+        bool buildtrees_per_spec = false;
 
-        mutable std::unique_ptr<ToolCache> m_tool_cache;
-        mutable vcpkg::Cache<Triplet, fs::path> m_triplets_cache;
+        Lazy<std::unique_ptr<ToolCache>> m_tool_cache;
+        std::unique_ptr<Files::CachingFilesystem> m_file_status_cache;
+        vcpkg::Cache<Triplet, fs::path> m_triplets_cache;
     };
 }
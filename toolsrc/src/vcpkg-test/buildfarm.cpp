@@ -0,0 +1,156 @@
+#include <catch2/catch.hpp>
+
+#include <vcpkg-test/util.h>
+
+#include <vcpkg/buildfarm.h>
+
+#include <thread>
+
+using namespace vcpkg;
+using std::chrono::milliseconds;
+
+TEST_CASE ("build farm queue hands each item to one worker", "[buildfarm]")
+{
+    auto& fs = Files::get_real_filesystem();
+    const fs::path root = Test::base_temporary_directory() / "build-farm-queue";
+    std::error_code ec;
+    fs::path failure_point;
+    fs.remove_all(root, ec, failure_point);
+
+    BuildFarm::QueueDirectory coordinator(fs, root);
+    BuildFarm::QueueDirectory worker_a(fs, root);
+    BuildFarm::QueueDirectory worker_b(fs, root);
+    coordinator.reset();
+    REQUIRE_FALSE(worker_a.is_closed());
+    REQUIRE_FALSE(worker_a.claim().has_value());
+
+    const auto zlib = Test::unsafe_pspec("zlib", Triplet::X64_WINDOWS);
+    const auto curl = Test::unsafe_pspec("curl", Triplet::X64_WINDOWS);
+    coordinator.push({zlib, {"core"}});
+    coordinator.push({curl, {"core", "ssl"}});
+
+    auto first = worker_a.claim().value_or_exit(VCPKG_LINE_INFO);
+    auto second = worker_b.claim().value_or_exit(VCPKG_LINE_INFO);
+    REQUIRE(first.spec != second.spec);
+    REQUIRE_FALSE(worker_a.claim().has_value());
+
+    const auto& claimed_curl = first.spec == curl ? first : second;
+    REQUIRE(claimed_curl.features == std::vector<std::string>{"core", "ssl"});
+
+    REQUIRE(coordinator.take_results().empty());
+    BuildFarm::WorkResult first_result{first.spec, Build::BuildResult::SUCCEEDED, milliseconds(1500)};
+    first_result.peak_rss_kb = 204800;
+    worker_a.complete(first, first_result);
+    worker_b.complete(second, {second.spec, Build::BuildResult::BUILD_FAILED, milliseconds(20)});
+
+    auto results = coordinator.take_results();
+    REQUIRE(results.size() == 2);
+    Util::sort(results, [](const BuildFarm::WorkResult& l, const BuildFarm::WorkResult& r) { return l.spec < r.spec; });
+    REQUIRE(results[0].spec == first.spec);
+    REQUIRE(results[0].result == Build::BuildResult::SUCCEEDED);
+    REQUIRE(results[0].duration == milliseconds(1500));
+    REQUIRE(results[0].peak_rss_kb.value_or_exit(VCPKG_LINE_INFO) == 204800);
+    REQUIRE_FALSE(results[0].restored_from_cache);
+    REQUIRE(results[1].result == Build::BuildResult::BUILD_FAILED);
+    REQUIRE_FALSE(results[1].peak_rss_kb.has_value());
+    REQUIRE(coordinator.take_results().empty());
+
+    coordinator.close();
+    REQUIRE(worker_b.is_closed());
+    coordinator.reset();
+    REQUIRE_FALSE(worker_b.is_closed());
+}
+
+TEST_CASE ("build farm queue takes back items of silent workers", "[buildfarm]")
+{
+    auto& fs = Files::get_real_filesystem();
+    const fs::path root = Test::base_temporary_directory() / "build-farm-leases";
+    std::error_code ec;
+    fs::path failure_point;
+    fs.remove_all(root, ec, failure_point);
+
+    BuildFarm::QueueDirectory coordinator(fs, root);
+    BuildFarm::QueueDirectory worker(fs, root);
+    coordinator.reset();
+
+    const auto zlib = Test::unsafe_pspec("zlib", Triplet::X64_WINDOWS);
+    const auto curl = Test::unsafe_pspec("curl", Triplet::X64_WINDOWS);
+    coordinator.push({zlib, {"core"}});
+    coordinator.push({curl, {"core", "ssl"}});
+    const auto first = worker.claim().value_or_exit(VCPKG_LINE_INFO);
+    const auto second = worker.claim().value_or_exit(VCPKG_LINE_INFO);
+
+    // Claims first seen now start their leases
+    REQUIRE(coordinator.take_expired(milliseconds(50)).empty());
+    std::this_thread::sleep_for(milliseconds(100));
+    worker.renew(first);
+    auto expired = coordinator.take_expired(milliseconds(50));
+    REQUIRE(expired.size() == 1);
+    REQUIRE(expired[0].spec == second.spec);
+    REQUIRE(expired[0].features == second.features);
+
+    // With no time allowed the renewed claim expires too; each claim is taken back once
+    REQUIRE(coordinator.take_expired(milliseconds(0)).size() == 1);
+    REQUIRE(coordinator.take_expired(milliseconds(0)).empty());
+    // Items taken back have to be pushed again to be claimed
+    REQUIRE_FALSE(worker.claim().has_value());
+
+    // A worker that was only slow still gets its result through
+    worker.complete(first, {first.spec, Build::BuildResult::SUCCEEDED, milliseconds(10)});
+    const auto results = coordinator.take_results();
+    REQUIRE(results.size() == 1);
+    REQUIRE(results[0].spec == first.spec);
+}
+
+TEST_CASE ("build farm workers act only on their own claims", "[buildfarm]")
+{
+    auto& fs = Files::get_real_filesystem();
+    const fs::path root = Test::base_temporary_directory() / "build-farm-claims";
+    std::error_code ec;
+    fs::path failure_point;
+    fs.remove_all(root, ec, failure_point);
+
+    BuildFarm::QueueDirectory coordinator(fs, root);
+    BuildFarm::QueueDirectory worker(fs, root);
+    coordinator.reset();
+
+    const auto zlib = Test::unsafe_pspec("zlib", Triplet::X64_WINDOWS);
+    coordinator.push({zlib, {"core"}});
+    const auto lost = worker.claim().value_or_exit(VCPKG_LINE_INFO);
+    REQUIRE(lost.attempt == 1);
+
+    auto expired = coordinator.take_expired(milliseconds(0));
+    REQUIRE(expired.size() == 1);
+    expired[0].attempt = 2;
+    coordinator.push(expired[0]);
+    const auto retried = worker.claim().value_or_exit(VCPKG_LINE_INFO);
+    REQUIRE(retried.attempt == 2);
+    REQUIRE(retried.claim_token != lost.claim_token);
+
+    // The worker that lost the item finishes late; the claim of the second attempt stays in place
+    worker.renew(lost);
+    worker.complete(lost, {zlib, Build::BuildResult::SUCCEEDED, milliseconds(10)});
+    REQUIRE(coordinator.take_results().size() == 1);
+    expired = coordinator.take_expired(milliseconds(0));
+    REQUIRE(expired.size() == 1);
+    REQUIRE(expired[0].attempt == 2);
+}
+
+TEST_CASE ("build farm memory budget", "[buildfarm]")
+{
+    BuildFarm::MemoryBudget memory;
+    memory.budget_kb = 1000;
+
+    REQUIRE(memory.admits(600, 400, 1));
+    REQUIRE_FALSE(memory.admits(601, 400, 1));
+    // The first build always starts, even alone over budget
+    REQUIRE(memory.admits(5000, 0, 0));
+
+    std::uint64_t available_kb = 100;
+    memory.min_available_kb = 200;
+    memory.available_memory_kb = [&]() -> Optional<std::uint64_t> { return available_kb; };
+    REQUIRE_FALSE(memory.admits(0, 0, 1));
+    REQUIRE(memory.admits(0, 0, 0));
+    available_kb = 300;
+    REQUIRE(memory.admits(0, 0, 1));
+}
@@ -0,0 +1,175 @@
+#include <catch2/catch.hpp>
+
+#include <vcpkg-test/util.h>
+
+#include <vcpkg/buildhistory.h>
+
+using namespace vcpkg;
+using std::chrono::milliseconds;
+
+TEST_CASE ("build history round trip", "[buildhistory]")
+{
+    auto& fs = Files::get_real_filesystem();
+    const fs::path root = Test::base_temporary_directory() / "build-history";
+    std::error_code ec;
+    fs::path failure_point;
+    fs.remove_all(root, ec, failure_point);
+
+    REQUIRE(BuildHistory::BuildHistory::load(fs, root).records().empty());
+
+    const auto zlib = Test::unsafe_pspec("zlib", Triplet::X64_WINDOWS);
+    const auto zlib_uwp = Test::unsafe_pspec("zlib", Triplet::X64_UWP);
+    const auto curl = Test::unsafe_pspec("curl", Triplet::X64_WINDOWS);
+
+    BuildHistory::append_records(fs, root, {{zlib, milliseconds(1000)}, {curl, milliseconds(5000)}});
+    BuildHistory::append_records(fs, root, {{zlib, milliseconds(3000)}});
+    // Damaged or unfinished files are skipped
+    fs.write_contents(root / "incomplete-0", "Package: zlib\nArchitecture: x64-windows\nDuration-Ms: 9\n", ec);
+    fs.write_contents(root / "0000000000000-bad", "Package: zlib\nArchitecture: x64-windows\nDuration-Ms: x\n", ec);
+
+    const auto history = BuildHistory::BuildHistory::load(fs, root);
+    REQUIRE(history.records().size() == 3);
+    REQUIRE(history.records().back().spec == zlib);
+    REQUIRE(history.records().back().duration == milliseconds(3000));
+
+    REQUIRE(history.predict_duration(zlib).value_or_exit(VCPKG_LINE_INFO) == milliseconds(2000));
+    REQUIRE(history.predict_duration(curl).value_or_exit(VCPKG_LINE_INFO) == milliseconds(5000));
+    // Never built for this triplet, so the other triplets stand in
+    REQUIRE(history.predict_duration(zlib_uwp).value_or_exit(VCPKG_LINE_INFO) == milliseconds(2000));
+    REQUIRE_FALSE(history.predict_duration(Test::unsafe_pspec("boost", Triplet::X64_WINDOWS)).has_value());
+}
+
+TEST_CASE ("build history predicts from recent builds", "[buildhistory]")
+{
+    auto& fs = Files::get_real_filesystem();
+    const fs::path root = Test::base_temporary_directory() / "build-history-recent";
+    std::error_code ec;
+    fs::path failure_point;
+    fs.remove_all(root, ec, failure_point);
+
+    const auto zlib = Test::unsafe_pspec("zlib", Triplet::X64_WINDOWS);
+    std::vector<BuildHistory::BuildRecord> records;
+    records.push_back({zlib, milliseconds(100000)});
+    for (int i = 0; i < 5; ++i)
+        records.push_back({zlib, milliseconds(10)});
+    BuildHistory::append_records(fs, root, records);
+
+    const auto history = BuildHistory::BuildHistory::load(fs, root);
+    REQUIRE(history.predict_duration(zlib).value_or_exit(VCPKG_LINE_INFO) == milliseconds(10));
+}
+
+TEST_CASE ("build history keeps results and resource use", "[buildhistory]")
+{
+    auto& fs = Files::get_real_filesystem();
+    const fs::path root = Test::base_temporary_directory() / "build-history-fields";
+    std::error_code ec;
+    fs::path failure_point;
+    fs.remove_all(root, ec, failure_point);
+
+    const auto zlib = Test::unsafe_pspec("zlib", Triplet::X64_WINDOWS);
+
+    BuildHistory::BuildRecord built{zlib, milliseconds(4000)};
+    built.abi = "abc123";
+    built.features = {"core", "extra"};
+    built.cpu_time = milliseconds(12000);
+    built.peak_rss_kb = 2048;
+
+    BuildHistory::BuildRecord cached{zlib, milliseconds(50)};
+    cached.restored_from_cache = true;
+
+    BuildHistory::BuildRecord failed{zlib, milliseconds(90000)};
+    failed.result = Build::BuildResult::BUILD_FAILED;
+
+    BuildHistory::append_records(fs, root, {built, cached, failed});
+
+    const auto history = BuildHistory::BuildHistory::load(fs, root);
+    REQUIRE(history.records().size() == 3);
+
+    const auto& first = history.records()[0];
+    REQUIRE(first.abi == "abc123");
+    REQUIRE(first.features == std::vector<std::string>{"core", "extra"});
+    REQUIRE(first.result == Build::BuildResult::SUCCEEDED);
+    REQUIRE_FALSE(first.restored_from_cache);
+    REQUIRE(first.cpu_time.value_or_exit(VCPKG_LINE_INFO) == milliseconds(12000));
+    REQUIRE(first.peak_rss_kb.value_or_exit(VCPKG_LINE_INFO) == 2048);
+    REQUIRE_FALSE(first.run.empty());
+
+    REQUIRE(history.records()[1].restored_from_cache);
+    REQUIRE_FALSE(history.records()[1].cpu_time.has_value());
+    REQUIRE(history.records()[2].result == Build::BuildResult::BUILD_FAILED);
+
+    // Neither cache hits nor failures say anything about how long a build takes
+    REQUIRE(history.predict_duration(zlib).value_or_exit(VCPKG_LINE_INFO) == milliseconds(4000));
+}
+
+TEST_CASE ("build history regressions", "[buildhistory]")
+{
+    auto& fs = Files::get_real_filesystem();
+    const fs::path root = Test::base_temporary_directory() / "build-history-regressions";
+    std::error_code ec;
+    fs::path failure_point;
+    fs.remove_all(root, ec, failure_point);
+
+    const auto zlib = Test::unsafe_pspec("zlib", Triplet::X64_WINDOWS);
+    const auto curl = Test::unsafe_pspec("curl", Triplet::X64_WINDOWS);
+    const auto qt = Test::unsafe_pspec("qt5-base", Triplet::X64_WINDOWS);
+
+    BuildHistory::append_records(
+        fs, root, {{zlib, milliseconds(1000)}, {curl, milliseconds(60000)}, {qt, milliseconds(600000)}});
+    BuildHistory::append_records(
+        fs, root, {{zlib, milliseconds(1900)}, {curl, milliseconds(100000)}, {qt, milliseconds(650000)}});
+
+    const auto history = BuildHistory::BuildHistory::load(fs, root);
+
+    // zlib nearly doubled, but by less than the minimum; qt5-base only grew by 8%
+    const auto regressions = BuildHistory::find_regressions(history, 20, milliseconds(10000));
+    REQUIRE(regressions.size() == 1);
+    REQUIRE(regressions[0].spec == curl);
+    REQUIRE(regressions[0].previous == milliseconds(60000));
+    REQUIRE(regressions[0].latest == milliseconds(100000));
+
+    REQUIRE(BuildHistory::find_regressions(history, 5, milliseconds(0)).size() == 3);
+}
+
+TEST_CASE ("build history percentiles", "[buildhistory]")
+{
+    std::vector<milliseconds> samples;
+    for (int i = 20; i >= 1; --i)
+        samples.push_back(milliseconds(i));
+
+    REQUIRE(BuildHistory::percentile(samples, 50) == milliseconds(10));
+    REQUIRE(BuildHistory::percentile(samples, 95) == milliseconds(19));
+    REQUIRE(BuildHistory::percentile(samples, 100) == milliseconds(20));
+
+    std::vector<milliseconds> one{milliseconds(7)};
+    REQUIRE(BuildHistory::percentile(one, 95) == milliseconds(7));
+}
+
+TEST_CASE ("build history predicts peak memory", "[buildhistory]")
+{
+    auto& fs = Files::get_real_filesystem();
+    const fs::path root = Test::base_temporary_directory() / "build-history-memory";
+    std::error_code ec;
+    fs::path failure_point;
+    fs.remove_all(root, ec, failure_point);
+
+    const auto zlib = Test::unsafe_pspec("zlib", Triplet::X64_WINDOWS);
+    const auto zlib_uwp = Test::unsafe_pspec("zlib", Triplet::X64_UWP);
+
+    std::vector<BuildHistory::BuildRecord> records;
+    for (std::uint64_t rss : {4096, 1024, 2048})
+    {
+        records.push_back({zlib, milliseconds(1000)});
+        records.back().peak_rss_kb = rss;
+    }
+    BuildHistory::BuildRecord failed{zlib, milliseconds(1000)};
+    failed.result = Build::BuildResult::BUILD_FAILED;
+    failed.peak_rss_kb = 100000;
+    records.push_back(failed);
+    BuildHistory::append_records(fs, root, records);
+
+    const auto history = BuildHistory::BuildHistory::load(fs, root);
+    REQUIRE(history.predict_peak_rss_kb(zlib).value_or_exit(VCPKG_LINE_INFO) == 4096);
+    REQUIRE(history.predict_peak_rss_kb(zlib_uwp).value_or_exit(VCPKG_LINE_INFO) == 4096);
+    REQUIRE_FALSE(history.predict_peak_rss_kb(Test::unsafe_pspec("boost", Triplet::X64_WINDOWS)).has_value());
+}
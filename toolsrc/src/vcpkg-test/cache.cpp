@@ -0,0 +1,84 @@
+#include <catch2/catch.hpp>
+
+#include <vcpkg/base/cache.h>
+#include <vcpkg/base/lazy.h>
+
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace vcpkg;
+
+template<class F>
+static void run_on_threads(int thread_count, const F& f)
+{
+    std::vector<std::thread> threads;
+    for (int i = 0; i < thread_count; ++i)
+        threads.emplace_back([&f, i]() { f(i); });
+    for (auto&& thread : threads)
+        thread.join();
+}
+
+TEST_CASE ("lazy from several threads", "[cache]")
+{
+    Lazy<std::string> lazy;
+    std::atomic<int> computations(0);
+    std::vector<const std::string*> results(8);
+
+    run_on_threads(8, [&](int i) {
+        results[i] = &lazy.get_lazy([&]() {
+            ++computations;
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            return std::string("value");
+        });
+    });
+
+    REQUIRE(computations == 1);
+    for (auto&& result : results)
+        REQUIRE(result == results.front());
+    REQUIRE(*results.front() == "value");
+}
+
+TEST_CASE ("lazy after a throwing computation", "[cache]")
+{
+    Lazy<int> lazy;
+    REQUIRE_THROWS(lazy.get_lazy([]() -> int { throw std::runtime_error("failed"); }));
+    REQUIRE(lazy.get_lazy([]() { return 42; }) == 42);
+    REQUIRE(lazy.get_lazy([]() { return 0; }) == 42);
+}
+
+TEST_CASE ("cache from several threads", "[cache]")
+{
+    Cache<int, std::string> cache;
+    std::atomic<int> computations(0);
+    // Catch's assertions may only be used from the main thread
+    std::atomic<int> mismatches(0);
+
+    run_on_threads(8, [&](int) {
+        for (int key = 0; key < 200; ++key)
+        {
+            const auto& value = cache.get_lazy(key, [&]() {
+                ++computations;
+                return std::to_string(key);
+            });
+            if (value != std::to_string(key)) ++mismatches;
+        }
+    });
+
+    REQUIRE(computations == 200);
+    REQUIRE(mismatches == 0);
+}
+
+TEST_CASE ("cache computing other keys", "[cache]")
+{
+    Cache<std::string, std::string> cache;
+    const auto& outer = cache.get_lazy("outer", [&]() {
+        return cache.get_lazy("inner", []() { return std::string("inner value"); }) + "!";
+    });
+
+    REQUIRE(outer == "inner value!");
+    REQUIRE(&cache.get_lazy("outer", []() { return std::string(); }) == &outer);
+}
@@ -0,0 +1,54 @@
+#include <catch2/catch.hpp>
+
+#include <vcpkg-test/util.h>
+
+#include <vcpkg/base/cachingfilesystem.h>
+#include <vcpkg/base/phases.h>
+#include <vcpkg/base/system.process.h>
+
+using namespace vcpkg;
+
+TEST_CASE ("caching filesystem", "[files]")
+{
+    auto& real_fs = Files::get_real_filesystem();
+    const fs::path root = Test::base_temporary_directory() / "caching-filesystem";
+    std::error_code ec;
+    fs::path failure_point;
+    real_fs.remove_all(root, ec, failure_point);
+    real_fs.create_directories(root / "dir", ec);
+    REQUIRE_FALSE(ec);
+
+    Files::CachingFilesystem fs(real_fs);
+    const auto file = root / "dir" / "file";
+    const auto hits_before = Phases::get_count(Phases::Counter::FILE_STATUS_CACHE_HITS);
+    const auto misses_before = Phases::get_count(Phases::Counter::FILE_STATUS_CACHE_MISSES);
+
+    REQUIRE_FALSE(fs.exists(file));
+    REQUIRE_FALSE(fs.exists(file));
+    REQUIRE(fs.misses() == 1);
+    REQUIRE(fs.hits() == 1);
+    REQUIRE(Phases::get_count(Phases::Counter::FILE_STATUS_CACHE_HITS) == hits_before + 1);
+    REQUIRE(Phases::get_count(Phases::Counter::FILE_STATUS_CACHE_MISSES) == misses_before + 1);
+
+    // Changes made through the cache are seen by it, including by the directories above
+    REQUIRE(fs.is_directory(root / "dir"));
+    fs.write_contents(file, "contents", ec);
+    REQUIRE(fs.exists(file));
+    REQUIRE(fs.is_regular_file(file));
+    REQUIRE(fs.is_directory(root / "dir"));
+    REQUIRE(fs.misses() == 5);
+
+    fs.remove_all(root / "dir", ec, failure_point);
+    REQUIRE_FALSE(fs.exists(file));
+    REQUIRE_FALSE(fs.is_directory(root / "dir"));
+
+    // Changes made behind its back are not, until a child process runs
+    real_fs.create_directories(root / "dir", ec);
+    REQUIRE_FALSE(fs.is_directory(root / "dir"));
+    System::cmd_execute_and_capture_output("echo");
+    REQUIRE(fs.is_directory(root / "dir"));
+
+    real_fs.remove_all(root / "dir", ec, failure_point);
+    fs.clear();
+    REQUIRE_FALSE(fs.is_directory(root / "dir"));
+}
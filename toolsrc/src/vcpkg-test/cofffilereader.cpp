@@ -0,0 +1,109 @@
+#include <catch2/catch.hpp>
+
+#include <vcpkg-test/util.h>
+
+#include <vcpkg/base/cofffilereader.h>
+
+using namespace vcpkg;
+
+static void append_u16(std::string& out, uint16_t value)
+{
+    out.push_back(static_cast<char>(value & 0xFF));
+    out.push_back(static_cast<char>(value >> 8));
+}
+
+static void append_u32(std::string& out, uint32_t value)
+{
+    for (int shift = 0; shift < 32; shift += 8)
+        out.push_back(static_cast<char>((value >> shift) & 0xFF));
+}
+
+static void append_member_header(std::string& out, const std::string& name, size_t size)
+{
+    std::string header(60, ' ');
+    header.replace(0, name.size(), name);
+    const auto size_field = std::to_string(size);
+    header.replace(48, size_field.size(), size_field);
+    header.replace(58, 2, "`\n");
+    out += header;
+}
+
+static fs::path write_test_file(const std::string& name, const std::string& contents)
+{
+    auto& fs = Files::get_real_filesystem();
+    const auto dir = Test::base_temporary_directory() / "coff";
+    std::error_code ec;
+    fs.create_directories(dir, ec);
+    const auto path = dir / name;
+    fs.write_contents(path, contents, VCPKG_LINE_INFO);
+    return path;
+}
+
+TEST_CASE ("read the machine type of a dll", "[cofffilereader]")
+{
+    std::string dll(0x80, '\0');
+    dll[0] = 'M';
+    dll[1] = 'Z';
+    dll.replace(0x3c, 4, "\x80\0\0\0", 4);
+    dll.append("PE\0\0", 4);
+    append_u16(dll, static_cast<uint16_t>(MachineType::ARM64));
+    dll.append(18, '\0');
+
+    const auto info = CoffFileReader::read_dll(write_test_file("arm64.dll", dll)).value_or_exit(VCPKG_LINE_INFO);
+    REQUIRE(info.machine_type == MachineType::ARM64);
+
+    // Damaged files are reported rather than stopping vcpkg
+    auto unsigned_dll = dll;
+    unsigned_dll[0x81] = 'X';
+    REQUIRE_FALSE(CoffFileReader::read_dll(write_test_file("unsigned.dll", unsigned_dll)).has_value());
+    dll.resize(0x84);
+    REQUIRE_FALSE(CoffFileReader::read_dll(write_test_file("truncated.dll", dll)).has_value());
+}
+
+TEST_CASE ("read the machine types of a lib", "[cofffilereader]")
+{
+    // An archive with two linker members, an object and an import header, each named by the second linker member
+    std::string lib = "!<arch>\n";
+    append_member_header(lib, "/", 4);
+    append_u32(lib, 0);
+
+    const size_t second_linker_member = lib.size();
+    const size_t member_count = 3;
+    const size_t second_linker_member_size = 4 + 4 * member_count;
+    const size_t object_offset = second_linker_member + 60 + second_linker_member_size;
+    const size_t object_size = 21; // odd, so the next member is padded
+    const size_t import_offset = object_offset + 60 + object_size + 1;
+
+    append_member_header(lib, "/", second_linker_member_size);
+    append_u32(lib, member_count);
+    append_u32(lib, static_cast<uint32_t>(import_offset));
+    append_u32(lib, 0); // ignored
+    append_u32(lib, static_cast<uint32_t>(object_offset));
+
+    append_member_header(lib, "zlib.obj/", object_size);
+    append_u16(lib, static_cast<uint16_t>(MachineType::AMD64));
+    lib.append(object_size - 2 + 1, '\0');
+
+    append_member_header(lib, "zlib.dll/", 20);
+    append_u16(lib, 0);
+    append_u16(lib, 0xFFFF);
+    append_u16(lib, 0);
+    append_u16(lib, static_cast<uint16_t>(MachineType::AMD64));
+    lib.append(12, '\0');
+
+    auto info = CoffFileReader::read_lib(write_test_file("x64.lib", lib)).value_or_exit(VCPKG_LINE_INFO);
+    REQUIRE(info.machine_types == std::vector<MachineType>{MachineType::AMD64});
+
+    // An object for a second architecture
+    lib[object_offset + 60] = static_cast<char>(static_cast<uint16_t>(MachineType::I386) & 0xFF);
+    lib[object_offset + 61] = static_cast<char>(static_cast<uint16_t>(MachineType::I386) >> 8);
+    info = CoffFileReader::read_lib(write_test_file("mixed.lib", lib)).value_or_exit(VCPKG_LINE_INFO);
+    REQUIRE(info.machine_types.size() == 2);
+
+    // Damaged files are reported rather than stopping vcpkg
+    const auto truncated = lib.substr(0, import_offset + 62);
+    REQUIRE_FALSE(CoffFileReader::read_lib(write_test_file("truncated.lib", truncated)).has_value());
+    REQUIRE_FALSE(CoffFileReader::read_lib(write_test_file("thin.lib", "!<thin>\n")).has_value());
+    lib[import_offset + 62] = '\0';
+    REQUIRE_FALSE(CoffFileReader::read_lib(write_test_file("bad-import.lib", lib)).has_value());
+}
@@ -0,0 +1,166 @@
+#include <catch2/catch.hpp>
+
+#include <vcpkg-test/util.h>
+
+#include <vcpkg/base/elffilereader.h>
+
+using namespace vcpkg;
+
+static void append_le(std::string& out, uint64_t value, size_t width)
+{
+    for (size_t i = 0; i < width; ++i)
+        out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+}
+
+static void put_le(std::string& out, size_t offset, uint64_t value, size_t width)
+{
+    for (size_t i = 0; i < width; ++i)
+        out[offset + i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+}
+
+static std::string elf64_header(uint16_t type, uint16_t machine)
+{
+    std::string elf(64, '\0');
+    elf.replace(0, 4, "\x7F" "ELF");
+    elf[4] = 2; // ELFCLASS64
+    elf[5] = 1; // ELFDATA2LSB
+    elf[6] = 1; // EV_CURRENT
+    put_le(elf, 16, type, 2);
+    put_le(elf, 18, machine, 2);
+    put_le(elf, 52, 64, 2);
+    put_le(elf, 58, 64, 2); // e_shentsize
+    return elf;
+}
+
+/// A shared object holding only a .dynstr and a .dynamic section
+static std::string make_shared_object(const std::string& soname, const std::string& runpath)
+{
+    std::string elf = elf64_header(3, 62);
+
+    const size_t dynstr = elf.size();
+    std::string strings = std::string(1, '\0');
+    const size_t soname_index = strings.size();
+    strings += soname + '\0';
+    const size_t runpath_index = strings.size();
+    strings += runpath + '\0';
+    elf += strings;
+    while (elf.size() % 8 != 0)
+        elf.push_back('\0');
+
+    const size_t dynamic = elf.size();
+    if (!soname.empty())
+    {
+        append_le(elf, 14, 8); // DT_SONAME
+        append_le(elf, soname_index, 8);
+    }
+    append_le(elf, 29, 8); // DT_RUNPATH
+    append_le(elf, runpath_index, 8);
+    append_le(elf, 0, 16); // DT_NULL
+    const size_t dynamic_size = elf.size() - dynamic;
+
+    const size_t shoff = elf.size();
+    elf.append(64, '\0'); // SHN_UNDEF
+    std::string section(64, '\0');
+    put_le(section, 4, 3, 4); // SHT_STRTAB
+    put_le(section, 24, dynstr, 8);
+    put_le(section, 32, strings.size(), 8);
+    elf += section;
+    section.assign(64, '\0');
+    put_le(section, 4, 6, 4); // SHT_DYNAMIC
+    put_le(section, 24, dynamic, 8);
+    put_le(section, 32, dynamic_size, 8);
+    put_le(section, 40, 1, 4); // sh_link to .dynstr
+    elf += section;
+
+    put_le(elf, 40, shoff, 8);
+    put_le(elf, 60, 3, 2);
+    return elf;
+}
+
+static fs::path write_test_file(const std::string& name, const std::string& contents)
+{
+    auto& fs = Files::get_real_filesystem();
+    const auto dir = Test::base_temporary_directory() / "elf";
+    std::error_code ec;
+    fs.create_directories(dir, ec);
+    const auto path = dir / name;
+    fs.write_contents(path, contents, VCPKG_LINE_INFO);
+    return path;
+}
+
+TEST_CASE ("read a shared object", "[elffilereader]")
+{
+    const auto path = write_test_file("libz.so.1", make_shared_object("libz.so.1", "$ORIGIN:/home/me/vcpkg/lib"));
+    const auto info = ElfFileReader::read_elf(path).value_or_exit(VCPKG_LINE_INFO);
+    REQUIRE(info.type == ElfFileReader::ElfType::SHARED_OBJECT);
+    REQUIRE(ElfFileReader::to_architecture(info.machine) == "x64");
+    REQUIRE(info.soname.value_or_exit(VCPKG_LINE_INFO) == "libz.so.1");
+    REQUIRE(info.search_paths == std::vector<std::string>{"$ORIGIN", "/home/me/vcpkg/lib"});
+
+    const auto unnamed = ElfFileReader::read_elf(write_test_file("libplugin.so", make_shared_object("", "$ORIGIN")));
+    REQUIRE_FALSE(unnamed.value_or_exit(VCPKG_LINE_INFO).soname.has_value());
+}
+
+TEST_CASE ("reject files that are not elf", "[elffilereader]")
+{
+    REQUIRE_FALSE(ElfFileReader::read_elf(write_test_file("libc.so", "/* GNU ld script */\nGROUP ( libc.so.6 )\n")));
+
+    // Section headers past the end of the file
+    auto truncated = make_shared_object("libz.so.1", "");
+    truncated.resize(truncated.size() - 100);
+    REQUIRE_FALSE(ElfFileReader::read_elf(write_test_file("truncated.so", truncated)));
+
+    REQUIRE_FALSE(ElfFileReader::read_archive_machines(write_test_file("libz.so.2", make_shared_object("", ""))));
+}
+
+TEST_CASE ("reject section header tables that do not fit", "[elffilereader]")
+{
+    // A section count in the first section header whose table size overflows to fit in the file
+    auto overflowing = make_shared_object("libz.so.1", "");
+    const size_t shoff = overflowing.size() - 3 * 64;
+    put_le(overflowing, 60, 0, 2);
+    put_le(overflowing, shoff + 32, (uint64_t(1) << 58) + 3, 8);
+    REQUIRE_FALSE(ElfFileReader::read_elf(write_test_file("overflowing.so", overflowing)));
+
+    // Section headers smaller than the fields read from them
+    auto small_entries = make_shared_object("libz.so.1", "");
+    put_le(small_entries, 58, 8, 2);
+    REQUIRE_FALSE(ElfFileReader::read_elf(write_test_file("small-entries.so", small_entries)));
+}
+
+TEST_CASE ("read the machines of a static archive", "[elffilereader]")
+{
+    const auto member = [](std::string& archive, const std::string& name, const std::string& contents) {
+        std::string header(60, ' ');
+        header.replace(0, name.size(), name);
+        const auto size = std::to_string(contents.size());
+        header.replace(48, size.size(), size);
+        header.replace(58, 2, "`\n");
+        archive += header + contents;
+        if (contents.size() % 2 != 0) archive.push_back('\n');
+    };
+
+    std::string archive = "!<arch>\n";
+    member(archive, "/", std::string(7, '\0'));
+    member(archive, "a.o/", elf64_header(1, 62));
+    member(archive, "b.o/", elf64_header(1, 62));
+    member(archive, "c.o/", elf64_header(1, 183));
+    member(archive, "readme/", "not an object");
+
+    const auto machines =
+        ElfFileReader::read_archive_machines(write_test_file("libmixed.a", archive)).value_or_exit(VCPKG_LINE_INFO);
+    REQUIRE(machines == std::vector<uint16_t>{62, 183});
+}
+
+#if defined(__linux__)
+TEST_CASE ("read the running executable", "[elffilereader]")
+{
+    const auto info = ElfFileReader::read_elf("/proc/self/exe").value_or_exit(VCPKG_LINE_INFO);
+#if defined(__x86_64__)
+    REQUIRE(ElfFileReader::to_architecture(info.machine) == "x64");
+#elif defined(__aarch64__)
+    REQUIRE(ElfFileReader::to_architecture(info.machine) == "arm64");
+#endif
+    REQUIRE(info.type != ElfFileReader::ElfType::RELOCATABLE);
+}
+#endif
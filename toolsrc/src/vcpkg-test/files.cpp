@@ -1,11 +1,21 @@
 #include <catch2/catch.hpp>
+#include <vcpkg-test/memoryfilesystem.h>
 #include <vcpkg-test/util.h>
 
 #include <vcpkg/base/files.h>
 #include <vcpkg/base/strings.h>
-
+#include <vcpkg/install.h>
+#include <vcpkg/paragraphs.h>
+#include <vcpkg/postbuildlint.packagetree.h>
+#include <vcpkg/vcpkglib.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <iostream>
+#include <mutex>
 #include <random>
+#include <thread>
 
 #include <vector>
 
@@ -177,6 +187,295 @@ TEST_CASE ("remove all", "[files]")
     CHECK_EC_ON_FILE(temp_dir, ec);
 }
 
+TEST_CASE ("walk directory", "[files]")
+{
+    auto urbg = get_urbg(1);
+
+    auto& fs = setup();
+
+    fs::path temp_dir = base_temporary_directory() / get_random_filename(urbg);
+    INFO("temp dir is: " << temp_dir);
+
+    create_directory_tree(urbg, fs, temp_dir, MaxDepth{4});
+
+    // Links are reported as links and never followed, as by recursive_directory_iterator
+    std::vector<std::pair<std::string, fs::file_type>> expected;
+    for (auto&& entry : fs::stdfs::recursive_directory_iterator(temp_dir))
+    {
+        expected.emplace_back(entry.path().generic_u8string(), fs::stdfs::symlink_status(entry.path()).type());
+    }
+    std::sort(expected.begin(), expected.end());
+
+    std::vector<std::pair<std::string, fs::file_type>> walked;
+    fs.walk_directory(temp_dir, [&](const vcpkg::Files::DirectoryEntry& entry) {
+        // Parents come before their children
+        const auto parent = entry.path.parent_path();
+        if (parent != temp_dir)
+        {
+            REQUIRE(std::find_if(walked.begin(), walked.end(), [&](const std::pair<std::string, fs::file_type>& p) {
+                        return p.first == parent.generic_u8string();
+                    }) != walked.end());
+        }
+        walked.emplace_back(entry.path.generic_u8string(), entry.type);
+    });
+    std::sort(walked.begin(), walked.end());
+    REQUIRE(walked == expected);
+
+    std::mutex mutex;
+    std::vector<std::pair<std::string, fs::file_type>> walked_in_parallel;
+    fs.walk_directory_parallel(temp_dir, [&](const vcpkg::Files::DirectoryEntry& entry) {
+        std::lock_guard<std::mutex> lock(mutex);
+        walked_in_parallel.emplace_back(entry.path.generic_u8string(), entry.type);
+    });
+    std::sort(walked_in_parallel.begin(), walked_in_parallel.end());
+    REQUIRE(walked_in_parallel == expected);
+
+    std::error_code ec;
+    fs::path fp;
+    fs.remove_all(temp_dir, ec, fp);
+    CHECK_EC_ON_FILE(fp, ec);
+}
+
+TEST_CASE ("memory filesystem", "[files]")
+{
+    vcpkg::Test::MemoryFilesystem fs;
+    std::error_code ec;
+    fs::path fp;
+
+    REQUIRE(fs.create_directories("/a/b/c", ec));
+    CHECK_EC(ec);
+    REQUIRE_FALSE(fs.create_directories("/a/b", ec));
+    fs.write_contents("/a/b/file.txt", "one\r\ntwo\n", ec);
+    CHECK_EC(ec);
+    REQUIRE(fs.read_contents("/a/b/file.txt", VCPKG_LINE_INFO) == "one\r\ntwo\n");
+    REQUIRE(fs.read_lines("/a/b/file.txt").value_or_exit(VCPKG_LINE_INFO) == std::vector<std::string>{"one", "two"});
+    REQUIRE(fs.file_size("/a/b/file.txt", ec) == 9);
+    REQUIRE(fs.is_regular_file("/a/b/file.txt"));
+    REQUIRE(fs.is_directory("/a/b/c"));
+    REQUIRE(fs.is_empty("/a/b/c"));
+    REQUIRE_FALSE(fs.exists("/a/b/missing"));
+    REQUIRE_FALSE(fs.exists("/a/b/file.txt/under-a-file"));
+    fs.write_contents("/missing/file.txt", "", ec);
+    REQUIRE(ec == std::errc::no_such_file_or_directory);
+
+    // Links are followed by status, but not by symlink_status
+    fs.create_symlink("b", "/a/link", ec);
+    CHECK_EC(ec);
+    fs.create_symlink("/nowhere", "/a/dangling", ec);
+    REQUIRE(fs::is_symlink(fs.symlink_status("/a/link", ec)));
+    REQUIRE(fs::is_directory(fs.status("/a/link", ec)));
+    REQUIRE(fs.read_contents("/a/link/file.txt", VCPKG_LINE_INFO) == "one\r\ntwo\n");
+    REQUIRE(fs.canonical("/a/link/c/../file.txt", ec) == fs::u8path("/a/b/file.txt"));
+    REQUIRE(fs::is_symlink(fs.symlink_status("/a/dangling", ec)));
+    REQUIRE_FALSE(fs::exists(fs.status("/a/dangling", ec)));
+    CHECK_EC(ec);
+
+    std::vector<std::string> listed;
+    for (auto&& path : fs.get_files_non_recursive("/a"))
+        listed.push_back(path.generic_u8string());
+    std::sort(listed.begin(), listed.end());
+    REQUIRE(listed == std::vector<std::string>{"/a/b", "/a/dangling", "/a/link"});
+    // Links to directories are not walked into
+    REQUIRE(fs.get_files_recursive("/a").size() == 5);
+
+    // Renames replace files and empty directories, but nothing else
+    fs.write_contents("/a/other.txt", "other", ec);
+    fs.rename("/a/other.txt", "/a/b/file.txt", ec);
+    CHECK_EC(ec);
+    REQUIRE_FALSE(fs.exists("/a/other.txt"));
+    REQUIRE(fs.read_contents("/a/b/file.txt", VCPKG_LINE_INFO) == "other");
+    fs.create_directory("/a/empty", ec);
+    fs.rename("/a/b", "/a/empty", ec);
+    CHECK_EC(ec);
+    REQUIRE(fs.read_contents("/a/empty/file.txt", VCPKG_LINE_INFO) == "other");
+    REQUIRE(fs.is_directory("/a/empty/c"));
+    fs.create_directories("/a/full/x", ec);
+    fs.rename("/a/empty", "/a/full", ec);
+    REQUIRE(ec == std::errc::directory_not_empty);
+    fs.rename("/a/empty", "/a/empty/c/d", ec);
+    REQUIRE(ec == std::errc::invalid_argument);
+    fs.rename("/a/empty/file.txt", "/a/full", ec);
+    REQUIRE(ec == std::errc::is_a_directory);
+
+    // Hard links share their contents
+    fs.create_hard_link("/a/empty/file.txt", "/a/hard.txt", ec);
+    CHECK_EC(ec);
+    fs.write_contents("/a/empty/file.txt", "changed", ec);
+    REQUIRE(fs.read_contents("/a/hard.txt", VCPKG_LINE_INFO) == "changed");
+
+    fs.copy("/a/empty", "/copy", fs::copy_options::recursive);
+    REQUIRE(fs.read_contents("/copy/file.txt", VCPKG_LINE_INFO) == "changed");
+    REQUIRE(fs.is_directory("/copy/c"));
+    REQUIRE_FALSE(fs.copy_file("/a/hard.txt", "/copy/file.txt", fs::copy_options::skip_existing, ec));
+    fs.copy_file("/a/hard.txt", "/copy/file.txt", fs::copy_options::none, ec);
+    REQUIRE(ec == std::errc::file_exists);
+
+    // Read-only files cannot be written and read-only directories cannot change, but remove_all removes them
+    fs.set_permissions("/a/hard.txt", fs::perms::owner_read, ec);
+    fs.write_contents("/a/hard.txt", "", ec);
+    REQUIRE(ec == std::errc::permission_denied);
+    fs.set_permissions("/copy", fs::perms::owner_read | fs::perms::owner_exec, ec);
+    fs.write_contents("/copy/new.txt", "", ec);
+    REQUIRE(ec == std::errc::permission_denied);
+    REQUIRE_FALSE(fs.remove("/copy/file.txt", ec));
+    REQUIRE(ec == std::errc::permission_denied);
+    REQUIRE_FALSE(fs.remove("/a", ec));
+    REQUIRE(ec == std::errc::directory_not_empty);
+    fs.remove_all("/copy", ec, fp);
+    CHECK_EC(ec);
+    fs.remove_all("/a", ec, fp);
+    CHECK_EC(ec);
+    REQUIRE(fs.get_files_recursive("/").empty());
+}
+
+TEST_CASE ("memory filesystem from several threads", "[files]")
+{
+    vcpkg::Test::MemoryFilesystem fs;
+    std::error_code ec;
+    fs.create_directory("/shared", ec);
+
+    // Each thread builds its files elsewhere and moves them in, so every run ends with the same tree
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; ++t)
+    {
+        threads.emplace_back([&fs, t] {
+            std::error_code thread_ec;
+            const auto scratch = fs::u8path("/scratch-" + std::to_string(t));
+            fs.create_directories(scratch / "sub", thread_ec);
+            for (int i = 0; i < 100; ++i)
+            {
+                const auto name = std::to_string(t) + "-" + std::to_string(i);
+                fs.write_contents(scratch / "sub" / fs::u8path(name), name, thread_ec);
+            }
+            fs.rename(scratch, fs::u8path("/shared/" + std::to_string(t)), thread_ec);
+        });
+    }
+    for (auto&& thread : threads)
+        thread.join();
+
+    std::vector<fs::path> walked;
+    fs.walk_directory("/shared", [&](const vcpkg::Files::DirectoryEntry& entry) { walked.push_back(entry.path); });
+    REQUIRE(walked.size() == 8 * 102);
+    REQUIRE(fs.get_files_non_recursive("/").size() == 1);
+
+    std::mutex mutex;
+    std::vector<fs::path> walked_in_parallel;
+    fs.walk_directory_parallel("/shared", [&](const vcpkg::Files::DirectoryEntry& entry) {
+        std::lock_guard<std::mutex> lock(mutex);
+        walked_in_parallel.push_back(entry.path);
+    });
+    std::sort(walked.begin(), walked.end());
+    std::sort(walked_in_parallel.begin(), walked_in_parallel.end());
+    REQUIRE(walked == walked_in_parallel);
+    REQUIRE(fs.read_contents("/shared/3/sub/3-42", VCPKG_LINE_INFO) == "3-42");
+}
+
+TEST_CASE ("install files into a memory filesystem", "[files]")
+{
+    vcpkg::Test::MemoryFilesystem fs;
+    std::error_code ec;
+    fs.create_directories("/packages/zlib_x64-linux/include", ec);
+    fs.create_directories("/packages/zlib_x64-linux/lib", ec);
+    fs.write_contents("/packages/zlib_x64-linux/CONTROL", "Package: zlib\n", ec);
+    fs.write_contents("/packages/zlib_x64-linux/include/zlib.h", "", ec);
+    fs.write_contents("/packages/zlib_x64-linux/lib/libz.so.1", "", ec);
+    fs.create_symlink("libz.so.1", "/packages/zlib_x64-linux/lib/libz.so", ec);
+    fs.create_directories("/installed/vcpkg/info", ec);
+
+    const auto dirs = vcpkg::Install::InstallDir::from_destination_root(
+        "/installed", "x64-linux", "/installed/vcpkg/info/zlib_x64-linux.list");
+    vcpkg::Install::install_files_and_write_listfile(fs, "/packages/zlib_x64-linux", dirs);
+
+    REQUIRE(fs.read_lines("/installed/vcpkg/info/zlib_x64-linux.list").value_or_exit(VCPKG_LINE_INFO) ==
+            std::vector<std::string>{"x64-linux/",
+                                     "x64-linux/include/",
+                                     "x64-linux/include/zlib.h",
+                                     "x64-linux/lib/",
+                                     "x64-linux/lib/libz.so",
+                                     "x64-linux/lib/libz.so.1"});
+    REQUIRE_FALSE(fs.exists("/installed/x64-linux/CONTROL"));
+    REQUIRE(fs::is_symlink(fs.symlink_status(VCPKG_LINE_INFO, "/installed/x64-linux/lib/libz.so")));
+}
+
+static std::string installed_status_paragraph(const std::string& name)
+{
+    return vcpkg::Strings::concat("Package: ",
+                                  name,
+                                  "\nVersion: 1.0\nArchitecture: x64-linux\nMulti-Arch: same\n"
+                                  "Status: install ok installed\n");
+}
+
+TEST_CASE ("status database and file conflicts in a memory filesystem", "[files]")
+{
+    vcpkg::Test::MemoryFilesystem fs;
+    std::error_code ec;
+    fs.create_directories("/installed/vcpkg/updates", ec);
+    fs.create_directories("/installed/vcpkg/info", ec);
+    fs.write_contents("/installed/vcpkg/status", installed_status_paragraph("zlib"), ec);
+    fs.write_contents("/installed/vcpkg/updates/0000000000", installed_status_paragraph("curl"), ec);
+    fs.write_lines("/installed/vcpkg/info/zlib_1.0_x64-linux.list",
+                   {"x64-linux/", "x64-linux/include/", "x64-linux/include/zlib.h"},
+                   ec);
+    fs.write_lines("/installed/vcpkg/info/curl_1.0_x64-linux.list",
+                   {"x64-linux/", "x64-linux/include/", "x64-linux/include/curl.h"},
+                   ec);
+
+    // Pending updates are folded into the status file
+    const auto status_db = vcpkg::database_load_check(fs, "/installed");
+    REQUIRE(std::distance(status_db.begin(), status_db.end()) == 2);
+    REQUIRE(fs.get_files_non_recursive("/installed/vcpkg/updates").empty());
+    REQUIRE(fs.read_contents("/installed/vcpkg/status", VCPKG_LINE_INFO).find("Package: curl") != std::string::npos);
+
+    const auto installed_files = vcpkg::get_installed_files(fs, "/installed", status_db);
+    REQUIRE(installed_files.size() == 2);
+
+    fs.create_directories("/packages/mylib_x64-linux/include", ec);
+    fs.write_contents("/packages/mylib_x64-linux/include/zlib.h", "", ec);
+    fs.write_contents("/packages/mylib_x64-linux/include/mylib.h", "", ec);
+    const auto conflicts = vcpkg::Install::find_file_conflicts(
+        fs, "/packages/mylib_x64-linux", vcpkg::Triplet::from_canonical_name("x64-linux"), installed_files);
+    REQUIRE(conflicts == std::vector<std::pair<std::string, std::string>>{{"include/zlib.h", "zlib:x64-linux"}});
+}
+
+TEST_CASE ("exclusive file lock", "[files]")
+{
+    auto& fs = setup();
+    const auto lock_path = base_temporary_directory() / "exclusive-file-lock";
+    std::error_code ec;
+    fs.remove(lock_path, ec);
+
+    std::atomic<int> holders(0);
+    std::atomic<int> overlaps(0);
+    std::atomic<int> failures(0);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; ++i)
+    {
+        // Catch's assertions may only be used from the main thread
+        threads.emplace_back([&]() {
+            for (int j = 0; j < 10; ++j)
+            {
+                std::error_code lock_ec;
+                vcpkg::Files::ExclusiveFileLock lock(lock_path, lock_ec);
+                if (lock_ec)
+                {
+                    ++failures;
+                    continue;
+                }
+                if (++holders != 1) ++overlaps;
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                --holders;
+            }
+        });
+    }
+    for (auto&& thread : threads)
+        thread.join();
+
+    REQUIRE(failures == 0);
+    REQUIRE(overlaps == 0);
+    REQUIRE(fs.exists(lock_path));
+    fs.remove(lock_path, ec);
+}
+
 #if defined(CATCH_CONFIG_ENABLE_BENCHMARKING)
 TEST_CASE ("remove all -- benchmarks", "[files][!benchmark]")
 {
@@ -240,4 +539,78 @@ TEST_CASE ("remove all -- benchmarks", "[files][!benchmark]")
         };
     }
 }
+
+TEST_CASE ("memory filesystem -- benchmarks", "[files][!benchmark]")
+{
+    // A package ten times the size of a large real one, so that only the work done per file shows
+    vcpkg::Test::MemoryFilesystem fs;
+    std::error_code ec;
+    for (int d = 0; d < 100; ++d)
+    {
+        const auto dir = fs::u8path("/packages/big_x64-linux/include/dir" + std::to_string(d));
+        fs.create_directories(dir, ec);
+        for (int f = 0; f < 100; ++f)
+            fs.write_contents(dir / fs::u8path("header" + std::to_string(f) + ".h"), "", ec);
+    }
+    fs.create_directories("/installed/vcpkg/info", ec);
+
+    BENCHMARK_ADVANCED("install 10000 files")(Catch::Benchmark::Chronometer meter)
+    {
+        const auto dirs = vcpkg::Install::InstallDir::from_destination_root(
+            "/installed", "x64-linux", "/installed/vcpkg/info/big_x64-linux.list");
+        meter.measure([&] {
+            fs::path fp;
+            fs.remove_all("/installed/x64-linux", ec, fp);
+            vcpkg::Install::install_files_and_write_listfile(fs, "/packages/big_x64-linux", dirs);
+        });
+    };
+
+    BENCHMARK("scan a package tree of 10000 files")
+    {
+        return vcpkg::PostBuildLint::PackageTree::scan(fs, "/packages/big_x64-linux").entries().size();
+    };
+
+    // Ten times the ports of the registry, each installed with ten files, one of which the big package also has
+    constexpr int port_count = 15000;
+    std::string status;
+    for (int i = 0; i < port_count; ++i)
+    {
+        const auto name = "port" + std::to_string(i);
+        const auto port_dir = fs::u8path("/ports/" + name);
+        fs.create_directories(port_dir, ec);
+        std::string control = vcpkg::Strings::concat("Source: ", name, "\nVersion: 1.0\nDescription: A port\n");
+        if (i > 1) vcpkg::Strings::append(control, "Build-Depends: port", i - 1, ", port", i - 2, '\n');
+        vcpkg::Strings::append(control, "\nFeature: extra\nDescription: An extra\n");
+        fs.write_contents(port_dir / "CONTROL", control, ec);
+
+        vcpkg::Strings::append(status, installed_status_paragraph(name), '\n');
+        std::vector<std::string> files{"x64-linux/", "x64-linux/include/"};
+        files.push_back(vcpkg::Strings::concat("x64-linux/include/dir", i % 100, "/header", i / 100 % 100, ".h"));
+        for (int f = 0; f < 9; ++f)
+            files.push_back(vcpkg::Strings::concat("x64-linux/share/", name, "/file", f));
+        fs.write_lines(fs::u8path("/installed/vcpkg/info/" + name + "_1.0_x64-linux.list"), files, ec);
+    }
+    fs.create_directories("/installed/vcpkg/updates", ec);
+    fs.write_contents("/installed/vcpkg/status", status, ec);
+
+    BENCHMARK("load 15000 ports")
+    {
+        return vcpkg::Paragraphs::load_all_ports(fs, "/ports").size();
+    };
+
+    BENCHMARK("load a status database of 15000 packages")
+    {
+        const auto status_db = vcpkg::database_load_check(fs, "/installed");
+        return std::distance(status_db.begin(), status_db.end());
+    };
+
+    const auto status_db = vcpkg::database_load_check(fs, "/installed");
+    BENCHMARK("find the conflicts of 10000 files with 15000 installed packages")
+    {
+        const auto installed_files = vcpkg::get_installed_files(fs, "/installed", status_db);
+        return vcpkg::Install::find_file_conflicts(
+                   fs, "/packages/big_x64-linux", vcpkg::Triplet::from_canonical_name("x64-linux"), installed_files)
+            .size();
+    };
+}
 #endif
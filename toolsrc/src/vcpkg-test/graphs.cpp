@@ -0,0 +1,146 @@
+#include <catch2/catch.hpp>
+
+#include <vcpkg/base/graphs.h>
+
+#include <string>
+
+using namespace vcpkg;
+
+namespace
+{
+    // 0 -> {1, 2}, 1 -> {3}, 2 -> {3}, 3 -> {}, 4 -> {2}
+    Graphs::CsrGraph make_diamond()
+    {
+        Graphs::CsrGraph g;
+        for (std::uint32_t v = 0; v < 5; ++v)
+            g.add_vertex(v);
+        g.add_edge(0, 1);
+        g.add_edge(0, 2);
+        g.add_edge(1, 3);
+        g.add_edge(2, 3);
+        g.add_edge(4, 2);
+        g.freeze();
+        return g;
+    }
+
+    std::string vertex_name(std::uint32_t v) { return std::to_string(v); }
+
+    struct ChainProvider final : Graphs::AdjacencyProvider<int, int>
+    {
+        int length;
+
+        explicit ChainProvider(int length) : length(length) {}
+
+        std::vector<int> adjacency_list(const int& vertex) const override
+        {
+            if (vertex + 1 < length) return {vertex + 1};
+            return {};
+        }
+        std::string to_string(const int& vertex) const override { return std::to_string(vertex); }
+        int load_vertex_data(const int& vertex) const override { return vertex; }
+    };
+}
+
+TEST_CASE ("leveled topological sort", "[graphs]")
+{
+    const auto g = make_diamond();
+    const auto result = Graphs::leveled_topological_sort(g, vertex_name);
+
+    REQUIRE(result.order.size() == 5);
+    std::vector<std::size_t> position(5);
+    for (std::size_t i = 0; i < result.order.size(); ++i)
+        position[result.order[i]] = i;
+    for (std::uint32_t v = 0; v < 5; ++v)
+    {
+        for (std::uint32_t succ : g.adjacency_list(v))
+            REQUIRE(position[succ] < position[v]);
+    }
+
+    REQUIRE(result.level[3] == 0);
+    REQUIRE(result.level[1] == 1);
+    REQUIRE(result.level[2] == 1);
+    REQUIRE(result.level[4] == 2);
+    REQUIRE(result.level[0] == 2);
+
+    // Unit costs: the longest chain of dependents waiting on 3 is 3 <- 2 <- 0
+    REQUIRE(result.remaining_work[3] == 3);
+    REQUIRE(result.remaining_work[2] == 2);
+    REQUIRE(result.remaining_work[0] == 1);
+    REQUIRE(result.remaining_work[4] == 1);
+}
+
+TEST_CASE ("leveled topological sort with costs", "[graphs]")
+{
+    const auto g = make_diamond();
+    const std::uint64_t costs[] = {1, 10, 2, 5, 100};
+    const auto result = Graphs::leveled_topological_sort(
+        g, [&](std::uint32_t v) { return costs[v]; }, vertex_name);
+
+    REQUIRE(result.remaining_work[0] == 1);
+    REQUIRE(result.remaining_work[4] == 100);
+    REQUIRE(result.remaining_work[1] == 11);
+    REQUIRE(result.remaining_work[2] == 102);
+    REQUIRE(result.remaining_work[3] == 107);
+}
+
+TEST_CASE ("topological frontier", "[graphs]")
+{
+    const auto g = make_diamond();
+    Graphs::TopologicalFrontier frontier(g);
+
+    REQUIRE(frontier.remaining() == 5);
+    REQUIRE(frontier.take_ready() == std::vector<std::uint32_t>{3});
+    REQUIRE_FALSE(frontier.has_ready());
+
+    frontier.complete(3);
+    auto ready = frontier.take_ready();
+    std::sort(ready.begin(), ready.end());
+    REQUIRE(ready == std::vector<std::uint32_t>{1, 2});
+
+    frontier.complete(2);
+    REQUIRE(frontier.take_ready() == std::vector<std::uint32_t>{4});
+    REQUIRE(frontier.blocked() == std::vector<std::uint32_t>{0});
+
+    frontier.complete(4);
+    REQUIRE_FALSE(frontier.has_ready());
+    frontier.complete(1);
+    REQUIRE(frontier.take_ready() == std::vector<std::uint32_t>{0});
+    frontier.complete(0);
+    REQUIRE(frontier.remaining() == 0);
+    REQUIRE(frontier.blocked().empty());
+}
+
+TEST_CASE ("topological frontier stops at cycles", "[graphs]")
+{
+    Graphs::CsrGraph g;
+    g.add_edge(0, 1);
+    g.add_edge(1, 2);
+    g.add_edge(2, 1);
+    g.add_vertex(3);
+    g.freeze();
+
+    Graphs::TopologicalFrontier frontier(g);
+    while (auto v = frontier.pop_ready())
+        frontier.complete(*v.get());
+
+    REQUIRE(frontier.remaining() == 3);
+    REQUIRE(frontier.blocked() == std::vector<std::uint32_t>{0, 1, 2});
+}
+
+TEST_CASE ("topological sort of a long chain", "[graphs]")
+{
+    const int length = 200000;
+    const auto sorted = Graphs::topological_sort(std::vector<int>{0}, ChainProvider{length}, nullptr);
+
+    REQUIRE(sorted.size() == static_cast<std::size_t>(length));
+    REQUIRE(sorted.front() == length - 1);
+    REQUIRE(sorted.back() == 0);
+
+    Graphs::CsrGraph g;
+    for (std::uint32_t v = 0; v + 1 < static_cast<std::uint32_t>(length); ++v)
+        g.add_edge(v, v + 1);
+    g.freeze();
+    const auto leveled = Graphs::leveled_topological_sort(g, vertex_name);
+    REQUIRE(leveled.level[0] == static_cast<std::uint32_t>(length - 1));
+    REQUIRE(leveled.remaining_work[length - 1] == static_cast<std::uint64_t>(length));
+}
@@ -0,0 +1,724 @@
+#include <vcpkg-test/memoryfilesystem.h>
+
+#include <vcpkg/base/checks.h>
+#include <vcpkg/base/strings.h>
+#include <vcpkg/base/util.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace vcpkg::Test
+{
+    using Lock = std::lock_guard<std::recursive_mutex>;
+
+    static constexpr fs::perms DEFAULT_FILE_PERMISSIONS =
+        fs::perms::owner_read | fs::perms::owner_write | fs::perms::group_read | fs::perms::others_read;
+    static constexpr fs::perms DEFAULT_DIRECTORY_PERMISSIONS =
+        DEFAULT_FILE_PERMISSIONS | fs::perms::owner_exec | fs::perms::group_exec | fs::perms::others_exec;
+
+    static std::vector<std::string> split_components(const std::string& generic_path)
+    {
+        std::vector<std::string> components;
+        for (auto&& component : Strings::split(generic_path, "/"))
+        {
+            if (!component.empty()) components.push_back(component);
+        }
+        return components;
+    }
+
+    static std::string join_key(const std::string& parent, const std::string& name)
+    {
+        return parent == "/" ? parent + name : Strings::concat(parent, '/', name);
+    }
+
+    static std::string parent_key(const std::string& key)
+    {
+        const auto slash = key.find_last_of('/');
+        return slash == 0 ? "/" : key.substr(0, slash);
+    }
+
+    static std::string name_of_key(const std::string& key) { return key.substr(key.find_last_of('/') + 1); }
+
+    /// <summary>
+    /// Errors meaning that nothing is there, which status reports as file_type::not_found rather than as errors,
+    /// as the real filesystem does.
+    /// </summary>
+    static bool is_not_found(const std::error_code& ec)
+    {
+        return ec == std::errc::no_such_file_or_directory || ec == std::errc::not_a_directory;
+    }
+
+    MemoryFilesystem::MemoryFilesystem()
+    {
+        Node root;
+        root.type = fs::file_type::directory;
+        root.permissions = DEFAULT_DIRECTORY_PERMISSIONS;
+        m_nodes.emplace("/", std::move(root));
+    }
+
+    const MemoryFilesystem::Node* MemoryFilesystem::find(const std::string& key) const
+    {
+        const auto it = m_nodes.find(key);
+        return it == m_nodes.end() ? nullptr : &it->second;
+    }
+
+    MemoryFilesystem::Node* MemoryFilesystem::find(const std::string& key)
+    {
+        const auto it = m_nodes.find(key);
+        return it == m_nodes.end() ? nullptr : &it->second;
+    }
+
+    fs::perms MemoryFilesystem::permissions_of(const Node& node) const
+    {
+        return node.type == fs::file_type::regular ? node.data->permissions : node.permissions;
+    }
+
+    std::string MemoryFilesystem::resolve(const fs::path& path, bool follow, std::error_code& ec) const
+    {
+        ec.clear();
+        auto pending = split_components(path.generic_u8string());
+        std::reverse(pending.begin(), pending.end());
+
+        std::string current = "/";
+        int links_followed = 0;
+        while (!pending.empty())
+        {
+            auto component = std::move(pending.back());
+            pending.pop_back();
+            if (component == ".") continue;
+            if (component == "..")
+            {
+                current = parent_key(current);
+                continue;
+            }
+
+            const bool last = pending.empty();
+            auto key = join_key(current, component);
+            const auto node = find(key);
+            if (node && node->type == fs::file_type::symlink && (follow || !last))
+            {
+                if (++links_followed > 40)
+                {
+                    ec = std::make_error_code(std::errc::too_many_symbolic_link_levels);
+                    return {};
+                }
+
+                if (!node->target.empty() && node->target.front() == '/') current = "/";
+                auto target_components = split_components(node->target);
+                pending.insert(pending.end(), target_components.rbegin(), target_components.rend());
+                continue;
+            }
+
+            if (!last)
+            {
+                if (!node)
+                {
+                    ec = std::make_error_code(std::errc::no_such_file_or_directory);
+                    return {};
+                }
+                if (node->type != fs::file_type::directory)
+                {
+                    ec = std::make_error_code(std::errc::not_a_directory);
+                    return {};
+                }
+            }
+            current = std::move(key);
+        }
+        return current;
+    }
+
+    MemoryFilesystem::Node* MemoryFilesystem::writable_parent(const std::string& key, std::error_code& ec)
+    {
+        if (key == "/")
+        {
+            ec = std::make_error_code(std::errc::permission_denied);
+            return nullptr;
+        }
+
+        const auto parent = find(parent_key(key));
+        if (!parent)
+            ec = std::make_error_code(std::errc::no_such_file_or_directory);
+        else if (parent->type != fs::file_type::directory)
+            ec = std::make_error_code(std::errc::not_a_directory);
+        else if ((parent->permissions & fs::perms::owner_write) == fs::perms::none)
+            ec = std::make_error_code(std::errc::permission_denied);
+        else
+            return parent;
+        return nullptr;
+    }
+
+    void MemoryFilesystem::insert(const std::string& key, Node&& node)
+    {
+        find(parent_key(key))->children.insert(name_of_key(key));
+        m_nodes[key] = std::move(node);
+    }
+
+    void MemoryFilesystem::erase_tree(const std::string& key)
+    {
+        const auto it = m_nodes.find(key);
+        if (it == m_nodes.end()) return;
+        for (auto&& child : std::set<std::string>(it->second.children))
+            erase_tree(join_key(key, child));
+
+        if (key == "/") return;
+        m_nodes.erase(key);
+        find(parent_key(key))->children.erase(name_of_key(key));
+    }
+
+    template<class Nodes>
+    static void rekey_children(Nodes& nodes, const std::string& from, const std::string& to)
+    {
+        const auto children = nodes.at(to).children;
+        for (auto&& child : children)
+        {
+            const auto child_from = join_key(from, child);
+            const auto child_to = join_key(to, child);
+            auto node = std::move(nodes.at(child_from));
+            nodes.erase(child_from);
+            nodes[child_to] = std::move(node);
+            rekey_children(nodes, child_from, child_to);
+        }
+    }
+
+    void MemoryFilesystem::move_tree(const std::string& from, const std::string& to)
+    {
+        auto node = std::move(m_nodes.at(from));
+        m_nodes.erase(from);
+        find(parent_key(from))->children.erase(name_of_key(from));
+        insert(to, std::move(node));
+        rekey_children(m_nodes, from, to);
+    }
+
+    bool MemoryFilesystem::create_directory_at(const std::string& key, std::error_code& ec)
+    {
+        if (const auto existing = find(key))
+        {
+            if (existing->type != fs::file_type::directory) ec = std::make_error_code(std::errc::file_exists);
+            return false;
+        }
+
+        if (!writable_parent(key, ec)) return false;
+        Node node;
+        node.type = fs::file_type::directory;
+        node.permissions = DEFAULT_DIRECTORY_PERMISSIONS;
+        insert(key, std::move(node));
+        return true;
+    }
+
+    void MemoryFilesystem::create_symlink(const fs::path& target, const fs::path& link, std::error_code& ec)
+    {
+        Lock lock(m_mutex);
+        const auto key = resolve(link, false, ec);
+        if (ec) return;
+        if (find(key))
+        {
+            ec = std::make_error_code(std::errc::file_exists);
+            return;
+        }
+        if (!writable_parent(key, ec)) return;
+
+        Node node;
+        node.type = fs::file_type::symlink;
+        node.target = target.generic_u8string();
+        node.permissions = fs::perms::all;
+        insert(key, std::move(node));
+    }
+
+    void MemoryFilesystem::set_permissions(const fs::path& path, fs::perms permissions, std::error_code& ec)
+    {
+        Lock lock(m_mutex);
+        const auto key = resolve(path, false, ec);
+        if (ec) return;
+        const auto node = find(key);
+        if (!node)
+            ec = std::make_error_code(std::errc::no_such_file_or_directory);
+        else if (node->type == fs::file_type::regular)
+            node->data->permissions = permissions;
+        else
+            node->permissions = permissions;
+    }
+
+    Expected<std::string> MemoryFilesystem::read_contents(const fs::path& file_path) const
+    {
+        Lock lock(m_mutex);
+        std::error_code ec;
+        const auto key = resolve(file_path, true, ec);
+        if (ec) return ec;
+        const auto node = find(key);
+        if (!node) return std::make_error_code(std::errc::no_such_file_or_directory);
+        if (node->type != fs::file_type::regular) return std::make_error_code(std::errc::is_a_directory);
+        return node->data->contents;
+    }
+
+    Expected<std::vector<std::string>> MemoryFilesystem::read_lines(const fs::path& file_path) const
+    {
+        auto maybe_contents = read_contents(file_path);
+        const auto contents = maybe_contents.get();
+        if (!contents) return maybe_contents.error();
+
+        std::vector<std::string> lines;
+        size_t start = 0;
+        while (start < contents->size())
+        {
+            auto end = contents->find('\n', start);
+            if (end == std::string::npos) end = contents->size();
+            lines.push_back(contents->substr(start, end - start));
+            // As in the real filesystem, to accomodate Windows line endings
+            if (!lines.back().empty() && lines.back().back() == '\r') lines.back().pop_back();
+            start = end + 1;
+        }
+        return lines;
+    }
+
+    fs::path MemoryFilesystem::find_file_recursively_up(const fs::path& starting_dir,
+                                                        const std::string& filename) const
+    {
+        fs::path current_dir = starting_dir;
+        for (;;)
+        {
+            if (exists(VCPKG_LINE_INFO, current_dir / filename)) return current_dir;
+
+            auto parent = current_dir.parent_path();
+            if (!current_dir.has_relative_path() || parent == current_dir) return {};
+            current_dir = std::move(parent);
+        }
+    }
+
+    std::vector<fs::path> MemoryFilesystem::get_files_recursive(const fs::path& dir) const
+    {
+        std::vector<fs::path> ret;
+        walk_directory(dir, [&](const Files::DirectoryEntry& entry) { ret.push_back(entry.path); });
+        return ret;
+    }
+
+    std::vector<fs::path> MemoryFilesystem::get_files_non_recursive(const fs::path& dir) const
+    {
+        std::vector<fs::path> ret;
+        std::error_code ec;
+        read_directory(dir, [&](Files::DirectoryEntry&& entry) { ret.push_back(std::move(entry.path)); }, ec);
+        return ret;
+    }
+
+    void MemoryFilesystem::read_directory(const fs::path& dir,
+                                          const std::function<void(Files::DirectoryEntry&&)>& visit,
+                                          std::error_code& ec) const
+    {
+        std::vector<Files::DirectoryEntry> entries;
+        {
+            Lock lock(m_mutex);
+            const auto key = resolve(dir, true, ec);
+            if (ec) return;
+            const auto node = find(key);
+            if (!node)
+            {
+                ec = std::make_error_code(std::errc::no_such_file_or_directory);
+                return;
+            }
+            if (node->type != fs::file_type::directory)
+            {
+                ec = std::make_error_code(std::errc::not_a_directory);
+                return;
+            }
+
+            for (auto&& child : node->children)
+            {
+                entries.push_back({dir / fs::u8path(child), find(join_key(key, child))->type});
+            }
+        }
+
+        // Outside the lock, so that visit may use this filesystem
+        for (auto&& entry : entries)
+            visit(std::move(entry));
+    }
+
+    void MemoryFilesystem::write_lines(const fs::path& file_path,
+                                       const std::vector<std::string>& lines,
+                                       std::error_code& ec)
+    {
+        std::string contents;
+        for (auto&& line : lines)
+            Strings::append(contents, line, '\n');
+        write_contents(file_path, contents, ec);
+    }
+
+    void MemoryFilesystem::write_contents(const fs::path& file_path, const std::string& data, std::error_code& ec)
+    {
+        Lock lock(m_mutex);
+        const auto key = resolve(file_path, true, ec);
+        if (ec) return;
+
+        if (const auto node = find(key))
+        {
+            if (node->type != fs::file_type::regular)
+                ec = std::make_error_code(std::errc::is_a_directory);
+            else if ((node->data->permissions & fs::perms::owner_write) == fs::perms::none)
+                ec = std::make_error_code(std::errc::permission_denied);
+            else
+                node->data->contents = data;
+            return;
+        }
+
+        if (!writable_parent(key, ec)) return;
+        Node node;
+        node.type = fs::file_type::regular;
+        node.data = std::make_shared<FileData>(FileData{data, DEFAULT_FILE_PERMISSIONS});
+        insert(key, std::move(node));
+    }
+
+    void MemoryFilesystem::rename(const fs::path& oldpath, const fs::path& newpath, std::error_code& ec)
+    {
+        Lock lock(m_mutex);
+        const auto from = resolve(oldpath, false, ec);
+        if (ec) return;
+        const auto to = resolve(newpath, false, ec);
+        if (ec) return;
+
+        const auto source = find(from);
+        if (!source)
+        {
+            ec = std::make_error_code(std::errc::no_such_file_or_directory);
+            return;
+        }
+        if (!writable_parent(from, ec) || !writable_parent(to, ec)) return;
+        if (from == to) return;
+        if (Strings::starts_with(to, from + '/'))
+        {
+            ec = std::make_error_code(std::errc::invalid_argument);
+            return;
+        }
+
+        if (const auto destination = find(to))
+        {
+            const bool source_is_directory = source->type == fs::file_type::directory;
+            const bool destination_is_directory = destination->type == fs::file_type::directory;
+            if (source_is_directory && !destination_is_directory)
+                ec = std::make_error_code(std::errc::not_a_directory);
+            else if (!source_is_directory && destination_is_directory)
+                ec = std::make_error_code(std::errc::is_a_directory);
+            else if (destination_is_directory && !destination->children.empty())
+                ec = std::make_error_code(std::errc::directory_not_empty);
+            if (ec) return;
+            erase_tree(to);
+        }
+
+        move_tree(from, to);
+    }
+
+    void MemoryFilesystem::rename_or_copy(const fs::path& oldpath,
+                                          const fs::path& newpath,
+                                          StringLiteral temp_suffix,
+                                          std::error_code& ec)
+    {
+        // Everything is on one device, so renaming always works where copying would
+        Util::unused(temp_suffix);
+        rename(oldpath, newpath, ec);
+    }
+
+    bool MemoryFilesystem::remove(const fs::path& path, std::error_code& ec)
+    {
+        Lock lock(m_mutex);
+        const auto key = resolve(path, false, ec);
+        if (ec)
+        {
+            if (is_not_found(ec)) ec.clear();
+            return false;
+        }
+
+        const auto node = find(key);
+        if (!node) return false;
+        if (node->type == fs::file_type::directory && !node->children.empty())
+        {
+            ec = std::make_error_code(std::errc::directory_not_empty);
+            return false;
+        }
+        if (!writable_parent(key, ec)) return false;
+
+        erase_tree(key);
+        return true;
+    }
+
+    void MemoryFilesystem::remove_all(const fs::path& path, std::error_code& ec, fs::path& failure_point)
+    {
+        Lock lock(m_mutex);
+        const auto key = resolve(path, false, ec);
+        if (ec)
+        {
+            if (is_not_found(ec))
+                ec.clear();
+            else
+                failure_point = path;
+            return;
+        }
+
+        // As the real filesystem does, removes read-only entries too
+        erase_tree(key);
+    }
+
+    bool MemoryFilesystem::is_directory(const fs::path& path) const
+    {
+        std::error_code ec;
+        return fs::is_directory(status(path, ec));
+    }
+
+    bool MemoryFilesystem::is_regular_file(const fs::path& path) const
+    {
+        std::error_code ec;
+        return fs::is_regular_file(status(path, ec));
+    }
+
+    bool MemoryFilesystem::is_empty(const fs::path& path) const
+    {
+        Lock lock(m_mutex);
+        std::error_code ec;
+        const auto key = resolve(path, true, ec);
+        const auto node = ec ? nullptr : find(key);
+        if (!node)
+        {
+            if (!ec) ec = std::make_error_code(std::errc::no_such_file_or_directory);
+            throw fs::stdfs::filesystem_error("is_empty", path, ec);
+        }
+
+        if (node->type == fs::file_type::directory) return node->children.empty();
+        return node->data->contents.empty();
+    }
+
+    std::uintmax_t MemoryFilesystem::file_size(const fs::path& path, std::error_code& ec) const
+    {
+        Lock lock(m_mutex);
+        const auto key = resolve(path, true, ec);
+        if (ec) return static_cast<std::uintmax_t>(-1);
+        const auto node = find(key);
+        if (!node)
+            ec = std::make_error_code(std::errc::no_such_file_or_directory);
+        else if (node->type != fs::file_type::regular)
+            ec = std::make_error_code(std::errc::is_a_directory);
+        else
+            return node->data->contents.size();
+        return static_cast<std::uintmax_t>(-1);
+    }
+
+    std::uintmax_t MemoryFilesystem::hard_link_count(const fs::path& path, std::error_code& ec) const
+    {
+        Lock lock(m_mutex);
+        const auto key = resolve(path, true, ec);
+        if (ec) return static_cast<std::uintmax_t>(-1);
+        const auto node = find(key);
+        if (!node)
+        {
+            ec = std::make_error_code(std::errc::no_such_file_or_directory);
+            return static_cast<std::uintmax_t>(-1);
+        }
+        // Hard links share their data
+        if (node->type == fs::file_type::regular) return static_cast<std::uintmax_t>(node->data.use_count());
+        return 1;
+    }
+
+    bool MemoryFilesystem::create_directory(const fs::path& path, std::error_code& ec)
+    {
+        Lock lock(m_mutex);
+        const auto key = resolve(path, true, ec);
+        if (ec) return false;
+        return create_directory_at(key, ec);
+    }
+
+    bool MemoryFilesystem::create_directories(const fs::path& path, std::error_code& ec)
+    {
+        Lock lock(m_mutex);
+        ec.clear();
+        bool created = false;
+        fs::path prefix = "/";
+        for (auto&& component : split_components(path.generic_u8string()))
+        {
+            prefix /= fs::u8path(component);
+            const auto key = resolve(prefix, true, ec);
+            if (ec) return false;
+            if (create_directory_at(key, ec)) created = true;
+            if (ec) return false;
+        }
+        return created;
+    }
+
+    void MemoryFilesystem::copy_entry(const fs::path& from, const fs::path& to, fs::copy_options opts, bool nested)
+    {
+        const bool copy_symlinks = (opts & fs::copy_options::copy_symlinks) != fs::copy_options::none;
+        const bool skip_symlinks = (opts & fs::copy_options::skip_symlinks) != fs::copy_options::none;
+        const bool recursive = (opts & fs::copy_options::recursive) != fs::copy_options::none;
+
+        std::error_code ec;
+        const auto from_status = copy_symlinks || skip_symlinks ? symlink_status(from, ec) : status(from, ec);
+        if (!ec && !fs::exists(from_status)) ec = std::make_error_code(std::errc::no_such_file_or_directory);
+        if (ec) throw fs::stdfs::filesystem_error("copy", from, to, ec);
+
+        if (fs::is_symlink(from_status))
+        {
+            if (!skip_symlinks) copy_symlink(from, to, ec);
+        }
+        else if (fs::is_regular_file(from_status))
+        {
+            copy_file(from, is_directory(to) ? to / from.filename() : to, opts, ec);
+        }
+        else if (fs::is_directory(from_status) && (recursive || !nested))
+        {
+            // As std::experimental::filesystem::copy, a copy that is not recursive copies only what is directly in
+            // the directory
+            create_directory(to, ec);
+            if (!ec)
+            {
+                for (auto&& child : get_files_non_recursive(from))
+                {
+                    if (!recursive && is_directory(child)) continue;
+                    copy_entry(child, to / child.filename(), opts, true);
+                }
+            }
+        }
+
+        if (ec) throw fs::stdfs::filesystem_error("copy", from, to, ec);
+    }
+
+    void MemoryFilesystem::copy(const fs::path& oldpath, const fs::path& newpath, fs::copy_options opts)
+    {
+        Lock lock(m_mutex);
+        copy_entry(oldpath, newpath, opts, false);
+    }
+
+    bool MemoryFilesystem::copy_file(const fs::path& oldpath,
+                                     const fs::path& newpath,
+                                     fs::copy_options opts,
+                                     std::error_code& ec)
+    {
+        Lock lock(m_mutex);
+        const auto from = resolve(oldpath, true, ec);
+        if (ec) return false;
+        const auto source = find(from);
+        if (!source)
+        {
+            ec = std::make_error_code(std::errc::no_such_file_or_directory);
+            return false;
+        }
+        if (source->type != fs::file_type::regular)
+        {
+            ec = std::make_error_code(std::errc::is_a_directory);
+            return false;
+        }
+
+        const auto to = resolve(newpath, true, ec);
+        if (ec) return false;
+        if (const auto destination = find(to))
+        {
+            const auto overwrite_options = fs::copy_options::overwrite_existing | fs::copy_options::update_existing;
+            const bool overwrite = (opts & overwrite_options) != fs::copy_options::none;
+            if (destination->type != fs::file_type::regular || destination->data == source->data)
+                ec = std::make_error_code(std::errc::file_exists);
+            else if ((opts & fs::copy_options::skip_existing) != fs::copy_options::none)
+                return false;
+            else if (!overwrite)
+                ec = std::make_error_code(std::errc::file_exists);
+            else if ((destination->data->permissions & fs::perms::owner_write) == fs::perms::none)
+                ec = std::make_error_code(std::errc::permission_denied);
+            if (ec) return false;
+
+            destination->data->contents = source->data->contents;
+            return true;
+        }
+
+        if (!writable_parent(to, ec)) return false;
+        Node node;
+        node.type = fs::file_type::regular;
+        node.data = std::make_shared<FileData>(*source->data);
+        insert(to, std::move(node));
+        return true;
+    }
+
+    void MemoryFilesystem::copy_symlink(const fs::path& oldpath, const fs::path& newpath, std::error_code& ec)
+    {
+        Lock lock(m_mutex);
+        const auto from = resolve(oldpath, false, ec);
+        if (ec) return;
+        const auto source = find(from);
+        if (!source)
+            ec = std::make_error_code(std::errc::no_such_file_or_directory);
+        else if (source->type != fs::file_type::symlink)
+            ec = std::make_error_code(std::errc::invalid_argument);
+        else
+            create_symlink(fs::u8path(source->target), newpath, ec);
+    }
+
+    void MemoryFilesystem::create_hard_link(const fs::path& target, const fs::path& link, std::error_code& ec)
+    {
+        Lock lock(m_mutex);
+        const auto from = resolve(target, true, ec);
+        if (ec) return;
+        const auto source = find(from);
+        if (!source)
+        {
+            ec = std::make_error_code(std::errc::no_such_file_or_directory);
+            return;
+        }
+        if (source->type != fs::file_type::regular)
+        {
+            ec = std::make_error_code(std::errc::operation_not_permitted);
+            return;
+        }
+
+        const auto to = resolve(link, false, ec);
+        if (ec) return;
+        if (find(to))
+        {
+            ec = std::make_error_code(std::errc::file_exists);
+            return;
+        }
+        if (!writable_parent(to, ec)) return;
+
+        Node node;
+        node.type = fs::file_type::regular;
+        node.data = source->data;
+        insert(to, std::move(node));
+    }
+
+    fs::file_status MemoryFilesystem::status(const fs::path& path, std::error_code& ec) const
+    {
+        Lock lock(m_mutex);
+        const auto key = resolve(path, true, ec);
+        const auto node = ec ? nullptr : find(key);
+        if (!node)
+        {
+            if (ec && !is_not_found(ec)) return fs::file_status(fs::file_type::none);
+            ec.clear();
+            return fs::file_status(fs::file_type::not_found);
+        }
+        return fs::file_status(node->type, permissions_of(*node));
+    }
+
+    fs::file_status MemoryFilesystem::symlink_status(const fs::path& path, std::error_code& ec) const
+    {
+        Lock lock(m_mutex);
+        const auto key = resolve(path, false, ec);
+        const auto node = ec ? nullptr : find(key);
+        if (!node)
+        {
+            if (ec && !is_not_found(ec)) return fs::file_status(fs::file_type::none);
+            ec.clear();
+            return fs::file_status(fs::file_type::not_found);
+        }
+        return fs::file_status(node->type, permissions_of(*node));
+    }
+
+    fs::path MemoryFilesystem::canonical(const fs::path& path, std::error_code& ec) const
+    {
+        Lock lock(m_mutex);
+        const auto key = resolve(path, true, ec);
+        if (ec) return {};
+        if (!find(key))
+        {
+            ec = std::make_error_code(std::errc::no_such_file_or_directory);
+            return {};
+        }
+        return fs::u8path(key);
+    }
+
+    std::vector<fs::path> MemoryFilesystem::find_from_PATH(const std::string& name) const
+    {
+        Util::unused(name);
+        return {};
+    }
+}
@@ -139,6 +139,30 @@ TEST_CASE ("SourceParagraph default features", "[paragraph]")
     REQUIRE(pgh.core_paragraph->default_features[0] == "a1");
 }
 
+TEST_CASE ("SourceParagraph peak memory", "[paragraph]")
+{
+    auto m_pgh =
+        vcpkg::SourceControlFile::parse_control_file(std::vector<std::unordered_map<std::string, std::string>>{{
+            {"Source", "a"},
+            {"Version", "1.0"},
+            {"Peak-Memory-Mb", "4096"},
+        }});
+    REQUIRE(m_pgh.has_value());
+    REQUIRE((*m_pgh.get())->core_paragraph->peak_memory_mb.value_or_exit(VCPKG_LINE_INFO) == 4096);
+
+    for (auto&& invalid : {"lots", "-5", "4096mb", "99999999999999999999"})
+    {
+        auto m_invalid =
+            vcpkg::SourceControlFile::parse_control_file(std::vector<std::unordered_map<std::string, std::string>>{{
+                {"Source", "a"},
+                {"Version", "1.0"},
+                {"Peak-Memory-Mb", invalid},
+            }});
+        REQUIRE_FALSE(m_invalid.has_value());
+        REQUIRE(m_invalid.error()->invalid_fields == std::vector<std::string>{"Peak-Memory-Mb"});
+    }
+}
+
 TEST_CASE ("BinaryParagraph construct minimum", "[paragraph]")
 {
     vcpkg::BinaryParagraph pgh({
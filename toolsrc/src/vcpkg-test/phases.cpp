@@ -0,0 +1,34 @@
+#include <catch2/catch.hpp>
+
+#include <vcpkg/base/phases.h>
+
+#include <chrono>
+#include <thread>
+
+using namespace vcpkg;
+using Phases::Phase;
+
+TEST_CASE ("nested phases", "[phases]")
+{
+    using namespace std::chrono_literals;
+
+    const auto outer_before = Phases::get_totals(Phase::STATUS_WRITES);
+    const auto inner_before = Phases::get_totals(Phase::FILE_INSTALLS);
+
+    {
+        Phases::Scope outer(Phase::STATUS_WRITES);
+        {
+            Phases::Scope inner(Phase::FILE_INSTALLS);
+            std::this_thread::sleep_for(50ms);
+        }
+    }
+
+    const auto outer_after = Phases::get_totals(Phase::STATUS_WRITES);
+    const auto inner_after = Phases::get_totals(Phase::FILE_INSTALLS);
+    REQUIRE(outer_after.count == outer_before.count + 1);
+    REQUIRE(inner_after.count == inner_before.count + 1);
+
+    // The time asleep counts only towards the inner phase
+    REQUIRE(inner_after.elapsed - inner_before.elapsed >= 50ms);
+    REQUIRE(outer_after.elapsed - outer_before.elapsed < 25ms);
+}
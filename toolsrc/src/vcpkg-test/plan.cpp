@@ -1,4 +1,5 @@
 #include <catch2/catch.hpp>
+#include <vcpkg-test/portuniverse.h>
 #include <vcpkg-test/util.h>
 
 #include <vcpkg/dependencies.h>
@@ -6,8 +7,10 @@
 #include <vcpkg/sourceparagraph.h>
 #include <vcpkg/triplet.h>
 
+#include <algorithm>
 #include <memory>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 using namespace vcpkg;
@@ -117,12 +120,13 @@ TEST_CASE ("basic install scheme", "[plan]")
 
     PackageSpecMap spec_map;
     auto spec_a = spec_map.emplace("a", "b");
-    auto spec_b = spec_map.emplace("b", "c");
-    auto spec_c = spec_map.emplace("c");
+    spec_map.emplace("b", "c");
+    spec_map.emplace("c");
 
     PortFileProvider::MapPortFileProvider map_port(spec_map.map);
+    CMakeVars::MockCMakeVarProvider var_provider;
     auto install_plan = Dependencies::PackageGraph::create_feature_install_plan(
-        map_port, {FeatureSpec{spec_a, ""}}, StatusParagraphs(std::move(status_paragraphs)));
+        map_port, var_provider, {FullPackageSpec{spec_a, {"core"}}}, StatusParagraphs(std::move(status_paragraphs)));
 
     REQUIRE(install_plan.size() == 3);
     REQUIRE(install_plan.at(0).spec().name() == "c");
@@ -144,10 +148,12 @@ TEST_CASE ("multiple install scheme", "[plan]")
     auto spec_g = spec_map.emplace("g");
     auto spec_h = spec_map.emplace("h");
 
-    Dependencies::MapPortFileProvider map_port(spec_map.map);
-    auto install_plan = Dependencies::create_feature_install_plan(
+    PortFileProvider::MapPortFileProvider map_port(spec_map.map);
+    CMakeVars::MockCMakeVarProvider var_provider;
+    auto install_plan = Dependencies::PackageGraph::create_feature_install_plan(
         map_port,
-        {FeatureSpec{spec_a, ""}, FeatureSpec{spec_b, ""}, FeatureSpec{spec_c, ""}},
+        var_provider,
+        {FullPackageSpec{spec_a, {"core"}}, FullPackageSpec{spec_b, {"core"}}, FullPackageSpec{spec_c, {"core"}}},
         StatusParagraphs(std::move(status_paragraphs)));
 
     auto iterator_pos = [&](const PackageSpec& spec) {
@@ -185,8 +191,10 @@ TEST_CASE ("existing package scheme", "[plan]")
     PackageSpecMap spec_map;
     auto spec_a = FullPackageSpec{spec_map.emplace("a")};
 
-    auto install_plan = Dependencies::create_feature_install_plan(
-        spec_map.map, FullPackageSpec::to_feature_specs({spec_a}), StatusParagraphs(std::move(status_paragraphs)));
+    PortFileProvider::MapPortFileProvider map_port(spec_map.map);
+    CMakeVars::MockCMakeVarProvider var_provider;
+    auto install_plan = Dependencies::PackageGraph::create_feature_install_plan(
+        map_port, var_provider, {spec_a}, StatusParagraphs(std::move(status_paragraphs)));
 
     REQUIRE(install_plan.size() == 1);
     const auto p = install_plan.at(0).install_action.get();
@@ -204,8 +212,10 @@ TEST_CASE ("user requested package scheme", "[plan]")
     const auto spec_a = FullPackageSpec{spec_map.emplace("a", "b")};
     const auto spec_b = FullPackageSpec{spec_map.emplace("b")};
 
-    const auto install_plan = Dependencies::create_feature_install_plan(
-        spec_map.map, FullPackageSpec::to_feature_specs({spec_a}), StatusParagraphs(std::move(status_paragraphs)));
+    PortFileProvider::MapPortFileProvider map_port(spec_map.map);
+    CMakeVars::MockCMakeVarProvider var_provider;
+    const auto install_plan = Dependencies::PackageGraph::create_feature_install_plan(
+        map_port, var_provider, {spec_a}, StatusParagraphs(std::move(status_paragraphs)));
 
     REQUIRE(install_plan.size() == 2);
     const auto p = install_plan.at(0).install_action.get();
@@ -230,19 +240,20 @@ TEST_CASE ("long install scheme", "[plan]")
     PackageSpecMap spec_map;
 
     auto spec_a = spec_map.emplace("a", "b, c, d, e, f, g, h, j, k");
-    auto spec_b = spec_map.emplace("b", "c, d, e, f, g, h, j, k");
-    auto spec_c = spec_map.emplace("c", "d, e, f, g, h, j, k");
-    auto spec_d = spec_map.emplace("d", "e, f, g, h, j, k");
-    auto spec_e = spec_map.emplace("e", "f, g, h, j, k");
-    auto spec_f = spec_map.emplace("f", "g, h, j, k");
-    auto spec_g = spec_map.emplace("g", "h, j, k");
-    auto spec_h = spec_map.emplace("h", "j, k");
-    auto spec_j = spec_map.emplace("j", "k");
-    auto spec_k = spec_map.emplace("k");
-
-    Dependencies::MapPortFileProvider map_port(spec_map.map);
-    auto install_plan = Dependencies::create_feature_install_plan(
-        map_port, {FeatureSpec{spec_a, ""}}, StatusParagraphs(std::move(status_paragraphs)));
+    spec_map.emplace("b", "c, d, e, f, g, h, j, k");
+    spec_map.emplace("c", "d, e, f, g, h, j, k");
+    spec_map.emplace("d", "e, f, g, h, j, k");
+    spec_map.emplace("e", "f, g, h, j, k");
+    spec_map.emplace("f", "g, h, j, k");
+    spec_map.emplace("g", "h, j, k");
+    spec_map.emplace("h", "j, k");
+    spec_map.emplace("j", "k");
+    spec_map.emplace("k");
+
+    PortFileProvider::MapPortFileProvider map_port(spec_map.map);
+    CMakeVars::MockCMakeVarProvider var_provider;
+    auto install_plan = Dependencies::PackageGraph::create_feature_install_plan(
+        map_port, var_provider, {FullPackageSpec{spec_a, {"core"}}}, StatusParagraphs(std::move(status_paragraphs)));
 
     REQUIRE(install_plan.size() == 8);
     REQUIRE(install_plan.at(0).spec().name() == "h");
@@ -266,8 +277,10 @@ TEST_CASE ("basic feature test 1", "[plan]")
     auto spec_a = FullPackageSpec{spec_map.emplace("a", "b, b[b1]", {{"a1", "b[b2]"}}), {"a1"}};
     auto spec_b = FullPackageSpec{spec_map.emplace("b", "", {{"b1", ""}, {"b2", ""}, {"b3", ""}})};
 
-    auto install_plan = Dependencies::create_feature_install_plan(
-        spec_map.map, FullPackageSpec::to_feature_specs({spec_a}), StatusParagraphs(std::move(status_paragraphs)));
+    PortFileProvider::MapPortFileProvider map_port(spec_map.map);
+    CMakeVars::MockCMakeVarProvider var_provider;
+    auto install_plan = Dependencies::PackageGraph::create_feature_install_plan(
+        map_port, var_provider, {spec_a}, StatusParagraphs(std::move(status_paragraphs)));
 
     REQUIRE(install_plan.size() == 4);
     remove_plan_check(install_plan.at(0), "a");
@@ -285,8 +298,10 @@ TEST_CASE ("basic feature test 2", "[plan]")
     auto spec_a = FullPackageSpec{spec_map.emplace("a", "b[b1]", {{"a1", "b[b2]"}}), {"a1"}};
     auto spec_b = FullPackageSpec{spec_map.emplace("b", "", {{"b1", ""}, {"b2", ""}, {"b3", ""}})};
 
-    auto install_plan = Dependencies::create_feature_install_plan(
-        spec_map.map, FullPackageSpec::to_feature_specs({spec_a}), StatusParagraphs(std::move(status_paragraphs)));
+    PortFileProvider::MapPortFileProvider map_port(spec_map.map);
+    CMakeVars::MockCMakeVarProvider var_provider;
+    auto install_plan = Dependencies::PackageGraph::create_feature_install_plan(
+        map_port, var_provider, {spec_a}, StatusParagraphs(std::move(status_paragraphs)));
 
     REQUIRE(install_plan.size() == 2);
     features_check(install_plan.at(0), "b", {"b1", "b2", "core"});
@@ -304,9 +319,10 @@ TEST_CASE ("basic feature test 3", "[plan]")
     auto spec_b = FullPackageSpec{spec_map.emplace("b")};
     auto spec_c = FullPackageSpec{spec_map.emplace("c", "a[a1]"), {"core"}};
 
-    auto install_plan = Dependencies::create_feature_install_plan(spec_map.map,
-                                                                  FullPackageSpec::to_feature_specs({spec_c, spec_a}),
-                                                                  StatusParagraphs(std::move(status_paragraphs)));
+    PortFileProvider::MapPortFileProvider map_port(spec_map.map);
+    CMakeVars::MockCMakeVarProvider var_provider;
+    auto install_plan = Dependencies::PackageGraph::create_feature_install_plan(
+        map_port, var_provider, {spec_c, spec_a}, StatusParagraphs(std::move(status_paragraphs)));
 
     REQUIRE(install_plan.size() == 4);
     remove_plan_check(install_plan.at(0), "a");
@@ -327,8 +343,10 @@ TEST_CASE ("basic feature test 4", "[plan]")
     auto spec_b = FullPackageSpec{spec_map.emplace("b")};
     auto spec_c = FullPackageSpec{spec_map.emplace("c", "a[a1]"), {"core"}};
 
-    auto install_plan = Dependencies::create_feature_install_plan(
-        spec_map.map, FullPackageSpec::to_feature_specs({spec_c}), StatusParagraphs(std::move(status_paragraphs)));
+    PortFileProvider::MapPortFileProvider map_port(spec_map.map);
+    CMakeVars::MockCMakeVarProvider var_provider;
+    auto install_plan = Dependencies::PackageGraph::create_feature_install_plan(
+        map_port, var_provider, {spec_c}, StatusParagraphs(std::move(status_paragraphs)));
 
     REQUIRE(install_plan.size() == 1);
     features_check(install_plan.at(0), "c", {"core"});
@@ -344,8 +362,10 @@ TEST_CASE ("basic feature test 5", "[plan]")
         FullPackageSpec{spec_map.emplace("a", "", {{"a1", "b[b1]"}, {"a2", "b[b2]"}, {"a3", "a[a2]"}}), {"a3"}};
     auto spec_b = FullPackageSpec{spec_map.emplace("b", "", {{"b1", ""}, {"b2", ""}})};
 
-    auto install_plan = Dependencies::create_feature_install_plan(
-        spec_map.map, FullPackageSpec::to_feature_specs({spec_a}), StatusParagraphs(std::move(status_paragraphs)));
+    PortFileProvider::MapPortFileProvider map_port(spec_map.map);
+    CMakeVars::MockCMakeVarProvider var_provider;
+    auto install_plan = Dependencies::PackageGraph::create_feature_install_plan(
+        map_port, var_provider, {spec_a}, StatusParagraphs(std::move(status_paragraphs)));
 
     REQUIRE(install_plan.size() == 2);
     features_check(install_plan.at(0), "b", {"core", "b2"});
@@ -361,9 +381,10 @@ TEST_CASE ("basic feature test 6", "[plan]")
     auto spec_a = FullPackageSpec{spec_map.emplace("a", "b[core]"), {"core"}};
     auto spec_b = FullPackageSpec{spec_map.emplace("b", "", {{"b1", ""}}), {"b1"}};
 
-    auto install_plan = Dependencies::create_feature_install_plan(spec_map.map,
-                                                                  FullPackageSpec::to_feature_specs({spec_a, spec_b}),
-                                                                  StatusParagraphs(std::move(status_paragraphs)));
+    PortFileProvider::MapPortFileProvider map_port(spec_map.map);
+    CMakeVars::MockCMakeVarProvider var_provider;
+    auto install_plan = Dependencies::PackageGraph::create_feature_install_plan(
+        map_port, var_provider, {spec_a, spec_b}, StatusParagraphs(std::move(status_paragraphs)));
 
     REQUIRE(install_plan.size() == 3);
     remove_plan_check(install_plan.at(0), "b");
@@ -383,8 +404,10 @@ TEST_CASE ("basic feature test 7", "[plan]")
     auto spec_x = FullPackageSpec{spec_map.emplace("x", "a"), {"core"}};
     auto spec_b = FullPackageSpec{spec_map.emplace("b", "", {{"b1", ""}}), {"b1"}};
 
-    auto install_plan = Dependencies::create_feature_install_plan(
-        spec_map.map, FullPackageSpec::to_feature_specs({spec_b}), StatusParagraphs(std::move(status_paragraphs)));
+    PortFileProvider::MapPortFileProvider map_port(spec_map.map);
+    CMakeVars::MockCMakeVarProvider var_provider;
+    auto install_plan = Dependencies::PackageGraph::create_feature_install_plan(
+        map_port, var_provider, {spec_b}, StatusParagraphs(std::move(status_paragraphs)));
 
     REQUIRE(install_plan.size() == 5);
     remove_plan_check(install_plan.at(0), "x");
@@ -414,9 +437,12 @@ TEST_CASE ("basic feature test 8", "[plan][!mayfail]")
     auto spec_b_86 = FullPackageSpec{spec_map.emplace("b")};
     auto spec_c_86 = FullPackageSpec{spec_map.emplace("c", "a[a1]"), {"core"}};
 
-    auto install_plan = Dependencies::create_feature_install_plan(
-        spec_map.map,
-        FullPackageSpec::to_feature_specs({spec_c_64, spec_a_86, spec_a_64, spec_c_86}),
+    PortFileProvider::MapPortFileProvider map_port(spec_map.map);
+    CMakeVars::MockCMakeVarProvider var_provider;
+    auto install_plan = Dependencies::PackageGraph::create_feature_install_plan(
+        map_port,
+        var_provider,
+        {spec_c_64, spec_a_86, spec_a_64, spec_c_86},
         StatusParagraphs(std::move(status_paragraphs)));
 
     remove_plan_check(install_plan.at(0), "a", Triplet::X64_WINDOWS);
@@ -439,9 +465,12 @@ TEST_CASE ("install all features test", "[plan]")
     auto install_specs = FullPackageSpec::from_string("a[*]", Triplet::X64_WINDOWS);
     REQUIRE(install_specs.has_value());
     if (!install_specs.has_value()) return;
-    auto install_plan = Dependencies::create_feature_install_plan(
-        spec_map.map,
-        FullPackageSpec::to_feature_specs({install_specs.value_or_exit(VCPKG_LINE_INFO)}),
+    PortFileProvider::MapPortFileProvider map_port(spec_map.map);
+    CMakeVars::MockCMakeVarProvider var_provider;
+    auto install_plan = Dependencies::PackageGraph::create_feature_install_plan(
+        map_port,
+        var_provider,
+        {install_specs.value_or_exit(VCPKG_LINE_INFO)},
         StatusParagraphs(std::move(status_paragraphs)));
 
     REQUIRE(install_plan.size() == 1);
@@ -458,9 +487,12 @@ TEST_CASE ("install default features test 1", "[plan]")
 
     // Install "a" (without explicit feature specification)
     auto install_specs = FullPackageSpec::from_string("a", Triplet::X64_WINDOWS);
-    auto install_plan = Dependencies::create_feature_install_plan(
-        spec_map.map,
-        FullPackageSpec::to_feature_specs({install_specs.value_or_exit(VCPKG_LINE_INFO)}),
+    PortFileProvider::MapPortFileProvider map_port(spec_map.map);
+    CMakeVars::MockCMakeVarProvider var_provider;
+    auto install_plan = Dependencies::PackageGraph::create_feature_install_plan(
+        map_port,
+        var_provider,
+        {install_specs.value_or_exit(VCPKG_LINE_INFO)},
         StatusParagraphs(std::move(status_paragraphs)));
 
     // Expect the default feature "1" to be installed, but not "0"
@@ -483,9 +515,12 @@ TEST_CASE ("install default features test 2", "[plan]")
 
     // Install "a" (without explicit feature specification)
     auto install_specs = FullPackageSpec::from_string("a", Triplet::X64_WINDOWS);
-    auto install_plan = Dependencies::create_feature_install_plan(
-        spec_map.map,
-        FullPackageSpec::to_feature_specs({install_specs.value_or_exit(VCPKG_LINE_INFO)}),
+    PortFileProvider::MapPortFileProvider map_port(spec_map.map);
+    CMakeVars::MockCMakeVarProvider var_provider;
+    auto install_plan = Dependencies::PackageGraph::create_feature_install_plan(
+        map_port,
+        var_provider,
+        {install_specs.value_or_exit(VCPKG_LINE_INFO)},
         StatusParagraphs(std::move(status_paragraphs)));
 
     // Expect "a" to get removed for rebuild and then installed with default
@@ -505,9 +540,12 @@ TEST_CASE ("install default features test 3", "[plan]")
 
     // Explicitly install "a" without default features
     auto install_specs = FullPackageSpec::from_string("a[core]", Triplet::X64_WINDOWS);
-    auto install_plan = Dependencies::create_feature_install_plan(
-        spec_map.map,
-        FullPackageSpec::to_feature_specs({install_specs.value_or_exit(VCPKG_LINE_INFO)}),
+    PortFileProvider::MapPortFileProvider map_port(spec_map.map);
+    CMakeVars::MockCMakeVarProvider var_provider;
+    auto install_plan = Dependencies::PackageGraph::create_feature_install_plan(
+        map_port,
+        var_provider,
+        {install_specs.value_or_exit(VCPKG_LINE_INFO)},
         StatusParagraphs(std::move(status_paragraphs)));
 
     // Expect the default feature not to get installed.
@@ -527,9 +565,12 @@ TEST_CASE ("install default features of dependency test 1", "[plan]")
 
     // Install "a" (without explicit feature specification)
     auto install_specs = FullPackageSpec::from_string("a", Triplet::X64_WINDOWS);
-    auto install_plan = Dependencies::create_feature_install_plan(
-        spec_map.map,
-        FullPackageSpec::to_feature_specs({install_specs.value_or_exit(VCPKG_LINE_INFO)}),
+    PortFileProvider::MapPortFileProvider map_port(spec_map.map);
+    CMakeVars::MockCMakeVarProvider var_provider;
+    auto install_plan = Dependencies::PackageGraph::create_feature_install_plan(
+        map_port,
+        var_provider,
+        {install_specs.value_or_exit(VCPKG_LINE_INFO)},
         StatusParagraphs(std::move(status_paragraphs)));
 
     // Expect "a" to get installed and defaults of "b" through the dependency,
@@ -555,9 +596,12 @@ TEST_CASE ("do not install default features of existing dependency", "[plan]")
 
     // Install "a" (without explicit feature specification)
     auto install_specs = FullPackageSpec::from_string("a", Triplet::X64_WINDOWS);
-    auto install_plan = Dependencies::create_feature_install_plan(
-        spec_map.map,
-        FullPackageSpec::to_feature_specs({install_specs.value_or_exit(VCPKG_LINE_INFO)}),
+    PortFileProvider::MapPortFileProvider map_port(spec_map.map);
+    CMakeVars::MockCMakeVarProvider var_provider;
+    auto install_plan = Dependencies::PackageGraph::create_feature_install_plan(
+        map_port,
+        var_provider,
+        {install_specs.value_or_exit(VCPKG_LINE_INFO)},
         StatusParagraphs(std::move(status_paragraphs)));
 
     // Expect "a" to get installed, but not require rebuilding "b"
@@ -581,9 +625,12 @@ TEST_CASE ("install default features of dependency test 2", "[plan]")
 
     // Install "a" (without explicit feature specification)
     auto install_specs = FullPackageSpec::from_string("a", Triplet::X64_WINDOWS);
-    auto install_plan = Dependencies::create_feature_install_plan(
-        spec_map.map,
-        FullPackageSpec::to_feature_specs({install_specs.value_or_exit(VCPKG_LINE_INFO)}),
+    PortFileProvider::MapPortFileProvider map_port(spec_map.map);
+    CMakeVars::MockCMakeVarProvider var_provider;
+    auto install_plan = Dependencies::PackageGraph::create_feature_install_plan(
+        map_port,
+        var_provider,
+        {install_specs.value_or_exit(VCPKG_LINE_INFO)},
         StatusParagraphs(std::move(status_paragraphs)));
 
     // Expect "a" to get installed, not the defaults of "b", as the required
@@ -605,19 +652,22 @@ TEST_CASE ("install plan action dependencies", "[plan]")
 
     // Install "a" (without explicit feature specification)
     auto install_specs = FullPackageSpec::from_string("a", Triplet::X64_WINDOWS);
-    auto install_plan = Dependencies::create_feature_install_plan(
-        spec_map.map,
-        FullPackageSpec::to_feature_specs({install_specs.value_or_exit(VCPKG_LINE_INFO)}),
+    PortFileProvider::MapPortFileProvider map_port(spec_map.map);
+    CMakeVars::MockCMakeVarProvider var_provider;
+    auto install_plan = Dependencies::PackageGraph::create_feature_install_plan(
+        map_port,
+        var_provider,
+        {install_specs.value_or_exit(VCPKG_LINE_INFO)},
         StatusParagraphs(std::move(status_paragraphs)));
 
     REQUIRE(install_plan.size() == 3);
     features_check(install_plan.at(0), "c", {"core"}, Triplet::X64_WINDOWS);
 
     features_check(install_plan.at(1), "b", {"core"}, Triplet::X64_WINDOWS);
-    REQUIRE(install_plan.at(1).install_action.get()->computed_dependencies == std::vector<PackageSpec>{spec_c});
+    REQUIRE(install_plan.at(1).install_action.get()->package_dependencies == std::vector<PackageSpec>{spec_c});
 
     features_check(install_plan.at(2), "a", {"core"}, Triplet::X64_WINDOWS);
-    REQUIRE(install_plan.at(2).install_action.get()->computed_dependencies == std::vector<PackageSpec>{spec_b});
+    REQUIRE(install_plan.at(2).install_action.get()->package_dependencies == std::vector<PackageSpec>{spec_b});
 }
 
 TEST_CASE ("install plan action dependencies 2", "[plan]")
@@ -633,19 +683,22 @@ TEST_CASE ("install plan action dependencies 2", "[plan]")
 
     // Install "a" (without explicit feature specification)
     auto install_specs = FullPackageSpec::from_string("a", Triplet::X64_WINDOWS);
-    auto install_plan = Dependencies::create_feature_install_plan(
-        spec_map.map,
-        FullPackageSpec::to_feature_specs({install_specs.value_or_exit(VCPKG_LINE_INFO)}),
+    PortFileProvider::MapPortFileProvider map_port(spec_map.map);
+    CMakeVars::MockCMakeVarProvider var_provider;
+    auto install_plan = Dependencies::PackageGraph::create_feature_install_plan(
+        map_port,
+        var_provider,
+        {install_specs.value_or_exit(VCPKG_LINE_INFO)},
         StatusParagraphs(std::move(status_paragraphs)));
 
     REQUIRE(install_plan.size() == 3);
     features_check(install_plan.at(0), "c", {"core"}, Triplet::X64_WINDOWS);
 
     features_check(install_plan.at(1), "b", {"core"}, Triplet::X64_WINDOWS);
-    REQUIRE(install_plan.at(1).install_action.get()->computed_dependencies == std::vector<PackageSpec>{spec_c});
+    REQUIRE(install_plan.at(1).install_action.get()->package_dependencies == std::vector<PackageSpec>{spec_c});
 
     features_check(install_plan.at(2), "a", {"core"}, Triplet::X64_WINDOWS);
-    REQUIRE(install_plan.at(2).install_action.get()->computed_dependencies == std::vector<PackageSpec>{spec_b, spec_c});
+    REQUIRE(install_plan.at(2).install_action.get()->package_dependencies == std::vector<PackageSpec>{spec_b, spec_c});
 }
 
 TEST_CASE ("install plan action dependencies 3", "[plan]")
@@ -659,14 +712,17 @@ TEST_CASE ("install plan action dependencies 3", "[plan]")
 
     // Install "a" (without explicit feature specification)
     auto install_specs = FullPackageSpec::from_string("a", Triplet::X64_WINDOWS);
-    auto install_plan = Dependencies::create_feature_install_plan(
-        spec_map.map,
-        FullPackageSpec::to_feature_specs({install_specs.value_or_exit(VCPKG_LINE_INFO)}),
+    PortFileProvider::MapPortFileProvider map_port(spec_map.map);
+    CMakeVars::MockCMakeVarProvider var_provider;
+    auto install_plan = Dependencies::PackageGraph::create_feature_install_plan(
+        map_port,
+        var_provider,
+        {install_specs.value_or_exit(VCPKG_LINE_INFO)},
         StatusParagraphs(std::move(status_paragraphs)));
 
     REQUIRE(install_plan.size() == 1);
     features_check(install_plan.at(0), "a", {"1", "0", "core"}, Triplet::X64_WINDOWS);
-    REQUIRE(install_plan.at(0).install_action.get()->computed_dependencies == std::vector<PackageSpec>{});
+    REQUIRE(install_plan.at(0).install_action.get()->package_dependencies == std::vector<PackageSpec>{});
 }
 
 TEST_CASE ("install with default features", "[plan]")
@@ -680,8 +736,10 @@ TEST_CASE ("install with default features", "[plan]")
     auto a_spec = spec_map.emplace("a", "b[core]", {{"0", ""}});
 
     // Install "a" and indicate that "b" should not install default features
-    auto install_plan = Dependencies::create_feature_install_plan(
-        spec_map.map, {FeatureSpec{a_spec, "0"}, FeatureSpec{b_spec, "core"}}, status_db);
+    PortFileProvider::MapPortFileProvider map_port(spec_map.map);
+    CMakeVars::MockCMakeVarProvider var_provider;
+    auto install_plan = Dependencies::PackageGraph::create_feature_install_plan(
+        map_port, var_provider, {FullPackageSpec{a_spec, {"0"}}, FullPackageSpec{b_spec, {"core"}}}, status_db);
 
     REQUIRE(install_plan.size() == 3);
     remove_plan_check(install_plan.at(0), "a");
@@ -700,11 +758,9 @@ TEST_CASE ("upgrade with default features 1", "[plan]")
     PackageSpecMap spec_map;
     auto spec_a = spec_map.emplace("a", "", {{"0", ""}, {"1", ""}}, {"1"});
 
-    Dependencies::MapPortFileProvider provider(spec_map.map);
-    Dependencies::PackageGraph graph(provider, status_db);
-
-    graph.upgrade(spec_a);
-    auto plan = graph.serialize();
+    PortFileProvider::MapPortFileProvider provider(spec_map.map);
+    CMakeVars::MockCMakeVarProvider var_provider;
+    auto plan = Dependencies::PackageGraph::create_upgrade_plan(provider, var_provider, {spec_a}, status_db);
 
     // The upgrade should not install the default feature
     REQUIRE(plan.size() == 2);
@@ -727,12 +783,9 @@ TEST_CASE ("upgrade with default features 2", "[plan]")
     auto spec_a = spec_map.emplace("a", "b[core]");
     auto spec_b = spec_map.emplace("b", "", {{"b0", ""}, {"b1", ""}}, {"b0", "b1"});
 
-    Dependencies::MapPortFileProvider provider(spec_map.map);
-    Dependencies::PackageGraph graph(provider, status_db);
-
-    graph.upgrade(spec_a);
-    graph.upgrade(spec_b);
-    auto plan = graph.serialize();
+    PortFileProvider::MapPortFileProvider provider(spec_map.map);
+    CMakeVars::MockCMakeVarProvider var_provider;
+    auto plan = Dependencies::PackageGraph::create_upgrade_plan(provider, var_provider, {spec_a, spec_b}, status_db);
 
     // The upgrade should install the new default feature b1 but not b0
     REQUIRE(plan.size() == 4);
@@ -755,11 +808,9 @@ TEST_CASE ("upgrade with default features 3", "[plan]")
     auto spec_a = spec_map.emplace("a", "b[core]");
     spec_map.emplace("b", "", {{"b0", ""}, {"b1", ""}}, {"b0"});
 
-    Dependencies::MapPortFileProvider provider(spec_map.map);
-    Dependencies::PackageGraph graph(provider, status_db);
-
-    graph.upgrade(spec_a);
-    auto plan = graph.serialize();
+    PortFileProvider::MapPortFileProvider provider(spec_map.map);
+    CMakeVars::MockCMakeVarProvider var_provider;
+    auto plan = Dependencies::PackageGraph::create_upgrade_plan(provider, var_provider, {spec_a}, status_db);
 
     // The upgrade should install the default feature
     REQUIRE(plan.size() == 3);
@@ -778,11 +829,9 @@ TEST_CASE ("upgrade with new default feature", "[plan]")
     PackageSpecMap spec_map;
     auto spec_a = spec_map.emplace("a", "", {{"0", ""}, {"1", ""}, {"2", ""}}, {"0", "1"});
 
-    Dependencies::MapPortFileProvider provider(spec_map.map);
-    Dependencies::PackageGraph graph(provider, status_db);
-
-    graph.upgrade(spec_a);
-    auto plan = graph.serialize();
+    PortFileProvider::MapPortFileProvider provider(spec_map.map);
+    CMakeVars::MockCMakeVarProvider var_provider;
+    auto plan = Dependencies::PackageGraph::create_upgrade_plan(provider, var_provider, {spec_a}, status_db);
 
     // The upgrade should install the new default feature but not the old default feature 0
     REQUIRE(plan.size() == 2);
@@ -802,9 +851,12 @@ TEST_CASE ("transitive features test", "[plan]")
     auto install_specs = FullPackageSpec::from_string("a[*]", Triplet::X64_WINDOWS);
     REQUIRE(install_specs.has_value());
     if (!install_specs.has_value()) return;
-    auto install_plan = Dependencies::create_feature_install_plan(
-        spec_map.map,
-        FullPackageSpec::to_feature_specs({install_specs.value_or_exit(VCPKG_LINE_INFO)}),
+    PortFileProvider::MapPortFileProvider map_port(spec_map.map);
+    CMakeVars::MockCMakeVarProvider var_provider;
+    auto install_plan = Dependencies::PackageGraph::create_feature_install_plan(
+        map_port,
+        var_provider,
+        {install_specs.value_or_exit(VCPKG_LINE_INFO)},
         StatusParagraphs(std::move(status_paragraphs)));
 
     REQUIRE(install_plan.size() == 3);
@@ -825,9 +877,12 @@ TEST_CASE ("no transitive features test", "[plan]")
     auto install_specs = FullPackageSpec::from_string("a[*]", Triplet::X64_WINDOWS);
     REQUIRE(install_specs.has_value());
     if (!install_specs.has_value()) return;
-    auto install_plan = Dependencies::create_feature_install_plan(
-        spec_map.map,
-        FullPackageSpec::to_feature_specs({install_specs.value_or_exit(VCPKG_LINE_INFO)}),
+    PortFileProvider::MapPortFileProvider map_port(spec_map.map);
+    CMakeVars::MockCMakeVarProvider var_provider;
+    auto install_plan = Dependencies::PackageGraph::create_feature_install_plan(
+        map_port,
+        var_provider,
+        {install_specs.value_or_exit(VCPKG_LINE_INFO)},
         StatusParagraphs(std::move(status_paragraphs)));
 
     REQUIRE(install_plan.size() == 3);
@@ -848,9 +903,12 @@ TEST_CASE ("only transitive features test", "[plan]")
     auto install_specs = FullPackageSpec::from_string("a[*]", Triplet::X64_WINDOWS);
     REQUIRE(install_specs.has_value());
     if (!install_specs.has_value()) return;
-    auto install_plan = Dependencies::create_feature_install_plan(
-        spec_map.map,
-        FullPackageSpec::to_feature_specs({install_specs.value_or_exit(VCPKG_LINE_INFO)}),
+    PortFileProvider::MapPortFileProvider map_port(spec_map.map);
+    CMakeVars::MockCMakeVarProvider var_provider;
+    auto install_plan = Dependencies::PackageGraph::create_feature_install_plan(
+        map_port,
+        var_provider,
+        {install_specs.value_or_exit(VCPKG_LINE_INFO)},
         StatusParagraphs(std::move(status_paragraphs)));
 
     REQUIRE(install_plan.size() == 3);
@@ -865,7 +923,7 @@ TEST_CASE ("basic remove scheme", "[plan]")
     pghs.push_back(make_status_pgh("a"));
     StatusParagraphs status_db(std::move(pghs));
 
-    auto remove_plan = Dependencies::create_remove_plan({unsafe_pspec("a")}, status_db);
+    auto remove_plan = Dependencies::PackageGraph::create_remove_plan({unsafe_pspec("a")}, status_db);
 
     REQUIRE(remove_plan.size() == 1);
     REQUIRE(remove_plan.at(0).spec.name() == "a");
@@ -878,13 +936,26 @@ TEST_CASE ("recurse remove scheme", "[plan]")
     pghs.push_back(make_status_pgh("b", "a"));
     StatusParagraphs status_db(std::move(pghs));
 
-    auto remove_plan = Dependencies::create_remove_plan({unsafe_pspec("a")}, status_db);
+    auto remove_plan = Dependencies::PackageGraph::create_remove_plan({unsafe_pspec("a")}, status_db);
 
     REQUIRE(remove_plan.size() == 2);
     REQUIRE(remove_plan.at(0).spec.name() == "b");
     REQUIRE(remove_plan.at(1).spec.name() == "a");
 }
 
+TEST_CASE ("remove scheme with a dependency that is not installed", "[plan]")
+{
+    std::vector<std::unique_ptr<StatusParagraph>> pghs;
+    pghs.push_back(make_status_pgh("b", "a"));
+    StatusParagraphs status_db(std::move(pghs));
+
+    auto remove_plan = Dependencies::PackageGraph::create_remove_plan({unsafe_pspec("a")}, status_db);
+
+    REQUIRE(remove_plan.size() == 1);
+    REQUIRE(remove_plan.at(0).spec.name() == "a");
+    REQUIRE(remove_plan.at(0).plan_type == Dependencies::RemovePlanType::NOT_INSTALLED);
+}
+
 TEST_CASE ("features depend remove scheme", "[plan]")
 {
     std::vector<std::unique_ptr<StatusParagraph>> pghs;
@@ -893,7 +964,7 @@ TEST_CASE ("features depend remove scheme", "[plan]")
     pghs.push_back(make_status_feature_pgh("b", "0", "a"));
     StatusParagraphs status_db(std::move(pghs));
 
-    auto remove_plan = Dependencies::create_remove_plan({unsafe_pspec("a")}, status_db);
+    auto remove_plan = Dependencies::PackageGraph::create_remove_plan({unsafe_pspec("a")}, status_db);
 
     REQUIRE(remove_plan.size() == 2);
     REQUIRE(remove_plan.at(0).spec.name() == "b");
@@ -909,7 +980,7 @@ TEST_CASE ("features depend remove scheme once removed", "[plan]")
     pghs.push_back(make_status_feature_pgh("opencv", "vtk", "vtk"));
     StatusParagraphs status_db(std::move(pghs));
 
-    auto remove_plan = Dependencies::create_remove_plan({unsafe_pspec("expat")}, status_db);
+    auto remove_plan = Dependencies::PackageGraph::create_remove_plan({unsafe_pspec("expat")}, status_db);
 
     REQUIRE(remove_plan.size() == 3);
     REQUIRE(remove_plan.at(0).spec.name() == "opencv");
@@ -926,8 +997,8 @@ TEST_CASE ("features depend remove scheme once removed x64", "[plan]")
     pghs.push_back(make_status_feature_pgh("opencv", "vtk", "vtk", "x64"));
     StatusParagraphs status_db(std::move(pghs));
 
-    auto remove_plan =
-        Dependencies::create_remove_plan({unsafe_pspec("expat", Triplet::from_canonical_name("x64"))}, status_db);
+    auto remove_plan = Dependencies::PackageGraph::create_remove_plan(
+        {unsafe_pspec("expat", Triplet::from_canonical_name("x64"))}, status_db);
 
     REQUIRE(remove_plan.size() == 3);
     REQUIRE(remove_plan.at(0).spec.name() == "opencv");
@@ -942,8 +1013,8 @@ TEST_CASE ("features depend core remove scheme", "[plan]")
     pghs.push_back(make_status_pgh("cpr", "curl[core]", "", "x64"));
     StatusParagraphs status_db(std::move(pghs));
 
-    auto remove_plan =
-        Dependencies::create_remove_plan({unsafe_pspec("curl", Triplet::from_canonical_name("x64"))}, status_db);
+    auto remove_plan = Dependencies::PackageGraph::create_remove_plan(
+        {unsafe_pspec("curl", Triplet::from_canonical_name("x64"))}, status_db);
 
     REQUIRE(remove_plan.size() == 2);
     REQUIRE(remove_plan.at(0).spec.name() == "cpr");
@@ -958,8 +1029,8 @@ TEST_CASE ("features depend core remove scheme 2", "[plan]")
     pghs.push_back(make_status_feature_pgh("curl", "b", "curl[a]", "x64"));
     StatusParagraphs status_db(std::move(pghs));
 
-    auto remove_plan =
-        Dependencies::create_remove_plan({unsafe_pspec("curl", Triplet::from_canonical_name("x64"))}, status_db);
+    auto remove_plan = Dependencies::PackageGraph::create_remove_plan(
+        {unsafe_pspec("curl", Triplet::from_canonical_name("x64"))}, status_db);
 
     REQUIRE(remove_plan.size() == 1);
     REQUIRE(remove_plan.at(0).spec.name() == "curl");
@@ -974,12 +1045,9 @@ TEST_CASE ("basic upgrade scheme", "[plan]")
     PackageSpecMap spec_map;
     auto spec_a = spec_map.emplace("a");
 
-    Dependencies::MapPortFileProvider provider(spec_map.map);
-    Dependencies::PackageGraph graph(provider, status_db);
-
-    graph.upgrade(spec_a);
-
-    auto plan = graph.serialize();
+    PortFileProvider::MapPortFileProvider provider(spec_map.map);
+    CMakeVars::MockCMakeVarProvider var_provider;
+    auto plan = Dependencies::PackageGraph::create_upgrade_plan(provider, var_provider, {spec_a}, status_db);
 
     REQUIRE(plan.size() == 2);
     REQUIRE(plan.at(0).spec().name() == "a");
@@ -999,12 +1067,9 @@ TEST_CASE ("basic upgrade scheme with recurse", "[plan]")
     auto spec_a = spec_map.emplace("a");
     spec_map.emplace("b", "a");
 
-    Dependencies::MapPortFileProvider provider(spec_map.map);
-    Dependencies::PackageGraph graph(provider, status_db);
-
-    graph.upgrade(spec_a);
-
-    auto plan = graph.serialize();
+    PortFileProvider::MapPortFileProvider provider(spec_map.map);
+    CMakeVars::MockCMakeVarProvider var_provider;
+    auto plan = Dependencies::PackageGraph::create_upgrade_plan(provider, var_provider, {spec_a}, status_db);
 
     REQUIRE(plan.size() == 4);
     REQUIRE(plan.at(0).spec().name() == "b");
@@ -1031,12 +1096,9 @@ TEST_CASE ("basic upgrade scheme with bystander", "[plan]")
     auto spec_a = spec_map.emplace("a");
     spec_map.emplace("b", "a");
 
-    Dependencies::MapPortFileProvider provider(spec_map.map);
-    Dependencies::PackageGraph graph(provider, status_db);
-
-    graph.upgrade(spec_a);
-
-    auto plan = graph.serialize();
+    PortFileProvider::MapPortFileProvider provider(spec_map.map);
+    CMakeVars::MockCMakeVarProvider var_provider;
+    auto plan = Dependencies::PackageGraph::create_upgrade_plan(provider, var_provider, {spec_a}, status_db);
 
     REQUIRE(plan.size() == 2);
     REQUIRE(plan.at(0).spec().name() == "a");
@@ -1055,12 +1117,9 @@ TEST_CASE ("basic upgrade scheme with new dep", "[plan]")
     auto spec_a = spec_map.emplace("a", "b");
     spec_map.emplace("b");
 
-    Dependencies::MapPortFileProvider provider(spec_map.map);
-    Dependencies::PackageGraph graph(provider, status_db);
-
-    graph.upgrade(spec_a);
-
-    auto plan = graph.serialize();
+    PortFileProvider::MapPortFileProvider provider(spec_map.map);
+    CMakeVars::MockCMakeVarProvider var_provider;
+    auto plan = Dependencies::PackageGraph::create_upgrade_plan(provider, var_provider, {spec_a}, status_db);
 
     REQUIRE(plan.size() == 3);
     REQUIRE(plan.at(0).spec().name() == "a");
@@ -1081,12 +1140,9 @@ TEST_CASE ("basic upgrade scheme with features", "[plan]")
     PackageSpecMap spec_map;
     auto spec_a = spec_map.emplace("a", "", {{"a1", ""}});
 
-    Dependencies::MapPortFileProvider provider(spec_map.map);
-    Dependencies::PackageGraph graph(provider, status_db);
-
-    graph.upgrade(spec_a);
-
-    auto plan = graph.serialize();
+    PortFileProvider::MapPortFileProvider provider(spec_map.map);
+    CMakeVars::MockCMakeVarProvider var_provider;
+    auto plan = Dependencies::PackageGraph::create_upgrade_plan(provider, var_provider, {spec_a}, status_db);
 
     REQUIRE(plan.size() == 2);
 
@@ -1107,12 +1163,9 @@ TEST_CASE ("basic upgrade scheme with new default feature", "[plan]")
     PackageSpecMap spec_map;
     auto spec_a = spec_map.emplace("a", "", {{"a1", ""}}, {"a1"});
 
-    Dependencies::MapPortFileProvider provider(spec_map.map);
-    Dependencies::PackageGraph graph(provider, status_db);
-
-    graph.upgrade(spec_a);
-
-    auto plan = graph.serialize();
+    PortFileProvider::MapPortFileProvider provider(spec_map.map);
+    CMakeVars::MockCMakeVarProvider var_provider;
+    auto plan = Dependencies::PackageGraph::create_upgrade_plan(provider, var_provider, {spec_a}, status_db);
 
     REQUIRE(plan.size() == 2);
 
@@ -1133,12 +1186,9 @@ TEST_CASE ("basic upgrade scheme with self features", "[plan]")
     PackageSpecMap spec_map;
     auto spec_a = spec_map.emplace("a", "", {{"a1", ""}, {"a2", "a[a1]"}});
 
-    Dependencies::MapPortFileProvider provider(spec_map.map);
-    Dependencies::PackageGraph graph(provider, status_db);
-
-    graph.upgrade(spec_a);
-
-    auto plan = graph.serialize();
+    PortFileProvider::MapPortFileProvider provider(spec_map.map);
+    CMakeVars::MockCMakeVarProvider var_provider;
+    auto plan = Dependencies::PackageGraph::create_upgrade_plan(provider, var_provider, {spec_a}, status_db);
 
     REQUIRE(plan.size() == 2);
 
@@ -1147,7 +1197,9 @@ TEST_CASE ("basic upgrade scheme with self features", "[plan]")
 
     REQUIRE(plan.at(1).spec().name() == "a");
     REQUIRE(plan.at(1).install_action.has_value());
-    REQUIRE(plan.at(1).install_action.get()->feature_list == std::set<std::string>{"core", "a1", "a2"});
+    auto feature_list = plan.at(1).install_action.get()->feature_list;
+    Util::sort(feature_list);
+    REQUIRE(feature_list == std::vector<std::string>{"a1", "a2", "core"});
 }
 
 TEST_CASE ("basic export scheme", "[plan]")
@@ -1159,7 +1211,7 @@ TEST_CASE ("basic export scheme", "[plan]")
     PackageSpecMap spec_map;
     auto spec_a = spec_map.emplace("a");
 
-    auto plan = Dependencies::create_export_plan({spec_a}, status_db);
+    auto plan = Dependencies::PackageGraph::create_export_plan({spec_a}, status_db);
 
     REQUIRE(plan.size() == 1);
     REQUIRE(plan.at(0).spec.name() == "a");
@@ -1174,10 +1226,10 @@ TEST_CASE ("basic export scheme with recurse", "[plan]")
     StatusParagraphs status_db(std::move(pghs));
 
     PackageSpecMap spec_map;
-    auto spec_a = spec_map.emplace("a");
+    spec_map.emplace("a");
     auto spec_b = spec_map.emplace("b", "a");
 
-    auto plan = Dependencies::create_export_plan({spec_b}, status_db);
+    auto plan = Dependencies::PackageGraph::create_export_plan({spec_b}, status_db);
 
     REQUIRE(plan.size() == 2);
     REQUIRE(plan.at(0).spec.name() == "a");
@@ -1196,9 +1248,9 @@ TEST_CASE ("basic export scheme with bystander", "[plan]")
 
     PackageSpecMap spec_map;
     auto spec_a = spec_map.emplace("a");
-    auto spec_b = spec_map.emplace("b", "a");
+    spec_map.emplace("b", "a");
 
-    auto plan = Dependencies::create_export_plan({spec_a}, status_db);
+    auto plan = Dependencies::PackageGraph::create_export_plan({spec_a}, status_db);
 
     REQUIRE(plan.size() == 1);
     REQUIRE(plan.at(0).spec.name() == "a");
@@ -1212,7 +1264,7 @@ TEST_CASE ("basic export scheme with missing", "[plan]")
     PackageSpecMap spec_map;
     auto spec_a = spec_map.emplace("a");
 
-    auto plan = Dependencies::create_export_plan({spec_a}, status_db);
+    auto plan = Dependencies::PackageGraph::create_export_plan({spec_a}, status_db);
 
     REQUIRE(plan.size() == 1);
     REQUIRE(plan.at(0).spec.name() == "a");
@@ -1230,7 +1282,7 @@ TEST_CASE ("basic export scheme with features", "[plan]")
     PackageSpecMap spec_map;
     auto spec_a = spec_map.emplace("a", "", {{"a1", ""}});
 
-    auto plan = Dependencies::create_export_plan({spec_a}, status_db);
+    auto plan = Dependencies::PackageGraph::create_export_plan({spec_a}, status_db);
 
     REQUIRE(plan.size() == 2);
 
@@ -1240,3 +1292,164 @@ TEST_CASE ("basic export scheme with features", "[plan]")
     REQUIRE(plan.at(1).spec.name() == "a");
     REQUIRE(plan.at(1).plan_type == Dependencies::ExportPlanType::ALREADY_BUILT);
 }
+
+TEST_CASE ("port universe", "[plan]")
+{
+    Test::PortUniverseOptions options;
+    options.port_count = 200;
+    const auto universe = Test::PortUniverse::generate(options);
+    const auto again = Test::PortUniverse::generate(options);
+
+    auto depends_of = [](const Test::PortUniverse& u, const std::string& name) {
+        return Util::fmap(u.ports.at(name).source_control_file->core_paragraph->depends,
+                          [](const Dependency& dep) { return dep.name() + " " + dep.qualifier; });
+    };
+
+    REQUIRE(universe.names.size() == 200);
+    REQUIRE(universe.names == again.names);
+    for (auto&& name : universe.names)
+        REQUIRE(depends_of(universe, name) == depends_of(again, name));
+
+    const auto triplet = Triplet::X86_WINDOWS;
+    PortFileProvider::MapPortFileProvider provider(universe.ports);
+    CMakeVars::MockCMakeVarProvider var_provider;
+    universe.provide_dep_info_vars(var_provider, triplet);
+
+    SECTION ("install everything")
+    {
+        StatusParagraphs status_db;
+        auto plan = Dependencies::PackageGraph::create_feature_install_plan(
+            provider, var_provider, universe.full_specs(triplet), status_db);
+
+        // Every port is installed once, after everything it depends on
+        REQUIRE(plan.size() == 200);
+        std::unordered_set<std::string> installed;
+        for (auto&& action : plan)
+        {
+            auto install_action = action.install_action.get();
+            REQUIRE(install_action != nullptr);
+            for (auto&& dep : install_action->package_dependencies)
+                REQUIRE(installed.count(dep.name()) == 1);
+            installed.insert(install_action->spec.name());
+        }
+    }
+
+    const auto status_db = universe.install_all(triplet);
+
+    SECTION ("upgrade the most popular port")
+    {
+        auto plan = Dependencies::PackageGraph::create_upgrade_plan(
+            provider, var_provider, {universe.specs(triplet).front()}, status_db);
+
+        const auto removes = std::count_if(
+            plan.begin(), plan.end(), [](const auto& action) { return action.remove_action.has_value(); });
+        REQUIRE(removes > 1);
+        REQUIRE(plan.size() == 2 * static_cast<size_t>(removes));
+    }
+
+    SECTION ("remove everything")
+    {
+        auto plan = Dependencies::PackageGraph::create_remove_plan(universe.specs(triplet), status_db);
+        REQUIRE(plan.size() == 200);
+    }
+
+    SECTION ("export everything")
+    {
+        auto plan = Dependencies::PackageGraph::create_export_plan(universe.specs(triplet), status_db);
+        REQUIRE(plan.size() == 200);
+        REQUIRE(std::all_of(plan.begin(), plan.end(), [](const Dependencies::ExportPlanAction& action) {
+            return action.plan_type == Dependencies::ExportPlanType::ALREADY_BUILT;
+        }));
+    }
+}
+
+#if defined(CATCH_CONFIG_ENABLE_BENCHMARKING)
+TEST_CASE ("install plan -- benchmarks", "[plan][!benchmark]")
+{
+    static const Triplet TRIPLETS[] = {
+        Triplet::X86_WINDOWS,
+        Triplet::X64_WINDOWS,
+        Triplet::X86_UWP,
+        Triplet::X64_UWP,
+        Triplet::ARM_UWP,
+        Triplet::ARM64_WINDOWS,
+    };
+
+    Test::PortUniverseOptions options;
+    options.port_count = 2000;
+    const auto universe = Test::PortUniverse::generate(options);
+
+    PortFileProvider::MapPortFileProvider provider(universe.ports);
+    CMakeVars::MockCMakeVarProvider var_provider;
+    std::vector<FullPackageSpec> all_triplets;
+    for (auto&& triplet : TRIPLETS)
+    {
+        universe.provide_dep_info_vars(var_provider, triplet);
+        Util::Vectors::concatenate(&all_triplets, universe.full_specs(triplet));
+    }
+    const auto one_triplet = universe.full_specs(TRIPLETS[0]);
+    const StatusParagraphs status_db;
+
+    BENCHMARK("all ports, one triplet")
+    {
+        return Dependencies::PackageGraph::create_feature_install_plan(provider, var_provider, one_triplet, status_db);
+    };
+
+    BENCHMARK("all ports, six triplets")
+    {
+        return Dependencies::PackageGraph::create_feature_install_plan(provider, var_provider, all_triplets, status_db);
+    };
+}
+
+TEST_CASE ("planner scaling -- benchmarks", "[plan][!benchmark]")
+{
+    const auto triplet = Triplet::X64_WINDOWS;
+
+    for (const size_t port_count : {10000, 100000})
+    {
+        Test::PortUniverseOptions options;
+        options.port_count = port_count;
+        const auto universe = Test::PortUniverse::generate(options);
+
+        PortFileProvider::MapPortFileProvider provider(universe.ports);
+        CMakeVars::MockCMakeVarProvider var_provider;
+        universe.provide_dep_info_vars(var_provider, triplet);
+
+        const auto specs = universe.specs(triplet);
+        const auto full_specs = universe.full_specs(triplet);
+        // The last ports are the leaves, which pull in much of the universe
+        const std::vector<FullPackageSpec> leaves(full_specs.end() - 10, full_specs.end());
+        const std::vector<PackageSpec> popular(specs.begin(), specs.begin() + 10);
+        const StatusParagraphs empty_db;
+        const auto full_db = universe.install_all(triplet);
+
+        const auto suffix = Strings::concat(", ", port_count, " ports");
+
+        BENCHMARK("install all ports" + suffix)
+        {
+            return Dependencies::PackageGraph::create_feature_install_plan(
+                provider, var_provider, full_specs, empty_db);
+        };
+
+        BENCHMARK("install ten leaves" + suffix)
+        {
+            return Dependencies::PackageGraph::create_feature_install_plan(provider, var_provider, leaves, empty_db);
+        };
+
+        BENCHMARK("upgrade ten popular ports" + suffix)
+        {
+            return Dependencies::PackageGraph::create_upgrade_plan(provider, var_provider, popular, full_db);
+        };
+
+        BENCHMARK("remove ten popular ports" + suffix)
+        {
+            return Dependencies::PackageGraph::create_remove_plan(popular, full_db);
+        };
+
+        BENCHMARK("export all ports" + suffix)
+        {
+            return Dependencies::PackageGraph::create_export_plan(specs, full_db);
+        };
+    }
+}
+#endif
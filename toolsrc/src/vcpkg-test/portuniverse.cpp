@@ -0,0 +1,156 @@
+#include <vcpkg-test/portuniverse.h>
+
+#include <vcpkg/base/checks.h>
+#include <vcpkg/base/strings.h>
+#include <vcpkg/base/util.h>
+#include <vcpkg/logicexpression.h>
+
+#include <random>
+
+namespace vcpkg::Test
+{
+    namespace
+    {
+        /// <summary>
+        /// Draws from the engine directly, as the standard distributions differ between standard libraries.
+        /// </summary>
+        struct Dice
+        {
+            std::mt19937_64 engine;
+
+            explicit Dice(std::uint64_t seed) : engine(seed) {}
+
+            size_t below(size_t bound) { return bound == 0 ? 0 : static_cast<size_t>(engine() % bound); }
+            bool percent(unsigned chance) { return below(100) < chance; }
+
+            /// <summary>
+            /// One of the first bound ports, most likely one of the very first.
+            /// </summary>
+            size_t popular_below(size_t bound)
+            {
+                const double u = static_cast<double>(engine() >> 11) / static_cast<double>(1ull << 53);
+                return std::min(bound - 1, static_cast<size_t>(static_cast<double>(bound) * u * u * u));
+            }
+        };
+    }
+
+    static constexpr const char* QUALIFIERS[] = {"windows", "!uwp", "linux", "!arm"};
+
+    PortUniverse PortUniverse::generate(const PortUniverseOptions& options)
+    {
+        using Pgh = std::unordered_map<std::string, std::string>;
+
+        Dice dice(options.seed);
+        PortUniverse universe;
+        std::vector<size_t> feature_counts;
+
+        // Picks a dependency of port i, without repeating any in used
+        const auto pick_dependency = [&](size_t i, std::vector<size_t>& used) -> Optional<std::string> {
+            const auto j = dice.popular_below(i);
+            if (Util::find(used, j) != used.end()) return nullopt;
+            used.push_back(j);
+
+            auto dependency = universe.names[j];
+            if (feature_counts[j] > 0 && dice.percent(options.feature_dependency_percent))
+                Strings::append(dependency, "[feature", dice.below(feature_counts[j]), ']');
+            if (dice.percent(options.qualified_percent))
+                Strings::append(dependency, " (", QUALIFIERS[dice.below(4)], ')');
+            return dependency;
+        };
+
+        for (size_t i = 0; i < options.port_count; ++i)
+        {
+            universe.names.push_back(Strings::concat("port", i));
+            const auto& name = universe.names.back();
+
+            std::vector<size_t> used;
+            std::vector<std::string> depends;
+            const auto dependency_count = i == 0 ? 0 : dice.below(options.max_dependencies + 1);
+            for (size_t d = 0; d < dependency_count; ++d)
+            {
+                auto maybe_dependency = pick_dependency(i, used);
+                if (auto dependency = maybe_dependency.get()) depends.push_back(std::move(*dependency));
+            }
+
+            feature_counts.push_back(i == 0 ? 0 : dice.below(options.max_features + 1));
+            std::vector<std::string> default_features;
+            std::vector<Pgh> pghs(1);
+            for (size_t f = 0; f < feature_counts.back(); ++f)
+            {
+                auto feature_name = Strings::concat("feature", f);
+                std::vector<std::string> feature_depends;
+                const auto feature_dependency_count = 1 + dice.below(2);
+                for (size_t d = 0; d < feature_dependency_count; ++d)
+                {
+                    auto maybe_dependency = pick_dependency(i, used);
+                    if (auto dependency = maybe_dependency.get()) feature_depends.push_back(std::move(*dependency));
+                }
+                if (dice.percent(options.default_feature_percent)) default_features.push_back(feature_name);
+
+                pghs.push_back(Pgh{{"Feature", std::move(feature_name)},
+                                   {"Description", "feature"},
+                                   {"Build-Depends", Strings::join(", ", feature_depends)}});
+            }
+            pghs[0] = Pgh{{"Source", name},
+                          {"Version", "0"},
+                          {"Build-Depends", Strings::join(", ", depends)},
+                          {"Default-Features", Strings::join(", ", default_features)}};
+
+            auto maybe_scf = SourceControlFile::parse_control_file(std::move(pghs));
+            auto scf = maybe_scf.get();
+            Checks::check_exit(VCPKG_LINE_INFO, scf != nullptr, "generated an invalid port %s", name);
+            universe.ports.emplace(name, SourceControlFileLocation{std::move(*scf), ""});
+        }
+
+        return universe;
+    }
+
+    std::vector<PackageSpec> PortUniverse::specs(const Triplet& triplet) const
+    {
+        return Util::fmap(names, [&](const std::string& name) {
+            return PackageSpec::from_name_and_triplet(name, triplet).value_or_exit(VCPKG_LINE_INFO);
+        });
+    }
+
+    std::vector<FullPackageSpec> PortUniverse::full_specs(const Triplet& triplet) const
+    {
+        return Util::fmap(specs(triplet), [](const PackageSpec& spec) { return FullPackageSpec{spec}; });
+    }
+
+    StatusParagraphs PortUniverse::install_all(const Triplet& triplet) const
+    {
+        using Pgh = std::unordered_map<std::string, std::string>;
+
+        std::vector<std::unique_ptr<StatusParagraph>> status_paragraphs;
+        for (auto&& name : names)
+        {
+            const auto& core = *ports.at(name).source_control_file->core_paragraph;
+            std::vector<std::string> depends;
+            for (auto&& dependency : core.depends)
+            {
+                if (dependency.qualifier.empty() ||
+                    evaluate_expression(dependency.qualifier, triplet.canonical_name()))
+                {
+                    depends.push_back(dependency.depend.name);
+                }
+            }
+
+            status_paragraphs.push_back(std::make_unique<StatusParagraph>(
+                Pgh{{"Package", name},
+                    {"Version", "0"},
+                    {"Architecture", triplet.canonical_name()},
+                    {"Multi-Arch", "same"},
+                    {"Depends", Strings::join(", ", depends)},
+                    {"Default-Features", Strings::join(", ", core.default_features)},
+                    {"Status", "install ok installed"}}));
+        }
+        return StatusParagraphs(std::move(status_paragraphs));
+    }
+
+    void PortUniverse::provide_dep_info_vars(CMakeVars::MockCMakeVarProvider& var_provider,
+                                             const Triplet& triplet) const
+    {
+        for (auto&& spec : specs(triplet))
+            var_provider.dep_resolution_vars[spec] = {};
+    }
+}
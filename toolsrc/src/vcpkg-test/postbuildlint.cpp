@@ -0,0 +1,56 @@
+#include <catch2/catch.hpp>
+
+#include <vcpkg-test/util.h>
+
+#include <vcpkg/base/util.h>
+#include <vcpkg/postbuildlint.packagetree.h>
+
+using namespace vcpkg;
+using namespace vcpkg::PostBuildLint;
+
+TEST_CASE ("package tree snapshot", "[postbuildlint]")
+{
+    auto& fs = Files::get_real_filesystem();
+    const fs::path root = Test::base_temporary_directory() / "package-tree";
+    std::error_code ec;
+    fs::path failure_point;
+    fs.remove_all(root, ec, failure_point);
+
+    fs.create_directories(root / "include", ec);
+    fs.create_directories(root / "lib" / "cmake", ec);
+    fs.create_directories(root / "debug" / "lib", ec);
+    fs.create_directories(root / "share" / "empty", ec);
+    fs.write_contents(root / "include" / "zlib.h", "#pragma once\n", ec);
+    fs.write_contents(root / "lib" / "zlib.lib", "1234", ec);
+    fs.write_contents(root / "lib" / "cmake" / "zlib-config.cmake", "", ec);
+    fs.write_contents(root / "debug" / "lib" / "zlibd.lib", "", ec);
+    fs.write_contents(root / "CONTROL", "", ec);
+    fs.write_contents(root / "stray.txt", "", ec);
+
+    const auto tree = PackageTree::scan(fs, root);
+
+    REQUIRE(tree.exists("include"));
+    REQUIRE(tree.exists("lib/cmake"));
+    REQUIRE_FALSE(tree.exists("debug/share"));
+    REQUIRE_FALSE(tree.is_empty_directory("include"));
+    REQUIRE(tree.is_empty_directory("share/empty"));
+    REQUIRE(tree.empty_directories() == std::vector<fs::path>{root / "share" / "empty"});
+
+    REQUIRE(tree.files_below("lib", FileClass::LIB) == std::vector<fs::path>{root / "lib" / "zlib.lib"});
+    REQUIRE(tree.files_below("debug/lib", FileClass::LIB) ==
+            std::vector<fs::path>{root / "debug" / "lib" / "zlibd.lib"});
+    REQUIRE(tree.files_below("lib", FileClass::CMAKE).size() == 1);
+    REQUIRE(tree.files_below("bin", FileClass::DLL).empty());
+
+    auto top_level = tree.files_directly_in("");
+    Util::sort(top_level);
+    REQUIRE(top_level == std::vector<fs::path>{root / "CONTROL", root / "stray.txt"});
+    REQUIRE(tree.files_directly_in("debug").empty());
+
+    const auto& entries = tree.entries();
+    const auto lib = std::find_if(entries.begin(), entries.end(), [](const PackageTreeEntry& entry) {
+        return entry.relative_path == "lib/zlib.lib";
+    });
+    REQUIRE(lib != entries.end());
+    REQUIRE(lib->size == 4);
+}
@@ -0,0 +1,106 @@
+#include <catch2/catch.hpp>
+
+#include <vcpkg/sharding.h>
+
+using namespace vcpkg;
+
+TEST_CASE ("parse shard", "[sharding]")
+{
+    const auto shard = Sharding::parse_shard("2/5").value_or_exit(VCPKG_LINE_INFO);
+    REQUIRE(shard.index == 1);
+    REQUIRE(shard.count == 5);
+
+    REQUIRE(Sharding::parse_shard("1/1").has_value());
+    REQUIRE_FALSE(Sharding::parse_shard("0/5").has_value());
+    REQUIRE_FALSE(Sharding::parse_shard("6/5").has_value());
+    REQUIRE_FALSE(Sharding::parse_shard("5").has_value());
+    REQUIRE_FALSE(Sharding::parse_shard("1/").has_value());
+    REQUIRE_FALSE(Sharding::parse_shard("-1/5").has_value());
+    REQUIRE_FALSE(Sharding::parse_shard("1/5/7").has_value());
+}
+
+TEST_CASE ("shards are balanced and dependency consistent", "[sharding]")
+{
+    // Two independent stacks of equal cost on top of a cheap shared base
+    //   0 <- 1 <- 2      0 <- 3 <- 4
+    Graphs::CsrGraph graph;
+    graph.add_edge(1, 0);
+    graph.add_edge(2, 1);
+    graph.add_edge(3, 0);
+    graph.add_edge(4, 3);
+    graph.freeze();
+    const std::vector<std::uint64_t> costs{1, 10, 10, 10, 10};
+
+    const auto owners = Sharding::assign_owners(graph, costs, 2);
+    REQUIRE(owners[1] == owners[2]);
+    REQUIRE(owners[3] == owners[4]);
+    REQUIRE(owners[2] != owners[4]);
+
+    std::vector<bool> covered(5, false);
+    for (size_t shard = 0; shard < 2; ++shard)
+    {
+        const auto installs = Sharding::shard_closure(graph, owners, shard);
+        for (std::uint32_t v : graph.vertex_list())
+        {
+            if (owners[v] == shard) covered[v] = true;
+            if (!installs[v]) continue;
+            // Whatever a shard installs comes with its dependencies
+            for (std::uint32_t dep : graph.adjacency_list(v))
+                REQUIRE(installs[dep]);
+        }
+        // Both shards need the shared base
+        REQUIRE(installs[0]);
+    }
+    REQUIRE(std::all_of(covered.begin(), covered.end(), [](bool b) { return b; }));
+
+    REQUIRE(Sharding::assign_owners(graph, costs, 2) == owners);
+}
+
+TEST_CASE ("a single shard owns everything", "[sharding]")
+{
+    Graphs::CsrGraph graph;
+    graph.add_edge(1, 0);
+    graph.add_vertex(2);
+    graph.freeze();
+
+    const auto owners = Sharding::assign_owners(graph, {5, 5, 5}, 1);
+    REQUIRE(owners == std::vector<size_t>{0, 0, 0});
+    REQUIRE(Sharding::shard_closure(graph, owners, 0) == std::vector<bool>{true, true, true});
+}
+
+TEST_CASE ("merge xunit results of shards", "[sharding]")
+{
+    const std::string first = R"(<assemblies>
+  <assembly name="vcpkg" run-date="2020-01-01" run-time="10:00:00" time="100">
+    <collection name="x64-linux" time="90">
+      <test name="zlib:x64-linux" method="zlib:x64-linux" time="5" result="Pass"></test>
+    </collection>
+  </assembly>
+</assemblies>
+)";
+    const std::string second = R"(<assemblies>
+  <assembly name="vcpkg" run-date="2020-01-01" run-time="10:00:05" time="300">
+    <collection name="x64-linux" time="250">
+      <test name="curl:x64-linux" method="curl:x64-linux" time="50" result="Pass"></test>
+    </collection>
+    <collection name="x64-osx" time="7">
+      <test name="zlib:x64-osx" method="zlib:x64-osx" time="7" result="Pass"></test>
+    </collection>
+  </assembly>
+</assemblies>
+)";
+
+    const std::string expected = R"(<assemblies>
+  <assembly name="vcpkg" run-date="2020-01-01" run-time="10:00:00" time="300">
+    <collection name="x64-linux" time="250">
+      <test name="zlib:x64-linux" method="zlib:x64-linux" time="5" result="Pass"></test>
+      <test name="curl:x64-linux" method="curl:x64-linux" time="50" result="Pass"></test>
+    </collection>
+    <collection name="x64-osx" time="7">
+      <test name="zlib:x64-osx" method="zlib:x64-osx" time="7" result="Pass"></test>
+    </collection>
+  </assembly>
+</assemblies>
+)";
+    REQUIRE(Sharding::merge_xunit({first, second}) == expected);
+}
@@ -3,6 +3,8 @@
 #include <vcpkg/base/util.h>
 #include <vcpkg/packagespec.h>
 
+#include <thread>
+
 using namespace vcpkg;
 
 TEST_CASE ("specifier conversion", "[specifier]")
@@ -14,11 +16,13 @@ TEST_CASE ("specifier conversion", "[specifier]")
         auto a_spec = PackageSpec::from_name_and_triplet("a", Triplet::X64_WINDOWS).value_or_exit(VCPKG_LINE_INFO);
         auto b_spec = PackageSpec::from_name_and_triplet("b", Triplet::X64_WINDOWS).value_or_exit(VCPKG_LINE_INFO);
 
-        auto fspecs = FullPackageSpec::to_feature_specs({{a_spec, {"0", "1"}}, {b_spec, {"2", "3"}}});
+        auto fspecs = FullPackageSpec::to_feature_specs({a_spec, {"0", "1"}}, {});
+        auto b_fspecs = FullPackageSpec::to_feature_specs({b_spec, {"2", "3"}}, {});
+        fspecs.insert(fspecs.end(), b_fspecs.begin(), b_fspecs.end());
 
         REQUIRE(fspecs.size() == SPEC_SIZE);
 
-        std::array<const char*, SPEC_SIZE> features = {"", "0", "1", "", "2", "3"};
+        std::array<const char*, SPEC_SIZE> features = {"0", "1", "core", "2", "3", "core"};
         std::array<PackageSpec*, SPEC_SIZE> specs = {&a_spec, &a_spec, &a_spec, &b_spec, &b_spec, &b_spec};
 
         for (std::size_t i = 0; i < SPEC_SIZE; ++i)
@@ -29,6 +33,57 @@ TEST_CASE ("specifier conversion", "[specifier]")
     }
 }
 
+TEST_CASE ("interned names", "[specifier]")
+{
+    static_assert(std::is_trivially_copyable<PackageSpec>::value, "PackageSpec should be cheap to copy");
+    static_assert(std::is_trivially_copyable<FeatureSpec>::value, "FeatureSpec should be cheap to copy");
+
+    auto zlib = PackageSpec::from_name_and_triplet("zlib", Triplet::X64_WINDOWS).value_or_exit(VCPKG_LINE_INFO);
+    auto zlib2 = PackageSpec::from_name_and_triplet(std::string("zl") + "ib", Triplet::X64_WINDOWS)
+                     .value_or_exit(VCPKG_LINE_INFO);
+    auto curl = PackageSpec::from_name_and_triplet("curl", Triplet::X64_WINDOWS).value_or_exit(VCPKG_LINE_INFO);
+
+    REQUIRE(&zlib.name() == &zlib2.name());
+    REQUIRE(zlib == zlib2);
+    REQUIRE(std::hash<PackageSpec>()(zlib) == std::hash<PackageSpec>()(zlib2));
+    REQUIRE(zlib != curl);
+    REQUIRE(curl < zlib);
+    REQUIRE_FALSE(zlib < zlib2);
+
+    FeatureSpec a(zlib, "a");
+    FeatureSpec b(zlib2, "b");
+    REQUIRE(&a.feature() == &FeatureSpec(curl, "a").feature());
+    REQUIRE(a < b);
+    REQUIRE(a == FeatureSpec(zlib2, "a"));
+    REQUIRE(InternedName().to_string().empty());
+    REQUIRE(InternedName::from_string("") == InternedName());
+    REQUIRE(FeatureSpec(zlib, "") == FeatureSpec(zlib2, std::string()));
+    REQUIRE(&FeatureSpec(zlib, "").feature() == &InternedName().to_string());
+
+    // Constant-initialized, so other static initializers may use the empty name
+    static constexpr InternedName EMPTY_NAME;
+    REQUIRE(EMPTY_NAME == InternedName::from_string(""));
+}
+
+TEST_CASE ("intern names from several threads", "[specifier]")
+{
+    std::vector<std::vector<InternedName>> interned(4);
+    std::vector<std::thread> threads;
+    for (auto&& names : interned)
+    {
+        threads.emplace_back([&names] {
+            for (int i = 0; i < 1000; ++i)
+                names.push_back(InternedName::from_string("port-" + std::to_string(i)));
+        });
+    }
+    for (auto&& thread : threads)
+        thread.join();
+
+    for (auto&& names : interned)
+        REQUIRE(names == interned.front());
+    REQUIRE(interned.front()[42].to_string() == "port-42");
+}
+
 TEST_CASE ("specifier parsing", "[specifier]")
 {
     SECTION ("parsed specifier from string")
@@ -101,7 +156,9 @@ TEST_CASE ("specifier parsing", "[specifier]")
         auto zlib = vcpkg::FullPackageSpec::from_string("zlib[0,1]", Triplet::X86_UWP).value_or_exit(VCPKG_LINE_INFO);
         auto openssl =
             vcpkg::FullPackageSpec::from_string("openssl[*]", Triplet::X86_UWP).value_or_exit(VCPKG_LINE_INFO);
-        auto specs = FullPackageSpec::to_feature_specs({zlib, openssl});
+        auto specs = FullPackageSpec::to_feature_specs(zlib, {});
+        auto openssl_specs = FullPackageSpec::to_feature_specs(openssl, {});
+        specs.insert(specs.end(), openssl_specs.begin(), openssl_specs.end());
         Util::sort(specs);
         auto spectargets = FeatureSpec::from_strings_and_triplet(
             {
@@ -0,0 +1,86 @@
+#include <catch2/catch.hpp>
+
+#include <vcpkg-test/util.h>
+
+#include <vcpkg/base/strings.h>
+#include <vcpkg/base/system.h>
+#include <vcpkg/base/system.process.h>
+
+#include <cstdio>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace vcpkg;
+
+#if !defined(_WIN32)
+TEST_CASE ("cmd_execute_clean passes the extra environment", "[system]")
+{
+    REQUIRE(System::cmd_execute_clean(R"(test "$VCPKG_TEST_VARIABLE" = "some value")",
+                                      {{"VCPKG_TEST_VARIABLE", "some value"}}) == 0);
+    REQUIRE(System::cmd_execute_clean(R"(test -z "$VCPKG_TEST_VARIABLE")") == 0);
+    REQUIRE(System::cmd_execute_clean("exit 3") == 3);
+}
+
+TEST_CASE ("jobserver hands out one token per extra job", "[system]")
+{
+    const System::Jobserver jobserver(4);
+    const auto& env = jobserver.environment();
+    REQUIRE(env.at("CMAKE_BUILD_PARALLEL_LEVEL") == "4");
+
+    // Under a make jobserver, the test joins it rather than creating one
+    if (System::get_environment_variable("MAKEFLAGS").has_value()) return;
+
+    const auto& makeflags = env.at("MAKEFLAGS");
+    const auto auth = makeflags.find("--jobserver-auth=");
+    REQUIRE(auth != std::string::npos);
+    const auto read_fd = std::atoi(makeflags.c_str() + auth + sizeof("--jobserver-auth=") - 1);
+
+    const auto read_tokens = Strings::format(R"###(test "$(head -c 3 <&%d)" = "+++")###", read_fd);
+    REQUIRE(System::cmd_execute_clean(read_tokens, env) == 0);
+}
+
+TEST_CASE ("jobservers on one named pipe share their tokens", "[system]")
+{
+    if (System::get_environment_variable("MAKEFLAGS").has_value()) return;
+
+    auto& fs = Files::get_real_filesystem();
+    const auto dir = Test::base_temporary_directory() / "jobserver";
+    std::error_code ec;
+    fs::path failure_point;
+    fs.remove_all(dir, ec, failure_point);
+    fs.create_directories(dir, ec);
+    const auto fifo = dir / "jobserver";
+
+    // Takes every token that is there without waiting, and puts them back
+    const auto count_tokens = [](const System::Jobserver& jobserver) {
+        const auto& makeflags = jobserver.environment().at("MAKEFLAGS");
+        int read_fd = -1;
+        int write_fd = -1;
+        REQUIRE(std::sscanf(makeflags.c_str(), " -j --jobserver-auth=%d,%d", &read_fd, &write_fd) == 2);
+
+        const int flags = fcntl(read_fd, F_GETFL);
+        fcntl(read_fd, F_SETFL, flags | O_NONBLOCK);
+        char tokens[16];
+        const auto count = read(read_fd, tokens, sizeof(tokens));
+        fcntl(read_fd, F_SETFL, flags);
+        if (count <= 0) return 0;
+        REQUIRE(write(write_fd, tokens, static_cast<size_t>(count)) == count);
+        return static_cast<int>(count);
+    };
+
+    {
+        const System::Jobserver first(3, fifo);
+        const System::Jobserver second(3, fifo);
+        REQUIRE(second.environment().at("CMAKE_BUILD_PARALLEL_LEVEL") == "3");
+        REQUIRE(count_tokens(second) == 2);
+        REQUIRE(count_tokens(first) == 2);
+    }
+
+    // Once nobody has the pipe open, the next jobserver fills it again
+    const System::Jobserver third(2, fifo);
+    REQUIRE(count_tokens(third) == 1);
+}
+#endif
@@ -0,0 +1,90 @@
+#include <catch2/catch.hpp>
+
+#include <vcpkg-test/util.h>
+
+#include <vcpkg/base/strings.h>
+#include <vcpkg/tools.h>
+
+using namespace vcpkg;
+
+TEST_CASE ("persisted tools", "[tools]")
+{
+    auto& fs = Files::get_real_filesystem();
+    const fs::path root = Test::base_temporary_directory() / "persisted-tools";
+    std::error_code ec;
+    fs::path failure_point;
+    fs.remove_all(root, ec, failure_point);
+    fs.create_directories(root / "cache", ec);
+    REQUIRE_FALSE(ec);
+
+    const auto file = root / "cache" / "tool-cache.txt";
+    const auto tools_xml = root / "vcpkgTools.xml";
+    const auto cmake = root / "cmake";
+    const auto ninja = root / "ninja";
+    fs.write_contents(tools_xml, "<tools/>", ec);
+    fs.write_contents(cmake, "cmake", ec);
+    fs.write_contents(ninja, "ninja", ec);
+    REQUIRE_FALSE(ec);
+
+    const std::string path_variable = "/usr/bin:/bin";
+    {
+        auto tools = PersistedTools::load(fs, file, path_variable, tools_xml);
+        REQUIRE_FALSE(tools.find("cmake").has_value());
+        tools.store(fs, "cmake", {cmake, "3.14.0"});
+        tools.store(fs, "ninja", {ninja, "1.8.2"});
+        // Nothing stays behind under a temporary name
+        REQUIRE(fs.get_files_non_recursive(root / "cache") == std::vector<fs::path>{file});
+    }
+
+    SECTION ("round trip")
+    {
+        const auto tools = PersistedTools::load(fs, file, path_variable, tools_xml);
+        const auto found = tools.find("cmake").value_or_exit(VCPKG_LINE_INFO);
+        REQUIRE(found.path == cmake);
+        REQUIRE(found.version == "3.14.0");
+        REQUIRE(tools.find("ninja").value_or_exit(VCPKG_LINE_INFO).version == "1.8.2");
+        REQUIRE_FALSE(tools.find("git").has_value());
+    }
+
+    SECTION ("a changed PATH forgets every tool")
+    {
+        const auto tools = PersistedTools::load(fs, file, path_variable + ":/opt/bin", tools_xml);
+        REQUIRE_FALSE(tools.find("cmake").has_value());
+        REQUIRE_FALSE(tools.find("ninja").has_value());
+    }
+
+    SECTION ("a changed vcpkgTools.xml forgets every tool")
+    {
+        fs.write_contents(tools_xml, "<tools version=\"2\"/>", ec);
+        REQUIRE_FALSE(ec);
+        const auto tools = PersistedTools::load(fs, file, path_variable, tools_xml);
+        REQUIRE_FALSE(tools.find("cmake").has_value());
+        REQUIRE_FALSE(tools.find("ninja").has_value());
+    }
+
+    SECTION ("a changed executable forgets only its tool")
+    {
+        fs.write_contents(cmake, "a newer cmake", ec);
+        REQUIRE_FALSE(ec);
+        const auto tools = PersistedTools::load(fs, file, path_variable, tools_xml);
+        REQUIRE_FALSE(tools.find("cmake").has_value());
+        REQUIRE(tools.find("ninja").has_value());
+    }
+
+    SECTION ("malformed lines are skipped")
+    {
+        auto lines = fs.read_lines(file).value_or_exit(VCPKG_LINE_INFO);
+        REQUIRE(lines.size() == 4);
+        lines.insert(lines.begin() + 2, "git");
+        lines.insert(lines.begin() + 3, Strings::concat("git\t", (root / "git").u8string(), "\t3 0"));
+        lines.push_back("python\tpython\t1 0\t3.7.0\textra");
+        fs.write_lines(file, lines, ec);
+        REQUIRE_FALSE(ec);
+
+        const auto tools = PersistedTools::load(fs, file, path_variable, tools_xml);
+        REQUIRE(tools.find("cmake").value_or_exit(VCPKG_LINE_INFO).version == "3.14.0");
+        REQUIRE(tools.find("ninja").value_or_exit(VCPKG_LINE_INFO).version == "1.8.2");
+        REQUIRE_FALSE(tools.find("git").has_value());
+        REQUIRE_FALSE(tools.find("python").has_value());
+    }
+}
@@ -22,10 +22,12 @@
 
 #include <vcpkg/base/chrono.h>
 #include <vcpkg/base/files.h>
+#include <vcpkg/base/phases.h>
 #include <vcpkg/base/strings.h>
 #include <vcpkg/base/system.debug.h>
 #include <vcpkg/base/system.print.h>
 #include <vcpkg/base/system.process.h>
+#include <vcpkg/build.h>
 #include <vcpkg/commands.h>
 #include <vcpkg/globalstate.h>
 #include <vcpkg/help.h>
@@ -126,7 +128,7 @@ static void inner(const VcpkgCmdArguments& args)
     auto default_vs_path = System::get_environment_variable("VCPKG_VISUAL_STUDIO_PATH").value_or("");
 
     const Expected<VcpkgPaths> expected_paths =
-        VcpkgPaths::create(vcpkg_root_dir, vcpkg_scripts_root_dir, default_vs_path, args.overlay_triplets.get());
+        VcpkgPaths::create(vcpkg_root_dir, vcpkg_scripts_root_dir, default_vs_path, args);
     Checks::check_exit(VCPKG_LINE_INFO,
                        !expected_paths.error(),
                        "Error: Invalid vcpkg root directory %s: %s",
@@ -308,8 +310,15 @@ int main(const int argc, const char* const* const argv)
 #endif
 
     Checks::register_global_shutdown_handler([]() {
+        Build::ArchiveUploadQueue::drain_all();
+
         const auto elapsed_us_inner = GlobalState::timer.lock()->microseconds();
 
+        if (Phases::g_print_summary)
+        {
+            Phases::print_summary(GlobalState::timer.lock()->elapsed().as<std::chrono::nanoseconds>());
+        }
+
         bool debugging = Debug::g_debugging;
 
         auto metrics = Metrics::g_metrics.lock();
@@ -358,6 +367,7 @@ int main(const int argc, const char* const* const argv)
     if (const auto p = args.printmetrics.get()) Metrics::g_metrics.lock()->set_print_metrics(*p);
     if (const auto p = args.sendmetrics.get()) Metrics::g_metrics.lock()->set_send_metrics(*p);
     if (const auto p = args.debug.get()) Debug::g_debugging = *p;
+    if (const auto p = args.phase_timings.get()) Phases::g_print_summary = *p;
 
     if (Debug::g_debugging)
     {
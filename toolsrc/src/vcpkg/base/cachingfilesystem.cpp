@@ -0,0 +1,256 @@
+#include "pch.h"
+
+#include <vcpkg/base/cachingfilesystem.h>
+#include <vcpkg/base/phases.h>
+#include <vcpkg/base/system.process.h>
+
+namespace vcpkg::Files
+{
+    static std::string cache_key(const fs::path& path)
+    {
+        auto key = (path.is_absolute() ? path : fs::stdfs::absolute(path)).generic_u8string();
+        while (key.size() > 1 && key.back() == '/')
+            key.pop_back();
+        return key;
+    }
+
+    /// <summary>
+    /// Drops key, everything below it and everything above it.
+    /// </summary>
+    template<class Map>
+    static void erase_related(Map& cache, const std::string& key)
+    {
+        cache.erase(cache.lower_bound(key + '/'), cache.lower_bound(key + char('/' + 1)));
+        for (auto end = key.size(); end != std::string::npos && end > 0; end = key.find_last_of('/', end - 1))
+        {
+            cache.erase(key.substr(0, end));
+        }
+        cache.erase("/");
+    }
+
+    CachingFilesystem::CachingFilesystem(Filesystem& underlying)
+        : m_underlying(underlying), m_child_process_generation(System::get_child_process_generation())
+    {
+    }
+
+    void CachingFilesystem::clear()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_status.clear();
+        m_symlink_status.clear();
+        ++m_forget_count;
+    }
+
+    fs::file_status CachingFilesystem::lookup(StatusMap& cache,
+                                              const fs::path& path,
+                                              std::error_code& ec,
+                                              fs::file_status (Filesystem::*query)(const fs::path&,
+                                                                                   std::error_code&) const) const
+    {
+        const auto key = cache_key(path);
+        std::uint64_t forget_count;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            const auto generation = System::get_child_process_generation();
+            if (generation != m_child_process_generation)
+            {
+                m_status.clear();
+                m_symlink_status.clear();
+                m_child_process_generation = generation;
+                ++m_forget_count;
+            }
+
+            const auto it = cache.find(key);
+            if (it != cache.end())
+            {
+                ++m_hits;
+                Phases::increment(Phases::Counter::FILE_STATUS_CACHE_HITS);
+                ec = it->second.ec;
+                return it->second.status;
+            }
+            forget_count = m_forget_count;
+        }
+
+        // Other threads may look up other paths meanwhile
+        ++m_misses;
+        Phases::increment(Phases::Counter::FILE_STATUS_CACHE_MISSES);
+        const auto result = (m_underlying.*query)(path, ec);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (forget_count == m_forget_count) cache.emplace(key, CachedStatus{result, ec});
+        return result;
+    }
+
+    void CachingFilesystem::forget(const fs::path& path)
+    {
+        const auto key = cache_key(path);
+        std::lock_guard<std::mutex> lock(m_mutex);
+        erase_related(m_status, key);
+        erase_related(m_symlink_status, key);
+        ++m_forget_count;
+    }
+
+    Expected<std::string> CachingFilesystem::read_contents(const fs::path& file_path) const
+    {
+        return m_underlying.read_contents(file_path);
+    }
+
+    Expected<std::vector<std::string>> CachingFilesystem::read_lines(const fs::path& file_path) const
+    {
+        return m_underlying.read_lines(file_path);
+    }
+
+    fs::path CachingFilesystem::find_file_recursively_up(const fs::path& starting_dir,
+                                                         const std::string& filename) const
+    {
+        return m_underlying.find_file_recursively_up(starting_dir, filename);
+    }
+
+    std::vector<fs::path> CachingFilesystem::get_files_recursive(const fs::path& dir) const
+    {
+        return m_underlying.get_files_recursive(dir);
+    }
+
+    std::vector<fs::path> CachingFilesystem::get_files_non_recursive(const fs::path& dir) const
+    {
+        return m_underlying.get_files_non_recursive(dir);
+    }
+
+    void CachingFilesystem::read_directory(const fs::path& dir,
+                                           const std::function<void(DirectoryEntry&&)>& visit,
+                                           std::error_code& ec) const
+    {
+        m_underlying.read_directory(dir, visit, ec);
+    }
+
+    void CachingFilesystem::write_lines(const fs::path& file_path,
+                                        const std::vector<std::string>& lines,
+                                        std::error_code& ec)
+    {
+        m_underlying.write_lines(file_path, lines, ec);
+        forget(file_path);
+    }
+
+    void CachingFilesystem::write_contents(const fs::path& file_path, const std::string& data, std::error_code& ec)
+    {
+        m_underlying.write_contents(file_path, data, ec);
+        forget(file_path);
+    }
+
+    void CachingFilesystem::rename(const fs::path& oldpath, const fs::path& newpath, std::error_code& ec)
+    {
+        m_underlying.rename(oldpath, newpath, ec);
+        forget(oldpath);
+        forget(newpath);
+    }
+
+    void CachingFilesystem::rename_or_copy(const fs::path& oldpath,
+                                           const fs::path& newpath,
+                                           StringLiteral temp_suffix,
+                                           std::error_code& ec)
+    {
+        m_underlying.rename_or_copy(oldpath, newpath, temp_suffix, ec);
+        forget(oldpath);
+        forget(newpath);
+        forget(newpath.native() + fs::u8path(temp_suffix.c_str()).native());
+    }
+
+    bool CachingFilesystem::remove(const fs::path& path, std::error_code& ec)
+    {
+        const auto result = m_underlying.remove(path, ec);
+        forget(path);
+        return result;
+    }
+
+    void CachingFilesystem::remove_all(const fs::path& path, std::error_code& ec, fs::path& failure_point)
+    {
+        m_underlying.remove_all(path, ec, failure_point);
+        forget(path);
+    }
+
+    bool CachingFilesystem::is_directory(const fs::path& path) const
+    {
+        std::error_code ec;
+        return fs::is_directory(status(path, ec));
+    }
+
+    bool CachingFilesystem::is_regular_file(const fs::path& path) const
+    {
+        std::error_code ec;
+        return fs::is_regular_file(status(path, ec));
+    }
+
+    bool CachingFilesystem::is_empty(const fs::path& path) const { return m_underlying.is_empty(path); }
+
+    std::uintmax_t CachingFilesystem::file_size(const fs::path& path, std::error_code& ec) const
+    {
+        return m_underlying.file_size(path, ec);
+    }
+
+    std::uintmax_t CachingFilesystem::hard_link_count(const fs::path& path, std::error_code& ec) const
+    {
+        return m_underlying.hard_link_count(path, ec);
+    }
+
+    bool CachingFilesystem::create_directory(const fs::path& path, std::error_code& ec)
+    {
+        const auto result = m_underlying.create_directory(path, ec);
+        forget(path);
+        return result;
+    }
+
+    bool CachingFilesystem::create_directories(const fs::path& path, std::error_code& ec)
+    {
+        const auto result = m_underlying.create_directories(path, ec);
+        forget(path);
+        return result;
+    }
+
+    void CachingFilesystem::copy(const fs::path& oldpath, const fs::path& newpath, fs::copy_options opts)
+    {
+        m_underlying.copy(oldpath, newpath, opts);
+        forget(newpath);
+    }
+
+    bool CachingFilesystem::copy_file(const fs::path& oldpath,
+                                      const fs::path& newpath,
+                                      fs::copy_options opts,
+                                      std::error_code& ec)
+    {
+        const auto result = m_underlying.copy_file(oldpath, newpath, opts, ec);
+        forget(newpath);
+        return result;
+    }
+
+    void CachingFilesystem::copy_symlink(const fs::path& oldpath, const fs::path& newpath, std::error_code& ec)
+    {
+        m_underlying.copy_symlink(oldpath, newpath, ec);
+        forget(newpath);
+    }
+
+    void CachingFilesystem::create_hard_link(const fs::path& target, const fs::path& link, std::error_code& ec)
+    {
+        m_underlying.create_hard_link(target, link, ec);
+        forget(link);
+    }
+
+    fs::file_status CachingFilesystem::status(const fs::path& path, std::error_code& ec) const
+    {
+        return lookup(m_status, path, ec, &Filesystem::status);
+    }
+
+    fs::file_status CachingFilesystem::symlink_status(const fs::path& path, std::error_code& ec) const
+    {
+        return lookup(m_symlink_status, path, ec, &Filesystem::symlink_status);
+    }
+
+    fs::path CachingFilesystem::canonical(const fs::path& path, std::error_code& ec) const
+    {
+        return m_underlying.canonical(path, ec);
+    }
+
+    std::vector<fs::path> CachingFilesystem::find_from_PATH(const std::string& name) const
+    {
+        return m_underlying.find_from_PATH(name);
+    }
+}
@@ -1,313 +1,204 @@
 #include "pch.h"
 
-#include <vcpkg/base/checks.h>
 #include <vcpkg/base/cofffilereader.h>
 #include <vcpkg/base/stringliteral.h>
-
-using namespace std;
+#include <vcpkg/base/strings.h>
 
 namespace vcpkg::CoffFileReader
 {
-#if defined(_WIN32)
-    template<class T>
-    static T reinterpret_bytes(const char* data)
+    /// <summary>
+    /// Bounds-checked little-endian reads from a mapped file. COFF files are little-endian whatever the host is.
+    /// A read past the end yields zeros and records the first such error, so that a damaged file is reported as
+    /// such instead of stopping vcpkg.
+    /// </summary>
+    struct ByteReader
     {
-        return (*reinterpret_cast<const T*>(&data[0]));
-    }
+        const fs::path& path;
+        const char* data;
+        size_t size;
+        mutable std::string error;
 
-    template<class T>
-    static T read_value_from_stream(fstream& fs)
-    {
-        T data;
-        fs.read(reinterpret_cast<char*>(&data), sizeof data);
-        return data;
-    }
+        bool check_range(size_t offset, size_t length, const char* label) const
+        {
+            if (offset <= size && length <= size - offset) return true;
+            if (error.empty())
+                error = Strings::format("Unexpected end of file %s while reading %s", path.generic_string(), label);
+            return false;
+        }
 
-    template<class T>
-    static T peek_value_from_stream(fstream& fs)
-    {
-        const std::streampos original_pos = fs.tellg();
-        T data;
-        fs.read(reinterpret_cast<char*>(&data), sizeof data);
-        fs.seekg(original_pos);
-        return data;
-    }
+        void check_equal(StringView expected, StringView actual, const char* label) const
+        {
+            if (expected == actual || !error.empty()) return;
+            error = Strings::format(
+                "Incorrect string (%s) found in %s. Expected: (%s) but found (%s)",
+                label,
+                path.generic_string(),
+                expected.to_string(),
+                actual.to_string());
+        }
 
-    static void verify_equal_strings(const LineInfo& line_info,
-                                     StringView expected,
-                                     StringView actual,
-                                     const char* label)
-    {
-        Checks::check_exit(line_info,
-                           expected == actual,
-                           "Incorrect string (%s) found. Expected: (%s) but found (%s)",
-                           label,
-                           expected,
-                           actual);
-    }
+        StringView bytes(size_t offset, size_t length, const char* label) const
+        {
+            if (!check_range(offset, length, label)) return {};
+            return {data + offset, length};
+        }
+
+        uint16_t u16(size_t offset, const char* label) const
+        {
+            if (!check_range(offset, 2, label)) return 0;
+            const auto p = reinterpret_cast<const unsigned char*>(data + offset);
+            return static_cast<uint16_t>(p[0] | (p[1] << 8));
+        }
+
+        uint32_t u32(size_t offset, const char* label) const
+        {
+            if (!check_range(offset, 4, label)) return 0;
+            const auto p = reinterpret_cast<const unsigned char*>(data + offset);
+            return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+                   (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+        }
+    };
 
-    static void read_and_verify_pe_signature(fstream& fs)
+    ExpectedT<DllInfo, std::string> read_dll(const fs::path& path)
     {
         static constexpr size_t OFFSET_TO_PE_SIGNATURE_OFFSET = 0x3c;
-
         static constexpr StringLiteral PE_SIGNATURE = "PE\0\0";
         static constexpr size_t PE_SIGNATURE_SIZE = 4;
 
-        fs.seekg(OFFSET_TO_PE_SIGNATURE_OFFSET, ios_base::beg);
-        const auto offset_to_pe_signature = read_value_from_stream<int32_t>(fs);
+        std::error_code ec;
+        const Files::MappedFile file(path, ec);
+        if (ec) return Strings::format("Could not open file %s for reading", path.generic_string());
+        const ByteReader reader{path, file.data(), file.size()};
 
-        fs.seekg(offset_to_pe_signature);
-        char signature[PE_SIGNATURE_SIZE];
-        fs.read(signature, PE_SIGNATURE_SIZE);
-        verify_equal_strings(VCPKG_LINE_INFO, PE_SIGNATURE, {signature, PE_SIGNATURE_SIZE}, "PE_SIGNATURE");
-        fs.seekg(offset_to_pe_signature + PE_SIGNATURE_SIZE, ios_base::beg);
-    }
+        const size_t offset_to_pe_signature = reader.u32(OFFSET_TO_PE_SIGNATURE_OFFSET, "PE_SIGNATURE_OFFSET");
+        reader.check_equal({PE_SIGNATURE.c_str(), PE_SIGNATURE_SIZE},
+                           reader.bytes(offset_to_pe_signature, PE_SIGNATURE_SIZE, "PE_SIGNATURE"),
+                           "PE_SIGNATURE");
 
-    static fpos_t align_to_size(const uint64_t unaligned, const uint64_t alignment_size)
-    {
-        fpos_t aligned = unaligned - 1;
-        aligned /= alignment_size;
-        aligned += 1;
-        aligned *= alignment_size;
-        return aligned;
+        // The COFF file header follows the signature and starts with the machine type
+        const auto machine = reader.u16(offset_to_pe_signature + PE_SIGNATURE_SIZE, "COFF header");
+        if (!reader.error.empty()) return std::move(reader.error);
+        return DllInfo{to_machine_type(machine)};
     }
 
-    struct CoffFileHeader
-    {
-        static constexpr size_t HEADER_SIZE = 20;
-
-        static CoffFileHeader read(fstream& fs)
-        {
-            CoffFileHeader ret;
-            ret.data.resize(HEADER_SIZE);
-            fs.read(&ret.data[0], HEADER_SIZE);
-            return ret;
-        }
-
-        MachineType machine_type() const
-        {
-            static constexpr size_t MACHINE_TYPE_OFFSET = 0;
-            static constexpr size_t MACHINE_TYPE_SIZE = 2;
-
-            std::string machine_field_as_string = data.substr(MACHINE_TYPE_OFFSET, MACHINE_TYPE_SIZE);
-            const auto machine = reinterpret_bytes<uint16_t>(machine_field_as_string.c_str());
-            return to_machine_type(machine);
-        }
-
-    private:
-        std::string data;
-    };
-
-    struct ArchiveMemberHeader
+    namespace ArchiveMemberHeader
     {
         static constexpr size_t HEADER_SIZE = 60;
 
-        static ArchiveMemberHeader read(fstream& fs)
+        static void verify(const ByteReader& reader, size_t offset)
         {
             static constexpr size_t HEADER_END_OFFSET = 58;
             static constexpr StringLiteral HEADER_END = "`\n";
-            static constexpr size_t HEADER_END_SIZE = 2;
-
-            ArchiveMemberHeader ret;
-            ret.data.resize(HEADER_SIZE);
-            fs.read(&ret.data[0], HEADER_SIZE);
 
-            if (ret.data[0] != '\0') // Due to freeglut. github issue #223
+            const auto header = reader.bytes(offset, HEADER_SIZE, "LIB member header");
+            if (header.size() == HEADER_SIZE && header.data()[0] != '\0') // Due to freeglut. github issue #223
             {
-                const std::string header_end = ret.data.substr(HEADER_END_OFFSET, HEADER_END_SIZE);
-                verify_equal_strings(VCPKG_LINE_INFO, HEADER_END, header_end, "LIB HEADER_END");
+                reader.check_equal(
+                    HEADER_END, {header.data() + HEADER_END_OFFSET, HEADER_END.size()}, "LIB HEADER_END");
             }
-
-            return ret;
         }
 
-        std::string name() const
+        static bool is_linker_member(const ByteReader& reader, size_t offset)
         {
-            static constexpr size_t HEADER_NAME_OFFSET = 0;
-            static constexpr size_t HEADER_NAME_SIZE = 16;
-            return data.substr(HEADER_NAME_OFFSET, HEADER_NAME_SIZE);
+            return reader.bytes(offset, 2, "LIB member name") == StringView{"/ ", 2};
         }
 
-        uint64_t member_size() const
+        static size_t member_size(const ByteReader& reader, size_t offset)
         {
-            static constexpr size_t ALIGNMENT_SIZE = 2;
-
             static constexpr size_t HEADER_SIZE_OFFSET = 48;
             static constexpr size_t HEADER_SIZE_FIELD_SIZE = 10;
-            const std::string as_string = data.substr(HEADER_SIZE_OFFSET, HEADER_SIZE_FIELD_SIZE);
-            // This is in ASCII decimal representation
-            const uint64_t value = std::strtoull(as_string.c_str(), nullptr, 10);
-
-            const uint64_t aligned = align_to_size(value, ALIGNMENT_SIZE);
-            return aligned;
-        }
-
-        std::string data;
-    };
 
-    struct OffsetsArray
-    {
-        static OffsetsArray read(fstream& fs, const uint32_t offset_count)
-        {
-            static constexpr uint32_t OFFSET_WIDTH = 4;
-
-            std::string raw_offsets;
-            const uint32_t raw_offset_size = offset_count * OFFSET_WIDTH;
-            raw_offsets.resize(raw_offset_size);
-            fs.read(&raw_offsets[0], raw_offset_size);
-
-            OffsetsArray ret;
-            for (uint32_t i = 0; i < offset_count; ++i)
+            // This is in ASCII decimal representation
+            const auto field = reader.bytes(offset + HEADER_SIZE_OFFSET, HEADER_SIZE_FIELD_SIZE, "LIB member size");
+            size_t value = 0;
+            for (char c : field)
             {
-                const std::string value_as_string = raw_offsets.substr(OFFSET_WIDTH * static_cast<size_t>(i),
-                                                                       OFFSET_WIDTH * (static_cast<size_t>(i) + 1));
-                const auto value = reinterpret_bytes<uint32_t>(value_as_string.c_str());
-
-                // Ignore offsets that point to offset 0. See vcpkg github #223 #288 #292
-                if (value != 0)
-                {
-                    ret.data.push_back(value);
-                }
+                if (c < '0' || c > '9') break;
+                value = value * 10 + static_cast<size_t>(c - '0');
             }
 
-            // Sort the offsets, because it is possible for them to be unsorted. See vcpkg github #292
-            std::sort(ret.data.begin(), ret.data.end());
-            return ret;
-        }
-
-        std::vector<uint32_t> data;
-    };
-
-    struct ImportHeader
-    {
-        static constexpr size_t HEADER_SIZE = 20;
-
-        static ImportHeader read(fstream& fs)
-        {
-            static constexpr size_t SIG1_OFFSET = 0;
-            static constexpr auto SIG1 = static_cast<uint16_t>(MachineType::UNKNOWN);
-            static constexpr size_t SIG1_SIZE = 2;
-
-            static constexpr size_t SIG2_OFFSET = 2;
-            static constexpr uint16_t SIG2 = 0xFFFF;
-            static constexpr size_t SIG2_SIZE = 2;
-
-            ImportHeader ret;
-            ret.data.resize(HEADER_SIZE);
-            fs.read(&ret.data[0], HEADER_SIZE);
-
-            const std::string sig1_as_string = ret.data.substr(SIG1_OFFSET, SIG1_SIZE);
-            const auto sig1 = reinterpret_bytes<uint16_t>(sig1_as_string.c_str());
-            Checks::check_exit(VCPKG_LINE_INFO, sig1 == SIG1, "Sig1 was incorrect. Expected %s but got %s", SIG1, sig1);
-
-            const std::string sig2_as_string = ret.data.substr(SIG2_OFFSET, SIG2_SIZE);
-            const auto sig2 = reinterpret_bytes<uint16_t>(sig2_as_string.c_str());
-            Checks::check_exit(VCPKG_LINE_INFO, sig2 == SIG2, "Sig2 was incorrect. Expected %s but got %s", SIG2, sig2);
-
-            return ret;
-        }
-
-        MachineType machine_type() const
-        {
-            static constexpr size_t MACHINE_TYPE_OFFSET = 6;
-            static constexpr size_t MACHINE_TYPE_SIZE = 2;
-
-            std::string machine_field_as_string = data.substr(MACHINE_TYPE_OFFSET, MACHINE_TYPE_SIZE);
-            const auto machine = reinterpret_bytes<uint16_t>(machine_field_as_string.c_str());
-            return to_machine_type(machine);
+            // Members are aligned to 2 bytes
+            return value + (value & 1);
         }
-
-    private:
-        std::string data;
-    };
-
-    static void read_and_verify_archive_file_signature(fstream& fs)
-    {
-        static constexpr StringLiteral FILE_START = "!<arch>\n";
-        static constexpr size_t FILE_START_SIZE = 8;
-
-        fs.seekg(std::fstream::beg);
-
-        char file_start[FILE_START_SIZE];
-        fs.read(file_start, FILE_START_SIZE);
-        verify_equal_strings(VCPKG_LINE_INFO, FILE_START, {file_start, FILE_START_SIZE}, "LIB FILE_START");
-    }
-
-    DllInfo read_dll(const fs::path& path)
-    {
-        std::fstream fs(path, std::ios::in | std::ios::binary | std::ios::ate);
-        Checks::check_exit(VCPKG_LINE_INFO, fs.is_open(), "Could not open file %s for reading", path.generic_string());
-
-        read_and_verify_pe_signature(fs);
-        CoffFileHeader header = CoffFileHeader::read(fs);
-        const MachineType machine = header.machine_type();
-        return {machine};
     }
 
-    struct Marker
-    {
-        void set_to_offset(const fpos_t position) { this->m_absolute_position = position; }
-
-        void set_to_current_pos(fstream& fs) { this->m_absolute_position = fs.tellg(); }
-
-        void seek_to_marker(fstream& fs) const { fs.seekg(this->m_absolute_position, ios_base::beg); }
-
-        void advance_by(const uint64_t offset) { this->m_absolute_position += offset; }
-
-    private:
-        fpos_t m_absolute_position = 0;
-    };
-
-    LibInfo read_lib(const fs::path& path)
+    ExpectedT<LibInfo, std::string> read_lib(const fs::path& path)
     {
-        std::fstream fs(path, std::ios::in | std::ios::binary | std::ios::ate);
-        Checks::check_exit(VCPKG_LINE_INFO, fs.is_open(), "Could not open file %s for reading", path.generic_string());
+        static constexpr StringLiteral FILE_START = "!<arch>\n";
 
-        read_and_verify_archive_file_signature(fs);
+        std::error_code ec;
+        const Files::MappedFile file(path, ec);
+        if (ec) return Strings::format("Could not open file %s for reading", path.generic_string());
+        const ByteReader reader{path, file.data(), file.size()};
 
-        Marker marker;
-        marker.set_to_current_pos(fs);
+        reader.check_equal(FILE_START, reader.bytes(0, FILE_START.size(), "LIB FILE_START"), "LIB FILE_START");
+        size_t position = FILE_START.size();
 
         // First Linker Member
-        const ArchiveMemberHeader first_linker_member_header = ArchiveMemberHeader::read(fs);
-        Checks::check_exit(VCPKG_LINE_INFO,
-                           first_linker_member_header.name().substr(0, 2) == "/ ",
-                           "Could not find proper first linker member");
-        marker.advance_by(ArchiveMemberHeader::HEADER_SIZE + first_linker_member_header.member_size());
-        marker.seek_to_marker(fs);
-
-        const ArchiveMemberHeader second_linker_member_header = ArchiveMemberHeader::read(fs);
-        Checks::check_exit(VCPKG_LINE_INFO,
-                           second_linker_member_header.name().substr(0, 2) == "/ ",
-                           "Could not find proper second linker member");
-        // The first 4 bytes contains the number of archive members
-        const auto archive_member_count = read_value_from_stream<uint32_t>(fs);
-        const OffsetsArray offsets = OffsetsArray::read(fs, archive_member_count);
-        marker.advance_by(ArchiveMemberHeader::HEADER_SIZE + second_linker_member_header.member_size());
-        marker.seek_to_marker(fs);
-
-        const bool has_longname_member_header = peek_value_from_stream<uint16_t>(fs) == 0x2F2F;
-        if (has_longname_member_header)
+        ArchiveMemberHeader::verify(reader, position);
+        if (!reader.error.empty()) return std::move(reader.error);
+        if (!ArchiveMemberHeader::is_linker_member(reader, position))
+            return Strings::format("Could not find proper first linker member in %s", path.generic_string());
+        position += ArchiveMemberHeader::HEADER_SIZE + ArchiveMemberHeader::member_size(reader, position);
+
+        // Second Linker Member
+        ArchiveMemberHeader::verify(reader, position);
+        if (!reader.error.empty()) return std::move(reader.error);
+        if (!ArchiveMemberHeader::is_linker_member(reader, position))
+            return Strings::format("Could not find proper second linker member in %s", path.generic_string());
+
+        // The first 4 bytes contains the number of archive members, followed by their offsets
+        static constexpr size_t OFFSET_WIDTH = 4;
+        const size_t offsets_start = position + ArchiveMemberHeader::HEADER_SIZE;
+        const uint32_t archive_member_count = reader.u32(offsets_start, "LIB member count");
+        reader.check_range(offsets_start + OFFSET_WIDTH,
+                           static_cast<size_t>(archive_member_count) * OFFSET_WIDTH,
+                           "LIB member offsets");
+        if (!reader.error.empty()) return std::move(reader.error);
+
+        std::vector<uint32_t> offsets;
+        offsets.reserve(archive_member_count);
+        for (uint32_t i = 0; i < archive_member_count; ++i)
         {
-            const ArchiveMemberHeader longnames_member_header = ArchiveMemberHeader::read(fs);
-            marker.advance_by(ArchiveMemberHeader::HEADER_SIZE + longnames_member_header.member_size());
-            marker.seek_to_marker(fs);
+            const auto value = reader.u32(offsets_start + OFFSET_WIDTH * (static_cast<size_t>(i) + 1), "LIB offset");
+
+            // Ignore offsets that point to offset 0. See vcpkg github #223 #288 #292
+            if (value != 0) offsets.push_back(value);
         }
 
+        // Many symbols live in the same member; each member needs looking at only once. The offsets can also be
+        // unsorted, see vcpkg github #292
+        std::sort(offsets.begin(), offsets.end());
+        offsets.erase(std::unique(offsets.begin(), offsets.end()), offsets.end());
+
         std::set<MachineType> machine_types;
-        // Next we have the obj and pseudo-object files
-        for (const uint32_t offset : offsets.data)
+        // Next we have the obj and pseudo-object files; import headers start with a zero machine type
+        for (const uint32_t offset : offsets)
         {
-            marker.set_to_offset(offset + ArchiveMemberHeader::HEADER_SIZE); // Skip the header, no need to read it.
-            marker.seek_to_marker(fs);
-            const auto first_two_bytes = peek_value_from_stream<uint16_t>(fs);
-            const bool is_import_header = to_machine_type(first_two_bytes) == MachineType::UNKNOWN;
-            const MachineType machine =
-                is_import_header ? ImportHeader::read(fs).machine_type() : CoffFileHeader::read(fs).machine_type();
-            machine_types.insert(machine);
+            // Skip the header, no need to read it.
+            const size_t member = offset + ArchiveMemberHeader::HEADER_SIZE;
+            const auto first_two_bytes = reader.u16(member, "LIB member");
+            if (first_two_bytes == static_cast<uint16_t>(MachineType::UNKNOWN))
+            {
+                static constexpr uint16_t SIG2 = 0xFFFF;
+                static constexpr size_t MACHINE_TYPE_OFFSET = 6;
+
+                const auto sig2 = reader.u16(member + 2, "import header");
+                if (!reader.error.empty()) return std::move(reader.error);
+                if (sig2 != SIG2)
+                {
+                    return Strings::format(
+                        "Sig2 was incorrect in %s. Expected %d but got %d", path.generic_string(), SIG2, sig2);
+                }
+                machine_types.insert(to_machine_type(reader.u16(member + MACHINE_TYPE_OFFSET, "import header")));
+            }
+            else
+            {
+                machine_types.insert(to_machine_type(reader.u16(member, "COFF header")));
+            }
+            if (!reader.error.empty()) return std::move(reader.error);
         }
 
-        return {std::vector<MachineType>(machine_types.cbegin(), machine_types.cend())};
+        return LibInfo{std::vector<MachineType>(machine_types.cbegin(), machine_types.cend())};
     }
-#endif
 }
@@ -1,47 +1,66 @@
 #include "pch.h"
 
+#include <vcpkg/base/chrono.h>
 #include <vcpkg/base/downloads.h>
 #include <vcpkg/base/hash.h>
+#include <vcpkg/base/http.h>
+#include <vcpkg/base/strings.h>
 #include <vcpkg/base/system.process.h>
 #include <vcpkg/base/util.h>
+#include <vcpkg/base/work_queue.h>
+
+#include <vcpkg/base/system.h>
+#include <vcpkg/base/system.print.h>
 
 #if defined(_WIN32)
 #include <VersionHelpers.h>
-#else
-#include <vcpkg/base/system.h>
 #endif
 
 namespace vcpkg::Downloads
 {
+    namespace
+    {
+        struct TransferError
+        {
+            std::string message;
+            bool retryable;
+        };
+    }
+
+    using TransferResult = ExpectedT<Http::Response, TransferError>;
+
 #if defined(_WIN32)
-    static void winhttp_download_file(Files::Filesystem& fs,
-                                      ZStringView target_file_path,
-                                      StringView hostname,
-                                      StringView url_path)
+    namespace
     {
-        // Make sure the directories are present, otherwise fopen_s fails
-        const auto dir = fs::path(target_file_path.c_str()).parent_path();
-        std::error_code ec;
-        fs.create_directories(dir, ec);
-        Checks::check_exit(VCPKG_LINE_INFO, !ec, "Could not create directories %s", dir.u8string());
+        struct WinHttpHandle
+        {
+            explicit WinHttpHandle(HINTERNET h) : h(h) {}
+            WinHttpHandle(const WinHttpHandle&) = delete;
+            WinHttpHandle& operator=(const WinHttpHandle&) = delete;
+            ~WinHttpHandle()
+            {
+                if (h) WinHttpCloseHandle(h);
+            }
 
-        FILE* f = nullptr;
-        const errno_t err = fopen_s(&f, target_file_path.c_str(), "wb");
-        Checks::check_exit(VCPKG_LINE_INFO,
-                           !err,
-                           "Could not download https://%s%s. Failed to open file %s. Error code was %s",
-                           hostname,
-                           url_path,
-                           target_file_path,
-                           std::to_string(err));
-
-        auto hSession = WinHttpOpen(L"vcpkg/1.0",
-                                    IsWindows8Point1OrGreater() ? WINHTTP_ACCESS_TYPE_AUTOMATIC_PROXY
-                                                                : WINHTTP_ACCESS_TYPE_DEFAULT_PROXY,
-                                    WINHTTP_NO_PROXY_NAME,
-                                    WINHTTP_NO_PROXY_BYPASS,
-                                    0);
-        Checks::check_exit(VCPKG_LINE_INFO, hSession, "WinHttpOpen() failed: %d", GetLastError());
+            HINTERNET h;
+        };
+    }
+
+    static TransferResult winhttp_transfer(StringView hostname,
+                                           INTERNET_PORT port,
+                                           bool secure,
+                                           StringView url_path,
+                                           const std::vector<std::string>& request_headers,
+                                           const std::function<bool(const Http::Response&)>& on_response,
+                                           const std::function<void(StringView)>& data_cb)
+    {
+        WinHttpHandle hSession(WinHttpOpen(L"vcpkg/1.0",
+                                           IsWindows8Point1OrGreater() ? WINHTTP_ACCESS_TYPE_AUTOMATIC_PROXY
+                                                                       : WINHTTP_ACCESS_TYPE_DEFAULT_PROXY,
+                                           WINHTTP_NO_PROXY_NAME,
+                                           WINHTTP_NO_PROXY_BYPASS,
+                                           0));
+        Checks::check_exit(VCPKG_LINE_INFO, hSession.h, "WinHttpOpen() failed: %d", GetLastError());
 
         // Win7 IE Proxy fallback
         if (IsWindows7OrGreater() && !IsWindows8Point1OrGreater())
@@ -49,7 +68,7 @@ namespace vcpkg::Downloads
             // First check if any proxy has been found automatically
             WINHTTP_PROXY_INFO proxyInfo;
             DWORD proxyInfoSize = sizeof(WINHTTP_PROXY_INFO);
-            auto noProxyFound = !WinHttpQueryOption(hSession, WINHTTP_OPTION_PROXY, &proxyInfo, &proxyInfoSize) ||
+            auto noProxyFound = !WinHttpQueryOption(hSession.h, WINHTTP_OPTION_PROXY, &proxyInfo, &proxyInfoSize) ||
                                 proxyInfo.dwAccessType == WINHTTP_ACCESS_TYPE_NO_PROXY;
 
             // If no proxy was found automatically, use IE's proxy settings, if any
@@ -62,7 +81,7 @@ namespace vcpkg::Downloads
                     proxy.dwAccessType = WINHTTP_ACCESS_TYPE_NAMED_PROXY;
                     proxy.lpszProxy = ieProxy.lpszProxy;
                     proxy.lpszProxyBypass = ieProxy.lpszProxyBypass;
-                    WinHttpSetOption(hSession, WINHTTP_OPTION_PROXY, &proxy, sizeof(proxy));
+                    WinHttpSetOption(hSession.h, WINHTTP_OPTION_PROXY, &proxy, sizeof(proxy));
                 }
             }
         }
@@ -70,111 +89,1050 @@ namespace vcpkg::Downloads
         // Use Windows 10 defaults on Windows 7
         DWORD secure_protocols(WINHTTP_FLAG_SECURE_PROTOCOL_SSL3 | WINHTTP_FLAG_SECURE_PROTOCOL_TLS1 |
                                WINHTTP_FLAG_SECURE_PROTOCOL_TLS1_1 | WINHTTP_FLAG_SECURE_PROTOCOL_TLS1_2);
-        WinHttpSetOption(hSession, WINHTTP_OPTION_SECURE_PROTOCOLS, &secure_protocols, sizeof(secure_protocols));
+        WinHttpSetOption(hSession.h, WINHTTP_OPTION_SECURE_PROTOCOLS, &secure_protocols, sizeof(secure_protocols));
 
         // Specify an HTTP server.
-        auto hConnect = WinHttpConnect(hSession, Strings::to_utf16(hostname).c_str(), INTERNET_DEFAULT_HTTPS_PORT, 0);
-        Checks::check_exit(VCPKG_LINE_INFO, hConnect, "WinHttpConnect() failed: %d", GetLastError());
+        WinHttpHandle hConnect(
+            WinHttpConnect(hSession.h, Strings::to_utf16(hostname).c_str(), port, 0));
+        if (!hConnect.h) return TransferError{Strings::format("WinHttpConnect() failed: %d", GetLastError()), true};
 
         // Create an HTTP request handle.
-        auto hRequest = WinHttpOpenRequest(hConnect,
-                                           L"GET",
-                                           Strings::to_utf16(url_path).c_str(),
-                                           nullptr,
-                                           WINHTTP_NO_REFERER,
-                                           WINHTTP_DEFAULT_ACCEPT_TYPES,
-                                           WINHTTP_FLAG_SECURE);
-        Checks::check_exit(VCPKG_LINE_INFO, hRequest, "WinHttpOpenRequest() failed: %d", GetLastError());
+        WinHttpHandle hRequest(WinHttpOpenRequest(hConnect.h,
+                                                  L"GET",
+                                                  Strings::to_utf16(url_path).c_str(),
+                                                  nullptr,
+                                                  WINHTTP_NO_REFERER,
+                                                  WINHTTP_DEFAULT_ACCEPT_TYPES,
+                                                  secure ? WINHTTP_FLAG_SECURE : 0));
+        if (!hRequest.h) return TransferError{Strings::format("WinHttpOpenRequest() failed: %d", GetLastError()), true};
+
+        std::wstring headers;
+        for (auto&& header : request_headers)
+        {
+            headers += Strings::to_utf16(header);
+            headers += L"\r\n";
+        }
 
         // Send a request.
-        auto bResults =
-            WinHttpSendRequest(hRequest, WINHTTP_NO_ADDITIONAL_HEADERS, 0, WINHTTP_NO_REQUEST_DATA, 0, 0, 0);
-        Checks::check_exit(VCPKG_LINE_INFO, bResults, "WinHttpSendRequest() failed: %d", GetLastError());
+        auto bResults = WinHttpSendRequest(hRequest.h,
+                                           headers.empty() ? WINHTTP_NO_ADDITIONAL_HEADERS : headers.c_str(),
+                                           static_cast<DWORD>(headers.size()),
+                                           WINHTTP_NO_REQUEST_DATA,
+                                           0,
+                                           0,
+                                           0);
+        if (!bResults) return TransferError{Strings::format("WinHttpSendRequest() failed: %d", GetLastError()), true};
 
         // End the request.
-        bResults = WinHttpReceiveResponse(hRequest, NULL);
-        Checks::check_exit(VCPKG_LINE_INFO, bResults, "WinHttpReceiveResponse() failed: %d", GetLastError());
+        bResults = WinHttpReceiveResponse(hRequest.h, NULL);
+        if (!bResults)
+        {
+            return TransferError{Strings::format("WinHttpReceiveResponse() failed: %d", GetLastError()), true};
+        }
+
+        DWORD headers_size = 0;
+        WinHttpQueryHeaders(hRequest.h,
+                            WINHTTP_QUERY_RAW_HEADERS_CRLF,
+                            WINHTTP_HEADER_NAME_BY_INDEX,
+                            WINHTTP_NO_OUTPUT_BUFFER,
+                            &headers_size,
+                            WINHTTP_NO_HEADER_INDEX);
+        std::wstring raw_headers(headers_size / sizeof(wchar_t), L'\0');
+        bResults = WinHttpQueryHeaders(hRequest.h,
+                                       WINHTTP_QUERY_RAW_HEADERS_CRLF,
+                                       WINHTTP_HEADER_NAME_BY_INDEX,
+                                       &raw_headers[0],
+                                       &headers_size,
+                                       WINHTTP_NO_HEADER_INDEX);
+        if (!bResults) return TransferError{Strings::format("WinHttpQueryHeaders() failed: %d", GetLastError()), true};
+
+        auto maybe_response = Http::parse_response_head(Strings::to_utf8(raw_headers.c_str()));
+        const auto response = maybe_response.get();
+        if (!response) return TransferError{Strings::format("Invalid response from %s", hostname), true};
+        if (!on_response(*response)) return std::move(*response);
 
         std::vector<char> buf;
 
-        size_t total_downloaded_size = 0;
         DWORD dwSize = 0;
         do
         {
             DWORD downloaded_size = 0;
-            bResults = WinHttpQueryDataAvailable(hRequest, &dwSize);
-            Checks::check_exit(VCPKG_LINE_INFO, bResults, "WinHttpQueryDataAvailable() failed: %d", GetLastError());
+            bResults = WinHttpQueryDataAvailable(hRequest.h, &dwSize);
+            if (!bResults)
+            {
+                return TransferError{Strings::format("WinHttpQueryDataAvailable() failed: %d", GetLastError()), true};
+            }
 
             if (buf.size() < dwSize) buf.resize(static_cast<size_t>(dwSize) * 2);
 
-            bResults = WinHttpReadData(hRequest, (LPVOID)buf.data(), dwSize, &downloaded_size);
-            Checks::check_exit(VCPKG_LINE_INFO, bResults, "WinHttpReadData() failed: %d", GetLastError());
-            fwrite(buf.data(), 1, downloaded_size, f);
-
-            total_downloaded_size += downloaded_size;
+            bResults = WinHttpReadData(hRequest.h, (LPVOID)buf.data(), dwSize, &downloaded_size);
+            if (!bResults) return TransferError{Strings::format("WinHttpReadData() failed: %d", GetLastError()), true};
+            data_cb(StringView{buf.data(), static_cast<size_t>(downloaded_size)});
         } while (dwSize > 0);
 
-        WinHttpCloseHandle(hSession);
-        WinHttpCloseHandle(hConnect);
-        WinHttpCloseHandle(hRequest);
-        fflush(f);
-        fclose(f);
+        return std::move(*response);
     }
 #endif
 
-    void verify_downloaded_file_hash(const Files::Filesystem& fs,
-                                     const std::string& url,
-                                     const fs::path& path,
-                                     const std::string& sha512)
+    // <HACK to handle NuGet.org changing nupkg hashes.>
+    static void fixup_downloaded_file_hash(std::string& actual_hash)
     {
-        std::string actual_hash = vcpkg::Hash::get_file_hash(VCPKG_LINE_INFO, fs, path, Hash::Algorithm::Sha512);
-
-        // <HACK to handle NuGet.org changing nupkg hashes.>
         // This is the NEW hash for 7zip
         if (actual_hash == "a9dfaaafd15d98a2ac83682867ec5766720acf6e99d40d1a00d480692752603bf3f3742623f0ea85647a92374df"
                            "405f331afd6021c5cf36af43ee8db198129c0")
             // This is the OLD hash for 7zip
             actual_hash = "8c75314102e68d2b2347d592f8e3eb05812e1ebb525decbac472231633753f1d4ca31c8e6881a36144a8da26b257"
                           "1305b3ae3f4e2b85fc4a290aeda63d1a13b8";
-        // </HACK>
+    }
+    // </HACK>
+
+    static std::string make_hash_mismatch_message(const std::string& url,
+                                                  const fs::path& path,
+                                                  const std::string& sha512,
+                                                  const std::string& actual_hash)
+    {
+        return Strings::format("File does not have the expected hash:\n"
+                               "             url : [ %s ]\n"
+                               "       File path : [ %s ]\n"
+                               "   Expected hash : [ %s ]\n"
+                               "     Actual hash : [ %s ]\n",
+                               url,
+                               path.u8string(),
+                               sha512,
+                               actual_hash);
+    }
+
+    void verify_downloaded_file_hash(const Files::Filesystem& fs,
+                                     const std::string& url,
+                                     const fs::path& path,
+                                     const std::string& sha512)
+    {
+        std::string actual_hash = vcpkg::Hash::get_file_hash(VCPKG_LINE_INFO, fs, path, Hash::Algorithm::Sha512);
+        fixup_downloaded_file_hash(actual_hash);
 
         Checks::check_exit(VCPKG_LINE_INFO,
                            sha512 == actual_hash,
-                           "File does not have the expected hash:\n"
-                           "             url : [ %s ]\n"
-                           "       File path : [ %s ]\n"
-                           "   Expected hash : [ %s ]\n"
-                           "     Actual hash : [ %s ]\n",
-                           url,
-                           path.u8string(),
-                           sha512,
-                           actual_hash);
+                           "%s",
+                           make_hash_mismatch_message(url, path, sha512, actual_hash));
     }
 
-    void download_file(vcpkg::Files::Filesystem& fs,
-                       const std::string& url,
-                       const fs::path& download_path,
-                       const std::string& sha512)
+    DownloadStore DownloadStore::for_downloads_dir(const fs::path& downloads)
+    {
+        DownloadStore store;
+        store.root = downloads / ".sha512";
+
+        if (auto read_only_stores = System::get_environment_variable("VCPKG_READONLY_DOWNLOAD_STORES"))
+        {
+#if defined(_WIN32)
+            static constexpr const char* PATH_SEPARATOR = ";";
+#else
+            static constexpr const char* PATH_SEPARATOR = ":";
+#endif
+            for (auto&& read_only_root : Strings::split(*read_only_stores.get(), PATH_SEPARATOR))
+            {
+                store.read_only_roots.push_back(fs::u8path(read_only_root));
+            }
+        }
+
+        return store;
+    }
+
+    bool DownloadStore::is_valid_sha512(const std::string& sha512)
+    {
+        return sha512.size() == 128 && std::all_of(sha512.begin(), sha512.end(), [](char c) {
+                   return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f');
+               });
+    }
+
+    static fs::path object_path_in(const fs::path& root, const std::string& sha512)
+    {
+        return root / fs::u8path(sha512.substr(0, 2)) / fs::u8path(sha512);
+    }
+
+    fs::path DownloadStore::object_path(const std::string& sha512) const { return object_path_in(root, sha512); }
+
+    static bool link_or_copy(Files::Filesystem& fs, const fs::path& target, const fs::path& link)
+    {
+        std::error_code ec;
+        fs.remove(link, ec);
+        fs.create_directories(link.parent_path(), ec);
+
+        fs.create_hard_link(target, link, ec);
+        if (!ec) return true;
+
+        // Across file systems, or where hard links are not supported
+        fs.copy_file(target, link, fs::copy_options::overwrite_existing, ec);
+        return !ec;
+    }
+
+    bool DownloadStore::try_link(Files::Filesystem& fs, const std::string& sha512, const fs::path& download_path) const
+    {
+        if (!is_valid_sha512(sha512)) return false;
+
+        if (fs.exists(object_path(sha512)))
+        {
+            return link_or_copy(fs, object_path(sha512), download_path);
+        }
+
+        for (auto&& read_only_root : read_only_roots)
+        {
+            const auto object = object_path_in(read_only_root, sha512);
+            if (fs.exists(object) && link_or_copy(fs, object, download_path)) return true;
+        }
+
+        return false;
+    }
+
+    void DownloadStore::prune(Files::Filesystem& fs) const
+    {
+        for (auto&& prefix_dir : fs.get_files_non_recursive(root))
+        {
+            // Skips the locks directory; temporary files do not have a hash for a name
+            if (prefix_dir.filename().u8string().size() != 2 || !fs.is_directory(prefix_dir)) continue;
+
+            for (auto&& object : fs.get_files_non_recursive(prefix_dir))
+            {
+                if (!is_valid_sha512(object.filename().u8string())) continue;
+
+                std::error_code ec;
+                if (fs.hard_link_count(object, ec) == 1) fs.remove(object, ec);
+            }
+        }
+    }
+
+    std::string get_url_host(StringView url)
     {
-        const std::string download_path_part = download_path.u8string() + ".part";
-        auto download_path_part_path = fs::u8path(download_path_part);
+        auto first = url.begin();
+        const auto last = url.end();
+
+        const auto scheme_end = Strings::search(url, "://");
+        if (scheme_end != last) first = scheme_end + 3;
+
+        const auto authority_end = std::find_if(first, last, [](char c) { return c == '/' || c == '?' || c == '#'; });
+
+        const auto user_info_end = std::find(std::make_reverse_iterator(authority_end),
+                                             std::make_reverse_iterator(first),
+                                             '@');
+        if (user_info_end.base() != first) first = user_info_end.base();
+
+        const auto host_end = (first != authority_end && *first == '[')
+                                  ? std::find(first, authority_end, ']') + 1
+                                  : std::find(first, authority_end, ':');
+
+        return Strings::ascii_to_lowercase(std::string(first, std::min(host_end, authority_end)));
+    }
+
+    namespace
+    {
+        // Limits the connections to each host without holding up a thread: a download that finds its host busy is
+        // parked here, and handed back to its work queue once a connection to that host is released.
+        struct HostConnectionLimiter
+        {
+            explicit HostConnectionLimiter(unsigned max_per_host) : m_max_per_host(max_per_host) {}
+
+            // Reserve up to `wanted` connections to `host`. Returns how many were reserved; if none and `retry` is set,
+            // it is called by the next release() for `host`.
+            unsigned try_acquire(const std::string& host, unsigned wanted, std::function<void()> retry)
+            {
+                std::lock_guard<std::mutex> lck(m_mutex);
+                auto& connections = m_connections[host];
+                const auto reserved = std::min(wanted, m_max_per_host - connections);
+                if (reserved == 0 && retry)
+                    m_parked[host].push_back(std::move(retry));
+                else
+                    connections += reserved;
+                return reserved;
+            }
+
+            void release(const std::string& host, unsigned count)
+            {
+                std::vector<std::function<void()>> parked;
+                {
+                    std::lock_guard<std::mutex> lck(m_mutex);
+                    m_connections[host] -= count;
+                    parked.swap(m_parked[host]);
+                }
+                for (auto&& retry : parked)
+                {
+                    retry();
+                }
+            }
+
+        private:
+            unsigned m_max_per_host;
+            std::mutex m_mutex;
+            std::unordered_map<std::string, unsigned> m_connections;
+            std::unordered_map<std::string, std::vector<std::function<void()>>> m_parked;
+        };
+
+        // The connections a download holds to the host of its URL. It starts with one, and its segments take more
+        // while the host has some to spare.
+        struct HostConnections
+        {
+            // No limit if null
+            HostConnectionLimiter* limiter;
+            std::string host;
+            unsigned held;
+
+            unsigned grow_to(unsigned wanted)
+            {
+                if (!limiter)
+                    held = std::max(held, wanted);
+                else if (wanted > held)
+                    held += limiter->try_acquire(host, wanted - held, nullptr);
+                return held;
+            }
+        };
+
+        struct ByteRange
+        {
+            std::uint64_t first;
+            Optional<std::uint64_t> last;
+        };
+    }
+
+    static Optional<std::uint64_t> parse_decimal(const std::string& s)
+    {
+        if (s.empty() || s.size() >= 20 || !std::all_of(s.begin(), s.end(), [](char c) { return c >= '0' && c <= '9'; }))
+        {
+            return nullopt;
+        }
+        return std::stoull(s);
+    }
+
+    static bool is_http_url(const std::string& url)
+    {
+        return Strings::case_insensitive_ascii_starts_with(url, "http://") ||
+               Strings::case_insensitive_ascii_starts_with(url, "https://");
+    }
+
+    static bool is_retryable_status(int status_code)
+    {
+        return status_code == 408 || status_code == 429 || (status_code >= 500 && status_code < 600);
+    }
+
+#if !defined(_WIN32)
+    static bool is_retryable_curl_exit_code(int exit_code)
+    {
+        switch (exit_code)
+        {
+            case 5:  // Couldn't resolve proxy
+            case 6:  // Couldn't resolve host
+            case 7:  // Failed to connect
+            case 18: // Partial file
+            case 28: // Operation timeout
+            case 35: // SSL connect error
+            case 52: // Empty reply from server
+            case 55: // Failed sending network data
+            case 56: // Failure in receiving network data
+                return true;
+            default: return false;
+        }
+    }
+
+    static TransferResult curl_transfer(const std::string& url,
+                                        const Optional<ByteRange>& range,
+                                        bool probe,
+                                        const fs::path& headers_path,
+                                        const std::function<void(StringView)>& data_cb)
+    {
+        auto cmd = Strings::format(R"(curl -L --fail --silent --show-error -D '%s')", headers_path.u8string());
+        if (auto r = range.get())
+        {
+            Strings::append(cmd, " -r ", std::to_string(r->first), '-');
+            if (auto last = r->last.get()) Strings::append(cmd, std::to_string(*last));
+        }
+        // Keep a server that ignores the range from sending the whole file
+        if (probe) cmd += " --max-filesize 1";
+        Strings::append(cmd, " '", url, '\'');
+
+        const auto exit_code = System::cmd_execute_and_stream_data(cmd, data_cb);
+
+        auto& real_fs = Files::get_real_filesystem();
+        const auto maybe_headers = real_fs.read_contents(headers_path);
+        auto maybe_response = Http::parse_response_head(maybe_headers ? *maybe_headers.get() : std::string());
         std::error_code ec;
-        fs.remove(download_path, ec);
-        fs.remove(download_path_part_path, ec);
+        real_fs.remove(headers_path, ec);
+
+        const auto response = maybe_response.get();
+        if (exit_code == 0)
+        {
+            if (response) return std::move(*response);
+
+            // Schemes without status codes, such as file://
+            Http::Response ok;
+            ok.status_code = 200;
+            return ok;
+        }
+
+        static constexpr int CURLE_HTTP_RETURNED_ERROR = 22;
+        static constexpr int CURLE_FILESIZE_EXCEEDED = 63;
+        if (response && (exit_code == CURLE_HTTP_RETURNED_ERROR || (probe && exit_code == CURLE_FILESIZE_EXCEEDED)))
+        {
+            return std::move(*response);
+        }
+
+        return TransferError{Strings::format("Downloading %s failed: curl exited with code %d", url, exit_code),
+                             is_retryable_curl_exit_code(exit_code)};
+    }
+#endif
+
+    // GET `url`, or the given range of it. The body is passed to `data_cb` unless the response has a different status
+    // than `expected_status`; curl may still have passed some of it by the time the status is known.
+    static TransferResult transfer(const std::string& url,
+                                   const Optional<ByteRange>& range,
+                                   int expected_status,
+                                   bool probe,
+                                   const fs::path& scratch_path,
+                                   const std::function<void(StringView)>& data_cb)
+    {
+        std::vector<std::string> request_headers;
+        if (auto r = range.get())
+        {
+            request_headers.push_back(Strings::concat("Range: bytes=", std::to_string(r->first), '-'));
+            if (auto last = r->last.get()) Strings::append(request_headers.back(), std::to_string(*last));
+        }
+
+        const auto on_response = [&](const Http::Response& response) {
+            return response.status_code == expected_status;
+        };
+
 #if defined(_WIN32)
-        auto url_no_proto = url.substr(8); // drop https://
+        // WinHTTP handles both schemes, and follows redirects itself
+        Util::unused(probe, scratch_path);
+        const bool secure = Strings::case_insensitive_ascii_starts_with(url, "https://");
+        if (!secure && !Strings::case_insensitive_ascii_starts_with(url, "http://"))
+        {
+            return TransferError{Strings::format("Downloading %s failed: only http:// and https:// are supported", url),
+                                 false};
+        }
+
+        auto url_no_proto = url.substr(secure ? 8 : 7);
         auto path_begin = Util::find(url_no_proto, '/');
         std::string hostname(url_no_proto.begin(), path_begin);
         std::string path(path_begin, url_no_proto.end());
 
-        winhttp_download_file(fs, download_path_part, hostname, path);
+        INTERNET_PORT port = secure ? INTERNET_DEFAULT_HTTPS_PORT : INTERNET_DEFAULT_HTTP_PORT;
+        const auto port_begin = hostname.rfind(':');
+        if (port_begin != std::string::npos)
+        {
+            const auto maybe_port = parse_decimal(hostname.substr(port_begin + 1));
+            if (auto p = maybe_port.get())
+            {
+                if (*p <= 65535) port = static_cast<INTERNET_PORT>(*p);
+            }
+            hostname.resize(port_begin);
+        }
+
+        return winhttp_transfer(hostname, port, secure, path, request_headers, on_response, data_cb);
 #else
-        const auto code = System::cmd_execute(
-            Strings::format(R"(curl -L '%s' --create-dirs --output '%s')", url, download_path_part));
-        Checks::check_exit(VCPKG_LINE_INFO, code == 0, "Could not download %s", url);
+        // No TLS library is linked, so the in-process client speaks plain http:// only and https:// goes through curl
+        if (!Strings::case_insensitive_ascii_starts_with(url, "http://"))
+        {
+            return curl_transfer(url, range, probe, fs::u8path(scratch_path.u8string() + ".headers"), data_cb);
+        }
+
+        auto result = Http::get(url, request_headers, on_response, data_cb);
+        if (auto response = result.get())
+        {
+            // A redirect to https:// or another scheme the in-process client does not handle
+            if (response->status_code >= 300 && response->status_code < 400)
+            {
+                if (auto location = response->get_header("location"))
+                {
+                    return transfer(*location.get(), range, expected_status, probe, scratch_path, data_cb);
+                }
+            }
+            return std::move(*response);
+        }
+        return TransferError{Strings::format("Downloading %s failed: %s", url, result.error()), true};
 #endif
+    }
+
+    static std::uint64_t file_size_or_zero(const fs::path& path)
+    {
+        std::error_code ec;
+        const auto size = fs::stdfs::file_size(path, ec);
+        return ec ? 0 : static_cast<std::uint64_t>(size);
+    }
+
+    static void for_each_chunk(const fs::path& path, const std::function<void(StringView)>& cb)
+    {
+        std::ifstream in(path, std::ios_base::in | std::ios_base::binary);
+        std::vector<char> buf(1024 * 1024);
+        while (in)
+        {
+            in.read(buf.data(), static_cast<std::streamsize>(buf.size()));
+            const auto read = static_cast<size_t>(in.gcount());
+            if (read == 0) break;
+            cb(StringView(buf.data(), read));
+        }
+    }
+
+    namespace
+    {
+        struct Segment
+        {
+            std::uint64_t offset = 0;
+            // Unknown if the server does not announce the size of the file
+            Optional<std::uint64_t> size;
+            // Bytes of the segment already in the part file, when several segments share it
+            std::uint64_t have = 0;
+            // Hash of the content of a download over a single connection, while all of it was written by this process
+            std::unique_ptr<Hash::Hasher> hasher;
+        };
+
+        struct TransferProgress
+        {
+            TransferProgress(std::string name, Optional<std::uint64_t> total, bool show_progress)
+                : m_name(std::move(name))
+                , m_total(total)
+                , m_show_progress(show_progress)
+                , m_timer(Chrono::ElapsedTimer::create_started())
+            {
+            }
+
+            void add(std::uint64_t bytes)
+            {
+                const auto received = m_received += bytes;
+                if (!m_show_progress) return;
+
+                std::lock_guard<std::mutex> lck(m_mutex);
+                const auto elapsed = m_timer.elapsed().as<std::chrono::seconds>();
+                if (elapsed - m_last_report < std::chrono::seconds(5)) return;
+                m_last_report = elapsed;
+
+                if (auto total = m_total.get())
+                {
+                    System::printf("    %s: %.1f of %.1f MiB, %.1f MiB/s\n",
+                                   m_name,
+                                   to_mib(received),
+                                   to_mib(*total),
+                                   to_mib(received) / seconds());
+                }
+                else
+                {
+                    System::printf(
+                        "    %s: %.1f MiB, %.1f MiB/s\n", m_name, to_mib(received), to_mib(received) / seconds());
+                }
+            }
+
+            void print_summary(size_t connections) const
+            {
+                const auto received = m_received.load();
+                System::printf("Downloaded %s: %.1f MiB in %s (%.1f MiB/s over %zd connection%s)\n",
+                               m_name,
+                               to_mib(received),
+                               m_timer.to_string(),
+                               to_mib(received) / seconds(),
+                               connections,
+                               connections == 1 ? "" : "s");
+            }
+
+        private:
+            static double to_mib(std::uint64_t bytes) { return static_cast<double>(bytes) / (1024 * 1024); }
+
+            double seconds() const
+            {
+                return std::max(m_timer.elapsed().as<std::chrono::duration<double>>().count(), 0.001);
+            }
+
+            std::string m_name;
+            Optional<std::uint64_t> m_total;
+            bool m_show_progress;
+            Chrono::ElapsedTimer m_timer;
+            std::atomic<std::uint64_t> m_received{0};
+            std::mutex m_mutex;
+            std::chrono::seconds m_last_report{0};
+        };
+
+        struct SegmentTransfer
+        {
+            const std::string* url;
+            const fs::path* part_path;
+            Segment* segment;
+            bool accepts_ranges;
+            // Several segments write to their own offsets of a part file of the final size
+            bool in_place;
+            const DownloadOptions* options;
+            TransferProgress* progress;
+            Optional<std::string>* error;
+
+            // Returns an error message, or nullopt once the segment is complete
+            Optional<std::string> run() const
+            {
+                std::string last_error;
+                for (unsigned attempt = 0; attempt < std::max(options->max_attempts, 1u); ++attempt)
+                {
+                    if (attempt != 0) std::this_thread::sleep_for(options->retry_delay * attempt);
+
+                    const auto size = segment->size.get();
+                    std::uint64_t have = segment->have;
+                    if (!in_place)
+                    {
+                        have = file_size_or_zero(*part_path);
+                        if (!accepts_ranges || (size && have > *size)) have = 0;
+                        if (have == 0) segment->hasher = Hash::get_hasher_for(Hash::Algorithm::Sha512);
+                    }
+                    if (size && have == *size) return nullopt;
+
+                    std::fstream out;
+                    if (in_place)
+                    {
+                        out.open(*part_path, std::ios_base::in | std::ios_base::out | std::ios_base::binary);
+                        out.seekp(static_cast<std::streamoff>(segment->offset + have));
+                    }
+                    else
+                    {
+                        out.open(*part_path,
+                                 std::ios_base::out | std::ios_base::binary |
+                                     (have == 0 ? std::ios_base::trunc : std::ios_base::app));
+                    }
+                    if (!out) return Strings::format("Could not open %s", part_path->u8string());
+
+                    Optional<ByteRange> range;
+                    if (accepts_ranges)
+                    {
+                        range = ByteRange{segment->offset + have,
+                                          size ? Optional<std::uint64_t>(segment->offset + *size - 1) : nullopt};
+                    }
+                    const int expected_status = accepts_ranges ? 206 : 200;
+
+                    std::uint64_t received = 0;
+                    const auto on_data = [&](StringView data) {
+                        // Never past the end of the segment, where the next one is written
+                        auto length = data.size();
+                        if (size) length = static_cast<size_t>(std::min<std::uint64_t>(length, *size - have - received));
+                        out.write(data.data(), static_cast<std::streamsize>(length));
+                        if (segment->hasher) segment->hasher->add_bytes(data.begin(), data.begin() + length);
+                        received += length;
+                        progress->add(length);
+                    };
+
+                    auto result = transfer(*url, range, expected_status, false, *part_path, on_data);
+
+                    out.close();
+                    if (!out) return Strings::format("Could not write %s", part_path->u8string());
+
+                    const auto response = result.get();
+                    if (!response)
+                    {
+                        last_error = result.error().message;
+                        if (!result.error().retryable) return last_error;
+                        continue;
+                    }
+
+                    bool unexpected_range = false;
+                    if (response->status_code == 206)
+                    {
+                        const auto content_range = response->get_header("content-range");
+                        const auto parsed = content_range ? Http::parse_content_range(*content_range.get()) : nullopt;
+                        unexpected_range = !parsed || parsed.get()->first != segment->offset + have;
+                    }
+
+                    if (response->status_code != expected_status || unexpected_range)
+                    {
+                        // Drop whatever was written for this response; in place, the next attempt overwrites it
+                        if (!in_place)
+                        {
+                            std::error_code ec;
+                            fs::stdfs::resize_file(*part_path, have, ec);
+                            segment->hasher = nullptr;
+                        }
+
+                        last_error = Strings::format("Downloading %s failed: the server responded with status %d%s",
+                                                     *url,
+                                                     response->status_code,
+                                                     unexpected_range ? " and an unexpected range" : "");
+                        if (!is_retryable_status(response->status_code)) return last_error;
+                        continue;
+                    }
+
+                    if (!size) return nullopt;
+                    segment->have = have + received;
+                    if (segment->have == *size) return nullopt;
+
+                    last_error = Strings::format("Downloading %s failed: the connection closed early", *url);
+                }
+
+                return Strings::format("Giving up after %u attempts. %s", options->max_attempts, last_error);
+            }
+
+            template<class ThreadLocalData, class Queue>
+            void operator()(ThreadLocalData&, const Queue&) &&
+            {
+                *error = run();
+            }
+        };
+    }
+
+    // A file is split into several segments only if the server accepts range requests and announces its size; the
+    // segments then share `<target>.part`, allocated at the final size, and each writes at its own offset.
+    static std::vector<Segment> plan_segments(const Optional<std::uint64_t>& total,
+                                              bool accepts_ranges,
+                                              const DownloadOptions& options,
+                                              unsigned max_connections)
+    {
+        std::vector<Segment> segments;
+
+        auto total_size = total.get();
+        if (!total_size)
+        {
+            segments.emplace_back();
+            return segments;
+        }
+
+        std::uint64_t count = 1;
+        if (accepts_ranges)
+        {
+            const auto segment_size = std::max<std::uint64_t>(options.min_segment_size, 1);
+            count = std::min<std::uint64_t>(std::min(options.max_segments, max_connections), *total_size / segment_size);
+            count = std::max<std::uint64_t>(count, 1);
+        }
+
+        for (std::uint64_t i = 0; i < count; ++i)
+        {
+            const auto offset = *total_size * i / count;
+            segments.emplace_back();
+            auto& segment = segments.back();
+            segment.offset = offset;
+            segment.size = *total_size * (i + 1) / count - offset;
+        }
+
+        return segments;
+    }
+
+    // How much of each segment of an in-place download is written, as `<offset> <bytes>` lines, so that a later run
+    // resumes it
+    static fs::path get_segments_path(const fs::path& part_path)
+    {
+        return fs::u8path(part_path.u8string() + ".segments");
+    }
+
+    static void save_segments(Files::Filesystem& fs, const fs::path& part_path, const std::vector<Segment>& segments)
+    {
+        std::vector<std::string> lines;
+        for (auto&& segment : segments)
+        {
+            lines.push_back(Strings::concat(std::to_string(segment.offset), ' ', std::to_string(segment.have)));
+        }
+
+        std::error_code ec;
+        fs.write_lines(get_segments_path(part_path), lines, ec);
+    }
+
+    // Pick up what an earlier attempt wrote to the part file, then allocate it at the final size
+    static Optional<std::string> prepare_in_place(Files::Filesystem& fs,
+                                                  const fs::path& part_path,
+                                                  std::uint64_t total,
+                                                  std::vector<Segment>& segments)
+    {
+        const auto part_size = file_size_or_zero(part_path);
+        auto maybe_lines = fs.read_lines(get_segments_path(part_path));
+        if (auto lines = maybe_lines.get())
+        {
+            bool resumable = part_size == total && lines->size() == segments.size();
+            for (size_t i = 0; resumable && i < segments.size(); ++i)
+            {
+                const auto fields = Strings::split((*lines)[i], " ");
+                const auto offset = fields.size() == 2 ? parse_decimal(fields[0]) : nullopt;
+                const auto have = fields.size() == 2 ? parse_decimal(fields[1]) : nullopt;
+                resumable = offset && have && *offset.get() == segments[i].offset &&
+                            *have.get() <= *segments[i].size.get();
+                if (resumable) segments[i].have = *have.get();
+            }
+
+            if (!resumable)
+            {
+                for (auto&& segment : segments)
+                {
+                    segment.have = 0;
+                }
+            }
+        }
+        else if (part_size <= total)
+        {
+            // Left by a download over a single connection, which writes from the start of the file
+            segments.front().have = std::min(part_size, *segments.front().size.get());
+        }
+
+        {
+            std::fstream create(part_path, std::ios_base::out | std::ios_base::binary | std::ios_base::app);
+            if (!create) return Strings::format("Could not open %s", part_path.u8string());
+        }
+        std::error_code ec;
+        fs::stdfs::resize_file(part_path, total, ec);
+        if (ec) return Strings::format("Could not allocate %s: %s", part_path.u8string(), ec.message());
+
+        // Written before any transfer starts, so that a part file without it only ever holds a prefix of the file
+        save_segments(fs, part_path, segments);
+        return nullopt;
+    }
+
+    // Remove the parts of earlier downloads of the same target that the current one does not use, such as the
+    // separate segment files older versions kept
+    static void remove_stale_parts(Files::Filesystem& fs, const fs::path& part_path)
+    {
+        const auto prefix = part_path.filename().u8string();
+        const auto segments_path = get_segments_path(part_path);
+        for (auto&& file : fs.get_files_non_recursive(part_path.parent_path()))
+        {
+            const auto filename = file.filename().u8string();
+            if (!Strings::starts_with(filename, prefix) || file == part_path || file == segments_path) continue;
+
+            std::error_code ec;
+            fs.remove(file, ec);
+        }
+    }
+
+    // Download `url` to `target`, verifying its hash. Returns an error message on failure.
+    static Optional<std::string> download_to(Files::Filesystem& fs,
+                                             const std::string& url,
+                                             const fs::path& target,
+                                             const std::string& display_name,
+                                             const std::string& sha512,
+                                             const DownloadOptions& options,
+                                             HostConnections& connections,
+                                             bool show_progress)
+    {
+        std::error_code ec;
+        fs.create_directories(target.parent_path(), ec);
+        const auto part_path = fs::u8path(target.u8string() + ".part");
+        const auto segments_path = get_segments_path(part_path);
+
+        // Ask for the first byte to learn the size of the file and whether the server accepts range requests
+        Optional<std::uint64_t> total;
+        bool accepts_ranges = false;
+        if (is_http_url(url))
+        {
+            auto probe = transfer(url, ByteRange{0, 0}, 206, true, part_path, [](StringView) {});
+            if (auto response = probe.get())
+            {
+                const auto content_range = response->get_header("content-range");
+                const auto parsed = content_range ? Http::parse_content_range(*content_range.get()) : nullopt;
+                if (response->status_code == 206 && parsed && parsed.get()->complete_length)
+                {
+                    accepts_ranges = true;
+                    total = parsed.get()->complete_length;
+                }
+                else if (response->status_code == 200)
+                {
+                    if (auto content_length = response->get_header("content-length"))
+                    {
+                        total = parse_decimal(*content_length.get());
+                    }
+                }
+                else if (response->status_code >= 400 && response->status_code != 416 &&
+                         !is_retryable_status(response->status_code))
+                {
+                    return Strings::format(
+                        "Downloading %s failed: the server responded with status %d", url, response->status_code);
+                }
+            }
+            else if (!probe.error().retryable)
+            {
+                return probe.error().message;
+            }
+        }
+
+        auto segments = plan_segments(total, accepts_ranges, options, options.max_segments);
+        if (segments.size() > 1)
+        {
+            const auto held = connections.grow_to(static_cast<unsigned>(segments.size()));
+            if (held < segments.size()) segments = plan_segments(total, accepts_ranges, options, held);
+        }
+        const bool in_place = segments.size() > 1;
+        remove_stale_parts(fs, part_path);
+        if (in_place)
+        {
+            auto maybe_error = prepare_in_place(fs, part_path, *total.get(), segments);
+            if (auto error = maybe_error.get()) return std::move(*error);
+        }
+        else
+        {
+            fs.remove(segments_path, ec);
+        }
+
+        TransferProgress progress(display_name, total, show_progress);
+        std::vector<Optional<std::string>> errors(segments.size());
+        if (!in_place)
+        {
+            const SegmentTransfer segment_transfer{
+                &url, &part_path, &segments[0], accepts_ranges, false, &options, &progress, &errors[0]};
+            errors[0] = segment_transfer.run();
+        }
+        else
+        {
+            WorkQueue<SegmentTransfer> queue(VCPKG_LINE_INFO);
+            for (size_t i = 0; i < segments.size(); ++i)
+            {
+                queue.enqueue_action(SegmentTransfer{
+                    &url, &part_path, &segments[i], accepts_ranges, true, &options, &progress, &errors[i]});
+            }
+            queue.run_and_join(static_cast<unsigned>(segments.size()), [] { return 0; });
+            save_segments(fs, part_path, segments);
+        }
+
+        for (auto&& error : errors)
+        {
+            // Finished segments are kept for the next attempt
+            if (auto e = error.get()) return std::move(*e);
+        }
+
+        // The segments wrote out of order, so only a download over one connection was hashed on the way
+        auto hasher = std::move(segments.front().hasher);
+        if (!hasher)
+        {
+            hasher = Hash::get_hasher_for(Hash::Algorithm::Sha512);
+            for_each_chunk(part_path, [&](StringView data) { hasher->add_bytes(data.begin(), data.end()); });
+        }
+        auto actual_hash = hasher->get_hash();
+        fixup_downloaded_file_hash(actual_hash);
+
+        fs.remove(segments_path, ec);
+        if (actual_hash != sha512)
+        {
+            fs.remove(part_path, ec);
+            return make_hash_mismatch_message(url, target, sha512, actual_hash);
+        }
+
+        fs.remove(target, ec);
+        fs.rename(part_path, target, ec);
+        if (ec) return Strings::format("Could not rename %s to %s", part_path.u8string(), target.u8string());
+
+        progress.print_summary(segments.size());
+        return nullopt;
+    }
+
+    // Download into the store, then link the requested file name to the stored object.
+    static Optional<std::string> try_download_file(Files::Filesystem& fs,
+                                                   const DownloadStore& store,
+                                                   const std::string& url,
+                                                   const fs::path& download_path,
+                                                   const std::string& sha512,
+                                                   const DownloadOptions& options,
+                                                   HostConnections& connections,
+                                                   bool show_progress)
+    {
+        const bool use_store = DownloadStore::is_valid_sha512(sha512);
+        const fs::path final_path = use_store ? store.object_path(sha512) : download_path;
+
+        // A file is downloaded by one thread of one process at a time, so that its segments are only written once.
+        // Other vcpkg processes may share the downloads directory. The lock files are kept apart from the downloads,
+        // named after the hash of the file or of its path.
+        const auto lock_name =
+            use_store ? sha512 : Hash::get_string_hash(final_path.u8string(), Hash::Algorithm::Sha256);
+        const auto lock_path = store.root / "locks" / fs::u8path(lock_name + ".lock");
+        std::error_code ec;
+        fs.create_directories(lock_path.parent_path(), ec);
+        Files::ExclusiveFileLock lock(lock_path, ec);
+        if (ec) return Strings::format("Could not lock %s: %s", lock_path.u8string(), ec.message());
+
+        if (!use_store || !fs.exists(final_path))
+        {
+            auto maybe_error = download_to(fs,
+                                           url,
+                                           final_path,
+                                           download_path.filename().u8string(),
+                                           sha512,
+                                           options,
+                                           connections,
+                                           show_progress);
+            if (auto error = maybe_error.get()) return std::move(*error);
+        }
+
+        if (use_store && !link_or_copy(fs, final_path, download_path))
+        {
+            return Strings::format("Could not link %s to %s", download_path.u8string(), final_path.u8string());
+        }
+
+        return nullopt;
+    }
+
+    void download_file(vcpkg::Files::Filesystem& fs,
+                       const DownloadStore& store,
+                       const std::string& url,
+                       const fs::path& download_path,
+                       const std::string& sha512,
+                       const DownloadOptions& options)
+    {
+        if (store.try_link(fs, sha512, download_path)) return;
+
+        HostConnections connections{nullptr, get_url_host(url), 1};
+        auto maybe_error = try_download_file(fs, store, url, download_path, sha512, options, connections, true);
+        if (auto error = maybe_error.get())
+        {
+            Checks::exit_with_message(VCPKG_LINE_INFO, *error);
+        }
+    }
+
+    namespace
+    {
+        struct DownloadAction
+        {
+            Files::Filesystem* fs;
+            const DownloadStore* store;
+            const DownloadRequest* request;
+            const DownloadOptions* options;
+            HostConnectionLimiter* limiter;
+            Util::LockGuarded<std::vector<std::string>>* errors;
+            // Where a download parked by the limiter picks up
+            size_t next_url = 0;
+            std::vector<std::string> failures;
+
+            template<class ThreadLocalData, class Queue>
+            void operator()(ThreadLocalData&, const Queue& queue) &&
+            {
+                if (next_url == 0 && store->try_link(*fs, request->sha512, request->download_path)) return;
+
+                for (; next_url < request->urls.size(); ++next_url)
+                {
+                    const auto& url = request->urls[next_url];
+                    HostConnections connections{limiter, get_url_host(url), 1};
+                    if (limiter->try_acquire(connections.host, 1, [&queue, action = *this]() {
+                            queue.enqueue_action(action);
+                        }) == 0)
+                    {
+                        return;
+                    }
+
+                    auto failure = try_download_file(
+                        *fs, *store, url, request->download_path, request->sha512, *options, connections, false);
+                    limiter->release(connections.host, connections.held);
+
+                    if (!failure) return;
+                    failures.push_back(std::move(failure).value_or_exit(VCPKG_LINE_INFO));
+                }
+
+                if (failures.empty())
+                {
+                    failures.push_back(
+                        Strings::format("No URLs were given for %s", request->download_path.filename().u8string()));
+                }
+                errors->lock()->push_back(Strings::join("\n", failures));
+            }
+        };
+    }
+
+    std::vector<std::string> download_files(Files::Filesystem& fs,
+                                            const DownloadStore& store,
+                                            const std::vector<DownloadRequest>& requests,
+                                            unsigned max_connections,
+                                            unsigned max_connections_per_host,
+                                            const DownloadOptions& options)
+    {
+        HostConnectionLimiter limiter(std::max(max_connections_per_host, 1u));
+        Util::LockGuarded<std::vector<std::string>> errors;
+
+        WorkQueue<DownloadAction> queue(VCPKG_LINE_INFO);
+        for (auto&& request : requests)
+        {
+            queue.enqueue_action(DownloadAction{&fs, &store, &request, &options, &limiter, &errors});
+        }
+
+        const auto num_threads = std::min(static_cast<size_t>(std::max(max_connections, 1u)), requests.size());
+        queue.run_and_join(static_cast<unsigned>(num_threads), [] { return 0; });
 
-        verify_downloaded_file_hash(fs, url, download_path_part_path, sha512);
-        fs.rename(download_path_part_path, download_path, VCPKG_LINE_INFO);
+        return std::move(*errors.lock());
     }
 }
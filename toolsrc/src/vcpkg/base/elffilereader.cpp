@@ -0,0 +1,221 @@
+#include "pch.h"
+
+#include <vcpkg/base/elffilereader.h>
+#include <vcpkg/base/strings.h>
+
+namespace vcpkg::ElfFileReader
+{
+    static constexpr size_t EI_CLASS = 4;
+    static constexpr size_t EI_DATA = 5;
+    static constexpr char ELFCLASS32 = 1;
+    static constexpr char ELFCLASS64 = 2;
+    static constexpr char ELFDATA2LSB = 1;
+    static constexpr char ELFDATA2MSB = 2;
+
+    static constexpr uint32_t SHT_DYNAMIC = 6;
+
+    static constexpr uint64_t DT_NULL = 0;
+    static constexpr uint64_t DT_SONAME = 14;
+    static constexpr uint64_t DT_RPATH = 15;
+    static constexpr uint64_t DT_RUNPATH = 29;
+
+    /// <summary>
+    /// Reads fixed-width integers of either byte order from a mapped file. A read past the end yields zero and
+    /// marks the reader as failed, so that damaged files are rejected once at the end instead of after every read.
+    /// </summary>
+    struct ByteReader
+    {
+        const char* data;
+        size_t size;
+        bool big_endian = false;
+        mutable bool failed = false;
+
+        bool in_range(uint64_t offset, uint64_t length) const
+        {
+            if (offset <= size && length <= size - offset) return true;
+            failed = true;
+            return false;
+        }
+
+        uint64_t read(uint64_t offset, size_t width) const
+        {
+            if (!in_range(offset, width)) return 0;
+            const auto p = reinterpret_cast<const unsigned char*>(data + offset);
+            uint64_t value = 0;
+            for (size_t i = 0; i < width; ++i)
+            {
+                const size_t byte = big_endian ? i : width - 1 - i;
+                value = (value << 8) | p[byte];
+            }
+            return value;
+        }
+
+        uint16_t u16(uint64_t offset) const { return static_cast<uint16_t>(read(offset, 2)); }
+        uint32_t u32(uint64_t offset) const { return static_cast<uint32_t>(read(offset, 4)); }
+        uint64_t u64(uint64_t offset) const { return read(offset, 8); }
+
+        std::string c_string(uint64_t offset) const
+        {
+            if (!in_range(offset, 0)) return {};
+            const auto start = data + offset;
+            const auto end = static_cast<const char*>(std::memchr(start, '\0', size - static_cast<size_t>(offset)));
+            if (!end)
+            {
+                failed = true;
+                return {};
+            }
+            return std::string(start, end);
+        }
+    };
+
+    static bool has_elf_magic(const char* data, size_t size)
+    {
+        // The ELF32 header is the smaller one, at 52 bytes
+        return size >= 52 && std::memcmp(data, "\x7F" "ELF", 4) == 0 &&
+               (data[EI_CLASS] == ELFCLASS32 || data[EI_CLASS] == ELFCLASS64) &&
+               (data[EI_DATA] == ELFDATA2LSB || data[EI_DATA] == ELFDATA2MSB);
+    }
+
+    static ByteReader make_reader(const char* data, size_t size)
+    {
+        ByteReader reader{data, size};
+        reader.big_endian = data[EI_DATA] == ELFDATA2MSB;
+        return reader;
+    }
+
+    static Optional<ElfInfo> parse_elf(const char* data, size_t size)
+    {
+        if (!has_elf_magic(data, size)) return nullopt;
+
+        const auto reader = make_reader(data, size);
+        const bool is_64 = data[EI_CLASS] == ELFCLASS64;
+
+        ElfInfo info;
+        switch (reader.u16(16))
+        {
+            case 1: info.type = ElfType::RELOCATABLE; break;
+            case 2: info.type = ElfType::EXECUTABLE; break;
+            case 3: info.type = ElfType::SHARED_OBJECT; break;
+            default: info.type = ElfType::OTHER; break;
+        }
+        info.machine = reader.u16(18);
+
+        const uint64_t shoff = is_64 ? reader.u64(40) : reader.u32(32);
+        const uint64_t shentsize = reader.u16(is_64 ? 58 : 46);
+        uint64_t shnum = reader.u16(is_64 ? 60 : 48);
+        if (reader.failed) return nullopt;
+        if (shoff == 0) return info;
+        // Every field read below lies within a section header of the standard size
+        if (shentsize < (is_64 ? 64u : 40u)) return nullopt;
+        // With more sections than fit in e_shnum, the count is in the first section header's sh_size
+        if (shnum == 0) shnum = is_64 ? reader.u64(shoff + 32) : reader.u32(shoff + 20);
+        // Bound the count by the file size before multiplying, which could otherwise overflow
+        if (reader.failed || shoff > size || shnum > (size - shoff) / shentsize) return nullopt;
+
+        const auto section_offset = [&](uint64_t index) {
+            return is_64 ? reader.u64(shoff + index * shentsize + 24) : reader.u32(shoff + index * shentsize + 16);
+        };
+
+        for (uint64_t i = 0; i < shnum; ++i)
+        {
+            const uint64_t header = shoff + i * shentsize;
+            if (reader.u32(header + 4) != SHT_DYNAMIC) continue;
+
+            const uint64_t offset = section_offset(i);
+            const uint64_t section_size = is_64 ? reader.u64(header + 32) : reader.u32(header + 20);
+            const uint64_t strtab_index = reader.u32(header + (is_64 ? 40 : 24));
+            if (strtab_index >= shnum) return nullopt;
+            const uint64_t strtab = section_offset(strtab_index);
+
+            const uint64_t entry_size = is_64 ? 16 : 8;
+            for (uint64_t entry = offset; entry + entry_size <= offset + section_size; entry += entry_size)
+            {
+                const uint64_t tag = is_64 ? reader.u64(entry) : reader.u32(entry);
+                const uint64_t value = is_64 ? reader.u64(entry + 8) : reader.u32(entry + 4);
+                if (tag == DT_NULL || reader.failed) break;
+                if (tag == DT_SONAME)
+                {
+                    info.soname = reader.c_string(strtab + value);
+                }
+                else if (tag == DT_RPATH || tag == DT_RUNPATH)
+                {
+                    for (auto&& path : Strings::split(reader.c_string(strtab + value), ":"))
+                        info.search_paths.push_back(std::move(path));
+                }
+            }
+            break;
+        }
+
+        if (reader.failed) return nullopt;
+        return info;
+    }
+
+    Optional<ElfInfo> read_elf(const fs::path& path)
+    {
+        std::error_code ec;
+        const Files::MappedFile file(path, ec);
+        if (ec) return nullopt;
+        return parse_elf(file.data(), file.size());
+    }
+
+    Optional<std::vector<uint16_t>> read_archive_machines(const fs::path& path)
+    {
+        static constexpr StringLiteral FILE_START = "!<arch>\n";
+        static constexpr size_t HEADER_SIZE = 60;
+        static constexpr size_t HEADER_SIZE_OFFSET = 48;
+        static constexpr size_t HEADER_SIZE_FIELD_SIZE = 10;
+
+        std::error_code ec;
+        const Files::MappedFile file(path, ec);
+        if (ec || file.size() < FILE_START.size() ||
+            std::memcmp(file.data(), FILE_START.c_str(), FILE_START.size()) != 0)
+        {
+            return nullopt;
+        }
+
+        std::vector<uint16_t> machines;
+        size_t position = FILE_START.size();
+        while (position + HEADER_SIZE <= file.size())
+        {
+            const char* header = file.data() + position;
+            size_t member_size = 0;
+            for (size_t i = 0; i < HEADER_SIZE_FIELD_SIZE; ++i)
+            {
+                const char c = header[HEADER_SIZE_OFFSET + i];
+                if (c < '0' || c > '9') break;
+                member_size = member_size * 10 + static_cast<size_t>(c - '0');
+            }
+
+            const size_t member = position + HEADER_SIZE;
+            if (member_size > file.size() - member) break;
+
+            // Symbol tables and the long name table are not objects, and are not ELF either
+            const char* data = file.data() + member;
+            if (has_elf_magic(data, member_size))
+            {
+                const auto machine = make_reader(data, member_size).u16(18);
+                if (std::find(machines.begin(), machines.end(), machine) == machines.end())
+                    machines.push_back(machine);
+            }
+
+            // Members are aligned to 2 bytes
+            position = member + member_size + (member_size & 1);
+        }
+
+        return machines;
+    }
+
+    std::string to_architecture(uint16_t machine)
+    {
+        switch (machine)
+        {
+            case 3: return "x86";
+            case 62: return "x64";
+            case 40: return "arm";
+            case 183: return "arm64";
+            case 21: return "ppc64le";
+            case 22: return "s390x";
+            default: return "e_machine " + std::to_string(machine);
+        }
+    }
+}
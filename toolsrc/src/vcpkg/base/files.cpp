@@ -9,7 +9,10 @@
 #include <vcpkg/base/work_queue.h>
 
 #if !defined(_WIN32)
+#include <dirent.h>
 #include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
@@ -139,6 +142,153 @@ namespace vcpkg::Files
             }
 #endif
         }
+
+        void read_directory_entries(const fs::path& dir,
+                                    const std::function<void(DirectoryEntry&&)>& visit,
+                                    std::error_code& ec)
+        {
+            ec.clear();
+#if defined(_WIN32)
+            WIN32_FIND_DATAW data;
+            const fs::path pattern = dir / "*";
+            const HANDLE find = FindFirstFileExW(
+                pattern.c_str(), FindExInfoBasic, &data, FindExSearchNameMatch, nullptr, FIND_FIRST_EX_LARGE_FETCH);
+            if (find == INVALID_HANDLE_VALUE)
+            {
+                const auto err = GetLastError();
+                if (err != ERROR_FILE_NOT_FOUND) ec.assign(err, std::system_category());
+                return;
+            }
+
+            do
+            {
+                const wchar_t* name = data.cFileName;
+                if (name[0] == L'.' && (name[1] == L'\0' || (name[1] == L'.' && name[2] == L'\0'))) continue;
+
+                auto type = fs::file_type::regular;
+                if (data.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT)
+                {
+                    // this also gives junctions file_type::directory_symlink
+                    type = data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY ? fs::file_type::directory_symlink
+                                                                             : fs::file_type::symlink;
+                }
+                else if (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+                {
+                    type = fs::file_type::directory;
+                }
+                visit(DirectoryEntry{dir / name, type});
+            } while (FindNextFileW(find, &data));
+
+            const auto err = GetLastError();
+            if (err != ERROR_NO_MORE_FILES) ec.assign(err, std::system_category());
+            FindClose(find);
+#else
+            // readdir hands out the d_type that getdents64 reports, so only file systems that do not fill it in need
+            // a stat per entry
+            DIR* const handle = opendir(dir.c_str());
+            if (!handle)
+            {
+                ec.assign(errno, std::system_category());
+                return;
+            }
+
+            errno = 0;
+            while (const dirent* entry = readdir(handle))
+            {
+                const char* name = entry->d_name;
+                if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) continue;
+
+                auto type = fs::file_type::unknown;
+#if defined(DT_UNKNOWN)
+                switch (entry->d_type)
+                {
+                    case DT_REG: type = fs::file_type::regular; break;
+                    case DT_DIR: type = fs::file_type::directory; break;
+                    case DT_LNK: type = fs::file_type::symlink; break;
+                    case DT_BLK: type = fs::file_type::block; break;
+                    case DT_CHR: type = fs::file_type::character; break;
+                    case DT_FIFO: type = fs::file_type::fifo; break;
+                    case DT_SOCK: type = fs::file_type::socket; break;
+                    default: break;
+                }
+#endif
+                if (type == fs::file_type::unknown)
+                {
+                    struct stat s;
+                    if (fstatat(dirfd(handle), name, &s, AT_SYMLINK_NOFOLLOW) == 0)
+                    {
+                        if (S_ISREG(s.st_mode))
+                            type = fs::file_type::regular;
+                        else if (S_ISDIR(s.st_mode))
+                            type = fs::file_type::directory;
+                        else if (S_ISLNK(s.st_mode))
+                            type = fs::file_type::symlink;
+                    }
+                }
+
+                visit(DirectoryEntry{dir / name, type});
+                errno = 0;
+            }
+
+            if (errno) ec.assign(errno, std::system_category());
+            closedir(handle);
+#endif
+        }
+
+        struct WalkDirectoryAction
+        {
+            const Filesystem* filesystem;
+            const std::function<void(const DirectoryEntry&)>* visit;
+            fs::path dir;
+
+            template<class ThreadLocalData, class Queue>
+            void operator()(ThreadLocalData&, const Queue& queue) &&
+            {
+                std::error_code ec;
+                filesystem->read_directory(
+                    dir,
+                    [&](DirectoryEntry&& entry) {
+                        (*visit)(entry);
+                        if (entry.type == fs::file_type::directory)
+                            queue.enqueue_action(WalkDirectoryAction{filesystem, visit, std::move(entry.path)});
+                    },
+                    ec);
+            }
+        };
+    }
+
+    void Filesystem::walk_directory(const fs::path& dir, const std::function<void(const DirectoryEntry&)>& visit) const
+    {
+        std::vector<fs::path> pending{dir};
+        std::vector<fs::path> subdirectories;
+        while (!pending.empty())
+        {
+            const fs::path current = std::move(pending.back());
+            pending.pop_back();
+
+            std::error_code ec;
+            this->read_directory(
+                current,
+                [&](DirectoryEntry&& entry) {
+                    visit(entry);
+                    if (entry.type == fs::file_type::directory) subdirectories.push_back(std::move(entry.path));
+                },
+                ec);
+
+            // Reversed, so that subdirectories are walked in the order they were listed
+            pending.insert(pending.end(),
+                           std::make_move_iterator(subdirectories.rbegin()),
+                           std::make_move_iterator(subdirectories.rend()));
+            subdirectories.clear();
+        }
+    }
+
+    void Filesystem::walk_directory_parallel(const fs::path& dir,
+                                             const std::function<void(const DirectoryEntry&)>& visit) const
+    {
+        WorkQueue<WalkDirectoryAction> queue(VCPKG_LINE_INFO);
+        queue.enqueue_action(WalkDirectoryAction{this, &visit, dir});
+        queue.run_and_join(static_cast<unsigned>(std::max(System::get_num_logical_cores(), 1)), [] { return 0; });
     }
 
     std::string Filesystem::read_contents(const fs::path& path, LineInfo linfo) const
@@ -336,33 +486,25 @@ namespace vcpkg::Files
         virtual std::vector<fs::path> get_files_recursive(const fs::path& dir) const override
         {
             std::vector<fs::path> ret;
-
-            std::error_code ec;
-            fs::stdfs::recursive_directory_iterator b(dir, ec), e{};
-            if (ec) return ret;
-            for (; b != e; ++b)
-            {
-                ret.push_back(b->path());
-            }
-
+            this->walk_directory(dir, [&](const DirectoryEntry& entry) { ret.push_back(entry.path); });
             return ret;
         }
 
         virtual std::vector<fs::path> get_files_non_recursive(const fs::path& dir) const override
         {
             std::vector<fs::path> ret;
-
             std::error_code ec;
-            fs::stdfs::directory_iterator b(dir, ec), e{};
-            if (ec) return ret;
-            for (; b != e; ++b)
-            {
-                ret.push_back(b->path());
-            }
-
+            read_directory_entries(dir, [&](DirectoryEntry&& entry) { ret.push_back(std::move(entry.path)); }, ec);
             return ret;
         }
 
+        virtual void read_directory(const fs::path& dir,
+                                    const std::function<void(DirectoryEntry&&)>& visit,
+                                    std::error_code& ec) const override
+        {
+            read_directory_entries(dir, visit, ec);
+        }
+
         virtual void write_lines(const fs::path& file_path,
                                  const std::vector<std::string>& lines,
                                  std::error_code& ec) override
@@ -505,9 +647,16 @@ namespace vcpkg::Files
 
                     if (path_type == fs::file_type::directory)
                     {
-                        for (const auto& entry : fs::stdfs::directory_iterator(current_path))
+                        std::vector<DirectoryEntry> entries;
+                        read_directory_entries(
+                            current_path,
+                            [&](DirectoryEntry&& entry) { entries.push_back(std::move(entry)); },
+                            ec);
+                        if (check_ec(ec, current_path, err)) return;
+
+                        for (const auto& entry : entries)
                         {
-                            do_remove(entry, err);
+                            remove_entry(entry, err);
                             if (err.ec) return;
                         }
 #if defined(_WIN32)
@@ -550,6 +699,22 @@ namespace vcpkg::Files
                     check_ec(ec, current_path, err);
                 }
 
+                static void remove_entry(const DirectoryEntry& entry, ErrorInfo& err)
+                {
+#if !defined(_WIN32)
+                    // Unlinking depends only on the directory being writable, so the listing says all that is needed
+                    if (entry.type != fs::file_type::directory && entry.type != fs::file_type::unknown)
+                    {
+                        if (unlink(entry.path.c_str()))
+                        {
+                            check_ec(std::error_code(errno, std::system_category()), entry.path, err);
+                        }
+                        return;
+                    }
+#endif
+                    do_remove(entry.path, err);
+                }
+
                 static bool check_ec(const std::error_code& ec, const fs::path& current_path, ErrorInfo& err)
                 {
                     if (ec)
@@ -595,6 +760,14 @@ namespace vcpkg::Files
         virtual bool is_directory(const fs::path& path) const override { return fs::stdfs::is_directory(path); }
         virtual bool is_regular_file(const fs::path& path) const override { return fs::stdfs::is_regular_file(path); }
         virtual bool is_empty(const fs::path& path) const override { return fs::stdfs::is_empty(path); }
+        virtual std::uintmax_t file_size(const fs::path& path, std::error_code& ec) const override
+        {
+            return fs::stdfs::file_size(path, ec);
+        }
+        virtual std::uintmax_t hard_link_count(const fs::path& path, std::error_code& ec) const override
+        {
+            return fs::stdfs::hard_link_count(path, ec);
+        }
         virtual bool create_directory(const fs::path& path, std::error_code& ec) override
         {
             return fs::stdfs::create_directory(path, ec);
@@ -618,6 +791,10 @@ namespace vcpkg::Files
         {
             return fs::stdfs::copy_symlink(oldpath, newpath, ec);
         }
+        virtual void create_hard_link(const fs::path& target, const fs::path& link, std::error_code& ec) override
+        {
+            fs::stdfs::create_hard_link(target, link, ec);
+        }
 
         virtual fs::file_status status(const fs::path& path, std::error_code& ec) const override
         {
@@ -708,6 +885,132 @@ namespace vcpkg::Files
         return std::regex_search(s, FILESYSTEM_INVALID_CHARACTERS_REGEX);
     }
 
+    MappedFile::MappedFile(const fs::path& path, std::error_code& ec)
+    {
+        ec.clear();
+#if defined(_WIN32)
+        const HANDLE file = CreateFileW(
+            path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            ec.assign(GetLastError(), std::system_category());
+            return;
+        }
+
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file, &size))
+        {
+            ec.assign(GetLastError(), std::system_category());
+        }
+        else if (size.QuadPart != 0)
+        {
+            m_mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (m_mapping) m_data = static_cast<const char*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+            if (m_data)
+                m_size = static_cast<size_t>(size.QuadPart);
+            else
+                ec.assign(GetLastError(), std::system_category());
+        }
+        CloseHandle(file);
+#else
+        const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd == -1)
+        {
+            ec.assign(errno, std::generic_category());
+            return;
+        }
+
+        struct stat st;
+        if (::fstat(fd, &st) != 0)
+        {
+            ec.assign(errno, std::generic_category());
+        }
+        else if (st.st_size != 0)
+        {
+            void* mapped = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapped == MAP_FAILED)
+            {
+                ec.assign(errno, std::generic_category());
+            }
+            else
+            {
+                m_data = static_cast<const char*>(mapped);
+                m_size = static_cast<size_t>(st.st_size);
+            }
+        }
+        ::close(fd);
+#endif
+    }
+
+    MappedFile::~MappedFile()
+    {
+#if defined(_WIN32)
+        if (m_data) UnmapViewOfFile(m_data);
+        if (m_mapping) CloseHandle(m_mapping);
+#else
+        if (m_data) ::munmap(const_cast<char*>(m_data), m_size);
+#endif
+    }
+
+    ExclusiveFileLock::ExclusiveFileLock(const fs::path& path, std::error_code& ec)
+    {
+        ec.clear();
+#if defined(_WIN32)
+        // Byte-range locks belong to the handle, so another handle to the file in this process waits as well
+        const HANDLE file = CreateFileW(path.c_str(),
+                                        GENERIC_READ | GENERIC_WRITE,
+                                        FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                        nullptr,
+                                        OPEN_ALWAYS,
+                                        FILE_ATTRIBUTE_NORMAL,
+                                        nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            ec.assign(GetLastError(), std::system_category());
+            return;
+        }
+
+        OVERLAPPED overlapped{};
+        if (!LockFileEx(file, LOCKFILE_EXCLUSIVE_LOCK, 0, MAXDWORD, MAXDWORD, &overlapped))
+        {
+            ec.assign(GetLastError(), std::system_category());
+            CloseHandle(file);
+            return;
+        }
+        m_handle = file;
+#else
+        // flock() locks belong to the open file description, so another open() in this process waits as well
+        const int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0666);
+        if (fd == -1)
+        {
+            ec.assign(errno, std::generic_category());
+            return;
+        }
+
+        int result;
+        do
+        {
+            result = ::flock(fd, LOCK_EX);
+        } while (result != 0 && errno == EINTR);
+        if (result != 0)
+        {
+            ec.assign(errno, std::generic_category());
+            ::close(fd);
+            return;
+        }
+        m_fd = fd;
+#endif
+    }
+
+    ExclusiveFileLock::~ExclusiveFileLock()
+    {
+#if defined(_WIN32)
+        if (m_handle) CloseHandle(m_handle);
+#else
+        if (m_fd != -1) ::close(m_fd);
+#endif
+    }
+
     void print_paths(const std::vector<fs::path>& paths)
     {
         std::string message = "\n";
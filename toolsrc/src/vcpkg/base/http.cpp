@@ -0,0 +1,480 @@
+#include "pch.h"
+
+#include <vcpkg/base/http.h>
+#include <vcpkg/base/strings.h>
+#include <vcpkg/base/system.debug.h>
+
+#if !defined(_WIN32)
+#include <netdb.h>
+#include <sys/socket.h>
+#endif
+
+namespace vcpkg::Http
+{
+    static bool is_blank(char c) { return c == ' ' || c == '\t'; }
+
+    static StringView trim_blanks(StringView sv)
+    {
+        auto first = sv.begin();
+        auto last = sv.end();
+        while (first != last && is_blank(*first))
+            ++first;
+        while (last != first && is_blank(*(last - 1)))
+            --last;
+        return StringView(first, last);
+    }
+
+    static Optional<std::uint64_t> parse_uint64(StringView sv)
+    {
+        if (sv.size() == 0 || sv.size() > 19) return nullopt;
+
+        std::uint64_t result = 0;
+        for (char c : sv)
+        {
+            if (c < '0' || c > '9') return nullopt;
+            result = result * 10 + static_cast<std::uint64_t>(c - '0');
+        }
+        return result;
+    }
+
+    Optional<const std::string&> Response::get_header(StringView lowercase_name) const
+    {
+        for (auto&& header : headers)
+        {
+            if (header.first == lowercase_name) return header.second;
+        }
+        return nullopt;
+    }
+
+    Optional<Response> parse_response_head(StringView head)
+    {
+        Optional<Response> result;
+
+        auto first = head.begin();
+        const auto last = head.end();
+        while (first != last)
+        {
+            const auto newline = std::find(first, last, '\n');
+            auto line_end = newline;
+            if (line_end != first && *(line_end - 1) == '\r') --line_end;
+            const StringView line(first, line_end);
+            first = newline == last ? last : newline + 1;
+
+            if (Strings::starts_with(line, "HTTP/"))
+            {
+                // HTTP/1.1 206 Partial Content
+                const auto code_begin = std::find(line.begin(), line.end(), ' ');
+                const auto code_end = std::find(code_begin + (code_begin != line.end()), line.end(), ' ');
+                const auto code = parse_uint64(StringView(code_begin + (code_begin != line.end()), code_end));
+                if (!code || *code.get() > 999)
+                {
+                    result = nullopt;
+                    continue;
+                }
+
+                Response response;
+                response.status_code = static_cast<int>(*code.get());
+                result = std::move(response);
+                continue;
+            }
+
+            auto response = result.get();
+            if (!response) continue;
+
+            const auto colon = std::find(line.begin(), line.end(), ':');
+            if (colon == line.end()) continue;
+
+            response->headers.emplace_back(
+                Strings::ascii_to_lowercase(trim_blanks(StringView(line.begin(), colon)).to_string()),
+                trim_blanks(StringView(colon + 1, line.end())).to_string());
+        }
+
+        return result;
+    }
+
+    Optional<ContentRange> parse_content_range(StringView value)
+    {
+        const auto trimmed = trim_blanks(value);
+        if (!Strings::starts_with(trimmed, "bytes ")) return nullopt;
+
+        const auto range_begin = trimmed.begin() + 6;
+        const auto dash = std::find(range_begin, trimmed.end(), '-');
+        const auto slash = std::find(range_begin, trimmed.end(), '/');
+        if (dash == trimmed.end() || slash == trimmed.end() || dash > slash) return nullopt;
+
+        const auto first = parse_uint64(StringView(range_begin, dash));
+        const auto last = parse_uint64(StringView(dash + 1, slash));
+        if (!first || !last || *last.get() < *first.get()) return nullopt;
+
+        ContentRange result;
+        result.first = *first.get();
+        result.last = *last.get();
+
+        const StringView complete_length(slash + 1, trimmed.end());
+        if (complete_length != "*")
+        {
+            result.complete_length = parse_uint64(complete_length);
+            if (!result.complete_length) return nullopt;
+        }
+
+        return result;
+    }
+
+#if !defined(_WIN32)
+    namespace
+    {
+        struct HttpUrl
+        {
+            std::string host;
+            std::string port;
+            std::string authority;
+            std::string target;
+        };
+
+        Optional<HttpUrl> parse_http_url(StringView url)
+        {
+            if (!Strings::case_insensitive_ascii_starts_with(url, "http://")) return nullopt;
+
+            auto first = url.begin() + 7;
+            const auto last = url.end();
+            const auto authority_end =
+                std::find_if(first, last, [](char c) { return c == '/' || c == '?' || c == '#'; });
+
+            const auto user_info_end = std::find(std::make_reverse_iterator(authority_end),
+                                                 std::make_reverse_iterator(first),
+                                                 '@');
+            if (user_info_end.base() != first) first = user_info_end.base();
+
+            HttpUrl result;
+            result.authority.assign(first, authority_end);
+
+            auto host_end = first;
+            if (first != authority_end && *first == '[')
+            {
+                host_end = std::find(first, authority_end, ']');
+                if (host_end == authority_end) return nullopt;
+                result.host.assign(first + 1, host_end);
+                ++host_end;
+            }
+            else
+            {
+                host_end = std::find(first, authority_end, ':');
+                result.host.assign(first, host_end);
+            }
+
+            if (result.host.empty()) return nullopt;
+
+            if (host_end != authority_end && *host_end == ':') result.port.assign(host_end + 1, authority_end);
+            if (result.port.empty()) result.port = "80";
+
+            result.target.assign(authority_end, std::find(authority_end, last, '#'));
+            if (result.target.empty() || result.target.front() != '/') result.target.insert(0, "/");
+
+            return result;
+        }
+
+        struct Connection
+        {
+            explicit Connection(int fd) : fd(fd) {}
+            Connection(const Connection&) = delete;
+            Connection& operator=(const Connection&) = delete;
+            ~Connection() { ::close(fd); }
+
+            bool send_all(StringView data)
+            {
+#if defined(MSG_NOSIGNAL)
+                static constexpr int SEND_FLAGS = MSG_NOSIGNAL;
+#else
+                static constexpr int SEND_FLAGS = 0;
+#endif
+                auto first = data.begin();
+                while (first != data.end())
+                {
+                    const auto sent = ::send(fd, first, static_cast<size_t>(data.end() - first), SEND_FLAGS);
+                    if (sent < 0)
+                    {
+                        if (errno == EINTR) continue;
+                        error = "send() failed: " + std::generic_category().message(errno);
+                        return false;
+                    }
+                    first += sent;
+                }
+                return true;
+            }
+
+            // Append the next data from the server to `buffer`. Returns false at the end of the stream or on failure,
+            // in which case `error` is set.
+            bool receive()
+            {
+                char chunk[64 * 1024];
+                for (;;)
+                {
+                    const auto received = ::recv(fd, chunk, sizeof(chunk), 0);
+                    if (received > 0)
+                    {
+                        buffer.append(chunk, static_cast<size_t>(received));
+                        return true;
+                    }
+                    if (received == 0) return false;
+                    if (errno == EINTR) continue;
+                    error = "recv() failed: " + std::generic_category().message(errno);
+                    return false;
+                }
+            }
+
+            bool read_line(std::string& line)
+            {
+                for (;;)
+                {
+                    const auto line_end = buffer.find("\r\n");
+                    if (line_end != std::string::npos)
+                    {
+                        line.assign(buffer, 0, line_end);
+                        buffer.erase(0, line_end + 2);
+                        return true;
+                    }
+                    if (!receive()) return false;
+                }
+            }
+
+            std::string closed_message(StringView what) const
+            {
+                if (error.empty()) return Strings::concat("The connection was closed ", what);
+                return Strings::concat(error, ' ', what);
+            }
+
+            int fd;
+            std::string buffer;
+            std::string error;
+        };
+
+        ExpectedT<int, std::string> connect_to(const HttpUrl& url)
+        {
+            addrinfo hints{};
+            hints.ai_family = AF_UNSPEC;
+            hints.ai_socktype = SOCK_STREAM;
+
+            addrinfo* addresses = nullptr;
+            const int rc = ::getaddrinfo(url.host.c_str(), url.port.c_str(), &hints, &addresses);
+            if (rc != 0) return Strings::format("Could not resolve %s: %s", url.host, ::gai_strerror(rc));
+
+            int fd = -1;
+            int connect_errno = 0;
+            for (auto address = addresses; address; address = address->ai_next)
+            {
+                fd = ::socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+                if (fd < 0) continue;
+                if (::connect(fd, address->ai_addr, address->ai_addrlen) == 0) break;
+                connect_errno = errno;
+                ::close(fd);
+                fd = -1;
+            }
+            ::freeaddrinfo(addresses);
+
+            if (fd < 0)
+            {
+                return Strings::format(
+                    "Could not connect to %s: %s", url.authority, std::generic_category().message(connect_errno));
+            }
+
+            // Give up on servers that stop sending instead of waiting forever
+            timeval timeout{};
+            timeout.tv_sec = 60;
+            ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+            ::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+#if defined(SO_NOSIGPIPE)
+            int no_sigpipe = 1;
+            ::setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &no_sigpipe, sizeof(no_sigpipe));
+#endif
+            return fd;
+        }
+
+        Optional<std::string> read_chunked_body(Connection& connection,
+                                                const std::function<void(StringView)>& data_cb)
+        {
+            std::string line;
+            for (;;)
+            {
+                if (!connection.read_line(line)) return connection.closed_message("within a chunked body");
+
+                char* size_end = nullptr;
+                const auto chunk_size = std::strtoull(line.c_str(), &size_end, 16);
+                if (size_end == line.c_str()) return Strings::format("Invalid chunk size: %s", line);
+
+                // The last chunk; trailers are ignored
+                if (chunk_size == 0) return nullopt;
+
+                auto remaining = static_cast<std::uint64_t>(chunk_size);
+                while (remaining > 0)
+                {
+                    if (connection.buffer.empty() && !connection.receive())
+                    {
+                        return connection.closed_message("within a chunk");
+                    }
+
+                    const auto taken =
+                        static_cast<size_t>(std::min<std::uint64_t>(remaining, connection.buffer.size()));
+                    data_cb(StringView(connection.buffer.data(), taken));
+                    connection.buffer.erase(0, taken);
+                    remaining -= taken;
+                }
+
+                if (!connection.read_line(line) || !line.empty()) return std::string("Invalid end of chunk");
+            }
+        }
+
+        Optional<std::string> read_body(Connection& connection,
+                                        const Response& response,
+                                        const std::function<void(StringView)>& data_cb)
+        {
+            if (auto transfer_encoding = response.get_header("transfer-encoding"))
+            {
+                if (Strings::case_insensitive_ascii_contains(*transfer_encoding.get(), "chunked"))
+                {
+                    return read_chunked_body(connection, data_cb);
+                }
+            }
+
+            if (auto content_length_header = response.get_header("content-length"))
+            {
+                const auto content_length = parse_uint64(*content_length_header.get());
+                if (!content_length) return Strings::format("Invalid Content-Length: %s", *content_length_header.get());
+
+                auto remaining = *content_length.get();
+                for (;;)
+                {
+                    if (!connection.buffer.empty())
+                    {
+                        const auto taken =
+                            static_cast<size_t>(std::min<std::uint64_t>(remaining, connection.buffer.size()));
+                        data_cb(StringView(connection.buffer.data(), taken));
+                        connection.buffer.clear();
+                        remaining -= taken;
+                    }
+
+                    if (remaining == 0) return nullopt;
+                    if (!connection.receive())
+                    {
+                        return connection.closed_message(Strings::format(
+                            "after %llu of %llu bytes",
+                            static_cast<unsigned long long>(*content_length.get() - remaining),
+                            static_cast<unsigned long long>(*content_length.get())));
+                    }
+                }
+            }
+
+            // Without a length, the body ends when the server closes the connection
+            for (;;)
+            {
+                if (!connection.buffer.empty())
+                {
+                    data_cb(connection.buffer);
+                    connection.buffer.clear();
+                }
+
+                if (!connection.receive())
+                {
+                    if (connection.error.empty()) return nullopt;
+                    return connection.error;
+                }
+            }
+        }
+
+        bool is_redirect(int status_code)
+        {
+            return status_code == 301 || status_code == 302 || status_code == 303 || status_code == 307 ||
+                   status_code == 308;
+        }
+
+        std::string resolve_location(const HttpUrl& base, const std::string& location)
+        {
+            if (Strings::starts_with(location, "//")) return "http:" + location;
+            if (Strings::starts_with(location, "/")) return Strings::concat("http://", base.authority, location);
+            return location;
+        }
+    }
+
+    ExpectedT<Response, std::string> get(const std::string& url,
+                                         const std::vector<std::string>& request_headers,
+                                         const std::function<bool(const Response&)>& on_response,
+                                         const std::function<void(StringView)>& data_cb)
+    {
+        static constexpr int MAX_REDIRECTS = 10;
+        static constexpr size_t MAX_HEAD_SIZE = 64 * 1024;
+
+        std::string current_url = url;
+        for (int redirects = 0;; ++redirects)
+        {
+            const auto maybe_parsed_url = parse_http_url(current_url);
+            const auto parsed_url = maybe_parsed_url.get();
+            if (!parsed_url) return Strings::format("%s is not an http:// URL", current_url);
+
+            auto maybe_fd = connect_to(*parsed_url);
+            const auto fd = maybe_fd.get();
+            if (!fd) return std::move(maybe_fd).error();
+
+            Connection connection(*fd);
+            Debug::print("GET ", current_url, '\n');
+
+            auto request = Strings::concat("GET ",
+                                           parsed_url->target,
+                                           " HTTP/1.1\r\nHost: ",
+                                           parsed_url->authority,
+                                           "\r\nUser-Agent: vcpkg/1.0\r\nAccept-Encoding: identity\r\n"
+                                           "Connection: close\r\n");
+            for (auto&& header : request_headers)
+            {
+                Strings::append(request, header, "\r\n");
+            }
+            request += "\r\n";
+
+            if (!connection.send_all(request)) return connection.error;
+
+            size_t head_end;
+            while ((head_end = connection.buffer.find("\r\n\r\n")) == std::string::npos)
+            {
+                if (connection.buffer.size() > MAX_HEAD_SIZE)
+                {
+                    return Strings::format("The response from %s has too many headers", parsed_url->authority);
+                }
+                if (!connection.receive()) return connection.closed_message("before a response was received");
+            }
+
+            auto maybe_response = parse_response_head(StringView(connection.buffer.data(), head_end + 2));
+            const auto response = maybe_response.get();
+            if (!response) return Strings::format("Invalid response from %s", parsed_url->authority);
+            connection.buffer.erase(0, head_end + 4);
+
+            if (is_redirect(response->status_code))
+            {
+                if (auto location = response->get_header("location"))
+                {
+                    if (redirects == MAX_REDIRECTS) return Strings::format("Too many redirects from %s", url);
+
+                    auto next_url = resolve_location(*parsed_url, *location.get());
+                    if (parse_http_url(next_url))
+                    {
+                        current_url = std::move(next_url);
+                        continue;
+                    }
+
+                    // Leave redirects to other schemes to the caller
+                    for (auto&& header : response->headers)
+                    {
+                        if (header.first == "location") header.second = next_url;
+                    }
+                    return std::move(*response);
+                }
+            }
+
+            if (on_response(*response))
+            {
+                auto maybe_error = read_body(connection, *response, data_cb);
+                if (auto error = maybe_error.get()) return std::move(*error);
+            }
+
+            return std::move(*response);
+        }
+    }
+#endif
+}
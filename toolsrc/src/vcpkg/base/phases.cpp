@@ -0,0 +1,97 @@
+#include "pch.h"
+
+#include <vcpkg/base/checks.h>
+#include <vcpkg/base/phases.h>
+#include <vcpkg/base/system.print.h>
+
+namespace vcpkg::Phases
+{
+    static constexpr size_t PHASE_COUNT = static_cast<size_t>(Phase::COUNT);
+    static constexpr size_t COUNTER_COUNT = static_cast<size_t>(Counter::COUNT);
+
+    static std::atomic<std::int64_t> g_elapsed_ns[PHASE_COUNT];
+    static std::atomic<std::uint64_t> g_counts[PHASE_COUNT];
+    static std::atomic<std::uint64_t> g_counters[COUNTER_COUNT];
+    static thread_local Scope* t_innermost = nullptr;
+
+    std::atomic<bool> g_print_summary(false);
+
+    StringLiteral to_string(Phase phase)
+    {
+        switch (phase)
+        {
+            case Phase::CHILD_PROCESSES: return "child processes";
+            case Phase::ABI_HASHING: return "ABI hashing";
+            case Phase::STATUS_WRITES: return "status writes";
+            case Phase::FILE_INSTALLS: return "file installs";
+            default: Checks::unreachable(VCPKG_LINE_INFO);
+        }
+    }
+
+    StringLiteral to_string(Counter counter)
+    {
+        switch (counter)
+        {
+            case Counter::FILE_STATUS_CACHE_HITS: return "file status cache hits";
+            case Counter::FILE_STATUS_CACHE_MISSES: return "file status cache misses";
+            default: Checks::unreachable(VCPKG_LINE_INFO);
+        }
+    }
+
+    void increment(Counter counter) { ++g_counters[static_cast<size_t>(counter)]; }
+
+    std::uint64_t get_count(Counter counter) { return g_counters[static_cast<size_t>(counter)].load(); }
+
+    Totals get_totals(Phase phase)
+    {
+        const auto index = static_cast<size_t>(phase);
+        return {std::chrono::nanoseconds(g_elapsed_ns[index].load()), g_counts[index].load()};
+    }
+
+    Scope::Scope(Phase phase) : m_phase(phase), m_outer(t_innermost), m_resumed(clock::now()), m_elapsed()
+    {
+        if (m_outer) m_outer->m_elapsed += m_resumed - m_outer->m_resumed;
+        t_innermost = this;
+    }
+
+    Scope::~Scope()
+    {
+        const auto now = clock::now();
+        m_elapsed += now - m_resumed;
+
+        const auto index = static_cast<size_t>(m_phase);
+        g_elapsed_ns[index] += std::chrono::duration_cast<std::chrono::nanoseconds>(m_elapsed).count();
+        ++g_counts[index];
+
+        t_innermost = m_outer;
+        if (m_outer) m_outer->m_resumed = now;
+    }
+
+    void print_summary(std::chrono::nanoseconds wall_time)
+    {
+        using milliseconds = std::chrono::duration<double, std::milli>;
+
+        System::print2("Time spent in each phase:\n");
+        auto accounted = std::chrono::nanoseconds::zero();
+        for (size_t i = 0; i < PHASE_COUNT; ++i)
+        {
+            const auto phase = static_cast<Phase>(i);
+            const auto totals = get_totals(phase);
+            accounted += totals.elapsed;
+            System::printf("    %s: %.1f ms in %llu calls\n",
+                           to_string(phase).c_str(),
+                           milliseconds(totals.elapsed).count(),
+                           static_cast<unsigned long long>(totals.count));
+        }
+        System::printf("    other: %.1f ms\n", milliseconds(wall_time - accounted).count());
+        System::printf("    total: %.1f ms\n", milliseconds(wall_time).count());
+
+        for (size_t i = 0; i < COUNTER_COUNT; ++i)
+        {
+            const auto counter = static_cast<Counter>(i);
+            const auto count = get_count(counter);
+            if (count == 0) continue;
+            System::printf("    %s: %llu\n", to_string(counter).c_str(), static_cast<unsigned long long>(count));
+        }
+    }
+}
@@ -2,11 +2,14 @@
 
 #include <vcpkg/base/checks.h>
 #include <vcpkg/base/chrono.h>
+#include <vcpkg/base/phases.h>
 #include <vcpkg/base/system.debug.h>
 #include <vcpkg/base/system.h>
 #include <vcpkg/base/system.process.h>
 #include <vcpkg/base/util.h>
 
+#include <climits>
+#include <condition_variable>
 #include <ctime>
 
 #if defined(__APPLE__)
@@ -17,6 +20,20 @@
 #include <sys/sysctl.h>
 #endif
 
+#if defined(__linux__)
+#include <unistd.h>
+#endif
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+extern char** environ;
+#endif
+
 #if defined(_WIN32)
 #pragma comment(lib, "Advapi32")
 #endif
@@ -30,23 +47,26 @@ namespace vcpkg
     {
         struct CtrlCStateMachine
         {
-            CtrlCStateMachine() : m_state(CtrlCState::normal) {}
+            CtrlCStateMachine() : m_number_of_external_processes(0) {}
 
+            // Several child processes may be outstanding at once (for example, while restoring binary caches in
+            // parallel), so the state is a count of children; a negative value means Ctrl-C was hit.
             void transition_to_spawn_process() noexcept
             {
-                auto expected = CtrlCState::normal;
-                auto transitioned = m_state.compare_exchange_strong(expected, CtrlCState::blocked_on_child);
-                if (!transitioned)
+                int cur = 0;
+                while (!m_number_of_external_processes.compare_exchange_strong(cur, cur + 1))
                 {
-                    // Ctrl-C was hit and is asynchronously executing on another thread
-                    Checks::exit_fail(VCPKG_LINE_INFO);
+                    if (cur < 0)
+                    {
+                        // Ctrl-C was hit and is asynchronously executing on another thread
+                        Checks::exit_fail(VCPKG_LINE_INFO);
+                    }
                 }
             }
             void transition_from_spawn_process() noexcept
             {
-                auto expected = CtrlCState::blocked_on_child;
-                auto transitioned = m_state.compare_exchange_strong(expected, CtrlCState::normal);
-                if (!transitioned)
+                auto previous = m_number_of_external_processes.fetch_add(-1);
+                if (previous < 0)
                 {
                     // Ctrl-C was hit while blocked on the child process, so exit immediately
                     Checks::exit_fail(VCPKG_LINE_INFO);
@@ -54,39 +74,49 @@ namespace vcpkg
             }
             void transition_handle_ctrl_c() noexcept
             {
-                auto prev_state = m_state.exchange(CtrlCState::exit_requested);
+                int old_value = 0;
+                while (!m_number_of_external_processes.compare_exchange_strong(old_value, old_value + INT_MIN))
+                {
+                    if (old_value < 0)
+                    {
+                        // Ctrl-C was hit previously?
+                        return;
+                    }
+                }
 
-                if (prev_state == CtrlCState::normal)
+                if (old_value == 0)
                 {
                     // Not currently blocked on a child process and Ctrl-C has not been hit.
                     Checks::exit_fail(VCPKG_LINE_INFO);
                 }
-                else if (prev_state == CtrlCState::exit_requested)
-                {
-                    // Ctrl-C was hit previously?
-                }
-                else
-                {
-                    // We are currently blocked on a child process. Upon return, transition_from_spawn_process() will be
-                    // called and exit.
-                }
+
+                // We are currently blocked on child processes. Upon return, transition_from_spawn_process() will be
+                // called and exit.
             }
 
         private:
-            enum class CtrlCState
-            {
-                normal,
-                blocked_on_child,
-                exit_requested,
-            };
-
-            std::atomic<CtrlCState> m_state;
+            std::atomic<int> m_number_of_external_processes;
         };
 
         static CtrlCStateMachine g_ctrl_c_state;
     }
 #endif
 
+    static std::atomic<std::uint64_t> g_child_process_generation{0};
+
+    namespace
+    {
+        struct ChildProcessScope
+        {
+            ChildProcessScope() { ++g_child_process_generation; }
+            ~ChildProcessScope() { ++g_child_process_generation; }
+
+            Phases::Scope phase_scope{Phases::Phase::CHILD_PROCESSES};
+        };
+    }
+
+    std::uint64_t System::get_child_process_generation() { return g_child_process_generation; }
+
     fs::path System::get_exe_path_of_current_process()
     {
 #if defined(_WIN32)
@@ -339,6 +369,7 @@ namespace vcpkg
 #if defined(_WIN32)
     void System::cmd_execute_no_wait(StringView cmd_line)
     {
+        ChildProcessScope child_process_scope;
         auto timer = Chrono::ElapsedTimer::create_started();
 
         PROCESS_INFORMATION process_info;
@@ -353,10 +384,176 @@ namespace vcpkg
     }
 #endif
 
+#if !defined(_WIN32)
+    static std::mutex g_interactive_signals_mutex;
+    static int g_interactive_signals_ignorers = 0;
+    static struct sigaction g_old_sigint;
+    static struct sigaction g_old_sigquit;
+
+    namespace
+    {
+        /// <summary>
+        /// Like system(), ignore SIGINT and SIGQUIT while waiting for a child. Ctrl+C at the terminal reaches the
+        /// child too, so the child decides whether the command stops. Counted, since threads may wait at once.
+        /// </summary>
+        struct IgnoreInteractiveSignals
+        {
+            IgnoreInteractiveSignals()
+            {
+                std::lock_guard<std::mutex> lock(g_interactive_signals_mutex);
+                if (g_interactive_signals_ignorers++ != 0) return;
+
+                struct sigaction ignore = {};
+                ignore.sa_handler = SIG_IGN;
+                sigemptyset(&ignore.sa_mask);
+                sigaction(SIGINT, &ignore, &g_old_sigint);
+                sigaction(SIGQUIT, &ignore, &g_old_sigquit);
+            }
+
+            ~IgnoreInteractiveSignals()
+            {
+                std::lock_guard<std::mutex> lock(g_interactive_signals_mutex);
+                if (--g_interactive_signals_ignorers != 0) return;
+
+                sigaction(SIGINT, &g_old_sigint, nullptr);
+                sigaction(SIGQUIT, &g_old_sigquit, nullptr);
+            }
+
+            IgnoreInteractiveSignals(const IgnoreInteractiveSignals&) = delete;
+            IgnoreInteractiveSignals& operator=(const IgnoreInteractiveSignals&) = delete;
+
+            /// <summary>
+            /// Called in the child between fork() and exec(), so it must be async-signal-safe.
+            /// </summary>
+            static void restore_in_child()
+            {
+                sigaction(SIGINT, &g_old_sigint, nullptr);
+                sigaction(SIGQUIT, &g_old_sigquit, nullptr);
+            }
+        };
+    }
+
+#if defined(__linux__)
+    // Resident set of each process in /proc whose parent is `root` or one of its descendants, summed
+    static std::uint64_t sample_process_tree_rss_kb(pid_t root)
+    {
+        std::unordered_map<pid_t, std::vector<pid_t>> children;
+        std::error_code ec;
+        for (fs::stdfs::directory_iterator it(fs::u8path("/proc"), ec), end; !ec && it != end; it.increment(ec))
+        {
+            const auto name = it->path().filename().u8string();
+            if (name.empty() || !std::all_of(name.begin(), name.end(), [](char c) { return c >= '0' && c <= '9'; }))
+                continue;
+
+            // The command name in parentheses may itself hold spaces and parentheses
+            std::ifstream stat_file(it->path() / "stat");
+            std::string stat;
+            if (!std::getline(stat_file, stat)) continue;
+            const auto comm_end = stat.rfind(')');
+            if (comm_end == std::string::npos) continue;
+            char state = 0;
+            int ppid = 0;
+            if (std::sscanf(stat.c_str() + comm_end + 1, " %c %d", &state, &ppid) != 2) continue;
+            children[ppid].push_back(std::atoi(name.c_str()));
+        }
+
+        static const auto page_kb = static_cast<std::uint64_t>(sysconf(_SC_PAGESIZE)) / 1024;
+        std::uint64_t total_kb = 0;
+        std::vector<pid_t> pending{root};
+        while (!pending.empty())
+        {
+            const auto pid = pending.back();
+            pending.pop_back();
+            // statm holds sizes in pages; the second is the resident set
+            std::ifstream statm(Strings::concat("/proc/", pid, "/statm"));
+            std::uint64_t size_pages = 0;
+            std::uint64_t resident_pages = 0;
+            if (statm >> size_pages >> resident_pages) total_kb += resident_pages * page_kb;
+
+            const auto it = children.find(pid);
+            if (it != children.end()) pending.insert(pending.end(), it->second.begin(), it->second.end());
+        }
+        return total_kb;
+    }
+
+    /// <summary>
+    /// Keeps sampling the memory of a process tree on a thread of its own, for as long as it lives.
+    /// </summary>
+    struct ProcessTreeMemorySampler
+    {
+        static constexpr std::chrono::milliseconds INTERVAL{250};
+
+        explicit ProcessTreeMemorySampler(pid_t root) : m_root(root), m_thread([this] { run(); }) { }
+        ProcessTreeMemorySampler(const ProcessTreeMemorySampler&) = delete;
+        ProcessTreeMemorySampler& operator=(const ProcessTreeMemorySampler&) = delete;
+        ~ProcessTreeMemorySampler()
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_stopped = true;
+            }
+            m_cv.notify_all();
+            m_thread.join();
+        }
+
+        std::uint64_t peak_kb() const
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_peak_kb;
+        }
+
+    private:
+        void run()
+        {
+            for (;;)
+            {
+                const auto sample_kb = sample_process_tree_rss_kb(m_root);
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_peak_kb = std::max(m_peak_kb, sample_kb);
+                if (m_cv.wait_for(lock, INTERVAL, [this] { return m_stopped; })) return;
+            }
+        }
+
+        pid_t m_root;
+        mutable std::mutex m_mutex;
+        std::condition_variable m_cv;
+        bool m_stopped = false;
+        std::uint64_t m_peak_kb = 0;
+        std::thread m_thread;
+    };
+#endif
+
+    static ChildResourceUsage to_child_resource_usage(const rusage& usage)
+    {
+        using std::chrono::microseconds;
+        using std::chrono::seconds;
+        const auto cpu_time = seconds(usage.ru_utime.tv_sec) + microseconds(usage.ru_utime.tv_usec) +
+                              seconds(usage.ru_stime.tv_sec) + microseconds(usage.ru_stime.tv_usec);
+#if defined(__APPLE__)
+        // Reported in bytes rather than kilobytes
+        const auto peak_rss_kb = static_cast<std::uint64_t>(usage.ru_maxrss) / 1024;
+#else
+        const auto peak_rss_kb = static_cast<std::uint64_t>(usage.ru_maxrss);
+#endif
+        return ChildResourceUsage{std::chrono::duration_cast<std::chrono::milliseconds>(cpu_time), peak_rss_kb};
+    }
+#endif
+
     int System::cmd_execute_clean(const ZStringView cmd_line,
                                   const std::unordered_map<std::string, std::string>& extra_env,
                                   const std::string& prepend_to_path)
     {
+        Optional<ChildResourceUsage> usage;
+        return cmd_execute_clean(cmd_line, extra_env, prepend_to_path, usage);
+    }
+
+    int System::cmd_execute_clean(const ZStringView cmd_line,
+                                  const std::unordered_map<std::string, std::string>& extra_env,
+                                  const std::string& prepend_to_path,
+                                  Optional<ChildResourceUsage>& usage)
+    {
+        ChildProcessScope child_process_scope;
+        usage = nullopt;
         auto timer = Chrono::ElapsedTimer::create_started();
 #if defined(_WIN32)
 
@@ -383,17 +580,197 @@ namespace vcpkg
         return static_cast<int>(exit_code);
 #else
         // TODO: this should create a clean environment on Linux/macOS
-        Util::unused(extra_env, prepend_to_path);
-        Debug::print("system(", cmd_line, ")\n");
+        Debug::print("sh -c ", cmd_line, "\n");
         fflush(nullptr);
-        int rc = system(cmd_line.c_str());
-        Debug::print("system() returned ", rc, " after ", static_cast<int>(timer.microseconds()), " us\n");
+
+        // Everything the child needs is prepared before fork(), which only allows async-signal-safe calls after it
+        std::vector<std::string> env_strings;
+        auto path = get_environment_variable("PATH").value_or("");
+        if (!prepend_to_path.empty()) path = prepend_to_path + path;
+        for (auto&& item : extra_env)
+        {
+            if (item.first == "PATH")
+                Strings::append(path, ':', item.second);
+            else
+                env_strings.push_back(Strings::concat(item.first, '=', item.second));
+        }
+        env_strings.push_back("PATH=" + path);
+
+        std::vector<char*> env_ptrs;
+        for (char** it = environ; *it; ++it)
+        {
+            const StringView var(*it, strlen(*it));
+            const auto eq = std::find(var.begin(), var.end(), '=');
+            const StringView name(var.begin(), eq);
+            const bool overridden = std::any_of(env_strings.begin(), env_strings.end(), [&](const std::string& s) {
+                return s.size() > name.size() && s[name.size()] == '=' && Strings::starts_with(s, name);
+            });
+            if (!overridden) env_ptrs.push_back(*it);
+        }
+        for (auto&& s : env_strings)
+            env_ptrs.push_back(&s[0]);
+        env_ptrs.push_back(nullptr);
+
+        const char* argv[] = {"sh", "-c", cmd_line.c_str(), nullptr};
+        IgnoreInteractiveSignals ignore_interactive_signals;
+        const pid_t pid = fork();
+        Checks::check_exit(VCPKG_LINE_INFO, pid >= 0, "fork() failed: %s", strerror(errno));
+        if (pid == 0)
+        {
+            // The child gets the dispositions vcpkg had before it started ignoring them
+            IgnoreInteractiveSignals::restore_in_child();
+            execve("/bin/sh", const_cast<char* const*>(argv), env_ptrs.data());
+            _exit(127);
+        }
+
+        // Unlike getrusage(RUSAGE_CHILDREN), wait4() counts only this child, not those of other threads
+        int status = 0;
+        rusage child_usage{};
+        {
+#if defined(__linux__)
+            ProcessTreeMemorySampler sampler(pid);
+#endif
+            while (wait4(pid, &status, 0, &child_usage) < 0)
+            {
+                Checks::check_exit(VCPKG_LINE_INFO, errno == EINTR, "wait4() failed: %s", strerror(errno));
+            }
+            usage = to_child_resource_usage(child_usage);
+#if defined(__linux__)
+            // ru_maxrss still catches a single process that peaked between two samples
+            auto& peak_rss_kb = usage.get()->peak_rss_kb;
+            peak_rss_kb = std::max(peak_rss_kb, sampler.peak_kb());
+#endif
+        }
+        const int rc = WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+        Debug::print("sh returned ", rc, " after ", static_cast<int>(timer.microseconds()), " us\n");
         return rc;
 #endif
     }
 
+    Jobserver::Jobserver(int jobs)
+    {
+        m_environment.emplace("CMAKE_BUILD_PARALLEL_LEVEL", std::to_string(std::max(jobs, 1)));
+        if (join_inherited()) return;
+        create_pipe(jobs);
+    }
+
+    Jobserver::Jobserver(int jobs, const fs::path& fifo)
+    {
+        m_environment.emplace("CMAKE_BUILD_PARALLEL_LEVEL", std::to_string(std::max(jobs, 1)));
+        if (join_inherited()) return;
+
+#if defined(_WIN32)
+        Util::unused(fifo);
+#else
+        if (mkfifo(fifo.c_str(), 0666) != 0 && errno != EEXIST)
+        {
+            Debug::print("mkfifo() failed, builds use a jobserver of their own: ", strerror(errno), "\n");
+            create_pipe(jobs);
+            return;
+        }
+
+        // Held while deciding whether to fill the pipe, so that two processes starting together do not both fill it
+        std::error_code ec;
+        Files::ExclusiveFileLock lock(fs::u8path(fifo.u8string() + ".lock"), ec);
+        if (ec) Debug::print("Could not lock the jobserver, proceeding without: ", ec.message(), "\n");
+
+        // A named pipe keeps its contents only while some process has it open, so without a reader there are no
+        // tokens left to share and this process puts them in again
+        const int probe = open(fifo.c_str(), O_WRONLY | O_NONBLOCK | O_CLOEXEC);
+        const bool has_tokens = probe >= 0;
+        if (probe >= 0) close(probe);
+
+        // Opening for reading without O_NONBLOCK would wait for a writer
+        m_read_fd = open(fifo.c_str(), O_RDONLY | O_NONBLOCK);
+        if (m_read_fd >= 0) fcntl(m_read_fd, F_SETFL, fcntl(m_read_fd, F_GETFL) & ~O_NONBLOCK);
+        if (m_read_fd >= 0) m_write_fd = open(fifo.c_str(), O_WRONLY);
+        if (m_write_fd < 0)
+        {
+            Debug::print(
+                "Opening ", fifo.u8string(), " failed, builds use a jobserver of their own: ", strerror(errno), "\n");
+            if (m_read_fd >= 0) close(m_read_fd);
+            m_read_fd = -1;
+            create_pipe(jobs);
+            return;
+        }
+
+        if (!has_tokens && !fill(jobs)) return;
+        hand_out();
+#endif
+    }
+
+    bool Jobserver::join_inherited()
+    {
+#if defined(_WIN32)
+        return false;
+#else
+        auto maybe_makeflags = get_environment_variable("MAKEFLAGS");
+        if (auto makeflags = maybe_makeflags.get())
+        {
+            if (makeflags->find("--jobserver-auth=") != std::string::npos ||
+                makeflags->find("--jobserver-fds=") != std::string::npos)
+            {
+                m_environment.emplace("MAKEFLAGS", *makeflags);
+                return true;
+            }
+        }
+        return false;
+#endif
+    }
+
+    void Jobserver::create_pipe(int jobs)
+    {
+#if defined(_WIN32)
+        Util::unused(jobs);
+#else
+        int fds[2];
+        if (pipe(fds) != 0)
+        {
+            Debug::print("pipe() failed, builds run without a jobserver: ", strerror(errno), "\n");
+            return;
+        }
+        m_read_fd = fds[0];
+        m_write_fd = fds[1];
+        if (fill(jobs)) hand_out();
+#endif
+    }
+
+    bool Jobserver::fill(int jobs)
+    {
+#if defined(_WIN32)
+        Util::unused(jobs);
+        return false;
+#else
+        // Every client holds one implicit token of its own
+        const std::string tokens(static_cast<size_t>(std::max(jobs, 1) - 1), '+');
+        if (!tokens.empty() && write(m_write_fd, tokens.data(), tokens.size()) != static_cast<ssize_t>(tokens.size()))
+        {
+            Debug::print("Filling the jobserver failed, builds run without it: ", strerror(errno), "\n");
+            return false;
+        }
+        return true;
+#endif
+    }
+
+    void Jobserver::hand_out()
+    {
+        // make 4.2 and later read --jobserver-auth, earlier versions --jobserver-fds
+        const auto fds_text = Strings::format("%d,%d", m_read_fd, m_write_fd);
+        m_environment.emplace("MAKEFLAGS",
+                              Strings::concat(" -j --jobserver-auth=", fds_text, " --jobserver-fds=", fds_text));
+    }
+
+    Jobserver::~Jobserver()
+    {
+#if !defined(_WIN32)
+        if (m_read_fd >= 0) close(m_read_fd);
+        if (m_write_fd >= 0) close(m_write_fd);
+#endif
+    }
+
     int System::cmd_execute(const ZStringView cmd_line)
     {
+        ChildProcessScope child_process_scope;
         // Flush stdout before launching external process
         fflush(nullptr);
 
@@ -424,6 +801,7 @@ namespace vcpkg
 
     ExitCodeAndOutput System::cmd_execute_and_capture_output(const ZStringView cmd_line)
     {
+        ChildProcessScope child_process_scope;
         auto timer = Chrono::ElapsedTimer::create_started();
 
 #if defined(_WIN32)
@@ -498,6 +876,58 @@ namespace vcpkg
 #endif
     }
 
+    int System::cmd_execute_and_stream_data(const ZStringView cmd_line,
+                                            const std::function<void(StringView)>& data_cb)
+    {
+        ChildProcessScope child_process_scope;
+        auto timer = Chrono::ElapsedTimer::create_started();
+
+        std::unique_ptr<char[]> buf(new char[32 * 1024]);
+        const size_t buf_size = 32 * 1024;
+
+#if defined(_WIN32)
+        // We are wrap the command line in quotes to cause cmd.exe to correctly process it
+        const auto actual_cmd_line = Strings::concat('"', cmd_line, '"');
+
+        Debug::print("_wpopen(", actual_cmd_line, ")\n");
+        g_ctrl_c_state.transition_to_spawn_process();
+        // Flush stdout before launching external process
+        fflush(stdout);
+        const auto pipe = _wpopen(Strings::to_utf16(actual_cmd_line).c_str(), L"rb");
+        if (pipe == nullptr)
+        {
+            g_ctrl_c_state.transition_from_spawn_process();
+            return 1;
+        }
+#else
+        Debug::print("popen(", cmd_line, ")\n");
+        // Flush stdout before launching external process
+        fflush(stdout);
+        const auto pipe = popen(cmd_line.c_str(), "r");
+        if (pipe == nullptr)
+        {
+            return 1;
+        }
+#endif
+
+        size_t read_size;
+        while ((read_size = fread(buf.get(), 1, buf_size, pipe)) > 0)
+        {
+            data_cb(StringView{buf.get(), read_size});
+        }
+
+#if defined(_WIN32)
+        const auto ec = _pclose(pipe);
+        g_ctrl_c_state.transition_from_spawn_process();
+#else
+        const auto ec = pclose(pipe);
+#endif
+
+        Debug::print("_pclose() returned ", ec, " after ", Strings::format("%8d", (int)timer.microseconds()), " us\n");
+
+        return ec;
+    }
+
     Optional<std::string> System::get_environment_variable(ZStringView varname) noexcept
     {
 #if defined(_WIN32)
@@ -519,6 +949,22 @@ namespace vcpkg
 #endif
     }
 
+    void System::set_environment_variable(ZStringView varname, Optional<std::string> value) noexcept
+    {
+#if defined(_WIN32)
+        const auto w_varname = Strings::to_utf16(varname);
+        if (auto v = value.get())
+            SetEnvironmentVariableW(w_varname.c_str(), Strings::to_utf16(*v).c_str());
+        else
+            SetEnvironmentVariableW(w_varname.c_str(), nullptr);
+#else
+        if (auto v = value.get())
+            setenv(varname.c_str(), v->c_str(), 1);
+        else
+            unsetenv(varname.c_str());
+#endif
+    }
+
 #if defined(_WIN32)
     static bool is_string_keytype(const DWORD hkey_type)
     {
@@ -615,6 +1061,64 @@ namespace vcpkg
 #endif
 
     int System::get_num_logical_cores() { return std::thread::hardware_concurrency(); }
+
+    std::string System::get_host_name()
+    {
+#if defined(_WIN32)
+        return get_environment_variable("COMPUTERNAME").value_or("localhost");
+#else
+        char name[256] = {};
+        if (gethostname(name, sizeof(name) - 1) != 0 || name[0] == '\0') return "localhost";
+        return name;
+#endif
+    }
+
+    int System::get_process_id()
+    {
+#if defined(_WIN32)
+        return static_cast<int>(GetCurrentProcessId());
+#else
+        return static_cast<int>(getpid());
+#endif
+    }
+
+    bool System::is_process_running(int process_id)
+    {
+#if defined(_WIN32)
+        const HANDLE process = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, static_cast<DWORD>(process_id));
+        if (!process) return GetLastError() == ERROR_ACCESS_DENIED;
+        DWORD exit_code = 0;
+        const bool running = GetExitCodeProcess(process, &exit_code) && exit_code == STILL_ACTIVE;
+        CloseHandle(process);
+        return running;
+#else
+        return kill(static_cast<pid_t>(process_id), 0) == 0 || errno == EPERM;
+#endif
+    }
+
+    Optional<std::uint64_t> System::get_available_memory_kb()
+    {
+#if defined(_WIN32)
+        MEMORYSTATUSEX status{};
+        status.dwLength = sizeof(status);
+        if (!GlobalMemoryStatusEx(&status)) return nullopt;
+        return static_cast<std::uint64_t>(status.ullAvailPhys / 1024);
+#elif defined(__linux__)
+        std::ifstream meminfo("/proc/meminfo");
+        std::string line;
+        while (std::getline(meminfo, line))
+        {
+            if (Strings::starts_with(line, "MemAvailable:"))
+            {
+                const auto value = line.c_str() + sizeof("MemAvailable:") - 1;
+                return static_cast<std::uint64_t>(std::strtoull(value, nullptr, 10));
+            }
+        }
+        return nullopt;
+#else
+        return nullopt;
+#endif
+    }
 }
 
 namespace vcpkg::Debug
@@ -1,15 +1,19 @@
 #include "pch.h"
 
+#include <vcpkg/base/cache.h>
 #include <vcpkg/base/checks.h>
 #include <vcpkg/base/chrono.h>
+#include <vcpkg/base/downloads.h>
 #include <vcpkg/base/enums.h>
 #include <vcpkg/base/hash.h>
 #include <vcpkg/base/optional.h>
+#include <vcpkg/base/phases.h>
 #include <vcpkg/base/stringliteral.h>
 #include <vcpkg/base/system.debug.h>
 #include <vcpkg/base/system.print.h>
 #include <vcpkg/base/system.process.h>
 #include <vcpkg/base/util.h>
+#include <vcpkg/base/work_queue.h>
 
 #include <vcpkg/build.h>
 #include <vcpkg/commands.h>
@@ -162,6 +166,8 @@ namespace vcpkg::Build
     static const std::string NAME_ONLY_RELEASE_CRT = "PolicyOnlyReleaseCRT";
     static const std::string NAME_EMPTY_INCLUDE_FOLDER = "PolicyEmptyIncludeFolder";
     static const std::string NAME_ALLOW_OBSOLETE_MSVCRT = "PolicyAllowObsoleteMsvcrt";
+    static const std::string NAME_ALLOW_ABSOLUTE_RPATH = "PolicyAllowAbsoluteRpath";
+    static const std::string NAME_ALLOW_MISSING_SONAME = "PolicyAllowMissingSoname";
 
     const std::string& to_string(BuildPolicy policy)
     {
@@ -172,6 +178,8 @@ namespace vcpkg::Build
             case BuildPolicy::ONLY_RELEASE_CRT: return NAME_ONLY_RELEASE_CRT;
             case BuildPolicy::EMPTY_INCLUDE_FOLDER: return NAME_EMPTY_INCLUDE_FOLDER;
             case BuildPolicy::ALLOW_OBSOLETE_MSVCRT: return NAME_ALLOW_OBSOLETE_MSVCRT;
+            case BuildPolicy::ALLOW_ABSOLUTE_RPATH: return NAME_ALLOW_ABSOLUTE_RPATH;
+            case BuildPolicy::ALLOW_MISSING_SONAME: return NAME_ALLOW_MISSING_SONAME;
             default: Checks::unreachable(VCPKG_LINE_INFO);
         }
     }
@@ -185,6 +193,8 @@ namespace vcpkg::Build
             case BuildPolicy::ONLY_RELEASE_CRT: return "VCPKG_POLICY_ONLY_RELEASE_CRT";
             case BuildPolicy::EMPTY_INCLUDE_FOLDER: return "VCPKG_POLICY_EMPTY_INCLUDE_FOLDER";
             case BuildPolicy::ALLOW_OBSOLETE_MSVCRT: return "VCPKG_POLICY_ALLOW_OBSOLETE_MSVCRT";
+            case BuildPolicy::ALLOW_ABSOLUTE_RPATH: return "VCPKG_POLICY_ALLOW_ABSOLUTE_RPATH";
+            case BuildPolicy::ALLOW_MISSING_SONAME: return "VCPKG_POLICY_ALLOW_MISSING_SONAME";
             default: Checks::unreachable(VCPKG_LINE_INFO);
         }
     }
@@ -248,9 +258,35 @@ namespace vcpkg::Build
                                   }));
     }
 
+    int get_concurrency()
+    {
+        static int concurrency = [] {
+            auto user_defined_concurrency = System::get_environment_variable("VCPKG_MAX_CONCURRENCY");
+            if (user_defined_concurrency)
+            {
+                return std::stoi(user_defined_concurrency.value_or_exit(VCPKG_LINE_INFO));
+            }
+            else
+            {
+                return System::get_num_logical_cores() + 1;
+            }
+        }();
+
+        return concurrency;
+    }
+
+    /// <summary>
+    /// One budget of get_concurrency() jobs for every build this process starts.
+    /// </summary>
+    static const System::Jobserver& get_jobserver()
+    {
+        static const System::Jobserver jobserver(get_concurrency());
+        return jobserver;
+    }
+
     static auto make_env_passthrough(const PreBuildInfo& pre_build_info) -> std::unordered_map<std::string, std::string>
     {
-        std::unordered_map<std::string, std::string> env;
+        std::unordered_map<std::string, std::string> env = get_jobserver().environment();
 
         for (auto&& env_var : pre_build_info.passthrough_env_vars)
         {
@@ -316,23 +352,6 @@ namespace vcpkg::Build
         paths.get_filesystem().write_contents(binary_control_file, start, VCPKG_LINE_INFO);
     }
 
-    static int get_concurrency()
-    {
-        static int concurrency = [] {
-            auto user_defined_concurrency = System::get_environment_variable("VCPKG_MAX_CONCURRENCY");
-            if (user_defined_concurrency)
-            {
-                return std::stoi(user_defined_concurrency.value_or_exit(VCPKG_LINE_INFO));
-            }
-            else
-            {
-                return System::get_num_logical_cores() + 1;
-            }
-        }();
-
-        return concurrency;
-    }
-
     static std::vector<System::CMakeVariable> get_cmake_vars(const VcpkgPaths& paths,
                                                              const BuildPackageConfig& config,
                                                              const Triplet& triplet,
@@ -352,6 +371,9 @@ namespace vcpkg::Build
             all_features.append(feature->name + ";");
         }
 
+        const PackageSpec spec =
+            PackageSpec::from_name_and_triplet(config.scf.core_paragraph->name, triplet).value_or_exit(VCPKG_LINE_INFO);
+
         std::vector<System::CMakeVariable> variables{
             {"CMD", "BUILD"},
             {"PORT", config.scf.core_paragraph->name},
@@ -362,6 +384,11 @@ namespace vcpkg::Build
             {"VCPKG_PLATFORM_TOOLSET", toolset.version.c_str()},
             {"VCPKG_USE_HEAD_VERSION", Util::Enum::to_bool(config.build_package_options.use_head_version) ? "1" : "0"},
             {"DOWNLOADS", paths.downloads},
+            {"CURRENT_INSTALLED_DIR", paths.installed / triplet.canonical_name()},
+            {"PACKAGES_DIR", paths.packages},
+            {"BUILDTREES_DIR", paths.buildtrees},
+            {"CURRENT_BUILDTREES_DIR", paths.buildtrees_dir(spec)},
+            {"CURRENT_PACKAGES_DIR", paths.package_dir(spec)},
             {"_VCPKG_NO_DOWNLOADS", !Util::Enum::to_bool(config.build_package_options.allow_downloads) ? "1" : "0"},
             {"_VCPKG_DOWNLOAD_TOOL", to_string(config.build_package_options.download_tool)},
             {"FEATURES", Strings::join(";", config.feature_list)},
@@ -427,26 +454,120 @@ namespace vcpkg::Build
         return command;
     }
 
+    struct ExecuteCommandAction
+    {
+        const std::string* command;
+        int* exit_code;
+
+        template<class ThreadLocalData, class Queue>
+        void operator()(ThreadLocalData&, const Queue&) &&
+        {
+            *exit_code = System::cmd_execute_clean(*command);
+        }
+    };
+
+    std::vector<Downloads::DownloadRequest> capture_distfiles(const VcpkgPaths& paths,
+                                                              const std::vector<BuildPackageConfig>& configs)
+    {
+        auto& fs = paths.get_filesystem();
+        const fs::path& cmake_exe_path = paths.get_tool_exe(Tools::CMAKE);
+
+        std::vector<PackageSpec> specs;
+        std::vector<fs::path> manifests;
+        std::vector<fs::path> logs;
+        std::vector<std::string> commands;
+        for (auto&& config : configs)
+        {
+            const auto& name = config.scf.core_paragraph->name;
+            const PackageSpec spec =
+                PackageSpec::from_name_and_triplet(name, config.triplet).value_or_exit(VCPKG_LINE_INFO);
+            const PreBuildInfo pre_build_info(
+                paths, config.triplet, config.var_provider.get_tag_vars(spec).value_or_exit(VCPKG_LINE_INFO));
+
+            std::error_code ec;
+            const fs::path buildtrees_dir = paths.buildtrees_dir(spec);
+            fs.create_directories(buildtrees_dir, ec);
+            const fs::path manifest = buildtrees_dir / (config.triplet.canonical_name() + ".distfiles.txt");
+            const fs::path log = buildtrees_dir / (config.triplet.canonical_name() + ".distfiles.log");
+            fs.remove(manifest, ec);
+
+            auto variables = get_cmake_vars(paths, config, config.triplet, paths.get_toolset(pre_build_info));
+            // get_cmake_vars() passes CMD first
+            variables.front() = {"CMD", "CAPTURE_DISTFILES"};
+            variables.push_back({"_VCPKG_DISTFILES_MANIFEST", manifest});
+
+            specs.push_back(spec);
+            manifests.push_back(manifest);
+            logs.push_back(log);
+            commands.push_back(System::make_cmake_cmd(cmake_exe_path, paths.ports_cmake, variables) +
+                               Strings::format(R"( > "%s" 2>&1)", log.u8string()));
+        }
+
+        std::vector<int> exit_codes(commands.size());
+        WorkQueue<ExecuteCommandAction> queue(VCPKG_LINE_INFO);
+        for (size_t i = 0; i < commands.size(); ++i)
+        {
+            queue.enqueue_action(ExecuteCommandAction{&commands[i], &exit_codes[i]});
+        }
+        const auto num_threads =
+            std::min(static_cast<size_t>(std::max(System::get_num_logical_cores(), 1)), commands.size());
+        queue.run_and_join(static_cast<unsigned>(num_threads), [] { return 0; });
+
+        std::vector<Downloads::DownloadRequest> requests;
+        for (size_t i = 0; i < manifests.size(); ++i)
+        {
+            // A halting portfile writes its manifest before it exits with an error
+            auto maybe_lines = fs.read_lines(manifests[i]);
+            auto lines = maybe_lines.get();
+            if (!lines)
+            {
+                if (exit_codes[i] != 0)
+                {
+                    System::print2(System::Color::warning,
+                                   "Warning: could not gather the sources of ",
+                                   specs[i].to_string(),
+                                   "; its build downloads them instead. See ",
+                                   logs[i].u8string(),
+                                   '\n');
+                }
+                continue;
+            }
+
+            for (auto&& line : *lines)
+            {
+                // <sha512> TAB <filename> TAB <url>;<url>...
+                const auto fields = Strings::split(line, "\t");
+                if (fields.size() != 3) continue;
+
+                requests.push_back({Strings::split(fields[2], ";"), paths.downloads / fs::u8path(fields[1]), fields[0]});
+            }
+        }
+
+        // Ports share distfiles, for example across triplets
+        Util::sort(requests, [](const Downloads::DownloadRequest& l, const Downloads::DownloadRequest& r) {
+            return l.download_path < r.download_path;
+        });
+        requests.erase(std::unique(requests.begin(),
+                                   requests.end(),
+                                   [](const Downloads::DownloadRequest& l, const Downloads::DownloadRequest& r) {
+                                       return l.download_path == r.download_path;
+                                   }),
+                       requests.end());
+        return requests;
+    }
+
     static std::string get_triplet_abi(const VcpkgPaths& paths,
                                        const PreBuildInfo& pre_build_info,
                                        const Triplet& triplet)
     {
-        static std::map<fs::path, std::string> s_hash_cache;
+        static Cache<std::string, std::string> s_hash_cache;
 
         const fs::path triplet_file_path = paths.get_triplet_file_path(triplet);
         const auto& fs = paths.get_filesystem();
 
-        std::string hash;
-
-        auto it_hash = s_hash_cache.find(triplet_file_path);
-        if (it_hash != s_hash_cache.end())
-        {
-            hash = it_hash->second;
-        }
-        else
-        {
+        return s_hash_cache.get_lazy(triplet_file_path.u8string(), [&]() {
             const auto algo = Hash::Algorithm::Sha1;
-            hash = Hash::get_file_hash(VCPKG_LINE_INFO, fs, triplet_file_path, algo);
+            std::string hash = Hash::get_file_hash(VCPKG_LINE_INFO, fs, triplet_file_path, algo);
 
             if (auto p = pre_build_info.external_toolchain_file.get())
             {
@@ -474,17 +595,16 @@ namespace vcpkg::Build
                 hash += Hash::get_file_hash(VCPKG_LINE_INFO, fs, paths.scripts / "toolchains" / "android.cmake", algo);
             }
 
-            s_hash_cache.emplace(triplet_file_path, hash);
-        }
-
-        return hash;
+            return hash;
+        });
     }
 
     static ExtendedBuildResult do_build_package(const VcpkgPaths& paths,
                                                 const PreBuildInfo& pre_build_info,
                                                 const PackageSpec& spec,
                                                 const std::string& abi_tag,
-                                                const BuildPackageConfig& config)
+                                                const BuildPackageConfig& config,
+                                                Optional<System::ChildResourceUsage>& usage)
     {
         auto& fs = paths.get_filesystem();
 
@@ -515,9 +635,9 @@ namespace vcpkg::Build
 
 #if defined(_WIN32)
         const int return_code =
-            System::cmd_execute_clean(command, env, powershell_exe_path.parent_path().u8string() + ";");
+            System::cmd_execute_clean(command, env, powershell_exe_path.parent_path().u8string() + ";", usage);
 #else
-        const int return_code = System::cmd_execute_clean(command, env);
+        const int return_code = System::cmd_execute_clean(command, env, {}, usage);
 #endif
         // With the exception of empty packages, builds in "Download Mode" always result in failure.
         if (config.build_package_options.only_downloads == Build::OnlyDownloads::YES)
@@ -581,12 +701,14 @@ namespace vcpkg::Build
                                                                      const std::string& abi_tag,
                                                                      const BuildPackageConfig& config)
     {
-        auto result = do_build_package(paths, pre_build_info, spec, abi_tag, config);
+        Optional<System::ChildResourceUsage> usage;
+        auto result = do_build_package(paths, pre_build_info, spec, abi_tag, config, usage);
+        result.resource_usage = std::move(usage);
 
         if (config.build_package_options.clean_buildtrees == CleanBuildtrees::YES)
         {
             auto& fs = paths.get_filesystem();
-            const fs::path buildtrees_dir = paths.buildtrees / config.scf.core_paragraph->name;
+            const fs::path buildtrees_dir = paths.buildtrees_dir(spec);
             auto buildtree_files = fs.get_files_non_recursive(buildtrees_dir);
             for (auto&& file : buildtree_files)
             {
@@ -607,6 +729,7 @@ namespace vcpkg::Build
                                             const PreBuildInfo& pre_build_info,
                                             Span<const AbiEntry> dependency_abis)
     {
+        Phases::Scope phase_scope(Phases::Phase::ABI_HASHING);
         auto& fs = paths.get_filesystem();
         const Triplet& triplet = config.triplet;
         const std::string& name = config.scf.core_paragraph->name;
@@ -622,21 +745,27 @@ namespace vcpkg::Build
         // just mark the port as no-hash
         const int max_port_file_count = 100;
 
-        // the order of recursive_directory_iterator is undefined so save the names to sort
+        // the order of the walk is undefined so save the names to sort
+        std::vector<fs::path> port_file_paths;
+        fs.walk_directory(config.port_dir, [&](const Files::DirectoryEntry& entry) {
+            // Links are hashed as what they point to
+            if (entry.type == fs::file_type::regular ||
+                (entry.type == fs::file_type::symlink && fs::is_regular_file(fs.status(VCPKG_LINE_INFO, entry.path))))
+            {
+                port_file_paths.push_back(entry.path);
+            }
+        });
+
         std::vector<AbiEntry> port_files;
-        for (auto& port_file : fs::stdfs::recursive_directory_iterator(config.port_dir))
+        for (auto&& port_file : port_file_paths)
         {
-            if (fs::is_regular_file(fs.status(VCPKG_LINE_INFO, port_file)))
-            {
-                port_files.emplace_back(
-                    port_file.path().filename().u8string(),
-                    vcpkg::Hash::get_file_hash(VCPKG_LINE_INFO, fs, port_file, Hash::Algorithm::Sha1));
+            port_files.emplace_back(port_file.filename().u8string(),
+                                    vcpkg::Hash::get_file_hash(VCPKG_LINE_INFO, fs, port_file, Hash::Algorithm::Sha1));
 
-                if (port_files.size() > max_port_file_count)
-                {
-                    abi_tag_entries.emplace_back("no_hash_max_portfile", "");
-                    break;
-                }
+            if (port_files.size() > max_port_file_count)
+            {
+                abi_tag_entries.emplace_back("no_hash_max_portfile", "");
+                break;
             }
         }
 
@@ -674,7 +803,7 @@ namespace vcpkg::Build
         }
 
         // No need to sort, the variables are stored in the same order they are written down in the abi-settings file
-        for (const auto env_var : pre_build_info.passthrough_env_vars)
+        for (const auto& env_var : pre_build_info.passthrough_env_vars)
         {
             abi_tag_entries.emplace_back(
                 "ENV:" + env_var,
@@ -703,8 +832,10 @@ namespace vcpkg::Build
         if (abi_tag_entries_missing.empty())
         {
             std::error_code ec;
-            fs.create_directories(paths.buildtrees / name, ec);
-            const auto abi_file_path = paths.buildtrees / name / (triplet.canonical_name() + ".vcpkg_abi_info.txt");
+            const auto buildtrees_dir =
+                paths.buildtrees_dir(PackageSpec::from_name_and_triplet(name, triplet).value_or_exit(VCPKG_LINE_INFO));
+            fs.create_directories(buildtrees_dir, ec);
+            const auto abi_file_path = buildtrees_dir / (triplet.canonical_name() + ".vcpkg_abi_info.txt");
             fs.write_contents(abi_file_path, full_abi_info, VCPKG_LINE_INFO);
 
             return AbiTagAndFile{Hash::get_file_hash(VCPKG_LINE_INFO, fs, abi_file_path, Hash::Algorithm::Sha1),
@@ -742,8 +873,68 @@ namespace vcpkg::Build
         return result;
     }
 
-    // Compress the source directory into the destination file.
-    static void compress_directory(const VcpkgPaths& paths, const fs::path& source, const fs::path& destination)
+    fs::path get_archive_path(const VcpkgPaths& paths, const std::string& abi_tag)
+    {
+        return paths.root / "archives" / fs::u8path(abi_tag.substr(0, 2)) / (abi_tag + ".zip");
+    }
+
+    fs::path get_archive_tombstone_path(const VcpkgPaths& paths, const std::string& abi_tag)
+    {
+        return paths.root / "archives" / "fail" / fs::u8path(abi_tag.substr(0, 2)) / (abi_tag + ".zip");
+    }
+
+    struct DecompressArchiveAction
+    {
+        const VcpkgPaths* paths;
+        const std::pair<PackageSpec, fs::path>* archive;
+        int* result;
+
+        template<class ThreadLocalData, class Queue>
+        void operator()(ThreadLocalData&, const Queue&) &&
+        {
+            *result = decompress_archive(*paths, archive->first, archive->second);
+        }
+    };
+
+    std::vector<int> decompress_archives(const VcpkgPaths& paths,
+                                         const std::vector<std::pair<PackageSpec, fs::path>>& archives)
+    {
+        std::vector<int> results(archives.size(), 0);
+        if (archives.empty()) return results;
+
+#if defined(_WIN32)
+        // Resolve the tool on this thread; the tool cache is not safe to populate concurrently.
+        Util::unused(paths.get_tool_exe(Tools::SEVEN_ZIP));
+#endif
+
+        WorkQueue<DecompressArchiveAction> queue(VCPKG_LINE_INFO);
+        for (size_t i = 0; i < archives.size(); ++i)
+        {
+            queue.enqueue_action(DecompressArchiveAction{&paths, &archives[i], &results[i]});
+        }
+
+        const auto num_threads =
+            std::min(static_cast<size_t>(std::max(System::get_num_logical_cores(), 1)), archives.size());
+        queue.run_and_join(static_cast<unsigned>(num_threads), [] { return 0; });
+        return results;
+    }
+
+    static std::string make_compress_directory_cmd(const VcpkgPaths& paths,
+                                                   const fs::path& source,
+                                                   const fs::path& destination)
+    {
+#if defined(_WIN32)
+        auto&& seven_zip_exe = paths.get_tool_exe(Tools::SEVEN_ZIP);
+
+        return Strings::format(
+            R"("%s" a "%s" "%s\*" >nul)", seven_zip_exe.u8string(), destination.u8string(), source.u8string());
+#else
+        Util::unused(paths);
+        return Strings::format(R"(cd '%s' && zip --quiet -r '%s' *)", source.u8string(), destination.u8string());
+#endif
+    }
+
+    static int run_compress_cmd(const VcpkgPaths& paths, const std::string& compress_cmd, const fs::path& destination)
     {
         auto& fs = paths.get_filesystem();
 
@@ -752,20 +943,164 @@ namespace vcpkg::Build
         fs.remove(destination, ec);
         Checks::check_exit(
             VCPKG_LINE_INFO, !fs.exists(destination), "Could not remove file: %s", destination.u8string());
-#if defined(_WIN32)
-        auto&& seven_zip_exe = paths.get_tool_exe(Tools::SEVEN_ZIP);
+        return System::cmd_execute_clean(compress_cmd);
+    }
 
-        System::cmd_execute_clean(Strings::format(
-            R"("%s" a "%s" "%s\*" >nul)", seven_zip_exe.u8string(), destination.u8string(), source.u8string()));
-#else
-        System::cmd_execute_clean(
-            Strings::format(R"(cd '%s' && zip --quiet -r '%s' *)", source.u8string(), destination.u8string()));
-#endif
+    // Compress the source directory into the destination file.
+    static int compress_directory(const VcpkgPaths& paths, const fs::path& source, const fs::path& destination)
+    {
+        return run_compress_cmd(paths, make_compress_directory_cmd(paths, source, destination), destination);
     }
 
-    static void compress_archive(const VcpkgPaths& paths, const PackageSpec& spec, const fs::path& destination)
+    static fs::path get_tmp_archive_path(const VcpkgPaths& paths, const PackageSpec& spec)
     {
-        compress_directory(paths, paths.package_dir(spec), destination);
+        return paths.buildtrees_dir(spec) / (spec.triplet().to_string() + ".zip");
+    }
+
+    // Move a compressed package into the binary cache. Returns a description of the failure, if any.
+    static Optional<std::string> store_archive(const VcpkgPaths& paths,
+                                               const fs::path& tmp_archive_path,
+                                               const fs::path& archive_path)
+    {
+        auto& fs = paths.get_filesystem();
+
+        std::error_code ec;
+        fs.create_directories(archive_path.parent_path(), ec);
+        fs.rename_or_copy(tmp_archive_path, archive_path, ".tmp", ec);
+        if (ec)
+        {
+            return Strings::format("Failed to store binary cache %s: %s", archive_path.u8string(), ec.message());
+        }
+        return nullopt;
+    }
+
+    static std::mutex g_upload_queues_mutex;
+    static std::vector<ArchiveUploadQueue*> g_upload_queues;
+
+    ArchiveUploadQueue::ArchiveUploadQueue(const VcpkgPaths& paths, size_t max_pending)
+        : m_paths(paths), m_max_pending(std::max(max_pending, size_t(1)))
+    {
+        std::lock_guard<std::mutex> lck(g_upload_queues_mutex);
+        g_upload_queues.push_back(this);
+    }
+
+    ArchiveUploadQueue::~ArchiveUploadQueue()
+    {
+        {
+            std::lock_guard<std::mutex> lck(g_upload_queues_mutex);
+            Util::erase_remove_if(g_upload_queues, [this](const ArchiveUploadQueue* queue) { return queue == this; });
+        }
+        {
+            std::lock_guard<std::mutex> lck(m_mutex);
+            m_stopping = true;
+        }
+        m_cv.notify_all();
+        if (m_worker.joinable()) m_worker.join();
+    }
+
+    void ArchiveUploadQueue::enqueue(const PackageSpec& spec, const fs::path& archive_path)
+    {
+        // The command is built here rather than on the worker, because looking up tools is not thread safe.
+        auto compress_cmd =
+            make_compress_directory_cmd(m_paths, m_paths.package_dir(spec), get_tmp_archive_path(m_paths, spec));
+
+        {
+            std::unique_lock<std::mutex> lck(m_mutex);
+            m_cv.wait(lck, [this] { return m_uploads.size() < m_max_pending; });
+            m_uploads.push_back(Upload{spec, archive_path, std::move(compress_cmd), false});
+            if (!m_worker.joinable()) m_worker = std::thread([this] { run(); });
+        }
+        m_cv.notify_all();
+    }
+
+    bool ArchiveUploadQueue::remove_package_dir_after_upload(const PackageSpec& spec)
+    {
+        std::lock_guard<std::mutex> lck(m_mutex);
+        for (auto&& upload : m_uploads)
+        {
+            if (upload.spec == spec)
+            {
+                upload.remove_package_dir = true;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    std::vector<std::string> ArchiveUploadQueue::drain()
+    {
+        std::unique_lock<std::mutex> lck(m_mutex);
+        if (!m_uploads.empty())
+        {
+            System::printf("Waiting for %zd binary cache uploads to complete...\n", m_uploads.size());
+        }
+        m_cv.wait(lck, [this] { return m_uploads.empty(); });
+
+        auto warnings = std::move(m_warnings);
+        m_warnings.clear();
+        return warnings;
+    }
+
+    void ArchiveUploadQueue::drain_all()
+    {
+        std::lock_guard<std::mutex> queues_lck(g_upload_queues_mutex);
+        for (auto queue : g_upload_queues)
+        {
+            {
+                // An upload that fails its own checks exits on the worker, which must not wait for itself
+                std::lock_guard<std::mutex> lck(queue->m_mutex);
+                if (queue->m_worker.get_id() == std::this_thread::get_id()) continue;
+            }
+
+            for (auto&& warning : queue->drain())
+            {
+                System::print2(System::Color::warning, warning, '\n');
+            }
+        }
+    }
+
+    void ArchiveUploadQueue::run()
+    {
+        auto& fs = m_paths.get_filesystem();
+
+        std::unique_lock<std::mutex> lck(m_mutex);
+        for (;;)
+        {
+            m_cv.wait(lck, [this] { return m_stopping || !m_uploads.empty(); });
+            if (m_uploads.empty()) return;
+
+            // Only this thread pops, so the front element stays valid while unlocked
+            const Upload& upload = m_uploads.front();
+            lck.unlock();
+
+            const auto tmp_archive_path = get_tmp_archive_path(m_paths, upload.spec);
+            Optional<std::string> warning;
+            if (run_compress_cmd(m_paths, upload.compress_cmd, tmp_archive_path) != 0)
+            {
+                warning = Strings::format("Failed to compress binary cache for %s", upload.spec.to_string());
+            }
+            else
+            {
+                warning = store_archive(m_paths, tmp_archive_path, upload.archive_path);
+            }
+
+            lck.lock();
+            if (auto w = warning.get()) m_warnings.push_back(std::move(*w));
+            const bool remove_package_dir = upload.remove_package_dir;
+            const PackageSpec spec = upload.spec;
+            m_uploads.pop_front();
+            lck.unlock();
+            m_cv.notify_all();
+
+            if (remove_package_dir)
+            {
+                std::error_code ec;
+                fs::path failure_point;
+                fs.remove_all(m_paths.package_dir(spec), ec, failure_point);
+            }
+
+            lck.lock();
+        }
     }
 
     ExtendedBuildResult build_package(const VcpkgPaths& paths,
@@ -812,7 +1147,12 @@ namespace vcpkg::Build
             config.var_provider.get_tag_vars(spec).value_or_exit(VCPKG_LINE_INFO);
         const PreBuildInfo pre_build_info(paths, triplet, cmake_vars);
 
-        auto maybe_abi_tag_and_file = compute_abi_tag(paths, config, pre_build_info, dependency_abis);
+        Optional<AbiTagAndFile> maybe_abi_tag_and_file;
+        const auto precomputed_abi = config.precomputed_abi.get();
+        if (precomputed_abi && precomputed_abi->dependency_abis == dependency_abis)
+            maybe_abi_tag_and_file = precomputed_abi->tag_and_file;
+        else
+            maybe_abi_tag_and_file = compute_abi_tag(paths, config, pre_build_info, dependency_abis);
         if (!maybe_abi_tag_and_file)
         {
             return do_build_package_and_clean_buildtrees(
@@ -821,16 +1161,25 @@ namespace vcpkg::Build
 
         std::error_code ec;
         const auto abi_tag_and_file = maybe_abi_tag_and_file.get();
-        const fs::path archives_root_dir = paths.root / "archives";
-        const std::string archive_name = abi_tag_and_file->tag + ".zip";
-        const fs::path archive_subpath = fs::u8path(abi_tag_and_file->tag.substr(0, 2)) / archive_name;
-        const fs::path archive_path = archives_root_dir / archive_subpath;
-        const fs::path archive_tombstone_path = archives_root_dir / "fail" / archive_subpath;
+        const fs::path archive_path = get_archive_path(paths, abi_tag_and_file->tag);
+        const fs::path archive_tombstone_path = get_archive_tombstone_path(paths, abi_tag_and_file->tag);
         const fs::path abi_package_dir = paths.package_dir(spec) / "share" / spec.name();
         const fs::path abi_file_in_package = paths.package_dir(spec) / "share" / spec.name() / "vcpkg_abi_info.txt";
 
         if (config.build_package_options.binary_caching == BinaryCaching::YES)
         {
+            const auto prefetched_abi_tag = config.prefetched_abi_tag.get();
+            if (prefetched_abi_tag && *prefetched_abi_tag == abi_tag_and_file->tag)
+            {
+                System::print2("Using prefetched binary package: ", archive_path.u8string(), "\n");
+
+                auto maybe_bcf = Paragraphs::try_load_cached_package(paths, spec);
+                auto bcf = std::make_unique<BinaryControlFile>(std::move(maybe_bcf).value_or_exit(VCPKG_LINE_INFO));
+                ExtendedBuildResult cached{BuildResult::SUCCEEDED, std::move(bcf)};
+                cached.restored_from_cache = true;
+                return cached;
+            }
+
             if (fs.exists(archive_path))
             {
                 System::print2("Using cached binary package: ", archive_path.u8string(), "\n");
@@ -845,7 +1194,9 @@ namespace vcpkg::Build
 
                 auto maybe_bcf = Paragraphs::try_load_cached_package(paths, spec);
                 auto bcf = std::make_unique<BinaryControlFile>(std::move(maybe_bcf).value_or_exit(VCPKG_LINE_INFO));
-                return {BuildResult::SUCCEEDED, std::move(bcf)};
+                ExtendedBuildResult cached{BuildResult::SUCCEEDED, std::move(bcf)};
+                cached.restored_from_cache = true;
+                return cached;
             }
 
             if (fs.exists(archive_tombstone_path))
@@ -875,21 +1226,23 @@ namespace vcpkg::Build
 
         if (config.build_package_options.binary_caching == BinaryCaching::YES && result.code == BuildResult::SUCCEEDED)
         {
-            const auto tmp_archive_path = paths.buildtrees / spec.name() / (spec.triplet().to_string() + ".zip");
-
-            compress_archive(paths, spec, tmp_archive_path);
-
-            fs.create_directories(archive_path.parent_path(), ec);
-            fs.rename_or_copy(tmp_archive_path, archive_path, ".tmp", ec);
-            if (ec)
+            if (auto archive_uploads = config.archive_uploads.get())
             {
-                System::printf(System::Color::warning,
-                               "Failed to store binary cache %s: %s\n",
-                               archive_path.u8string(),
-                               ec.message());
+                archive_uploads->enqueue(spec, archive_path);
+                System::printf("Queued binary cache upload: %s\n", archive_path.u8string());
             }
             else
-                System::printf("Stored binary cache: %s\n", archive_path.u8string());
+            {
+                const auto tmp_archive_path = get_tmp_archive_path(paths, spec);
+
+                compress_directory(paths, paths.package_dir(spec), tmp_archive_path);
+
+                const auto maybe_warning = store_archive(paths, tmp_archive_path, archive_path);
+                if (auto warning = maybe_warning.get())
+                    System::print2(System::Color::warning, *warning, "\n");
+                else
+                    System::printf("Stored binary cache: %s\n", archive_path.u8string());
+            }
         }
         else if (config.build_package_options.binary_caching == BinaryCaching::YES &&
                  (result.code == BuildResult::BUILD_FAILED || result.code == BuildResult::POST_BUILD_CHECKS_FAILED))
@@ -897,12 +1250,13 @@ namespace vcpkg::Build
             if (!fs.exists(archive_tombstone_path))
             {
                 // Build failed, store all failure logs in the tombstone.
-                const auto tmp_log_path = paths.buildtrees / spec.name() / "tmp_failure_logs";
+                const auto buildtrees_dir = paths.buildtrees_dir(spec);
+                const auto tmp_log_path = buildtrees_dir / "tmp_failure_logs";
                 const auto tmp_log_path_destination = tmp_log_path / spec.name();
-                const auto tmp_failure_zip = paths.buildtrees / spec.name() / "failure_logs.zip";
+                const auto tmp_failure_zip = buildtrees_dir / "failure_logs.zip";
                 fs.create_directories(tmp_log_path_destination, ec);
 
-                for (auto& log_file : fs::stdfs::directory_iterator(paths.buildtrees / spec.name()))
+                for (auto& log_file : fs::stdfs::directory_iterator(buildtrees_dir))
                 {
                     if (log_file.path().extension() == ".log")
                     {
@@ -913,7 +1267,7 @@ namespace vcpkg::Build
                     }
                 }
 
-                compress_directory(paths, tmp_log_path, paths.buildtrees / spec.name() / "failure_logs.zip");
+                compress_directory(paths, tmp_log_path, tmp_failure_zip);
 
                 fs.create_directories(archive_tombstone_path.parent_path(), ec);
                 fs.rename_or_copy(tmp_failure_zip, archive_tombstone_path, ".tmp", ec);
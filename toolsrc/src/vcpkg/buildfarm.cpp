@@ -0,0 +1,623 @@
+#include "pch.h"
+
+#include <vcpkg/base/chrono.h>
+#include <vcpkg/base/strings.h>
+#include <vcpkg/base/system.print.h>
+#include <vcpkg/base/system.process.h>
+#include <vcpkg/base/util.h>
+#include <vcpkg/buildfarm.h>
+#include <vcpkg/buildhistory.h>
+#include <vcpkg/paragraphs.h>
+#include <vcpkg/parse.h>
+
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+namespace vcpkg::BuildFarm
+{
+    namespace Fields
+    {
+        static const std::string PACKAGE = "Package";
+        static const std::string ARCHITECTURE = "Architecture";
+        static const std::string FEATURES = "Features";
+        static const std::string ATTEMPT = "Attempt";
+        static const std::string RESULT = "Result";
+        static const std::string DURATION_MS = "Duration-Ms";
+        static const std::string RESTORED = "Restored";
+        static const std::string PEAK_RSS_KB = "Peak-Rss-Kb";
+        static const std::string HEARTBEAT = "Heartbeat";
+    }
+
+    // Workers and the coordinator look for new files this often
+    static constexpr std::chrono::seconds POLL_INTERVAL{1};
+
+    static Optional<Parse::RawParagraph> read_paragraph(const Files::Filesystem& fs, const fs::path& file)
+    {
+        auto maybe_pgh = Paragraphs::get_single_paragraph(fs, file);
+        if (auto pgh = maybe_pgh.get()) return std::move(*pgh);
+        return nullopt;
+    }
+
+    static Optional<PackageSpec> parse_spec(const Parse::RawParagraph& pgh)
+    {
+        const auto package = pgh.find(Fields::PACKAGE);
+        const auto architecture = pgh.find(Fields::ARCHITECTURE);
+        if (package == pgh.end() || architecture == pgh.end()) return nullopt;
+        auto maybe_spec = PackageSpec::from_name_and_triplet(
+            package->second, Triplet::from_canonical_name(std::string(architecture->second)));
+        if (const auto spec = maybe_spec.get()) return *spec;
+        return nullopt;
+    }
+
+    static Optional<WorkItem> read_item(const Files::Filesystem& fs, const fs::path& file)
+    {
+        auto maybe_pgh = read_paragraph(fs, file);
+        const auto pgh = maybe_pgh.get();
+        if (!pgh) return nullopt;
+        auto maybe_spec = parse_spec(*pgh);
+        const auto spec = maybe_spec.get();
+        if (!spec) return nullopt;
+
+        WorkItem item{*spec, {}};
+        const auto it_features = pgh->find(Fields::FEATURES);
+        if (it_features != pgh->end()) item.features = Parse::parse_comma_list(it_features->second);
+        const auto it_attempt = pgh->find(Fields::ATTEMPT);
+        if (it_attempt != pgh->end()) item.attempt = std::max(1, std::atoi(it_attempt->second.c_str()));
+        return item;
+    }
+
+    // Tells apart the workers of all hosts sharing a queue
+    static std::string get_worker_id()
+    {
+        return Strings::concat(System::get_host_name(), '-', System::get_process_id());
+    }
+
+    QueueDirectory::QueueDirectory(Files::Filesystem& fs, fs::path root)
+        : m_fs(fs)
+        , m_root(std::move(root))
+        , m_pending(m_root / "pending")
+        , m_claimed(m_root / "claimed")
+        , m_leases(m_root / "leases")
+        , m_done(m_root / "done")
+        , m_incoming(m_root / "incoming")
+        , m_closed_marker(m_root / "closed")
+    {
+    }
+
+    void QueueDirectory::reset()
+    {
+        for (auto&& dir : {m_pending, m_claimed, m_leases, m_done, m_incoming})
+        {
+            m_fs.remove_all(dir, VCPKG_LINE_INFO);
+            std::error_code ec;
+            m_fs.create_directories(dir, ec);
+            Checks::check_exit(VCPKG_LINE_INFO, !ec, "Failed to create %s: %s", dir.u8string(), ec.message());
+        }
+        m_fs.remove(m_closed_marker, VCPKG_LINE_INFO);
+        m_seen_leases.clear();
+    }
+
+    void QueueDirectory::publish(const std::string& contents, const fs::path& destination)
+    {
+        const auto tmp = m_incoming / Strings::concat(destination.parent_path().filename().u8string(),
+                                                      '-',
+                                                      destination.filename().u8string());
+        std::error_code ec;
+        m_fs.write_contents(tmp, contents, ec);
+        if (!ec) m_fs.rename(tmp, destination, ec);
+        Checks::check_exit(VCPKG_LINE_INFO, !ec, "Failed to write %s: %s", destination.u8string(), ec.message());
+    }
+
+    void QueueDirectory::push(const WorkItem& item)
+    {
+        std::string contents;
+        Strings::append(contents, Fields::PACKAGE, ": ", item.spec.name(), '\n');
+        Strings::append(contents, Fields::ARCHITECTURE, ": ", item.spec.triplet(), '\n');
+        if (!item.features.empty())
+            Strings::append(contents, Fields::FEATURES, ": ", Strings::join(", ", item.features), '\n');
+        Strings::append(contents, Fields::ATTEMPT, ": ", std::to_string(item.attempt), '\n');
+        publish(contents, m_pending / Strings::concat(item.spec.dir(), '.', item.attempt));
+    }
+
+    std::vector<WorkResult> QueueDirectory::take_results()
+    {
+        std::vector<WorkResult> results;
+        auto files = m_fs.get_files_non_recursive(m_done);
+        Util::sort(files);
+        for (auto&& file : files)
+        {
+            auto maybe_pgh = read_paragraph(m_fs, file);
+            m_fs.remove(file, VCPKG_LINE_INFO);
+
+            const auto pgh = maybe_pgh.get();
+            if (!pgh) continue;
+            auto maybe_spec = parse_spec(*pgh);
+            const auto spec = maybe_spec.get();
+            if (!spec) continue;
+
+            WorkResult result{*spec, Build::BuildResult::BUILD_FAILED, std::chrono::milliseconds(0)};
+            const auto it_result = pgh->find(Fields::RESULT);
+            if (it_result != pgh->end())
+            {
+                const auto it = Util::find_if(Build::BUILD_RESULT_VALUES, [&](Build::BuildResult r) {
+                    return Build::to_string(r) == it_result->second;
+                });
+                if (it != Build::BUILD_RESULT_VALUES.end()) result.result = *it;
+            }
+            const auto it_duration = pgh->find(Fields::DURATION_MS);
+            if (it_duration != pgh->end())
+                result.duration = std::chrono::milliseconds(std::atoll(it_duration->second.c_str()));
+            const auto it_restored = pgh->find(Fields::RESTORED);
+            result.restored_from_cache = it_restored != pgh->end() && it_restored->second == "yes";
+            const auto it_peak_rss = pgh->find(Fields::PEAK_RSS_KB);
+            if (it_peak_rss != pgh->end())
+                result.peak_rss_kb = static_cast<std::uint64_t>(std::atoll(it_peak_rss->second.c_str()));
+
+            results.push_back(std::move(result));
+        }
+        return results;
+    }
+
+    std::vector<WorkItem> QueueDirectory::take_expired(std::chrono::milliseconds lease_timeout)
+    {
+        const auto now = std::chrono::steady_clock::now();
+        std::vector<WorkItem> expired;
+        std::map<std::string, Lease> seen_leases;
+        auto files = m_fs.get_files_non_recursive(m_claimed);
+        Util::sort(files);
+        for (auto&& file : files)
+        {
+            const auto name = file.filename().u8string();
+            const auto lease_file = m_leases / file.filename();
+            // A worker that has not renewed its lease yet has none
+            std::string contents;
+            auto maybe_contents = m_fs.read_contents(lease_file);
+            if (auto c = maybe_contents.get()) contents = std::move(*c);
+
+            Lease lease{contents, now};
+            auto it = m_seen_leases.find(name);
+            if (it != m_seen_leases.end() && it->second.contents == contents) lease.renewed = it->second.renewed;
+            if (now - lease.renewed < lease_timeout)
+            {
+                seen_leases.emplace(name, std::move(lease));
+                continue;
+            }
+
+            auto maybe_item = read_item(m_fs, file);
+            std::error_code ec;
+            // The worker may have completed the item meanwhile
+            if (!m_fs.remove(file, ec)) continue;
+            m_fs.remove(lease_file, ec);
+            if (auto item = maybe_item.get()) expired.push_back(std::move(*item));
+        }
+        m_seen_leases = std::move(seen_leases);
+        return expired;
+    }
+
+    void QueueDirectory::close() { publish("", m_closed_marker); }
+
+    bool QueueDirectory::is_closed() const { return m_fs.exists(m_closed_marker); }
+
+    fs::path QueueDirectory::host_dir(const std::string& host_name) const
+    {
+        return m_root / "hosts" / fs::u8path(host_name);
+    }
+
+    Optional<WorkItem> QueueDirectory::claim()
+    {
+        const auto worker_id = get_worker_id();
+        auto files = m_fs.get_files_non_recursive(m_pending);
+        Util::sort(files);
+        for (auto&& file : files)
+        {
+            const auto claim_token = Strings::concat(file.filename().u8string(), '.', worker_id);
+            const auto claimed = m_claimed / fs::u8path(claim_token);
+            std::error_code ec;
+            m_fs.rename(file, claimed, ec);
+            // Another worker was faster
+            if (ec) continue;
+
+            auto maybe_item = read_item(m_fs, claimed);
+            if (auto item = maybe_item.get())
+            {
+                item->claim_token = claim_token;
+                return maybe_item;
+            }
+
+            System::print2(System::Color::warning, "Warning: ignoring damaged work item ", claimed.u8string(), '\n');
+            m_fs.remove(claimed, ec);
+        }
+        return nullopt;
+    }
+
+    void QueueDirectory::renew(const WorkItem& item)
+    {
+        // Any new contents will do, as the coordinator only looks for changes
+        const auto heartbeat = std::chrono::steady_clock::now().time_since_epoch().count();
+        const auto contents = Strings::concat(Fields::HEARTBEAT, ": ", std::to_string(heartbeat), '\n');
+        const auto token = fs::u8path(item.claim_token);
+        const auto tmp = m_incoming / Strings::concat("leases-", item.claim_token);
+        std::error_code ec;
+        m_fs.write_contents(tmp, contents, ec);
+        if (!ec) m_fs.rename(tmp, m_leases / token, ec);
+    }
+
+    void QueueDirectory::complete(const WorkItem& item, const WorkResult& result)
+    {
+        std::string contents;
+        Strings::append(contents, Fields::PACKAGE, ": ", result.spec.name(), '\n');
+        Strings::append(contents, Fields::ARCHITECTURE, ": ", result.spec.triplet(), '\n');
+        Strings::append(contents, Fields::RESULT, ": ", Build::to_string(result.result), '\n');
+        Strings::append(contents, Fields::DURATION_MS, ": ", std::to_string(result.duration.count()), '\n');
+        if (result.restored_from_cache) Strings::append(contents, Fields::RESTORED, ": yes\n");
+        if (const auto peak_rss_kb = result.peak_rss_kb.get())
+            Strings::append(contents, Fields::PEAK_RSS_KB, ": ", std::to_string(*peak_rss_kb), '\n');
+        const auto token = fs::u8path(item.claim_token);
+        publish(contents, m_done / token);
+
+        std::error_code ec;
+        m_fs.remove(m_claimed / token, ec);
+        m_fs.remove(m_leases / token, ec);
+    }
+
+    namespace
+    {
+        /// <summary>
+        /// Registers this process among the workers of a host, in a file named after its process id, for as long as
+        /// it lives.
+        /// </summary>
+        struct HostWorkers
+        {
+            HostWorkers(Files::Filesystem& fs, fs::path dir)
+                : m_fs(fs), m_dir(std::move(dir)), m_self(m_dir / std::to_string(System::get_process_id()))
+            {
+                std::error_code ec;
+                m_fs.create_directories(m_dir, ec);
+                m_fs.write_contents(m_self, "", ec);
+            }
+            HostWorkers(const HostWorkers&) = delete;
+            HostWorkers& operator=(const HostWorkers&) = delete;
+            ~HostWorkers()
+            {
+                std::error_code ec;
+                m_fs.remove(m_self, ec);
+            }
+
+            /// <summary>
+            /// Workers still running, counting this one. Drops the registrations of those that died.
+            /// </summary>
+            int count() const
+            {
+                int running = 0;
+                for (auto&& file : m_fs.get_files_non_recursive(m_dir))
+                {
+                    const auto process_id = std::atoi(file.filename().u8string().c_str());
+                    if (file == m_self || (process_id > 0 && System::is_process_running(process_id)))
+                    {
+                        ++running;
+                        continue;
+                    }
+                    std::error_code ec;
+                    m_fs.remove(file, ec);
+                }
+                return std::max(running, 1);
+            }
+
+        private:
+            Files::Filesystem& m_fs;
+            fs::path m_dir;
+            fs::path m_self;
+        };
+    }
+
+    static Chrono::ElapsedTime to_elapsed_time(std::chrono::milliseconds ms)
+    {
+        return Chrono::ElapsedTime(std::chrono::duration_cast<std::chrono::nanoseconds>(ms));
+    }
+
+    bool MemoryBudget::admits(std::uint64_t candidate_kb, std::uint64_t in_flight_kb, size_t in_flight_count) const
+    {
+        if (in_flight_count == 0) return true;
+        if (budget_kb != 0 && in_flight_kb + candidate_kb > budget_kb) return false;
+        if (min_available_kb != 0 && available_memory_kb)
+        {
+            auto maybe_available = available_memory_kb();
+            if (auto available = maybe_available.get())
+            {
+                if (*available < min_available_kb) return false;
+            }
+        }
+        return true;
+    }
+
+    Install::InstallSummary coordinate(std::vector<Dependencies::AnyAction>& action_plan,
+                                       const VcpkgPaths& paths,
+                                       QueueDirectory& queue,
+                                       const MemoryBudget& memory,
+                                       std::chrono::milliseconds lease_timeout)
+    {
+        using Build::BuildResult;
+
+        const auto timer = Chrono::ElapsedTimer::create_started();
+        Install::InstallSummary summary;
+
+        std::unordered_map<PackageSpec, size_t> index_of;
+        for (size_t i = 0; i < action_plan.size(); ++i)
+        {
+            if (auto install_action = action_plan[i].install_action.get())
+                index_of.emplace(install_action->spec, i);
+            else
+                System::print2(System::Color::warning,
+                               "Warning: workers cannot remove packages; skipping removal of ",
+                               action_plan[i].spec(),
+                               '\n');
+        }
+
+        std::vector<size_t> waiting_on(action_plan.size(), 0);
+        std::vector<std::vector<size_t>> dependents(action_plan.size());
+        std::vector<size_t> ready;
+        for (size_t i = 0; i < action_plan.size(); ++i)
+        {
+            if (!action_plan[i].install_action) continue;
+            for (auto&& dep : action_plan[i].install_action.get()->package_dependencies)
+            {
+                auto it = index_of.find(dep);
+                if (it == index_of.end() || it->second == i) continue;
+                ++waiting_on[i];
+                dependents[it->second].push_back(i);
+            }
+            if (waiting_on[i] == 0) ready.push_back(i);
+        }
+
+        std::vector<BuildHistory::BuildRecord> history_records;
+        std::vector<bool> finished(action_plan.size(), false);
+        std::function<void(size_t, BuildResult, Chrono::ElapsedTime)> finish =
+            [&](size_t i, BuildResult result, Chrono::ElapsedTime timing) {
+                if (finished[i]) return;
+                finished[i] = true;
+
+                summary.results.emplace_back(action_plan[i].spec(), &action_plan[i]);
+                summary.results.back().build_result = Build::ExtendedBuildResult(result);
+                summary.results.back().timing = timing;
+                System::printf("%s: %s: %s\n", action_plan[i].spec(), Build::to_string(result), timing);
+
+                for (size_t dependent : dependents[i])
+                {
+                    if (result != BuildResult::SUCCEEDED)
+                        finish(dependent, BuildResult::CASCADED_DUE_TO_MISSING_DEPENDENCIES, {});
+                    else if (--waiting_on[dependent] == 0)
+                        ready.push_back(dependent);
+                }
+            };
+
+        size_t outstanding = 0;
+        std::uint64_t in_flight_kb = 0;
+        std::vector<std::uint64_t> reserved_kb(action_plan.size(), 0);
+        std::vector<int> claims(action_plan.size(), 0);
+        std::vector<size_t> deferred;
+        for (;;)
+        {
+            while (!ready.empty())
+            {
+                const auto i = ready.back();
+                ready.pop_back();
+                if (finished[i]) continue;
+
+                auto& action = *action_plan[i].install_action.get();
+                switch (action.plan_type)
+                {
+                    case Dependencies::InstallPlanType::BUILD_AND_INSTALL:
+                    {
+                        const auto it_peak = memory.predicted_peak_kb.find(action.spec);
+                        const std::uint64_t peak_kb = it_peak == memory.predicted_peak_kb.end() ? 0 : it_peak->second;
+                        if (!memory.admits(peak_kb, in_flight_kb, outstanding))
+                        {
+                            deferred.push_back(i);
+                            break;
+                        }
+
+                        ++claims[i];
+                        queue.push({action.spec, action.feature_list, claims[i]});
+                        ++outstanding;
+                        reserved_kb[i] = peak_kb;
+                        in_flight_kb += peak_kb;
+                        System::print2("Queued ", action.spec, '\n');
+                        break;
+                    }
+                    case Dependencies::InstallPlanType::EXCLUDED: finish(i, BuildResult::EXCLUDED, {}); break;
+                    default: finish(i, BuildResult::SUCCEEDED, {}); break;
+                }
+            }
+
+            // Builds held back for memory are tried again once something finishes
+            ready.insert(ready.end(), deferred.rbegin(), deferred.rend());
+            deferred.clear();
+
+            if (outstanding == 0) break;
+
+            auto results = queue.take_results();
+            for (auto&& result : results)
+            {
+                auto it = index_of.find(result.spec);
+                if (it == index_of.end() || finished[it->second]) continue;
+                --outstanding;
+                in_flight_kb -= reserved_kb[it->second];
+                finish(it->second, result.result, to_elapsed_time(result.duration));
+
+                BuildHistory::BuildRecord record{result.spec, result.duration};
+                record.features = action_plan[it->second].install_action.get()->feature_list;
+                record.result = result.result;
+                record.restored_from_cache = result.restored_from_cache;
+                record.peak_rss_kb = result.peak_rss_kb;
+                history_records.push_back(std::move(record));
+            }
+
+            // Results are taken first, so that an item completed just as its lease ran out is not built again
+            auto expired = queue.take_expired(lease_timeout);
+            for (auto&& item : expired)
+            {
+                auto it = index_of.find(item.spec);
+                if (it == index_of.end() || finished[it->second]) continue;
+                const auto i = it->second;
+                if (claims[i] < MAX_CLAIMS)
+                {
+                    System::print2(System::Color::warning,
+                                   "Warning: the worker building ",
+                                   item.spec,
+                                   " stopped responding; queueing it again\n");
+                    item.attempt = ++claims[i];
+                    queue.push(item);
+                    continue;
+                }
+
+                System::printf(System::Color::error,
+                               "Error: %d workers stopped responding while building %s\n",
+                               claims[i],
+                               item.spec);
+                --outstanding;
+                in_flight_kb -= reserved_kb[i];
+                finish(i, BuildResult::BUILD_FAILED, {});
+            }
+
+            if (results.empty() && expired.empty()) std::this_thread::sleep_for(POLL_INTERVAL);
+        }
+
+        BuildHistory::append_records(paths.get_filesystem(), paths.vcpkg_dir_history, history_records);
+
+        summary.total_elapsed_time = timer.to_string();
+        return summary;
+    }
+
+    void run_worker(const VcpkgCmdArguments& args,
+                    const VcpkgPaths& paths,
+                    QueueDirectory& queue,
+                    const fs::path& worker_root)
+    {
+        using Build::BuildResult;
+
+        auto& fs = paths.get_filesystem();
+        const auto installed = worker_root / "installed";
+        const auto history_dir = installed / "vcpkg" / "history";
+        const auto buildtrees = worker_root / "buildtrees";
+
+        // The child writes into the buildtrees root before it would create it
+        std::error_code ec;
+        fs.create_directories(buildtrees, ec);
+        Checks::check_exit(VCPKG_LINE_INFO, !ec, "Failed to create %s: %s", buildtrees.u8string(), ec.message());
+
+        std::string common_args = Strings::concat(" --binarycaching --vcpkg-root \"",
+                                                  paths.root.u8string(),
+                                                  "\" --x-install-root=\"",
+                                                  installed.u8string(),
+                                                  "\" --x-packages-root=\"",
+                                                  (worker_root / "packages").u8string(),
+                                                  "\" --x-buildtrees-root=\"",
+                                                  buildtrees.u8string(),
+                                                  '"');
+        // The child starts in the vcpkg root rather than where this worker was started
+        const auto from_original_cwd = [&](const std::string& path) {
+            return (paths.original_cwd / fs::u8path(path)).u8string();
+        };
+        if (auto scripts_root = args.scripts_root_dir.get())
+            Strings::append(common_args, " --x-scripts-root=\"", from_original_cwd(*scripts_root), '"');
+        if (auto overlay_ports = args.overlay_ports.get())
+        {
+            for (auto&& overlay : *overlay_ports)
+                Strings::append(common_args, " --overlay-ports=\"", from_original_cwd(overlay), '"');
+        }
+        if (auto overlay_triplets = args.overlay_triplets.get())
+        {
+            for (auto&& overlay : *overlay_triplets)
+                Strings::append(common_args, " --overlay-triplets=\"", from_original_cwd(overlay), '"');
+        }
+
+        // The child processes join the jobserver through MAKEFLAGS, and learn their share of it from
+        // VCPKG_MAX_CONCURRENCY
+        const auto host_dir = queue.host_dir(System::get_host_name());
+        const HostWorkers host_workers(fs, host_dir / "workers");
+        const int jobs = Build::get_concurrency();
+        const System::Jobserver jobserver(jobs, host_dir / "jobserver");
+        const auto it_makeflags = jobserver.environment().find("MAKEFLAGS");
+        if (it_makeflags != jobserver.environment().end())
+            System::set_environment_variable("MAKEFLAGS", it_makeflags->second);
+
+        const auto exe = System::get_exe_path_of_current_process().u8string();
+        bool waiting = false;
+        for (;;)
+        {
+            auto maybe_item = queue.claim();
+            if (const auto item = maybe_item.get())
+            {
+                waiting = false;
+                std::string spec_text = item->spec.name();
+                if (!item->features.empty()) Strings::append(spec_text, '[', Strings::join(",", item->features), ']');
+                Strings::append(spec_text, ':', item->spec.triplet());
+
+                const int share = std::max(1, jobs / host_workers.count());
+                System::set_environment_variable("VCPKG_MAX_CONCURRENCY", std::to_string(share));
+
+                System::printf("Building %s with %d jobs\n", spec_text, share);
+                const auto records_before = BuildHistory::BuildHistory::load(fs, history_dir).records().size();
+                const auto timer = Chrono::ElapsedTimer::create_started();
+
+                std::mutex heartbeat_mutex;
+                std::condition_variable heartbeat_cv;
+                bool building = true;
+                std::thread heartbeat([&] {
+                    std::unique_lock<std::mutex> lock(heartbeat_mutex);
+                    do
+                    {
+                        queue.renew(*item);
+                    } while (!heartbeat_cv.wait_for(
+                        lock, QueueDirectory::HEARTBEAT_INTERVAL, [&] { return !building; }));
+                });
+
+                const int exit_code =
+                    System::cmd_execute(Strings::concat('"', exe, "\" install ", spec_text, common_args));
+
+                {
+                    std::lock_guard<std::mutex> lock(heartbeat_mutex);
+                    building = false;
+                }
+                heartbeat_cv.notify_all();
+                heartbeat.join();
+
+                WorkResult result{item->spec,
+                                  exit_code == 0 ? BuildResult::SUCCEEDED : BuildResult::BUILD_FAILED,
+                                  timer.elapsed().as<std::chrono::milliseconds>()};
+
+                // The child records what happened to the item itself, as opposed to its dependencies
+                const auto history = BuildHistory::BuildHistory::load(fs, history_dir);
+                for (size_t i = records_before; i < history.records().size(); ++i)
+                {
+                    const auto& record = history.records()[i];
+                    if (record.spec != item->spec) continue;
+                    result.result = record.result;
+                    result.restored_from_cache = record.restored_from_cache;
+                    if (record.is_successful_build())
+                    {
+                        result.duration = record.duration;
+                        result.peak_rss_kb = record.peak_rss_kb;
+                    }
+                }
+
+                queue.complete(*item, result);
+                System::printf(
+                    "%s: %s: %s\n", item->spec, Build::to_string(result.result), to_elapsed_time(result.duration));
+                continue;
+            }
+
+            if (queue.is_closed()) break;
+            if (!waiting)
+            {
+                System::print2("Waiting for work\n");
+                waiting = true;
+            }
+            std::this_thread::sleep_for(POLL_INTERVAL);
+        }
+    }
+}
@@ -0,0 +1,276 @@
+#include "pch.h"
+
+#include <vcpkg/base/strings.h>
+#include <vcpkg/base/system.print.h>
+#include <vcpkg/base/util.h>
+#include <vcpkg/buildhistory.h>
+#include <vcpkg/paragraphs.h>
+#include <vcpkg/parse.h>
+
+namespace vcpkg::BuildHistory
+{
+    namespace Fields
+    {
+        static const std::string PACKAGE = "Package";
+        static const std::string ARCHITECTURE = "Architecture";
+        static const std::string DURATION_MS = "Duration-Ms";
+        static const std::string ABI = "Abi";
+        static const std::string FEATURES = "Features";
+        static const std::string RESULT = "Result";
+        static const std::string ORIGIN = "Origin";
+        static const std::string CPU_MS = "Cpu-Ms";
+        static const std::string PEAK_RSS_KB = "Peak-Rss-Kb";
+    }
+
+    static const std::string ORIGIN_BUILD = "build";
+    static const std::string ORIGIN_BINARY_CACHE = "binary-cache";
+
+    // Only the most recent builds are averaged, so that predictions follow ports as they grow or shrink
+    static constexpr size_t PREDICTION_WINDOW = 5;
+
+    static Optional<std::uint64_t> parse_number(const std::string& s)
+    {
+        if (s.empty()) return nullopt;
+        char* end = nullptr;
+        const auto value = std::strtoull(s.c_str(), &end, 10);
+        if (*end != '\0') return nullopt;
+        return static_cast<std::uint64_t>(value);
+    }
+
+    static Optional<BuildRecord> parse_record(const Parse::RawParagraph& pgh)
+    {
+        const auto field = [&](const std::string& name) -> const std::string* {
+            const auto it = pgh.find(name);
+            return it == pgh.end() ? nullptr : &it->second;
+        };
+
+        const auto package = field(Fields::PACKAGE);
+        const auto architecture = field(Fields::ARCHITECTURE);
+        const auto duration = field(Fields::DURATION_MS);
+        if (!package || !architecture || !duration) return nullopt;
+
+        auto maybe_spec =
+            PackageSpec::from_name_and_triplet(*package, Triplet::from_canonical_name(std::string(*architecture)));
+        const auto spec = maybe_spec.get();
+        if (!spec) return nullopt;
+
+        auto maybe_ms = parse_number(*duration);
+        const auto ms = maybe_ms.get();
+        if (!ms) return nullopt;
+
+        BuildRecord record{*spec, std::chrono::milliseconds(*ms)};
+
+        // Fields added after the first version of the format are optional
+        if (const auto abi = field(Fields::ABI)) record.abi = *abi;
+        if (const auto features = field(Fields::FEATURES)) record.features = Parse::parse_comma_list(*features);
+        if (const auto result = field(Fields::RESULT))
+        {
+            const auto it = Util::find_if(Build::BUILD_RESULT_VALUES,
+                                          [&](Build::BuildResult r) { return Build::to_string(r) == *result; });
+            if (it == Build::BUILD_RESULT_VALUES.end()) return nullopt;
+            record.result = *it;
+        }
+        if (const auto origin = field(Fields::ORIGIN)) record.restored_from_cache = *origin == ORIGIN_BINARY_CACHE;
+        if (const auto cpu = field(Fields::CPU_MS))
+        {
+            auto maybe_cpu_ms = parse_number(*cpu);
+            if (const auto cpu_ms = maybe_cpu_ms.get()) record.cpu_time = std::chrono::milliseconds(*cpu_ms);
+        }
+        if (const auto rss = field(Fields::PEAK_RSS_KB)) record.peak_rss_kb = parse_number(*rss);
+
+        return record;
+    }
+
+    static void serialize(const BuildRecord& record, std::string& out)
+    {
+        Strings::append(out, Fields::PACKAGE, ": ", record.spec.name(), '\n');
+        Strings::append(out, Fields::ARCHITECTURE, ": ", record.spec.triplet(), '\n');
+        Strings::append(out, Fields::DURATION_MS, ": ", std::to_string(record.duration.count()), '\n');
+        if (!record.abi.empty()) Strings::append(out, Fields::ABI, ": ", record.abi, '\n');
+        if (!record.features.empty())
+            Strings::append(out, Fields::FEATURES, ": ", Strings::join(", ", record.features), '\n');
+        Strings::append(out, Fields::RESULT, ": ", Build::to_string(record.result), '\n');
+        Strings::append(
+            out, Fields::ORIGIN, ": ", record.restored_from_cache ? ORIGIN_BINARY_CACHE : ORIGIN_BUILD, '\n');
+        if (const auto cpu_time = record.cpu_time.get())
+            Strings::append(out, Fields::CPU_MS, ": ", std::to_string(cpu_time->count()), '\n');
+        if (const auto peak_rss_kb = record.peak_rss_kb.get())
+            Strings::append(out, Fields::PEAK_RSS_KB, ": ", std::to_string(*peak_rss_kb), '\n');
+    }
+
+    static Optional<std::chrono::milliseconds> average_recent(const std::vector<BuildRecord>& records,
+                                                              const std::vector<size_t>& indices)
+    {
+        if (indices.empty()) return nullopt;
+
+        const size_t count = std::min(indices.size(), PREDICTION_WINDOW);
+        std::chrono::milliseconds total{};
+        for (auto it = indices.end() - count; it != indices.end(); ++it)
+        {
+            total += records[*it].duration;
+        }
+        return total / static_cast<long long>(count);
+    }
+
+    static Optional<std::uint64_t> max_recent_peak_rss(const std::vector<BuildRecord>& records,
+                                                       const std::vector<size_t>& indices)
+    {
+        const size_t count = std::min(indices.size(), PREDICTION_WINDOW);
+        Optional<std::uint64_t> peak;
+        for (auto it = indices.end() - count; it != indices.end(); ++it)
+        {
+            if (const auto rss = records[*it].peak_rss_kb.get())
+            {
+                if (!peak || *rss > *peak.get()) peak = *rss;
+            }
+        }
+        return peak;
+    }
+
+    BuildHistory BuildHistory::load(const Files::Filesystem& fs, const fs::path& history_dir)
+    {
+        BuildHistory history;
+        if (!fs.is_directory(history_dir)) return history;
+
+        // File names start with the time they were written, so sorting them puts the records in chronological order
+        auto files = fs.get_files_non_recursive(history_dir);
+        Util::sort(files);
+        for (auto&& file : files)
+        {
+            if (!fs.is_regular_file(file)) continue;
+            if (Strings::starts_with(file.filename().u8string(), "incomplete")) continue;
+
+            // The history is advisory; a damaged file must not stop a build
+            auto maybe_pghs = Paragraphs::get_paragraphs(fs, file);
+            auto pghs = maybe_pghs.get();
+            if (!pghs) continue;
+
+            for (auto&& pgh : *pghs)
+            {
+                auto maybe_record = parse_record(pgh);
+                if (auto record = maybe_record.get())
+                {
+                    record->run = file.filename().u8string();
+                    if (record->is_successful_build())
+                    {
+                        history.m_by_spec[record->spec].push_back(history.m_records.size());
+                        history.m_by_name[record->spec.name()].push_back(history.m_records.size());
+                    }
+                    history.m_records.push_back(std::move(*record));
+                }
+            }
+        }
+
+        return history;
+    }
+
+    Optional<std::chrono::milliseconds> BuildHistory::predict_duration(const PackageSpec& spec) const
+    {
+        const auto by_spec = m_by_spec.find(spec);
+        if (by_spec != m_by_spec.end()) return average_recent(m_records, by_spec->second);
+
+        const auto by_name = m_by_name.find(spec.name());
+        if (by_name != m_by_name.end()) return average_recent(m_records, by_name->second);
+
+        return nullopt;
+    }
+
+    Optional<std::uint64_t> BuildHistory::predict_peak_rss_kb(const PackageSpec& spec) const
+    {
+        const auto by_spec = m_by_spec.find(spec);
+        if (by_spec != m_by_spec.end())
+        {
+            auto peak = max_recent_peak_rss(m_records, by_spec->second);
+            if (peak) return peak;
+        }
+
+        const auto by_name = m_by_name.find(spec.name());
+        if (by_name != m_by_name.end()) return max_recent_peak_rss(m_records, by_name->second);
+
+        return nullopt;
+    }
+
+    void append_records(Files::Filesystem& fs, const fs::path& history_dir, const std::vector<BuildRecord>& records)
+    {
+        if (records.empty()) return;
+
+        std::string contents;
+        for (auto&& record : records)
+        {
+            if (!contents.empty()) contents.push_back('\n');
+            serialize(record, contents);
+        }
+
+        std::error_code ec;
+        fs.create_directories(history_dir, ec);
+
+        const auto now = std::chrono::duration_cast<std::chrono::milliseconds>(
+                             std::chrono::system_clock::now().time_since_epoch())
+                             .count();
+        fs::path history_file;
+        for (int suffix = 0;; ++suffix)
+        {
+            history_file = history_dir / Strings::format("%013lld-%d", static_cast<long long>(now), suffix);
+            if (!fs.exists(history_file)) break;
+        }
+
+        const auto tmp_file = history_dir / Strings::concat("incomplete-", history_file.filename().u8string());
+        fs.write_contents(tmp_file, contents, ec);
+        if (!ec) fs.rename(tmp_file, history_file, ec);
+        if (ec)
+        {
+            System::print2(System::Color::warning,
+                           "Warning: failed to record build history in ",
+                           history_dir.u8string(),
+                           ": ",
+                           ec.message(),
+                           '\n');
+        }
+    }
+
+    std::chrono::milliseconds percentile(std::vector<std::chrono::milliseconds>& durations, int percent)
+    {
+        Checks::check_exit(VCPKG_LINE_INFO, !durations.empty());
+        const size_t rank = (durations.size() * static_cast<size_t>(percent) + 99) / 100;
+        const auto nth = durations.begin() + (rank == 0 ? 0 : rank - 1);
+        std::nth_element(durations.begin(), nth, durations.end());
+        return *nth;
+    }
+
+    std::vector<Regression> find_regressions(const BuildHistory& history,
+                                             int threshold_percent,
+                                             std::chrono::milliseconds min_increase)
+    {
+        // The latest and the one before it, per spec
+        std::unordered_map<PackageSpec, std::pair<const BuildRecord*, const BuildRecord*>> last_two;
+        for (auto&& record : history.records())
+        {
+            if (!record.is_successful_build()) continue;
+            auto& entry = last_two[record.spec];
+            if (entry.first && entry.first->run != record.run) entry.second = entry.first;
+            entry.first = &record;
+        }
+
+        std::vector<Regression> regressions;
+        for (auto&& kv : last_two)
+        {
+            const auto latest = kv.second.first;
+            const auto previous = kv.second.second;
+            if (!previous) continue;
+
+            const auto increase = latest->duration - previous->duration;
+            if (increase < min_increase) continue;
+            if (increase.count() * 100 <= previous->duration.count() * threshold_percent) continue;
+
+            regressions.push_back({kv.first, previous->duration, latest->duration});
+        }
+
+        Util::sort(regressions, [](const Regression& lhs, const Regression& rhs) {
+            const auto lhs_increase = lhs.latest - lhs.previous;
+            const auto rhs_increase = rhs.latest - rhs.previous;
+            if (lhs_increase != rhs_increase) return lhs_increase > rhs_increase;
+            return lhs.spec < rhs.spec;
+        });
+        return regressions;
+    }
+}
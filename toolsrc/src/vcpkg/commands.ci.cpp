@@ -7,12 +7,15 @@
 #include <vcpkg/base/system.h>
 #include <vcpkg/base/util.h>
 #include <vcpkg/build.h>
+#include <vcpkg/buildfarm.h>
+#include <vcpkg/buildhistory.h>
 #include <vcpkg/commands.h>
 #include <vcpkg/dependencies.h>
 #include <vcpkg/globalstate.h>
 #include <vcpkg/help.h>
 #include <vcpkg/input.h>
 #include <vcpkg/install.h>
+#include <vcpkg/sharding.h>
 #include <vcpkg/vcpkglib.h>
 
 namespace vcpkg::Commands::CI
@@ -32,10 +35,27 @@ namespace vcpkg::Commands::CI
     static constexpr StringLiteral OPTION_PURGE_TOMBSTONES = "--purge-tombstones";
     static constexpr StringLiteral OPTION_XUNIT = "--x-xunit";
     static constexpr StringLiteral OPTION_RANDOMIZE = "--x-randomize";
+    static constexpr StringLiteral OPTION_SHARD = "--x-shard";
+    static constexpr StringLiteral OPTION_SHARD_HISTORY = "--x-shard-history";
+    static constexpr StringLiteral OPTION_COORDINATOR = "--x-coordinator";
+    static constexpr StringLiteral OPTION_MEMORY_BUDGET = "--x-memory-budget-mb";
+    static constexpr StringLiteral OPTION_MIN_AVAILABLE_MEMORY = "--x-min-available-memory-mb";
 
-    static constexpr std::array<CommandSetting, 2> CI_SETTINGS = {{
+    static constexpr std::array<CommandSetting, 7> CI_SETTINGS = {{
         {OPTION_EXCLUDE, "Comma separated list of ports to skip"},
         {OPTION_XUNIT, "File to output results in XUnit format (internal)"},
+        {OPTION_SHARD, "Only build shard i of N, written i/N (experimental)"},
+        {OPTION_SHARD_HISTORY,
+         "Build history shared by all shards, used to balance them by build time instead of port size "
+         "(experimental)"},
+        {OPTION_COORDINATOR,
+         "Queue directory through which `vcpkg x-worker` processes run the builds instead of this one (experimental)"},
+        {OPTION_MEMORY_BUDGET,
+         "With --x-coordinator, only queue builds while their predicted peak memory use adds up to at most this many "
+         "MB (experimental)"},
+        {OPTION_MIN_AVAILABLE_MEMORY,
+         "With --x-coordinator, hold back new builds while less than this many MB of memory are available "
+         "(experimental)"},
     }};
 
     static constexpr std::array<CommandSwitch, 3> CI_SWITCHES = {{
@@ -217,6 +237,8 @@ namespace vcpkg::Commands::CI
         std::map<PackageSpec, std::vector<std::string>> features;
         std::unordered_map<std::string, SourceControlFileLocation> default_feature_provider;
         std::map<PackageSpec, std::string> abi_tag_map;
+        std::map<PackageSpec, std::vector<PackageSpec>> dependencies;
+        std::map<PackageSpec, fs::path> port_dirs;
     };
 
     static std::unique_ptr<UnknownCIPortsResults> find_unknown_ports_for_ci(
@@ -231,7 +253,7 @@ namespace vcpkg::Commands::CI
 
         auto& fs = paths.get_filesystem();
 
-        std::set<PackageSpec> will_fail;
+        std::unordered_set<PackageSpec> will_fail;
 
         const Build::BuildPackageOptions build_options = {
             Build::UseHeadVersion::NO,
@@ -271,10 +293,13 @@ namespace vcpkg::Commands::CI
         {
             if (auto p = action.install_action.get())
             {
+                ret->dependencies.emplace(p->spec, p->package_dependencies);
+
                 // determine abi tag
                 std::string abi;
                 if (auto scfl = p->source_control_file_location.get())
                 {
+                    ret->port_dirs.emplace(p->spec, scfl->source_location);
                     auto emp = ret->default_feature_provider.emplace(p->spec.name(), *scfl);
                     emp.first->second.source_control_file->core_paragraph->default_features = p->feature_list;
 
@@ -317,11 +342,8 @@ namespace vcpkg::Commands::CI
 
                 std::string state;
 
-                auto archives_root_dir = paths.root / "archives";
-                auto archive_name = abi + ".zip";
-                auto archive_subpath = fs::u8path(abi.substr(0, 2)) / archive_name;
-                auto archive_path = archives_root_dir / archive_subpath;
-                auto archive_tombstone_path = archives_root_dir / "fail" / archive_subpath;
+                auto archive_path = Build::get_archive_path(paths, abi);
+                auto archive_tombstone_path = Build::get_archive_tombstone_path(paths, abi);
 
                 if (purge_tombstones)
                 {
@@ -369,6 +391,162 @@ namespace vcpkg::Commands::CI
         return ret;
     }
 
+    struct ShardPlan
+    {
+        /// <summary>
+        /// Ports this shard builds and reports results for.
+        /// </summary>
+        std::unordered_set<PackageSpec> owned;
+
+        /// <summary>
+        /// Owned ports and everything they depend on. Dependencies owned by other shards are restored from the
+        /// binary cache if they got there first, and built again otherwise.
+        /// </summary>
+        std::unordered_set<PackageSpec> installed;
+    };
+
+    static std::uint64_t port_files_size(const Files::Filesystem& fs, const fs::path& port_dir)
+    {
+        std::uint64_t total = 0;
+        for (auto&& file : fs.get_files_recursive(port_dir))
+        {
+            std::error_code ec;
+            const auto size = fs::stdfs::file_size(file, ec);
+            if (!ec) total += size;
+        }
+        return total;
+    }
+
+    static std::uint64_t get_megabytes_setting(const ParsedArguments& options, StringLiteral option)
+    {
+        auto it = options.settings.find(option);
+        if (it == options.settings.end()) return 0;
+
+        const auto& text = it->second;
+        const bool valid = !text.empty() && text.size() <= 9 &&
+                           std::all_of(text.begin(), text.end(), [](char c) { return c >= '0' && c <= '9'; });
+        Checks::check_exit(VCPKG_LINE_INFO, valid, "Value of %s must be a number of megabytes", option);
+        return std::stoull(text);
+    }
+
+    /// <summary>
+    /// Predicted peak memory use of every build in the plan: the build history's when it has seen the port build,
+    /// else the Peak-Memory-Mb hint from the port's CONTROL file.
+    /// </summary>
+    static std::map<PackageSpec, std::uint64_t> predict_peak_memory(
+        const std::vector<Dependencies::AnyAction>& action_plan, const BuildHistory::BuildHistory& history)
+    {
+        std::map<PackageSpec, std::uint64_t> peaks;
+        for (auto&& action : action_plan)
+        {
+            auto install_action = action.install_action.get();
+            if (!install_action) continue;
+
+            auto maybe_peak = history.predict_peak_rss_kb(install_action->spec);
+            if (auto peak = maybe_peak.get())
+            {
+                peaks.emplace(install_action->spec, *peak);
+                continue;
+            }
+
+            if (auto scfl = install_action->source_control_file_location.get())
+            {
+                auto maybe_hint = scfl->source_control_file->core_paragraph->peak_memory_mb;
+                if (auto hint = maybe_hint.get()) peaks.emplace(install_action->spec, *hint * 1024);
+            }
+        }
+        return peaks;
+    }
+
+    /// <summary>
+    /// Costs come from the shared build history when given, so that shards balance by build time; ports never built
+    /// before count as a median one. Otherwise the size of each port's files stands in for its build time.
+    /// </summary>
+    static std::vector<std::uint64_t> estimate_costs(const VcpkgPaths& paths,
+                                                     const UnknownCIPortsResults& ports,
+                                                     const std::vector<PackageSpec>& specs,
+                                                     const BuildHistory::BuildHistory* history)
+    {
+        std::vector<std::uint64_t> costs(specs.size(), 0);
+        if (history)
+        {
+            std::vector<bool> predicted(specs.size(), false);
+            std::vector<std::uint64_t> known;
+            for (size_t i = 0; i < specs.size(); ++i)
+            {
+                auto maybe_duration = history->predict_duration(specs[i]);
+                if (auto duration = maybe_duration.get())
+                {
+                    costs[i] = static_cast<std::uint64_t>(duration->count());
+                    predicted[i] = true;
+                    known.push_back(costs[i]);
+                }
+            }
+
+            if (!known.empty())
+            {
+                std::nth_element(known.begin(), known.begin() + known.size() / 2, known.end());
+                const auto median = known[known.size() / 2];
+                for (size_t i = 0; i < specs.size(); ++i)
+                {
+                    if (!predicted[i]) costs[i] = median;
+                }
+                return costs;
+            }
+        }
+
+        auto& fs = paths.get_filesystem();
+        for (size_t i = 0; i < specs.size(); ++i)
+        {
+            auto it = ports.port_dirs.find(specs[i]);
+            if (it != ports.port_dirs.end()) costs[i] = port_files_size(fs, it->second);
+        }
+        return costs;
+    }
+
+    /// <summary>
+    /// Splits the whole triplet, rather than only the ports missing from the binary cache, so that shards agree on
+    /// the split even when they start while others are still filling the cache.
+    /// </summary>
+    static ShardPlan plan_shard(const VcpkgPaths& paths,
+                                const UnknownCIPortsResults& ports,
+                                const Sharding::ShardIndex& shard,
+                                const BuildHistory::BuildHistory* history)
+    {
+        // Number the ports in spec order so every shard builds the same graph
+        std::vector<PackageSpec> specs;
+        std::map<PackageSpec, std::uint32_t> ids;
+        for (auto&& kv : ports.dependencies)
+        {
+            ids.emplace(kv.first, static_cast<std::uint32_t>(specs.size()));
+            specs.push_back(kv.first);
+        }
+
+        Graphs::CsrGraph graph;
+        for (auto&& kv : ports.dependencies)
+        {
+            const auto id = ids.at(kv.first);
+            graph.add_vertex(id);
+            for (auto&& dep : kv.second)
+            {
+                auto it = ids.find(dep);
+                if (it != ids.end() && it->second != id) graph.add_edge(id, it->second);
+            }
+        }
+        graph.freeze();
+
+        const auto owners = Sharding::assign_owners(graph, estimate_costs(paths, ports, specs, history), shard.count);
+        const auto installs = Sharding::shard_closure(graph, owners, shard.index);
+
+        ShardPlan plan;
+        for (std::uint32_t id = 0; id < specs.size(); ++id)
+        {
+            if (owners[id] == shard.index) plan.owned.insert(specs[id]);
+            if (installs[id]) plan.installed.insert(specs[id]);
+        }
+        return plan;
+    }
+
     void perform_and_exit(const VcpkgCmdArguments& args, const VcpkgPaths& paths, const Triplet& default_triplet)
     {
         if (!GlobalState::g_binary_caching)
@@ -389,6 +567,48 @@ namespace vcpkg::Commands::CI
         const auto is_dry_run = Util::Sets::contains(options.switches, OPTION_DRY_RUN);
         const auto purge_tombstones = Util::Sets::contains(options.switches, OPTION_PURGE_TOMBSTONES);
 
+        Optional<Sharding::ShardIndex> maybe_shard;
+        auto it_shard = options.settings.find(OPTION_SHARD);
+        if (it_shard != options.settings.end())
+        {
+            maybe_shard = Sharding::parse_shard(it_shard->second);
+            Checks::check_exit(VCPKG_LINE_INFO,
+                               maybe_shard.has_value(),
+                               "Value of %s must be i/N, where i is between 1 and N",
+                               OPTION_SHARD);
+        }
+
+        std::unique_ptr<BuildFarm::QueueDirectory> work_queue;
+        auto it_coordinator = options.settings.find(OPTION_COORDINATOR);
+        if (it_coordinator != options.settings.end() && !is_dry_run)
+        {
+            work_queue = std::make_unique<BuildFarm::QueueDirectory>(
+                paths.get_filesystem(), paths.original_cwd / fs::u8path(it_coordinator->second));
+            work_queue->reset();
+        }
+
+        Optional<BuildHistory::BuildHistory> maybe_shard_history;
+        auto it_shard_history = options.settings.find(OPTION_SHARD_HISTORY);
+        if (it_shard_history != options.settings.end())
+        {
+            maybe_shard_history =
+                BuildHistory::BuildHistory::load(paths.get_filesystem(), fs::u8path(it_shard_history->second));
+        }
+
+        BuildFarm::MemoryBudget memory_budget;
+        memory_budget.budget_kb = get_megabytes_setting(options, OPTION_MEMORY_BUDGET) * 1024;
+        memory_budget.min_available_kb = get_megabytes_setting(options, OPTION_MIN_AVAILABLE_MEMORY) * 1024;
+        Optional<BuildHistory::BuildHistory> maybe_memory_history;
+        if (work_queue && memory_budget.budget_kb != 0)
+        {
+            // The coordinator records the builds of its workers in its own history, unless a shared one is given
+            if (auto shard_history = maybe_shard_history.get())
+                maybe_memory_history = *shard_history;
+            else
+                maybe_memory_history =
+                    BuildHistory::BuildHistory::load(paths.get_filesystem(), paths.vcpkg_dir_history);
+        }
+
         std::vector<Triplet> triplets = Util::fmap(
             args.command_arguments, [](std::string s) { return Triplet::from_canonical_name(std::move(s)); });
 
@@ -466,6 +686,33 @@ namespace vcpkg::Commands::CI
             auto action_plan = Dependencies::PackageGraph::create_feature_install_plan(
                 new_default_provider, var_provider, split_specs->unknown, status_db, serialize_options);
 
+            Optional<ShardPlan> maybe_shard_plan;
+            if (auto shard = maybe_shard.get())
+            {
+                maybe_shard_plan = plan_shard(paths, *split_specs, *shard, maybe_shard_history.get());
+                const auto& shard_plan = *maybe_shard_plan.get();
+
+                Util::erase_remove_if(action_plan, [&](const Dependencies::AnyAction& action) {
+                    auto install_action = action.install_action.get();
+                    return install_action && !Util::Sets::contains(shard_plan.installed, install_action->spec);
+                });
+
+                for (auto it = split_specs->known.begin(); it != split_specs->known.end();)
+                {
+                    if (Util::Sets::contains(shard_plan.owned, it->first))
+                        ++it;
+                    else
+                        it = split_specs->known.erase(it);
+                }
+
+                System::printf("Shard %zd/%zd owns %zd of %zd ports\n",
+                               shard->index + 1,
+                               shard->count,
+                               shard_plan.owned.size(),
+                               split_specs->dependencies.size());
+            }
+            const auto shard_plan = maybe_shard_plan.get();
+
             for (auto&& action : action_plan)
             {
                 if (auto action_ptr = action.install_action.get())
@@ -488,12 +735,21 @@ namespace vcpkg::Commands::CI
             else
             {
                 auto collection_timer = Chrono::ElapsedTimer::create_started();
-                auto summary = Install::perform(action_plan, Install::KeepGoing::YES, paths, status_db, var_provider);
+                if (auto memory_history = maybe_memory_history.get())
+                {
+                    memory_budget.predicted_peak_kb = predict_peak_memory(action_plan, *memory_history);
+                }
+                auto summary =
+                    work_queue ? BuildFarm::coordinate(action_plan, paths, *work_queue, memory_budget)
+                               : Install::perform(action_plan, Install::KeepGoing::YES, paths, status_db, var_provider);
                 auto collection_time_elapsed = collection_timer.elapsed();
 
                 // Adding results for ports that were built or pulled from an archive
                 for (auto&& result : summary.results)
                 {
+                    // Dependencies owned by other shards are reported there
+                    if (shard_plan && !Util::Sets::contains(shard_plan->owned, result.spec)) continue;
+
                     auto& port_features = split_specs->features[result.spec];
                     split_specs->known.erase(result.spec);
                     xunitTestResults.add_test_results(result.spec.to_string(),
@@ -523,6 +779,7 @@ namespace vcpkg::Commands::CI
             }
         }
         xunitTestResults.assembly_time(timer.elapsed());
+        if (work_queue) work_queue->close();
 
         for (auto&& result : results)
         {
@@ -25,6 +25,7 @@ namespace vcpkg::Commands
             {"build-external", &BuildExternal::perform_and_exit},
             {"export", &Export::perform_and_exit},
             {"depend-info", &DependInfo::perform_and_exit},
+            {"edit", &Edit::perform_and_exit},
         };
         return t;
     }
@@ -39,7 +40,6 @@ namespace vcpkg::Commands
             {"integrate", &Integrate::perform_and_exit},
             {"owns", &Owns::perform_and_exit},
             {"update", &Update::perform_and_exit},
-            {"edit", &Edit::perform_and_exit},
             {"create", &Create::perform_and_exit},
             {"import", &Import::perform_and_exit},
             {"cache", &Cache::perform_and_exit},
@@ -49,6 +49,8 @@ namespace vcpkg::Commands
             {"fetch", &Fetch::perform_and_exit},
             {"x-history", &PortHistory::perform_and_exit},
             {"x-vsinstances", &X_VSInstances::perform_and_exit},
+            {"x-merge-xunit", &X_MergeXunit::perform_and_exit},
+            {"x-worker", &X_Worker::perform_and_exit},
         };
         return t;
     }
@@ -1,5 +1,6 @@
 #include "pch.h"
 
+#include <vcpkg/base/graphs.h>
 #include <vcpkg/base/strings.h>
 #include <vcpkg/base/system.print.h>
 #include <vcpkg/base/util.h>
@@ -172,34 +173,11 @@ namespace vcpkg::Commands::DependInfo
             return "";
         }
 
-        void assign_depth_to_dependencies(const std::string& package,
-                                          const int depth,
-                                          const int max_depth,
-                                          std::map<std::string, PackageDependInfo>& dependencies_map)
-        {
-            auto iter = dependencies_map.find(package);
-            Checks::check_exit(
-                VCPKG_LINE_INFO, iter != dependencies_map.end(), "Package not found in dependency graph");
-
-            PackageDependInfo& info = iter->second;
-
-            if (depth > info.depth)
-            {
-                info.depth = depth;
-                if (depth < max_depth || max_depth == NO_RECURSE_LIMIT_VALUE)
-                {
-                    for (auto&& dependency : info.dependencies)
-                    {
-                        assign_depth_to_dependencies(dependency, depth + 1, max_depth, dependencies_map);
-                    }
-                }
-            }
-        }
-
         std::vector<PackageDependInfo> extract_depend_info(const std::vector<const InstallPlanAction*>& install_actions,
                                                            const int max_depth)
         {
-            std::map<std::string, PackageDependInfo> package_dependencies;
+            std::vector<PackageDependInfo> package_dependencies;
+            Graphs::Interner<std::string> ids;
             for (const InstallPlanAction* pia : install_actions)
             {
                 const InstallPlanAction& install_action = *pia;
@@ -212,18 +190,44 @@ namespace vcpkg::Commands::DependInfo
                 features.erase("core");
 
                 std::string port_name = install_action.spec.name();
+                if (!ids.intern(port_name).second) continue;
 
                 PackageDependInfo info{port_name, -1, features, dependencies};
-                package_dependencies.emplace(port_name, std::move(info));
+                package_dependencies.push_back(std::move(info));
             }
 
-            const InstallPlanAction& init = *install_actions.back();
-            assign_depth_to_dependencies(init.spec.name(), 0, max_depth, package_dependencies);
+            // Edges point from each package to the packages that depend on it, so that the requested packages
+            // end up on level 0 and each dependency one level below the deepest package using it.
+            Graphs::CsrGraph dependents;
+            for (std::uint32_t id = 0; id < package_dependencies.size(); ++id)
+            {
+                dependents.add_vertex(id);
+                for (auto&& dependency : package_dependencies[id].dependencies)
+                {
+                    auto maybe_dep_id = ids.find(dependency);
+                    auto dep_id = maybe_dep_id.get();
+                    Checks::check_exit(VCPKG_LINE_INFO, dep_id != nullptr, "Package not found in dependency graph");
+                    dependents.add_edge(*dep_id, id);
+                }
+            }
+            dependents.freeze();
 
-            std::vector<PackageDependInfo> out =
-                Util::fmap(package_dependencies, [](auto&& kvpair) -> PackageDependInfo { return kvpair.second; });
-            Util::erase_remove_if(out, [](auto&& info) { return info.depth < 0; });
-            return out;
+            const auto levels = Graphs::leveled_topological_sort(
+                dependents, [&](std::uint32_t id) -> const std::string& { return ids[id]; });
+
+            for (std::uint32_t id = 0; id < package_dependencies.size(); ++id)
+            {
+                package_dependencies[id].depth = static_cast<int>(levels.level[id]);
+            }
+
+            if (max_depth != NO_RECURSE_LIMIT_VALUE)
+            {
+                Util::erase_remove_if(package_dependencies, [&](auto&& info) { return info.depth > max_depth; });
+            }
+            std::sort(package_dependencies.begin(), package_dependencies.end(), [](auto&& lhs, auto&& rhs) {
+                return lhs.package < rhs.package;
+            });
+            return package_dependencies;
         }
     }
 
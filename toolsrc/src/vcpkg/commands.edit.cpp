@@ -72,8 +72,15 @@ namespace vcpkg::Commands::Edit
 
     static std::vector<std::string> create_editor_arguments(const VcpkgPaths& paths,
                                                             const ParsedArguments& options,
-                                                            const std::vector<std::string>& ports)
+                                                            const std::vector<std::string>& ports,
+                                                            const Triplet& default_triplet)
     {
+        // The buildtree of a port built for the default triplet
+        const auto buildtrees_dir_of = [&](const std::string& port_name) {
+            return paths.buildtrees_dir(
+                PackageSpec::from_name_and_triplet(port_name, default_triplet).value_or_exit(VCPKG_LINE_INFO));
+        };
+
         if (Util::Sets::contains(options.switches, OPTION_ALL))
         {
             const auto& fs = paths.get_filesystem();
@@ -83,7 +90,7 @@ namespace vcpkg::Commands::Edit
             return Util::fmap(ports, [&](const std::string& port_name) -> std::string {
                 const auto portpath = paths.ports / port_name;
                 const auto portfile = portpath / "portfile.cmake";
-                const auto buildtrees_current_dir = paths.buildtrees / port_name;
+                const auto buildtrees_current_dir = buildtrees_dir_of(port_name);
                 const auto pattern = port_name + "_";
 
                 std::string package_paths;
@@ -106,7 +113,7 @@ namespace vcpkg::Commands::Edit
         if (Util::Sets::contains(options.switches, OPTION_BUILDTREES))
         {
             return Util::fmap(ports, [&](const std::string& port_name) -> std::string {
-                const auto buildtrees_current_dir = paths.buildtrees / port_name;
+                const auto buildtrees_current_dir = buildtrees_dir_of(port_name);
                 return Strings::format(R"###("%s")###", buildtrees_current_dir.u8string());
             });
         }
@@ -118,7 +125,7 @@ namespace vcpkg::Commands::Edit
         });
     }
 
-    void perform_and_exit(const VcpkgCmdArguments& args, const VcpkgPaths& paths)
+    void perform_and_exit(const VcpkgCmdArguments& args, const VcpkgPaths& paths, const Triplet& default_triplet)
     {
         auto& fs = paths.get_filesystem();
 
@@ -221,7 +228,7 @@ namespace vcpkg::Commands::Edit
         }
 
         const fs::path env_editor = *it;
-        const std::vector<std::string> arguments = create_editor_arguments(paths, options, ports);
+        const std::vector<std::string> arguments = create_editor_arguments(paths, options, ports, default_triplet);
         const auto args_as_string = Strings::join(" ", arguments);
         const auto cmd_line = Strings::format(R"("%s" %s -n)", env_editor.u8string(), args_as_string);
 
@@ -0,0 +1,135 @@
+#include "pch.h"
+
+#include <vcpkg/base/chrono.h>
+#include <vcpkg/base/system.print.h>
+#include <vcpkg/base/util.h>
+#include <vcpkg/buildhistory.h>
+#include <vcpkg/commands.h>
+#include <vcpkg/help.h>
+
+#include <map>
+
+namespace vcpkg::Commands::HistoryStats
+{
+    static constexpr StringLiteral OPTION_THRESHOLD = "--regression-threshold";
+
+    static constexpr std::array<CommandSetting, 1> HISTORY_STATS_SETTINGS = {{
+        {OPTION_THRESHOLD, "Percentage by which a build must have slowed down to be reported (default 20)"},
+    }};
+
+    const CommandStructure COMMAND_STRUCTURE = {
+        Help::create_example_string("x-history stats [port]"),
+        1,
+        2,
+        {{}, HISTORY_STATS_SETTINGS},
+        nullptr,
+    };
+
+    // Builds that got only this much slower are noise rather than regressions
+    static constexpr std::chrono::seconds MIN_REGRESSION{10};
+
+    static std::string format_duration(std::chrono::milliseconds ms)
+    {
+        return Chrono::ElapsedTime(std::chrono::duration_cast<std::chrono::nanoseconds>(ms)).to_string();
+    }
+
+    static int get_threshold(const ParsedArguments& options)
+    {
+        auto iter = options.settings.find(OPTION_THRESHOLD);
+        if (iter == options.settings.end()) return 20;
+
+        try
+        {
+            return std::stoi(iter->second);
+        }
+        catch (const std::exception&)
+        {
+            Checks::exit_with_message(VCPKG_LINE_INFO, "Value of %s must be an integer", OPTION_THRESHOLD);
+        }
+    }
+
+    void perform_and_exit(const VcpkgCmdArguments& args, const VcpkgPaths& paths)
+    {
+        const ParsedArguments options = args.parse_arguments(COMMAND_STRUCTURE);
+        const int threshold = get_threshold(options);
+        const std::string port_filter = args.command_arguments.size() > 1 ? args.command_arguments.at(1) : "";
+
+        const auto history = BuildHistory::BuildHistory::load(paths.get_filesystem(), paths.vcpkg_dir_history);
+        std::vector<BuildHistory::BuildRecord> records = history.records();
+        if (!port_filter.empty())
+        {
+            Util::erase_remove_if(records, [&](const BuildHistory::BuildRecord& r) {
+                return r.spec.name() != port_filter;
+            });
+        }
+
+        if (records.empty())
+        {
+            System::print2("No builds recorded in ", paths.vcpkg_dir_history.u8string(), "\n");
+            Checks::exit_success(VCPKG_LINE_INFO);
+        }
+
+        std::map<PackageSpec, std::vector<std::chrono::milliseconds>> durations;
+        size_t restored = 0;
+        size_t restored_last_run = 0;
+        size_t total_last_run = 0;
+        for (auto&& record : records)
+        {
+            if (record.is_successful_build()) durations[record.spec].push_back(record.duration);
+            if (record.restored_from_cache) ++restored;
+            if (record.run == records.back().run)
+            {
+                ++total_last_run;
+                if (record.restored_from_cache) ++restored_last_run;
+            }
+        }
+
+        System::printf("%zu builds recorded\n", records.size());
+        System::printf("Binary cache hit rate: %zu/%zu (%.0f%%), last run %zu/%zu (%.0f%%)\n\n",
+                       restored,
+                       records.size(),
+                       100.0 * restored / records.size(),
+                       restored_last_run,
+                       total_last_run,
+                       100.0 * restored_last_run / total_last_run);
+
+        if (!durations.empty())
+        {
+            System::printf("%-40s %6s %12s %12s\n", "package", "builds", "p50", "p95");
+            for (auto&& kv : durations)
+            {
+                auto samples = kv.second;
+                const auto p50 = BuildHistory::percentile(samples, 50);
+                const auto p95 = BuildHistory::percentile(samples, 95);
+                System::printf("%-40s %6zd %12s %12s\n",
+                               kv.first.to_string(),
+                               kv.second.size(),
+                               format_duration(p50),
+                               format_duration(p95));
+            }
+        }
+
+        auto regressions = BuildHistory::find_regressions(history, threshold, MIN_REGRESSION);
+        if (!port_filter.empty())
+        {
+            Util::erase_remove_if(regressions, [&](const BuildHistory::Regression& r) {
+                return r.spec.name() != port_filter;
+            });
+        }
+
+        if (!regressions.empty())
+        {
+            System::printf("\nSlower by more than %d%% than in an earlier run:\n", threshold);
+            for (auto&& regression : regressions)
+            {
+                System::printf(System::Color::warning,
+                               "    %s: %s -> %s\n",
+                               regression.spec,
+                               format_duration(regression.previous),
+                               format_duration(regression.latest));
+            }
+        }
+
+        Checks::exit_success(VCPKG_LINE_INFO);
+    }
+}
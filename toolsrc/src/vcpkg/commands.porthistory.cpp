@@ -77,6 +77,12 @@ namespace vcpkg::Commands::PortHistory
 
     void perform_and_exit(const VcpkgCmdArguments& args, const VcpkgPaths& paths)
     {
+        // "stats" is not a port; it queries the history of local builds instead of the ports tree
+        if (!args.command_arguments.empty() && args.command_arguments.at(0) == "stats")
+        {
+            HistoryStats::perform_and_exit(args, paths);
+        }
+
         Util::unused(args.parse_arguments(COMMAND_STRUCTURE));
 
         std::string port_name = args.command_arguments.at(0);
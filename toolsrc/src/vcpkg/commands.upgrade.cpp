@@ -166,14 +166,19 @@ namespace vcpkg::Commands::Upgrade
         };
 
         // Set build settings for all install actions
+        std::vector<FullPackageSpec> install_package_specs;
         for (auto&& action : action_plan)
         {
             if (auto p_install = action.install_action.get())
             {
                 p_install->build_options = install_plan_options;
+                install_package_specs.emplace_back(FullPackageSpec{p_install->spec, p_install->feature_list});
             }
         }
 
+        // The builds, and finding binary cache hits before they start, need each package's triplet variables
+        var_provider.load_tag_vars(install_package_specs, provider);
+
         Dependencies::print_plan(action_plan, true, paths.ports);
 
         if (!no_dry_run)
@@ -193,6 +198,10 @@ namespace vcpkg::Commands::Upgrade
         {
             summary.print();
         }
+        else
+        {
+            summary.print_warnings();
+        }
 
         Checks::exit_success(VCPKG_LINE_INFO);
     }
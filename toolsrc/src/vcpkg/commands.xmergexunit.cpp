@@ -0,0 +1,37 @@
+#include "pch.h"
+
+#include <vcpkg/base/files.h>
+#include <vcpkg/base/system.print.h>
+#include <vcpkg/base/util.h>
+#include <vcpkg/commands.h>
+#include <vcpkg/help.h>
+#include <vcpkg/sharding.h>
+
+namespace vcpkg::Commands::X_MergeXunit
+{
+    const CommandStructure COMMAND_STRUCTURE = {
+        Help::create_example_string("x-merge-xunit all.xml shard1.xml shard2.xml"),
+        2,
+        SIZE_MAX,
+        {{}, {}},
+        nullptr,
+    };
+
+    void perform_and_exit(const VcpkgCmdArguments& args, const VcpkgPaths& paths)
+    {
+        args.parse_arguments(COMMAND_STRUCTURE);
+
+        auto& fs = paths.get_filesystem();
+        std::vector<std::string> documents;
+        for (size_t i = 1; i < args.command_arguments.size(); ++i)
+        {
+            documents.push_back(fs.read_contents(fs::u8path(args.command_arguments[i])).value_or_exit(VCPKG_LINE_INFO));
+        }
+
+        const auto output = fs::u8path(args.command_arguments[0]);
+        fs.write_contents(output, Sharding::merge_xunit(documents), VCPKG_LINE_INFO);
+        System::print2("Merged ", documents.size(), " result files into ", output.u8string(), "\n");
+
+        Checks::exit_success(VCPKG_LINE_INFO);
+    }
+}
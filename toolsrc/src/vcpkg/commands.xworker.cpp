@@ -0,0 +1,34 @@
+#include "pch.h"
+
+#include <vcpkg/base/system.print.h>
+#include <vcpkg/buildfarm.h>
+#include <vcpkg/commands.h>
+#include <vcpkg/help.h>
+
+namespace vcpkg::Commands::X_Worker
+{
+    const CommandStructure COMMAND_STRUCTURE = {
+        Strings::format("Builds the ports queued by `vcpkg ci --x-coordinator=<queue-dir>` until it finishes.\n"
+                        "Every worker needs its own worker directory.\n%s",
+                        Help::create_example_string("x-worker <queue-dir> <worker-dir>")),
+        2,
+        2,
+        {{}, {}},
+        nullptr,
+    };
+
+    void perform_and_exit(const VcpkgCmdArguments& args, const VcpkgPaths& paths)
+    {
+        args.parse_arguments(COMMAND_STRUCTURE);
+
+        // vcpkg has already changed into its root
+        const auto queue_root = paths.original_cwd / fs::u8path(args.command_arguments[0]);
+        const auto worker_root = paths.original_cwd / fs::u8path(args.command_arguments[1]);
+
+        BuildFarm::QueueDirectory queue(paths.get_filesystem(), queue_root);
+        BuildFarm::run_worker(args, paths, queue, worker_root);
+
+        System::print2("The coordinator has finished\n");
+        Checks::exit_success(VCPKG_LINE_INFO);
+    }
+}
@@ -12,6 +12,8 @@
 #include <vcpkg/vcpkglib.h>
 #include <vcpkg/vcpkgpaths.h>
 
+#include <deque>
+
 namespace vcpkg::Dependencies
 {
     namespace
@@ -28,7 +30,9 @@ namespace vcpkg::Dependencies
             }
 
             InstalledPackageView ipv;
-            std::unordered_set<PackageSpec> remove_edges;
+
+            // Ids of the installed clusters which depend on this one
+            std::vector<std::uint32_t> remove_edges;
             std::unordered_set<std::string> original_features;
         };
 
@@ -112,13 +116,15 @@ namespace vcpkg::Dependencies
                     {
                         if (dep.qualifier.empty())
                         {
+                            auto dep_spec = PackageSpec::from_name_and_triplet(dep.depend.name, m_spec.triplet())
+                                                .value_or_exit(VCPKG_LINE_INFO);
                             for (const std::string& dep_feature : dep.depend.features)
                             {
-                                dep_list.emplace_back(
-                                    PackageSpec::from_name_and_triplet(dep.depend.name, m_spec.triplet())
-                                        .value_or_exit(VCPKG_LINE_INFO),
-                                    dep_feature);
+                                dep_list.emplace_back(dep_spec, dep_feature);
                             }
+
+                            // Match filter_dependencies_to_specs(): a dependency without features means its core
+                            if (dep.depend.features.empty()) dep_list.emplace_back(dep_spec, "core");
                         }
                     }
                 }
@@ -168,36 +174,30 @@ namespace vcpkg::Dependencies
             RequestType request_type = RequestType::AUTO_SELECTED;
             bool visited = false;
         };
-
-        struct ClusterPtr
-        {
-            Cluster* ptr;
-
-            Cluster* operator->() const { return ptr; }
-        };
-
-        bool operator==(const ClusterPtr& l, const ClusterPtr& r) { return l.ptr == r.ptr; }
     }
-}
 
-namespace std
-{
-    template<>
-    struct hash<vcpkg::Dependencies::ClusterPtr>
+    /// <summary>
+    /// A package and one of its features, as ids interned by a ClusterGraph.
+    /// </summary>
+    struct ClusterFeature
     {
-        size_t operator()(const vcpkg::Dependencies::ClusterPtr& value) const
+        std::uint32_t cluster;
+        std::uint32_t feature;
+
+        bool operator==(const ClusterFeature& rhs) const { return cluster == rhs.cluster && feature == rhs.feature; }
+        bool operator<(const ClusterFeature& rhs) const
         {
-            return std::hash<vcpkg::PackageSpec>()(value.ptr->m_spec);
+            return cluster < rhs.cluster || (cluster == rhs.cluster && feature < rhs.feature);
         }
     };
-}
 
-namespace vcpkg::Dependencies
-{
+    /// <summary>
+    /// Edges between clusters, by cluster id. Both graphs are frozen when the plan is serialized.
+    /// </summary>
     struct GraphPlan
     {
-        Graphs::Graph<ClusterPtr> remove_graph;
-        Graphs::Graph<ClusterPtr> install_graph;
+        Graphs::CsrGraph remove_graph;
+        Graphs::CsrGraph install_graph;
     };
 
     /// <summary>
@@ -205,38 +205,41 @@ namespace vcpkg::Dependencies
     /// </summary>
     struct ClusterGraph : Util::MoveOnlyBase
     {
+        /// <summary>
+        /// "core" is the first feature interned by every ClusterGraph.
+        /// </summary>
+        static constexpr std::uint32_t CORE_FEATURE = 0;
+
         explicit ClusterGraph(const PortFileProvider::PortFileProvider& port_provider) : m_port_provider(port_provider)
         {
+            m_features.intern("core");
         }
 
         /// <summary>
         ///     Find the cluster associated with spec or if not found, create it from the PortFileProvider.
         /// </summary>
         /// <param name="spec">Package spec to get the cluster for.</param>
-        /// <returns>The cluster found or created for spec.</returns>
-        Cluster& get(const PackageSpec& spec)
+        /// <returns>The id of the cluster found or created for spec.</returns>
+        std::uint32_t find_or_create(const PackageSpec& spec)
         {
-            auto it = m_graph.find(spec);
-            if (it == m_graph.end())
+            auto interned = m_specs.intern(spec);
+            if (interned.second)
             {
                 const SourceControlFileLocation* scfl = m_port_provider.get_control_file(spec.name()).get();
 
                 Checks::check_exit(
                     VCPKG_LINE_INFO, scfl, "Error: Cannot find definition for package `%s`.", spec.name());
 
-                return m_graph
-                    .emplace(std::piecewise_construct, std::forward_as_tuple(spec), std::forward_as_tuple(spec, *scfl))
-                    .first->second;
+                m_clusters.emplace_back(spec, *scfl);
             }
 
-            return it->second;
+            return interned.first;
         }
 
-        Cluster& get(const InstalledPackageView& ipv)
+        std::uint32_t find_or_create(const InstalledPackageView& ipv)
         {
-            auto it = m_graph.find(ipv.spec());
-
-            if (it == m_graph.end())
+            auto interned = m_specs.intern(ipv.spec());
+            if (interned.second)
             {
                 Optional<const SourceControlFileLocation&> maybe_scfl =
                     m_port_provider.get_control_file(ipv.spec().name());
@@ -249,23 +252,36 @@ namespace vcpkg::Dependencies
                                               ipv.spec().to_string(),
                                               "\" and re-attempt.");
 
-                return m_graph
-                    .emplace(std::piecewise_construct,
-                             std::forward_as_tuple(ipv.spec()),
-                             std::forward_as_tuple(ipv, *maybe_scfl.get()))
-                    .first->second;
+                m_clusters.emplace_back(ipv, *maybe_scfl.get());
             }
-
-            if (!it->second.m_installed)
+            else if (!m_clusters[interned.first].m_installed)
             {
-                it->second.m_installed = {ipv};
+                m_clusters[interned.first].m_installed = {ipv};
             }
 
-            return it->second;
+            return interned.first;
+        }
+
+        Cluster& get(std::uint32_t id) { return m_clusters[id]; }
+
+        Cluster& get(const PackageSpec& spec) { return m_clusters[find_or_create(spec)]; }
+
+        std::uint32_t feature_id(const std::string& feature) { return m_features.intern(feature).first; }
+
+        const std::string& feature_name(std::uint32_t id) const { return m_features[id]; }
+
+        ClusterFeature intern(const FeatureSpec& spec)
+        {
+            return {find_or_create(spec.spec()), feature_id(spec.feature())};
         }
 
     private:
-        std::unordered_map<PackageSpec, Cluster> m_graph;
+        Graphs::Interner<PackageSpec> m_specs;
+        Graphs::Interner<std::string> m_features;
+
+        // Indexed by cluster id. A deque keeps references to clusters valid while the graph grows.
+        std::deque<Cluster> m_clusters;
+
         const PortFileProvider::PortFileProvider& m_port_provider;
     };
 
@@ -459,14 +475,12 @@ namespace vcpkg::Dependencies
     {
         struct RemoveAdjacencyProvider final : Graphs::AdjacencyProvider<PackageSpec, RemovePlanAction>
         {
-            const StatusParagraphs& status_db;
-            const std::vector<InstalledPackageView>& installed_ports;
+            const std::unordered_map<PackageSpec, std::vector<PackageSpec>>& dependents;
             const std::unordered_set<PackageSpec>& specs_as_set;
 
-            RemoveAdjacencyProvider(const StatusParagraphs& status_db,
-                                    const std::vector<InstalledPackageView>& installed_ports,
+            RemoveAdjacencyProvider(const std::unordered_map<PackageSpec, std::vector<PackageSpec>>& dependents,
                                     const std::unordered_set<PackageSpec>& specs_as_set)
-                : status_db(status_db), installed_ports(installed_ports), specs_as_set(specs_as_set)
+                : dependents(dependents), specs_as_set(specs_as_set)
             {
             }
 
@@ -477,18 +491,8 @@ namespace vcpkg::Dependencies
                     return {};
                 }
 
-                const PackageSpec& spec = plan.spec;
-                std::vector<PackageSpec> dependents;
-                for (auto&& ipv : installed_ports)
-                {
-                    auto deps = ipv.dependencies();
-
-                    if (std::find(deps.begin(), deps.end(), spec) == deps.end()) continue;
-
-                    dependents.push_back(ipv.spec());
-                }
-
-                return dependents;
+                const auto it = dependents.find(plan.spec);
+                return it == dependents.end() ? std::vector<PackageSpec>{} : it->second;
             }
 
             RemovePlanAction load_vertex_data(const PackageSpec& spec) const override
@@ -496,8 +500,7 @@ namespace vcpkg::Dependencies
                 const RequestType request_type = specs_as_set.find(spec) != specs_as_set.end()
                                                      ? RequestType::USER_REQUESTED
                                                      : RequestType::AUTO_SELECTED;
-                const StatusParagraphs::const_iterator it = status_db.find_installed(spec);
-                if (it == status_db.end())
+                if (dependents.find(spec) == dependents.end())
                 {
                     return RemovePlanAction{spec, RemovePlanType::NOT_INSTALLED, request_type};
                 }
@@ -507,9 +510,26 @@ namespace vcpkg::Dependencies
             std::string to_string(const PackageSpec& spec) const override { return spec.to_string(); }
         };
 
-        auto installed_ports = get_installed_ports(status_db);
+        // Every installed port, with the installed ports that depend on it; looking them up port by port would take
+        // time quadratic in the number installed. The keys are exactly the installed ports, so dependencies which are
+        // not installed are left out.
+        std::unordered_map<PackageSpec, std::vector<PackageSpec>> dependents;
+        const auto installed_ports = get_installed_ports(status_db);
+        for (auto&& ipv : installed_ports)
+            dependents[ipv.spec()];
+        for (auto&& ipv : installed_ports)
+        {
+            for (auto&& dep : ipv.dependencies())
+            {
+                const auto it = dependents.find(dep);
+                if (it == dependents.end()) continue;
+                auto& list = it->second;
+                if (list.empty() || list.back() != ipv.spec()) list.push_back(ipv.spec());
+            }
+        }
+
         const std::unordered_set<PackageSpec> specs_as_set(specs.cbegin(), specs.cend());
-        return Graphs::topological_sort(specs, RemoveAdjacencyProvider{status_db, installed_ports, specs_as_set}, {});
+        return Graphs::topological_sort(specs, RemoveAdjacencyProvider{dependents, specs_as_set}, {});
     }
 
     std::vector<ExportPlanAction> PackageGraph::create_export_plan(const std::vector<PackageSpec>& specs,
@@ -517,11 +537,12 @@ namespace vcpkg::Dependencies
     {
         struct ExportAdjacencyProvider final : Graphs::AdjacencyProvider<PackageSpec, ExportPlanAction>
         {
-            const StatusParagraphs& status_db;
+            const std::unordered_map<PackageSpec, InstalledPackageView>& installed;
             const std::unordered_set<PackageSpec>& specs_as_set;
 
-            ExportAdjacencyProvider(const StatusParagraphs& s, const std::unordered_set<PackageSpec>& specs_as_set)
-                : status_db(s), specs_as_set(specs_as_set)
+            ExportAdjacencyProvider(const std::unordered_map<PackageSpec, InstalledPackageView>& installed,
+                                    const std::unordered_set<PackageSpec>& specs_as_set)
+                : installed(installed), specs_as_set(specs_as_set)
             {
             }
 
@@ -536,11 +557,10 @@ namespace vcpkg::Dependencies
                                                      ? RequestType::USER_REQUESTED
                                                      : RequestType::AUTO_SELECTED;
 
-                auto maybe_ipv = status_db.find_all_installed(spec);
-
-                if (auto p_ipv = maybe_ipv.get())
+                const auto it = installed.find(spec);
+                if (it != installed.end())
                 {
-                    return ExportPlanAction{spec, std::move(*p_ipv), request_type};
+                    return ExportPlanAction{spec, InstalledPackageView(it->second), request_type};
                 }
 
                 return ExportPlanAction{spec, request_type};
@@ -549,9 +569,17 @@ namespace vcpkg::Dependencies
             std::string to_string(const PackageSpec& spec) const override { return spec.to_string(); }
         };
 
+        // Searching the status database for every port would take time quadratic in the number installed
+        std::unordered_map<PackageSpec, InstalledPackageView> installed;
+        for (auto&& ipv : get_installed_ports(status_db))
+        {
+            const auto spec = ipv.spec();
+            installed.emplace(spec, std::move(ipv));
+        }
+
         const std::unordered_set<PackageSpec> specs_as_set(specs.cbegin(), specs.cend());
         std::vector<ExportPlanAction> toposort =
-            Graphs::topological_sort(specs, ExportAdjacencyProvider{status_db, specs_as_set}, {});
+            Graphs::topological_sort(specs, ExportAdjacencyProvider{installed, specs_as_set}, {});
         return toposort;
     }
 
@@ -593,11 +621,10 @@ namespace vcpkg::Dependencies
         return pgraph.serialize(options);
     }
 
-    std::vector<FeatureSpec> PackageGraph::graph_installs(const PackageSpec& spec,
-                                                          const std::vector<FeatureSpec>& new_dependencies)
+    std::vector<ClusterFeature> PackageGraph::graph_installs(std::uint32_t cluster,
+                                                             const std::vector<ClusterFeature>& new_dependencies)
     {
-        std::vector<FeatureSpec> next_dependencies;
-        Cluster& clust = m_graph->get(spec);
+        std::vector<ClusterFeature> next_dependencies;
 
         // Create graph vertices for each of our dependencies and create an edge from us to each of our
         // dependencies. If our dependency's cluster hasn't been visited in the past, add its default
@@ -605,66 +632,80 @@ namespace vcpkg::Dependencies
         // features or not. For a feature with qualified dependencies we can enter the body of this loop up
         // to twice. Once to collect all the unqualified dependencies and once after we've run the triplet
         // to collect dependency information for qualified dependencies.
-        for (const FeatureSpec& dep_spec : new_dependencies)
+        for (const ClusterFeature& dep : new_dependencies)
         {
-            Cluster& dep_clust = m_graph->get(dep_spec.spec());
+            Cluster& dep_clust = m_graph->get(dep.cluster);
 
             if (!dep_clust.visited)
             {
                 dep_clust.visited = true;
-                m_graph_plan->install_graph.add_vertex({&dep_clust});
+                m_graph_plan->install_graph.add_vertex(dep.cluster);
 
-                // Add default features
-                for (const std::string& feature :
-                     dep_clust.m_scfl.source_control_file->core_paragraph->default_features)
+                // Add default features, unless the dependency is already installed with the features the user chose
+                if (!dep_clust.m_installed.has_value())
                 {
-                    // Instead of dealing with adding default features to each of our dependencies right
-                    // away we just defer to the next pass of the loop.
-                    next_dependencies.emplace_back(dep_spec.spec(), feature);
+                    for (const std::string& feature :
+                         dep_clust.m_scfl.source_control_file->core_paragraph->default_features)
+                    {
+                        // Instead of dealing with adding default features to each of our dependencies right
+                        // away we just defer to the next pass of the loop.
+                        next_dependencies.push_back({dep.cluster, m_graph->feature_id(feature)});
+                    }
                 }
 
-                next_dependencies.emplace_back(dep_spec.spec(), "core");
+                next_dependencies.push_back({dep.cluster, ClusterGraph::CORE_FEATURE});
             }
 
-            if (dep_spec.spec() != clust.m_spec)
+            if (dep.cluster != cluster)
             {
-                m_graph_plan->install_graph.add_edge({&clust}, {&dep_clust});
+                m_graph_plan->install_graph.add_edge(cluster, dep.cluster);
             }
         }
 
         return next_dependencies;
     }
 
-    std::vector<FeatureSpec> PackageGraph::graph_removals(const PackageSpec& first_remove_spec)
+    std::vector<ClusterFeature> PackageGraph::graph_removals(std::uint32_t first_remove_cluster)
     {
-        std::vector<PackageSpec> to_remove{first_remove_spec};
-        std::vector<FeatureSpec> removed;
+        std::vector<std::uint32_t> to_remove{first_remove_cluster};
+        std::vector<ClusterFeature> removed;
 
         while (!to_remove.empty())
         {
-            PackageSpec remove_spec = std::move(to_remove.back());
+            const std::uint32_t remove_cluster = to_remove.back();
             to_remove.pop_back();
 
-            Cluster& clust = m_graph->get(remove_spec);
+            Cluster& clust = m_graph->get(remove_cluster);
             ClusterInstalled& info = clust.m_installed.value_or_exit(VCPKG_LINE_INFO);
 
-            m_graph_plan->remove_graph.add_vertex({&clust});
+            m_graph_plan->remove_graph.add_vertex(remove_cluster);
 
             for (const std::string& orig_feature : info.original_features)
             {
-                removed.emplace_back(remove_spec, orig_feature);
+                removed.push_back({remove_cluster, m_graph->feature_id(orig_feature)});
             }
 
-            for (const PackageSpec& new_remove_spec : info.remove_edges)
+            // Features which became default after the port was installed are added when it is rebuilt
+            const auto& installed_defaults = info.ipv.core->package.default_features;
+            for (const std::string& default_feature :
+                 clust.m_scfl.source_control_file->core_paragraph->default_features)
             {
-                Cluster& depend_cluster = m_graph->get(new_remove_spec);
+                if (Util::find(installed_defaults, default_feature) == installed_defaults.end())
+                {
+                    removed.push_back({remove_cluster, m_graph->feature_id(default_feature)});
+                }
+            }
+
+            for (const std::uint32_t new_remove_cluster : info.remove_edges)
+            {
+                Cluster& depend_cluster = m_graph->get(new_remove_cluster);
                 if (!depend_cluster.m_install_info)
                 {
                     depend_cluster.m_install_info = make_optional(ClusterInstallInfo{});
-                    to_remove.emplace_back(new_remove_spec);
+                    to_remove.push_back(new_remove_cluster);
                 }
 
-                m_graph_plan->remove_graph.add_edge({&clust}, {&depend_cluster});
+                m_graph_plan->remove_graph.add_edge(remove_cluster, new_remove_cluster);
             }
         }
 
@@ -673,17 +714,18 @@ namespace vcpkg::Dependencies
 
     void PackageGraph::install(Span<const FeatureSpec> specs)
     {
-        std::vector<FeatureSpec> qualified_specs;
-        std::vector<FeatureSpec> next_dependencies{specs.begin(), specs.end()};
+        std::vector<ClusterFeature> qualified_specs;
+        std::vector<ClusterFeature> next_dependencies =
+            Util::fmap(specs, [&](const FeatureSpec& spec) { return m_graph->intern(spec); });
 
         // Mark all the clusters that are explicitly requested as visited so we don't add default features later
-        for (const FeatureSpec& explicit_spec : specs)
+        for (const ClusterFeature& explicit_spec : next_dependencies)
         {
-            Cluster& clust = m_graph->get(explicit_spec.spec());
+            Cluster& clust = m_graph->get(explicit_spec.cluster);
             if (!clust.visited)
             {
                 clust.visited = true;
-                m_graph_plan->install_graph.add_vertex({&clust});
+                m_graph_plan->install_graph.add_vertex(explicit_spec.cluster);
             }
         }
 
@@ -694,27 +736,40 @@ namespace vcpkg::Dependencies
             while (!next_dependencies.empty())
             {
                 // Extract the top of the stack
-                FeatureSpec spec = std::move(next_dependencies.back());
+                const ClusterFeature spec = next_dependencies.back();
                 next_dependencies.pop_back();
 
-                // Get the cluster for the PackageSpec of the FeatureSpec we are adding to the install graph
-                Cluster& clust = m_graph->get(spec.spec());
+                // Get the cluster of the feature we are adding to the install graph
+                Cluster& clust = m_graph->get(spec.cluster);
+                const std::string& feature = m_graph->feature_name(spec.feature);
+
+                // Requesting every feature of a port adds each of them individually
+                if (feature == "*")
+                {
+                    for (auto&& fpgh : clust.m_scfl.source_control_file->feature_paragraphs)
+                    {
+                        next_dependencies.push_back({spec.cluster, m_graph->feature_id(fpgh->name)});
+                    }
+
+                    next_dependencies.push_back({spec.cluster, ClusterGraph::CORE_FEATURE});
+                    continue;
+                }
 
                 // TODO: There's always the chance that we don't find the feature we're looking for (probably a
                 // malformed CONTROL file somewhere). We should probably output a better error.
                 const std::vector<Dependency>* paragraph_depends;
-                if (spec.feature() == "core")
+                if (spec.feature == ClusterGraph::CORE_FEATURE)
                 {
                     paragraph_depends = &clust.m_scfl.source_control_file->core_paragraph->depends;
                 }
                 else
                 {
-                    paragraph_depends = &clust.m_scfl.source_control_file->find_feature(spec.feature())
+                    paragraph_depends = &clust.m_scfl.source_control_file->find_feature(feature)
                                              .value_or_exit(VCPKG_LINE_INFO)
                                              .depends;
                 }
 
-                if (!m_var_provider.get_dep_info_vars(spec.spec()).has_value())
+                if (!m_var_provider.get_dep_info_vars(clust.m_spec).has_value())
                 {
                     for (const Dependency& dep : *paragraph_depends)
                     {
@@ -724,7 +779,7 @@ namespace vcpkg::Dependencies
                         // takes ~150ms per call.
                         if (!dep.qualifier.empty())
                         {
-                            qualified_specs.emplace_back(spec);
+                            qualified_specs.push_back(spec);
                             break;
                         }
                     }
@@ -732,7 +787,8 @@ namespace vcpkg::Dependencies
 
                 bool port_installed = clust.m_installed.has_value();
                 bool build_was_needed = clust.m_install_info.has_value();
-                auto new_dependencies = clust.add_feature(spec.feature(), m_var_provider);
+                auto new_dependencies = Util::fmap(clust.add_feature(feature, m_var_provider),
+                                                   [&](const FeatureSpec& dep) { return m_graph->intern(dep); });
                 bool build_is_needed = clust.m_install_info.has_value();
 
                 // If the port was already installed and this is the first time we're adding features then we're
@@ -741,19 +797,15 @@ namespace vcpkg::Dependencies
                 // dependencies.
                 if (port_installed && !build_was_needed && build_is_needed)
                 {
-                    auto reinstall_features = graph_removals(spec.spec());
-                    next_dependencies.insert(next_dependencies.end(),
-                                             std::make_move_iterator(reinstall_features.begin()),
-                                             std::make_move_iterator(reinstall_features.end()));
+                    auto reinstall_features = graph_removals(spec.cluster);
+                    next_dependencies.insert(
+                        next_dependencies.end(), reinstall_features.begin(), reinstall_features.end());
                 }
 
-                auto new_default_dependencies = graph_installs(clust.m_spec, new_dependencies);
-                next_dependencies.insert(next_dependencies.end(),
-                                         std::make_move_iterator(new_dependencies.begin()),
-                                         std::make_move_iterator(new_dependencies.end()));
-                next_dependencies.insert(next_dependencies.end(),
-                                         std::make_move_iterator(new_default_dependencies.begin()),
-                                         std::make_move_iterator(new_default_dependencies.end()));
+                auto new_default_dependencies = graph_installs(spec.cluster, new_dependencies);
+                next_dependencies.insert(next_dependencies.end(), new_dependencies.begin(), new_dependencies.end());
+                next_dependencies.insert(
+                    next_dependencies.end(), new_default_dependencies.begin(), new_default_dependencies.end());
             }
 
             if (!qualified_specs.empty())
@@ -762,16 +814,14 @@ namespace vcpkg::Dependencies
 
                 // Extract the package specs we need to get dependency info from. We don't run the triplet on a per
                 // feature basis. We run it once for the whole port.
-                auto qualified_package_specs =
-                    Util::fmap(qualified_specs, [](const FeatureSpec& fspec) { return fspec.spec(); });
+                auto qualified_package_specs = Util::fmap(
+                    qualified_specs, [&](const ClusterFeature& fspec) { return m_graph->get(fspec.cluster).m_spec; });
                 Util::sort_unique_erase(qualified_package_specs);
                 m_var_provider.load_dep_info_vars(qualified_package_specs);
 
                 // Put all the FeatureSpecs for which we had qualified dependencies back on the dependencies stack.
                 // We need to recheck if evaluating the triplet revealed any new dependencies.
-                next_dependencies.insert(next_dependencies.end(),
-                                         std::make_move_iterator(qualified_specs.begin()),
-                                         std::make_move_iterator(qualified_specs.end()));
+                next_dependencies.insert(next_dependencies.end(), qualified_specs.begin(), qualified_specs.end());
                 qualified_specs.clear();
             }
         }
@@ -783,11 +833,18 @@ namespace vcpkg::Dependencies
 
         for (const PackageSpec& spec : specs)
         {
-            auto specific_removals = graph_removals(spec);
-            removals.insert(removals.end(),
-                            std::make_move_iterator(specific_removals.begin()),
-                            std::make_move_iterator(specific_removals.end()));
-            m_graph->get(spec).request_type = RequestType::USER_REQUESTED;
+            const std::uint32_t cluster = m_graph->find_or_create(spec);
+
+            // Upgrading a port always rebuilds it, even if none of its features change
+            Cluster& clust = m_graph->get(cluster);
+            if (!clust.m_install_info) clust.m_install_info = make_optional(ClusterInstallInfo{});
+
+            auto specific_removals = graph_removals(cluster);
+            for (const ClusterFeature& removal : specific_removals)
+            {
+                removals.emplace_back(m_graph->get(removal.cluster).m_spec, m_graph->feature_name(removal.feature));
+            }
+            clust.request_type = RequestType::USER_REQUESTED;
         }
 
         Util::sort_unique_erase(removals);
@@ -810,13 +867,17 @@ namespace vcpkg::Dependencies
 
     std::vector<AnyAction> PackageGraph::serialize(const CreateInstallPlanOptions& options) const
     {
-        auto remove_vertex_list = m_graph_plan->remove_graph.vertex_list();
-        auto remove_toposort =
-            Graphs::topological_sort(remove_vertex_list, m_graph_plan->remove_graph, options.randomizer);
+        auto to_string = [&](std::uint32_t cluster) { return m_graph->get(cluster).m_spec.to_string(); };
+
+        m_graph_plan->remove_graph.freeze();
+        auto remove_toposort = Util::fmap(
+            Graphs::topological_sort(m_graph_plan->remove_graph, to_string, options.randomizer),
+            [&](std::uint32_t cluster) { return &m_graph->get(cluster); });
 
-        auto insert_vertex_list = m_graph_plan->install_graph.vertex_list();
-        auto insert_toposort =
-            Graphs::topological_sort(insert_vertex_list, m_graph_plan->install_graph, options.randomizer);
+        m_graph_plan->install_graph.freeze();
+        auto insert_toposort = Util::fmap(
+            Graphs::topological_sort(m_graph_plan->install_graph, to_string, options.randomizer),
+            [&](std::uint32_t cluster) { return &m_graph->get(cluster); });
 
         std::vector<AnyAction> plan;
 
@@ -862,7 +923,7 @@ namespace vcpkg::Dependencies
 
         for (auto&& ipv : installed_ports)
         {
-            graph->get(ipv);
+            graph->find_or_create(ipv);
         }
 
         // Populate the graph with "remove edges", which are the reverse of the Build-Depends edges.
@@ -878,7 +939,7 @@ namespace vcpkg::Dependencies
                                    "Error: database corrupted. Package %s is installed but dependency %s is not.",
                                    ipv.spec(),
                                    dep);
-                p_installed->remove_edges.emplace(ipv.spec());
+                p_installed->remove_edges.push_back(graph->find_or_create(ipv.spec()));
             }
         }
         return graph;
@@ -92,6 +92,7 @@ namespace vcpkg::Help
                        "  vcpkg update                    Display list of packages for updating\n"
                        "  vcpkg upgrade                   Rebuild all outdated packages\n"
                        "  vcpkg x-history <pkg>           Shows the history of CONTROL versions of a package\n"
+                       "  vcpkg x-history stats [pkg]     Shows build times, slowdowns and cache hits of past builds\n"
                        "  vcpkg hash <file> [alg]         Hash a file by specific algorithm, default SHA512\n"
                        "  vcpkg help topics               Display the list of help topics\n"
                        "  vcpkg help <topic>              Display help for a specific topic\n"
@@ -126,6 +127,10 @@ namespace vcpkg::Help
                        ")\n"
                        "\n"
                        "  --x-scripts-root=<path>             (Experimental) Specify the scripts root directory\n"
+                       "  --x-install-root=<path>             (Experimental) Specify the installed root directory\n"
+                       "  --x-packages-root=<path>            (Experimental) Specify the packages root directory\n"
+                       "  --x-buildtrees-root=<path>          (Experimental) Specify the buildtrees root directory\n"
+                       "  --x-buildtrees-per-spec             (Experimental) Give each triplet of a port its own buildtree\n"
                        "\n"
                        "  @response_file                  Specify a "
                        "response file to provide additional parameters\n"
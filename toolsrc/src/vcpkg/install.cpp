@@ -1,9 +1,13 @@
 #include "pch.h"
 
 #include <vcpkg/base/files.h>
+#include <vcpkg/base/graphs.h>
+#include <vcpkg/base/phases.h>
+#include <vcpkg/base/system.h>
 #include <vcpkg/base/system.print.h>
 #include <vcpkg/base/util.h>
 #include <vcpkg/build.h>
+#include <vcpkg/buildhistory.h>
 #include <vcpkg/cmakevars.h>
 #include <vcpkg/commands.h>
 #include <vcpkg/dependencies.h>
@@ -16,6 +20,8 @@
 #include <vcpkg/remove.h>
 #include <vcpkg/vcpkglib.h>
 
+#include <queue>
+
 namespace vcpkg::Install
 {
     using namespace Dependencies;
@@ -43,6 +49,7 @@ namespace vcpkg::Install
                                           const fs::path& source_dir,
                                           const InstallDir& destination_dir)
     {
+        Phases::Scope phase_scope(Phases::Phase::FILE_INSTALLS);
         std::vector<std::string> output;
         std::error_code ec;
 
@@ -62,19 +69,17 @@ namespace vcpkg::Install
             VCPKG_LINE_INFO, !ec, "Could not create directory for listfile %s", listfile.generic_string());
 
         output.push_back(Strings::format(R"(%s/)", destination_subdirectory));
-        auto files = fs.get_files_recursive(source_dir);
-        for (auto&& file : files)
+        // The walk lists each directory before its contents, and carries the type of every entry, so nothing
+        // needs a stat of its own
+        std::vector<Files::DirectoryEntry> entries;
+        fs.walk_directory(source_dir, [&](const Files::DirectoryEntry& entry) { entries.push_back(entry); });
+        for (auto&& entry : entries)
         {
-            const auto status = fs.symlink_status(file, ec);
-            if (ec)
-            {
-                System::print2(System::Color::error, "failed: ", file.u8string(), ": ", ec.message(), "\n");
-                continue;
-            }
-
+            const fs::path& file = entry.path;
             const std::string filename = file.filename().u8string();
-            if (fs::is_regular_file(status) && (Strings::case_insensitive_ascii_equals(filename, "CONTROL") ||
-                                                Strings::case_insensitive_ascii_equals(filename, "BUILD_INFO")))
+            if (entry.type == fs::file_type::regular &&
+                (Strings::case_insensitive_ascii_equals(filename, "CONTROL") ||
+                 Strings::case_insensitive_ascii_equals(filename, "BUILD_INFO")))
             {
                 // Do not copy the control file
                 continue;
@@ -83,7 +88,7 @@ namespace vcpkg::Install
             const std::string suffix = file.generic_u8string().substr(prefix_length + 1);
             const fs::path target = destination / suffix;
 
-            switch (status.type())
+            switch (entry.type)
             {
                 case fs::file_type::directory:
                 {
@@ -172,10 +177,10 @@ namespace vcpkg::Install
     static SortedVector<std::string> build_list_of_package_files(const Files::Filesystem& fs,
                                                                  const fs::path& package_dir)
     {
-        const std::vector<fs::path> package_file_paths = fs.get_files_recursive(package_dir);
         const size_t package_remove_char_count = package_dir.generic_string().size() + 1; // +1 for the slash
-        auto package_files = Util::fmap(package_file_paths, [package_remove_char_count](const fs::path& path) {
-            return std::string(path.generic_string(), package_remove_char_count);
+        std::vector<std::string> package_files;
+        fs.walk_directory(package_dir, [&](const Files::DirectoryEntry& entry) {
+            package_files.emplace_back(entry.path.generic_string(), package_remove_char_count);
         });
 
         return SortedVector<std::string>(std::move(package_files));
@@ -191,14 +196,12 @@ namespace vcpkg::Install
         return SortedVector<file_pack>(std::move(installed_files));
     }
 
-    InstallResult install_package(const VcpkgPaths& paths, const BinaryControlFile& bcf, StatusParagraphs* status_db)
+    std::vector<file_pack> find_file_conflicts(const Files::Filesystem& fs,
+                                               const fs::path& package_dir,
+                                               const Triplet& triplet,
+                                               const std::vector<StatusParagraphAndAssociatedFiles>& pgh_and_files)
     {
-        const fs::path package_dir = paths.package_dir(bcf.core_paragraph.spec);
-        const Triplet& triplet = bcf.core_paragraph.spec.triplet();
-        const std::vector<StatusParagraphAndAssociatedFiles> pgh_and_files = get_installed_files(paths, *status_db);
-
-        const SortedVector<std::string> package_files =
-            build_list_of_package_files(paths.get_filesystem(), package_dir);
+        const SortedVector<std::string> package_files = build_list_of_package_files(fs, package_dir);
         const SortedVector<file_pack> installed_files = build_list_of_installed_files(pgh_and_files, triplet);
 
         struct intersection_compare
@@ -225,7 +228,16 @@ namespace vcpkg::Install
         std::sort(intersection.begin(), intersection.end(), [](const file_pack& lhs, const file_pack& rhs) {
             return lhs.second < rhs.second;
         });
+        return intersection;
+    }
 
+    InstallResult install_package(const VcpkgPaths& paths, const BinaryControlFile& bcf, StatusParagraphs* status_db)
+    {
+        const fs::path package_dir = paths.package_dir(bcf.core_paragraph.spec);
+        const Triplet& triplet = bcf.core_paragraph.spec.triplet();
+        const std::vector<StatusParagraphAndAssociatedFiles> pgh_and_files = get_installed_files(paths, *status_db);
+
+        const auto intersection = find_file_conflicts(paths.get_filesystem(), package_dir, triplet, pgh_and_files);
         if (!intersection.empty())
         {
             const fs::path triplet_install_path = paths.installed / triplet.canonical_name();
@@ -297,7 +309,8 @@ namespace vcpkg::Install
     ExtendedBuildResult perform_install_plan_action(const VcpkgPaths& paths,
                                                     InstallPlanAction& action,
                                                     StatusParagraphs& status_db,
-                                                    const CMakeVars::CMakeVarProvider& var_provider)
+                                                    const CMakeVars::CMakeVarProvider& var_provider,
+                                                    Build::ArchiveUploadQueue& archive_uploads)
     {
         const InstallPlanType& plan_type = action.plan_type;
         const std::string display_name = action.spec.to_string();
@@ -339,13 +352,22 @@ namespace vcpkg::Install
 
             auto result = [&]() -> Build::ExtendedBuildResult {
                 const auto& scfl = action.source_control_file_location.value_or_exit(VCPKG_LINE_INFO);
-                const Build::BuildPackageConfig build_config{scfl,
-                                                             action.spec.triplet(),
-                                                             action.build_options,
-                                                             var_provider,
-                                                             std::move(action.feature_dependencies),
-                                                             std::move(action.package_dependencies),
-                                                             std::move(action.feature_list)};
+                Build::BuildPackageConfig build_config{scfl,
+                                                       action.spec.triplet(),
+                                                       action.build_options,
+                                                       var_provider,
+                                                       std::move(action.feature_dependencies),
+                                                       std::move(action.package_dependencies),
+                                                       std::move(action.feature_list)};
+                if (auto prefetched_abi_tag = action.prefetched_abi_tag.get())
+                {
+                    build_config.prefetched_abi_tag = *prefetched_abi_tag;
+                }
+                if (auto precomputed_abi = action.precomputed_abi.get())
+                {
+                    build_config.precomputed_abi = *precomputed_abi;
+                }
+                build_config.archive_uploads = archive_uploads;
                 return Build::build_package(paths, build_config, status_db);
             }();
 
@@ -368,7 +390,8 @@ namespace vcpkg::Install
                 Paragraphs::try_load_cached_package(paths, action.spec).value_or_exit(VCPKG_LINE_INFO));
             auto code = aux_install(display_name_with_features, *bcf);
 
-            if (action.build_options.clean_packages == Build::CleanPackages::YES)
+            if (action.build_options.clean_packages == Build::CleanPackages::YES &&
+                !archive_uploads.remove_package_dir_after_upload(action.spec))
             {
                 auto& fs = paths.get_filesystem();
                 const fs::path package_dir = paths.package_dir(action.spec);
@@ -387,9 +410,15 @@ namespace vcpkg::Install
                         fs.remove(p, VCPKG_LINE_INFO);
                     }
                 }
+
+                // The downloaded files above are only links. The store, which other roots and the builds still to come
+                // may share, keeps the data until it is pruned at the end of the run.
             }
 
-            return {code, std::move(bcf)};
+            Build::ExtendedBuildResult installed{code, std::move(bcf)};
+            installed.restored_from_cache = result.restored_from_cache;
+            installed.resource_usage = result.resource_usage;
+            return installed;
         }
 
         if (plan_type == InstallPlanType::EXCLUDED)
@@ -426,6 +455,333 @@ namespace vcpkg::Install
         {
             System::printf("    %s: %d\n", Build::to_string(entry.first), entry.second);
         }
+
+        print_warnings();
+    }
+
+    void InstallSummary::print_warnings() const
+    {
+        if (warnings.empty()) return;
+
+        System::print2(System::Color::warning, "\nWARNINGS\n");
+        for (const std::string& warning : warnings)
+        {
+            System::print2(System::Color::warning, "    ", warning, "\n");
+        }
+    }
+
+    /// <summary>
+    /// Compute the ABI tags of every package the plan will build and restore all binary cache hits into packages/
+    /// concurrently, so that the build loop does not extract them one at a time.
+    /// </summary>
+    static void prefetch_binary_caches(std::vector<AnyAction>& action_plan,
+                                       const VcpkgPaths& paths,
+                                       const StatusParagraphs& status_db,
+                                       const CMakeVars::CMakeVarProvider& var_provider)
+    {
+        auto& fs = paths.get_filesystem();
+
+        // ABI each spec will have once the plan has run up to the current action; empty when it cannot be known
+        std::unordered_map<PackageSpec, std::string> planned_abis;
+        std::vector<InstallPlanAction*> hit_actions;
+        std::vector<std::string> hit_tags;
+        std::vector<std::pair<PackageSpec, fs::path>> archives;
+
+        auto compute_abi = [&](InstallPlanAction& action) -> Optional<std::string> {
+            const auto scfl = action.source_control_file_location.get();
+            if (!scfl) return nullopt;
+
+            std::vector<Build::AbiEntry> dependency_abis;
+            for (auto&& pspec : action.package_dependencies)
+            {
+                if (pspec == action.spec) continue;
+
+                const auto it = planned_abis.find(pspec);
+                if (it != planned_abis.end())
+                {
+                    if (it->second.empty()) return nullopt;
+                    dependency_abis.emplace_back(pspec.name(), it->second);
+                    continue;
+                }
+
+                const auto status_it = status_db.find_installed(pspec);
+                if (status_it == status_db.end()) return nullopt;
+                dependency_abis.emplace_back(pspec.name(), status_it->get()->package.abi);
+            }
+
+            const auto cmake_vars = var_provider.get_tag_vars(action.spec).get();
+            if (!cmake_vars) return nullopt;
+            const Build::PreBuildInfo pre_build_info(paths, action.spec.triplet(), *cmake_vars);
+
+            const Build::BuildPackageConfig build_config{*scfl,
+                                                         action.spec.triplet(),
+                                                         action.build_options,
+                                                         var_provider,
+                                                         action.feature_dependencies,
+                                                         action.package_dependencies,
+                                                         action.feature_list};
+            auto maybe_abi_tag_and_file = Build::compute_abi_tag(paths, build_config, pre_build_info, dependency_abis);
+            if (auto abi_tag_and_file = maybe_abi_tag_and_file.get())
+            {
+                planned_abis[action.spec] = pre_build_info.public_abi_override.value_or(abi_tag_and_file->tag);
+                action.precomputed_abi = Build::PrecomputedAbi{*abi_tag_and_file, std::move(dependency_abis)};
+                return std::move(abi_tag_and_file->tag);
+            }
+            return nullopt;
+        };
+
+        for (auto& action : action_plan)
+        {
+            auto install_action = action.install_action.get();
+            if (!install_action)
+            {
+                planned_abis[action.spec()].clear();
+                continue;
+            }
+
+            if (install_action->plan_type != InstallPlanType::BUILD_AND_INSTALL) continue;
+
+            planned_abis[install_action->spec].clear();
+            if (install_action->build_options.binary_caching != Build::BinaryCaching::YES ||
+                install_action->build_options.only_downloads == Build::OnlyDownloads::YES)
+            {
+                continue;
+            }
+
+            auto maybe_abi_tag = compute_abi(*install_action);
+            if (auto abi_tag = maybe_abi_tag.get())
+            {
+                auto archive_path = Build::get_archive_path(paths, *abi_tag);
+                if (fs.exists(archive_path))
+                {
+                    hit_actions.push_back(install_action);
+                    hit_tags.push_back(std::move(*abi_tag));
+                    archives.emplace_back(install_action->spec, std::move(archive_path));
+                }
+            }
+        }
+
+        if (archives.empty()) return;
+
+        const auto timer = Chrono::ElapsedTimer::create_started();
+        System::printf("Restoring %zd packages from the binary cache...\n", archives.size());
+
+        const auto results = Build::decompress_archives(paths, archives);
+        size_t restored = 0;
+        for (size_t i = 0; i < archives.size(); ++i)
+        {
+            if (results[i] == 0)
+            {
+                hit_actions[i]->prefetched_abi_tag = std::move(hit_tags[i]);
+                ++restored;
+            }
+            else
+            {
+                System::printf(System::Color::warning,
+                               "Failed to decompress archive package %s for %s\n",
+                               archives[i].second.u8string(),
+                               archives[i].first.to_string());
+            }
+        }
+
+        System::printf("Restored %zd/%zd packages from the binary cache in %s\n",
+                       restored,
+                       archives.size(),
+                       timer.to_string());
+    }
+
+    /// <summary>
+    /// Gather the distfiles of every package the plan will build and download them concurrently, with a limited number
+    /// of connections per host, instead of one port at a time from inside the build loop.
+    /// </summary>
+    static void download_sources(const std::vector<AnyAction>& action_plan,
+                                 const VcpkgPaths& paths,
+                                 const CMakeVars::CMakeVarProvider& var_provider)
+    {
+        static constexpr unsigned MAX_CONNECTIONS = 16;
+        static constexpr unsigned MAX_CONNECTIONS_PER_HOST = 4;
+
+        auto& fs = paths.get_filesystem();
+
+        std::vector<Build::BuildPackageConfig> configs;
+        for (auto&& action : action_plan)
+        {
+            auto install_action = action.install_action.get();
+            if (!install_action || install_action->plan_type != InstallPlanType::BUILD_AND_INSTALL) continue;
+            if (install_action->prefetched_abi_tag) continue;
+
+            const auto& options = install_action->build_options;
+            if (options.allow_downloads != Build::AllowDownloads::YES ||
+                options.download_tool != Build::DownloadTool::BUILT_IN ||
+                options.clean_downloads == Build::CleanDownloads::YES)
+            {
+                continue;
+            }
+
+            const auto scfl = install_action->source_control_file_location.get();
+            if (!scfl || !var_provider.get_tag_vars(install_action->spec)) continue;
+
+            configs.emplace_back(*scfl,
+                                 install_action->spec.triplet(),
+                                 options,
+                                 var_provider,
+                                 install_action->feature_dependencies,
+                                 install_action->package_dependencies,
+                                 install_action->feature_list);
+        }
+
+        // A single port gains nothing from gathering its distfiles first
+        if (configs.size() < 2) return;
+
+        const auto timer = Chrono::ElapsedTimer::create_started();
+        System::printf("Gathering sources for %zd packages...\n", configs.size());
+
+        auto requests = Build::capture_distfiles(paths, configs);
+        Util::erase_remove_if(requests,
+                              [&](const Downloads::DownloadRequest& request) { return fs.exists(request.download_path); });
+        if (requests.empty()) return;
+
+        System::printf("Downloading %zd source files...\n", requests.size());
+        const auto errors = Downloads::download_files(fs,
+                                                      Downloads::DownloadStore::for_downloads_dir(paths.downloads),
+                                                      requests,
+                                                      MAX_CONNECTIONS,
+                                                      MAX_CONNECTIONS_PER_HOST);
+        for (auto&& error : errors)
+        {
+            System::print2(System::Color::warning, error, "\n");
+        }
+
+        System::printf("Downloaded %zd/%zd source files in %s\n",
+                       requests.size() - errors.size(),
+                       requests.size(),
+                       timer.to_string());
+    }
+
+    /// <summary>
+    /// Predicted time each action will take. Packages without history are assumed to take as long as the median
+    /// package that has some; nullopt if nothing in the plan has ever been built here.
+    /// </summary>
+    static Optional<std::vector<std::chrono::milliseconds>> predict_durations(
+        const std::vector<AnyAction>& action_plan, const BuildHistory::BuildHistory& history)
+    {
+        std::vector<Optional<std::chrono::milliseconds>> predictions;
+        std::vector<std::chrono::milliseconds> known;
+        for (auto&& action : action_plan)
+        {
+            auto install_action = action.install_action.get();
+            if (install_action && install_action->plan_type == InstallPlanType::BUILD_AND_INSTALL &&
+                !install_action->prefetched_abi_tag)
+            {
+                predictions.push_back(history.predict_duration(install_action->spec));
+                if (auto p = predictions.back().get()) known.push_back(*p);
+            }
+            else
+            {
+                predictions.push_back(std::chrono::milliseconds::zero());
+            }
+        }
+
+        if (known.empty()) return nullopt;
+
+        std::nth_element(known.begin(), known.begin() + known.size() / 2, known.end());
+        const auto median = known[known.size() / 2];
+        return Util::fmap(predictions, [&](const Optional<std::chrono::milliseconds>& p) { return p.value_or(median); });
+    }
+
+    /// <summary>
+    /// Reorder the install actions of a plan so that, among the actions whose dependencies are satisfied, the one
+    /// with the longest chain of predicted work behind it goes first. Ties keep their planned order.
+    /// </summary>
+    static void order_by_critical_path(std::vector<AnyAction>& action_plan,
+                                       std::vector<std::chrono::milliseconds>& predicted)
+    {
+        std::vector<size_t> install_indices;
+        std::unordered_map<PackageSpec, std::uint32_t> vertex_of;
+        for (size_t i = 0; i < action_plan.size(); ++i)
+        {
+            if (auto install_action = action_plan[i].install_action.get())
+            {
+                vertex_of.emplace(install_action->spec, static_cast<std::uint32_t>(install_indices.size()));
+                install_indices.push_back(i);
+            }
+        }
+        if (install_indices.size() < 2) return;
+
+        // Edges point from each package to the packages it depends on
+        Graphs::CsrGraph graph;
+        for (std::uint32_t v = 0; v < install_indices.size(); ++v)
+        {
+            graph.add_vertex(v);
+            const auto& install_action = action_plan[install_indices[v]].install_action.value_or_exit(VCPKG_LINE_INFO);
+            for (auto&& dep : install_action.package_dependencies)
+            {
+                auto it = vertex_of.find(dep);
+                if (it != vertex_of.end() && it->second != v) graph.add_edge(v, it->second);
+            }
+        }
+        graph.freeze();
+
+        const auto leveled = Graphs::leveled_topological_sort(
+            graph,
+            [&](std::uint32_t v) { return predicted[install_indices[v]].count() + 1; },
+            [&](std::uint32_t v) { return action_plan[install_indices[v]].spec().to_string(); });
+
+        // Max-heap on remaining work; the negated vertex keeps earlier-planned actions first on ties
+        std::priority_queue<std::pair<std::uint64_t, std::int64_t>> ready;
+        Graphs::TopologicalFrontier frontier(graph);
+        std::vector<size_t> order;
+        for (;;)
+        {
+            for (std::uint32_t v : frontier.take_ready())
+                ready.emplace(leveled.remaining_work[v], -static_cast<std::int64_t>(v));
+            if (ready.empty()) break;
+
+            const auto v = static_cast<std::uint32_t>(-ready.top().second);
+            ready.pop();
+            order.push_back(install_indices[v]);
+            frontier.complete(v);
+        }
+
+        std::vector<AnyAction> reordered;
+        std::vector<std::chrono::milliseconds> reordered_predicted;
+        reordered.reserve(action_plan.size());
+        reordered_predicted.reserve(action_plan.size());
+        for (size_t i = 0; i < action_plan.size(); ++i)
+        {
+            if (!action_plan[i].install_action)
+            {
+                reordered.push_back(std::move(action_plan[i]));
+                reordered_predicted.push_back(predicted[i]);
+            }
+        }
+        for (size_t i : order)
+        {
+            reordered.push_back(std::move(action_plan[i]));
+            reordered_predicted.push_back(predicted[i]);
+        }
+
+        action_plan = std::move(reordered);
+        predicted = std::move(reordered_predicted);
+    }
+
+    static BuildHistory::BuildRecord make_build_record(const InstallPlanAction& action,
+                                                       std::vector<std::string> features,
+                                                       const Build::ExtendedBuildResult& result,
+                                                       const Chrono::ElapsedTime& elapsed)
+    {
+        BuildHistory::BuildRecord record{action.spec, elapsed.as<std::chrono::milliseconds>()};
+        record.features = std::move(features);
+        record.result = result.code;
+        record.restored_from_cache = result.restored_from_cache;
+        if (result.binary_control_file) record.abi = result.binary_control_file->core_paragraph.abi;
+
+        if (const auto usage = result.resource_usage.get())
+        {
+            record.cpu_time = usage->cpu_time;
+            record.peak_rss_kb = usage->peak_rss_kb;
+        }
+        return record;
     }
 
     InstallSummary perform(std::vector<AnyAction>& action_plan,
@@ -440,24 +796,75 @@ namespace vcpkg::Install
         size_t counter = 0;
         const size_t package_count = action_plan.size();
 
-        for (auto& action : action_plan)
+        prefetch_binary_caches(action_plan, paths, status_db, var_provider);
+        download_sources(action_plan, paths, var_provider);
+
+        const auto history = BuildHistory::BuildHistory::load(paths.get_filesystem(), paths.vcpkg_dir_history);
+        std::vector<std::chrono::milliseconds> predicted;
+        auto maybe_predicted = predict_durations(action_plan, history);
+        if (auto p = maybe_predicted.get())
+        {
+            predicted = std::move(*p);
+            order_by_critical_path(action_plan, predicted);
+        }
+        else
+        {
+            // Without any history every action would weigh the same; keep the planned order
+            predicted.assign(action_plan.size(), std::chrono::milliseconds::zero());
+        }
+
+        // Scaled by how long the finished builds took compared to their predictions
+        std::chrono::milliseconds remaining_predicted{};
+        for (auto&& p : predicted)
+            remaining_predicted += p;
+        double elapsed_ms = 0;
+        double elapsed_predicted_ms = 0;
+
+        Build::ArchiveUploadQueue archive_uploads(paths);
+        std::vector<BuildHistory::BuildRecord> history_records;
+
+        for (size_t i = 0; i < action_plan.size(); ++i)
         {
+            auto& action = action_plan[i];
             const auto build_timer = Chrono::ElapsedTimer::create_started();
             counter++;
 
             const PackageSpec& spec = action.spec();
             const std::string display_name = spec.to_string();
-            System::printf("Starting package %zd/%zd: %s\n", counter, package_count, display_name);
+            if (remaining_predicted.count() > 0)
+            {
+                const double scale = elapsed_predicted_ms > 0 ? elapsed_ms / elapsed_predicted_ms : 1.0;
+                const Chrono::ElapsedTime eta(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::duration<double, std::milli>(remaining_predicted.count() * scale)));
+                System::printf(
+                    "Starting package %zd/%zd: %s (about %s remaining)\n", counter, package_count, display_name, eta);
+            }
+            else
+            {
+                System::printf("Starting package %zd/%zd: %s\n", counter, package_count, display_name);
+            }
 
             results.emplace_back(spec, &action);
 
             if (auto install_action = action.install_action.get())
             {
-                auto result = perform_install_plan_action(paths, *install_action, status_db, var_provider);
+                // perform_install_plan_action() consumes the feature list
+                const bool builds = install_action->plan_type == InstallPlanType::BUILD_AND_INSTALL;
+                auto features = builds ? install_action->feature_list : std::vector<std::string>{};
+                auto result =
+                    perform_install_plan_action(paths, *install_action, status_db, var_provider, archive_uploads);
+
+                if (builds && result.code != BuildResult::DOWNLOADED)
+                {
+                    history_records.push_back(make_build_record(
+                        *install_action, std::move(features), result, build_timer.elapsed()));
+                }
 
                 if (result.code != BuildResult::SUCCEEDED && keep_going == KeepGoing::NO)
                 {
+                    BuildHistory::append_records(paths.get_filesystem(), paths.vcpkg_dir_history, history_records);
                     System::print2(Build::create_user_troubleshooting_message(install_action->spec), '\n');
+                    InstallSummary{{}, {}, archive_uploads.drain()}.print_warnings();
                     Checks::exit_fail(VCPKG_LINE_INFO);
                 }
 
@@ -474,9 +881,27 @@ namespace vcpkg::Install
 
             results.back().timing = build_timer.elapsed();
             System::printf("Elapsed time for package %s: %s\n", display_name, results.back().timing);
+
+            remaining_predicted -= predicted[i];
+            if (predicted[i].count() > 0 && !results.back().build_result.restored_from_cache)
+            {
+                elapsed_ms += results.back().timing.as<std::chrono::duration<double, std::milli>>().count();
+                elapsed_predicted_ms += static_cast<double>(predicted[i].count());
+            }
+        }
+
+        BuildHistory::append_records(paths.get_filesystem(), paths.vcpkg_dir_history, history_records);
+
+        auto warnings = archive_uploads.drain();
+        if (std::any_of(action_plan.begin(), action_plan.end(), [](const AnyAction& action) {
+                const auto install_action = action.install_action.get();
+                return install_action && install_action->build_options.clean_downloads == Build::CleanDownloads::YES;
+            }))
+        {
+            Downloads::DownloadStore::for_downloads_dir(paths.downloads).prune(paths.get_filesystem());
         }
 
-        return InstallSummary{std::move(results), timer.to_string()};
+        return InstallSummary{std::move(results), timer.to_string(), std::move(warnings)};
     }
 
     static constexpr StringLiteral OPTION_DRY_RUN = "--dry-run";
@@ -727,6 +1152,10 @@ namespace vcpkg::Install
         {
             summary.print();
         }
+        else
+        {
+            summary.print_warnings();
+        }
 
         auto it_xunit = options.settings.find(OPTION_XUNIT);
         if (it_xunit != options.settings.end())
@@ -6,6 +6,30 @@
 #include <vcpkg/packagespecparseresult.h>
 #include <vcpkg/parse.h>
 
+#include <mutex>
+
+namespace vcpkg
+{
+    struct NameInstance
+    {
+        NameInstance(const std::string& s, size_t hash) : value(s), hash(hash) {}
+
+        const std::string value;
+        const size_t hash = 0;
+
+        bool operator==(const NameInstance& o) const { return o.value == value; }
+    };
+}
+
+namespace std
+{
+    template<>
+    struct hash<vcpkg::NameInstance>
+    {
+        size_t operator()(const vcpkg::NameInstance& n) const { return n.hash; }
+    };
+}
+
 using vcpkg::Parse::parse_comma_list;
 
 namespace vcpkg
@@ -112,7 +136,7 @@ namespace vcpkg
         }
 
         PackageSpec p;
-        p.m_name = name;
+        p.m_name = InternedName::from_string(name);
         p.m_triplet = triplet;
         return p;
     }
@@ -136,18 +160,47 @@ namespace vcpkg
         });
     }
 
-    const std::string& PackageSpec::name() const { return this->m_name; }
+    InternedName InternedName::from_string(const std::string& name)
+    {
+        // So that every empty name equals a default-constructed one
+        if (name.empty()) return InternedName();
+
+        // Specs may be created from worker threads, so unlike the triplet pool this one is guarded. It is split by
+        // hash so that threads interning different names rarely wait for each other.
+        // Elements of an unordered_set never move, so the returned pointers stay valid.
+        struct PoolShard
+        {
+            std::mutex mtx;
+            std::unordered_set<NameInstance> instances;
+        };
+        static constexpr size_t SHARD_COUNT = 16;
+        static PoolShard shards[SHARD_COUNT];
+
+        const size_t hash = std::hash<std::string>()(name);
+        auto& shard = shards[hash % SHARD_COUNT];
+        std::lock_guard<std::mutex> lock(shard.mtx);
+        return &*shard.instances.emplace(name, hash).first;
+    }
+
+    const std::string& InternedName::to_string() const
+    {
+        static const std::string EMPTY;
+        return m_instance ? m_instance->value : EMPTY;
+    }
+    size_t InternedName::hash_code() const { return m_instance ? m_instance->hash : 0; }
+
+    const std::string& PackageSpec::name() const { return this->m_name.to_string(); }
 
     const Triplet& PackageSpec::triplet() const { return this->m_triplet; }
 
-    std::string PackageSpec::dir() const { return Strings::format("%s_%s", this->m_name, this->m_triplet); }
+    std::string PackageSpec::dir() const { return Strings::format("%s_%s", this->name(), this->m_triplet); }
 
     std::string PackageSpec::to_string() const { return Strings::format("%s:%s", this->name(), this->triplet()); }
     void PackageSpec::to_string(std::string& s) const { Strings::append(s, this->name(), ':', this->triplet()); }
 
     bool operator==(const PackageSpec& left, const PackageSpec& right)
     {
-        return left.name() == right.name() && left.triplet() == right.triplet();
+        return left.interned_name() == right.interned_name() && left.triplet() == right.triplet();
     }
 
     bool operator!=(const PackageSpec& left, const PackageSpec& right) { return !(left == right); }
@@ -32,14 +32,16 @@ namespace vcpkg::Parse
     {
         return remove_field(&fields, fieldname).value_or("");
     }
+    void ParagraphParser::invalid_field(const std::string& fieldname) { invalid_fields.push_back(fieldname); }
     std::unique_ptr<ParseControlErrorInfo> ParagraphParser::error_info(const std::string& name) const
     {
-        if (!fields.empty() || !missing_fields.empty())
+        if (!fields.empty() || !missing_fields.empty() || !invalid_fields.empty())
         {
             auto err = std::make_unique<ParseControlErrorInfo>();
             err->name = name;
             err->extra_fields = Util::extract_keys(fields);
             err->missing_fields = std::move(missing_fields);
+            err->invalid_fields = std::move(invalid_fields);
             return err;
         }
         return nullptr;
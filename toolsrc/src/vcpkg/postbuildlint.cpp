@@ -1,14 +1,17 @@
 #include "pch.h"
 
 #include <vcpkg/base/cofffilereader.h>
+#include <vcpkg/base/elffilereader.h>
 #include <vcpkg/base/files.h>
 #include <vcpkg/base/system.print.h>
 #include <vcpkg/base/system.process.h>
 #include <vcpkg/base/util.h>
+#include <vcpkg/base/work_queue.h>
 #include <vcpkg/build.h>
 #include <vcpkg/packagespec.h>
 #include <vcpkg/postbuildlint.buildtype.h>
 #include <vcpkg/postbuildlint.h>
+#include <vcpkg/postbuildlint.packagetree.h>
 #include <vcpkg/vcpkgpaths.h>
 
 using vcpkg::Build::BuildInfo;
@@ -17,11 +20,6 @@ using vcpkg::Build::PreBuildInfo;
 
 namespace vcpkg::PostBuildLint
 {
-    static auto not_extension_pred(const Files::Filesystem& fs, const std::string& ext)
-    {
-        return [&fs, ext](const fs::path& path) { return fs.is_directory(path) || path.extension() != ext; };
-    }
-
     enum class LintStatus
     {
         SUCCESS = 0,
@@ -77,17 +75,15 @@ namespace vcpkg::PostBuildLint
         return V_NO_MSVCRT;
     }
 
-    static LintStatus check_for_files_in_include_directory(const Files::Filesystem& fs,
-                                                           const Build::BuildPolicies& policies,
-                                                           const fs::path& package_dir)
+    static LintStatus check_for_files_in_include_directory(const PackageTree& tree,
+                                                           const Build::BuildPolicies& policies)
     {
         if (policies.is_enabled(BuildPolicy::EMPTY_INCLUDE_FOLDER))
         {
             return LintStatus::SUCCESS;
         }
 
-        const fs::path include_dir = package_dir / "include";
-        if (!fs.exists(include_dir) || fs.is_empty(include_dir))
+        if (!tree.exists("include") || tree.is_empty_directory("include"))
         {
             System::print2(System::Color::warning,
                            "The folder /include is empty or not present. This indicates the library was not correctly "
@@ -98,17 +94,15 @@ namespace vcpkg::PostBuildLint
         return LintStatus::SUCCESS;
     }
 
-    static LintStatus check_for_files_in_debug_include_directory(const Files::Filesystem& fs,
-                                                                 const fs::path& package_dir)
+    static LintStatus check_for_files_in_debug_include_directory(const PackageTree& tree)
     {
-        const fs::path debug_include_dir = package_dir / "debug" / "include";
-
-        std::vector<fs::path> files_found = fs.get_files_recursive(debug_include_dir);
-
-        Util::erase_remove_if(
-            files_found, [&fs](const fs::path& path) { return fs.is_directory(path) || path.extension() == ".ifc"; });
+        const auto& entries = tree.entries();
+        const bool files_found = std::any_of(entries.begin(), entries.end(), [](const PackageTreeEntry& entry) {
+            return !entry.is_directory && entry.file_class != FileClass::IFC &&
+                   Strings::starts_with(entry.relative_path, "debug/include/");
+        });
 
-        if (!files_found.empty())
+        if (files_found)
         {
             System::print2(System::Color::warning,
                            "Include files should not be duplicated into the /debug/include directory. If this cannot "
@@ -120,11 +114,9 @@ namespace vcpkg::PostBuildLint
         return LintStatus::SUCCESS;
     }
 
-    static LintStatus check_for_files_in_debug_share_directory(const Files::Filesystem& fs, const fs::path& package_dir)
+    static LintStatus check_for_files_in_debug_share_directory(const PackageTree& tree)
     {
-        const fs::path debug_share = package_dir / "debug" / "share";
-
-        if (fs.exists(debug_share))
+        if (tree.exists("debug/share"))
         {
             System::print2(System::Color::warning,
                            "/debug/share should not exist. Please reorganize any important files, then use\n"
@@ -135,12 +127,9 @@ namespace vcpkg::PostBuildLint
         return LintStatus::SUCCESS;
     }
 
-    static LintStatus check_folder_lib_cmake(const Files::Filesystem& fs,
-                                             const fs::path& package_dir,
-                                             const PackageSpec& spec)
+    static LintStatus check_folder_lib_cmake(const PackageTree& tree, const PackageSpec& spec)
     {
-        const fs::path lib_cmake = package_dir / "lib" / "cmake";
-        if (fs.exists(lib_cmake))
+        if (tree.exists("lib/cmake"))
         {
             System::printf(
                 System::Color::warning,
@@ -152,26 +141,15 @@ namespace vcpkg::PostBuildLint
         return LintStatus::SUCCESS;
     }
 
-    static LintStatus check_for_misplaced_cmake_files(const Files::Filesystem& fs,
-                                                      const fs::path& package_dir,
-                                                      const PackageSpec& spec)
+    static LintStatus check_for_misplaced_cmake_files(const PackageTree& tree, const PackageSpec& spec)
     {
-        std::vector<fs::path> dirs = {
-            package_dir / "cmake",
-            package_dir / "debug" / "cmake",
-            package_dir / "lib" / "cmake",
-            package_dir / "debug" / "lib" / "cmake",
-        };
+        static constexpr StringLiteral DIRS[] = {"cmake", "debug/cmake", "lib/cmake", "debug/lib/cmake"};
 
         std::vector<fs::path> misplaced_cmake_files;
-        for (auto&& dir : dirs)
+        for (auto&& dir : DIRS)
         {
-            auto files = fs.get_files_recursive(dir);
-            for (auto&& file : files)
-            {
-                if (!fs.is_directory(file) && file.extension() == ".cmake")
-                    misplaced_cmake_files.push_back(std::move(file));
-            }
+            auto files = tree.files_below(dir, FileClass::CMAKE);
+            misplaced_cmake_files.insert(misplaced_cmake_files.end(), files.begin(), files.end());
         }
 
         if (!misplaced_cmake_files.empty())
@@ -188,12 +166,9 @@ namespace vcpkg::PostBuildLint
         return LintStatus::SUCCESS;
     }
 
-    static LintStatus check_folder_debug_lib_cmake(const Files::Filesystem& fs,
-                                                   const fs::path& package_dir,
-                                                   const PackageSpec& spec)
+    static LintStatus check_folder_debug_lib_cmake(const PackageTree& tree, const PackageSpec& spec)
     {
-        const fs::path lib_cmake_debug = package_dir / "debug" / "lib" / "cmake";
-        if (fs.exists(lib_cmake_debug))
+        if (tree.exists("debug/lib/cmake"))
         {
             System::printf(System::Color::warning,
                            "The /debug/lib/cmake folder should be merged with /lib/cmake into /share/%s\n",
@@ -204,10 +179,9 @@ namespace vcpkg::PostBuildLint
         return LintStatus::SUCCESS;
     }
 
-    static LintStatus check_for_dlls_in_lib_dir(const Files::Filesystem& fs, const fs::path& package_dir)
+    static LintStatus check_for_dlls_in_lib_dir(const PackageTree& tree, StringView lib_dir)
     {
-        std::vector<fs::path> dlls = fs.get_files_recursive(package_dir / "lib");
-        Util::erase_remove_if(dlls, not_extension_pred(fs, ".dll"));
+        const std::vector<fs::path> dlls = tree.files_below(lib_dir, FileClass::DLL);
 
         if (!dlls.empty())
         {
@@ -231,7 +205,7 @@ namespace vcpkg::PostBuildLint
         {
             return LintStatus::SUCCESS;
         }
-        const fs::path current_buildtrees_dir = paths.buildtrees / spec.name();
+        const fs::path current_buildtrees_dir = paths.buildtrees_dir(spec);
         const fs::path current_buildtrees_dir_src = current_buildtrees_dir / "src";
 
         std::vector<fs::path> potential_copyright_files;
@@ -278,10 +252,9 @@ namespace vcpkg::PostBuildLint
         return LintStatus::ERROR_DETECTED;
     }
 
-    static LintStatus check_for_exes(const Files::Filesystem& fs, const fs::path& package_dir)
+    static LintStatus check_for_exes(const PackageTree& tree, StringView bin_dir)
     {
-        std::vector<fs::path> exes = fs.get_files_recursive(package_dir / "bin");
-        Util::erase_remove_if(exes, not_extension_pred(fs, ".exe"));
+        const std::vector<fs::path> exes = tree.files_below(bin_dir, FileClass::EXE);
 
         if (!exes.empty())
         {
@@ -295,19 +268,72 @@ namespace vcpkg::PostBuildLint
         return LintStatus::SUCCESS;
     }
 
-    static LintStatus check_exports_of_dlls(const std::vector<fs::path>& dlls, const fs::path& dumpbin_exe)
+    template<class Result>
+    struct InspectFileAction
     {
-        std::vector<fs::path> dlls_with_no_exports;
-        for (const fs::path& dll : dlls)
+        const std::function<Result(const fs::path&)>* inspect;
+        const fs::path* file;
+        Result* result;
+
+        template<class ThreadLocalData, class Queue>
+        void operator()(ThreadLocalData&, const Queue&) &&
+        {
+            *result = (*inspect)(*file);
+        }
+    };
+
+    /// <summary>
+    /// inspect applied to each file, with one file per core in flight at a time.
+    /// </summary>
+    template<class Result>
+    static std::vector<Result> inspect_in_parallel(const std::vector<fs::path>& files,
+                                                   const std::function<Result(const fs::path&)>& inspect)
+    {
+        std::vector<Result> results(files.size());
+        if (files.empty()) return results;
+
+        WorkQueue<InspectFileAction<Result>> queue(VCPKG_LINE_INFO);
+        for (size_t i = 0; i < files.size(); ++i)
         {
+            queue.enqueue_action(InspectFileAction<Result>{&inspect, &files[i], &results[i]});
+        }
+
+        const auto num_threads =
+            std::min(static_cast<size_t>(std::max(System::get_num_logical_cores(), 1)), files.size());
+        queue.run_and_join(static_cast<unsigned>(num_threads), [] { return 0; });
+        return results;
+    }
+
+    /// <summary>
+    /// Output of `dumpbin <option>` for each file.
+    /// </summary>
+    static std::vector<std::string> run_dumpbin(const fs::path& dumpbin_exe,
+                                                StringLiteral option,
+                                                const std::vector<fs::path>& files)
+    {
+        return inspect_in_parallel<std::string>(files, [&](const fs::path& file) {
             const std::string cmd_line =
-                Strings::format(R"("%s" /exports "%s")", dumpbin_exe.u8string(), dll.u8string());
+                Strings::format(R"("%s" %s "%s")", dumpbin_exe.u8string(), option, file.u8string());
             System::ExitCodeAndOutput ec_data = System::cmd_execute_and_capture_output(cmd_line);
-            Checks::check_exit(VCPKG_LINE_INFO, ec_data.exit_code == 0, "Running command:\n   %s\n failed", cmd_line);
+            Checks::check_exit(VCPKG_LINE_INFO,
+                               ec_data.exit_code == 0,
+                               "Running command:\n   %s\n failed with message:\n%s",
+                               cmd_line,
+                               ec_data.output);
+            return std::move(ec_data.output);
+        });
+    }
 
-            if (ec_data.output.find("ordinal hint RVA      name") == std::string::npos)
+    static LintStatus check_exports_of_dlls(const std::vector<fs::path>& dlls, const fs::path& dumpbin_exe)
+    {
+        const auto outputs = run_dumpbin(dumpbin_exe, "/exports", dlls);
+
+        std::vector<fs::path> dlls_with_no_exports;
+        for (size_t i = 0; i < dlls.size(); ++i)
+        {
+            if (outputs[i].find("ordinal hint RVA      name") == std::string::npos)
             {
-                dlls_with_no_exports.push_back(dll);
+                dlls_with_no_exports.push_back(dlls[i]);
             }
         }
 
@@ -331,17 +357,14 @@ namespace vcpkg::PostBuildLint
             return LintStatus::SUCCESS;
         }
 
+        const auto outputs = run_dumpbin(dumpbin_exe, "/headers", dlls);
+
         std::vector<fs::path> dlls_with_improper_uwp_bit;
-        for (const fs::path& dll : dlls)
+        for (size_t i = 0; i < dlls.size(); ++i)
         {
-            const std::string cmd_line =
-                Strings::format(R"("%s" /headers "%s")", dumpbin_exe.u8string(), dll.u8string());
-            System::ExitCodeAndOutput ec_data = System::cmd_execute_and_capture_output(cmd_line);
-            Checks::check_exit(VCPKG_LINE_INFO, ec_data.exit_code == 0, "Running command:\n   %s\n failed", cmd_line);
-
-            if (ec_data.output.find("App Container") == std::string::npos)
+            if (outputs[i].find("App Container") == std::string::npos)
             {
-                dlls_with_improper_uwp_bit.push_back(dll);
+                dlls_with_improper_uwp_bit.push_back(dlls[i]);
             }
         }
 
@@ -362,7 +385,6 @@ namespace vcpkg::PostBuildLint
         std::string actual_arch;
     };
 
-#if defined(_WIN32)
     static std::string get_actual_architecture(const MachineType& machine_type)
     {
         switch (machine_type)
@@ -376,9 +398,7 @@ namespace vcpkg::PostBuildLint
             default: return "Machine Type Code = " + std::to_string(static_cast<uint16_t>(machine_type));
         }
     }
-#endif
 
-#if defined(_WIN32)
     static void print_invalid_architecture_files(const std::string& expected_architecture,
                                                  std::vector<FileAndArch> binaries_with_invalid_architecture)
     {
@@ -396,10 +416,25 @@ namespace vcpkg::PostBuildLint
         }
     }
 
+    /// <summary>
+    /// Files the COFF reader could not make sense of. Reported rather than fatal, since the files are read on worker
+    /// threads and a single damaged file should not stop the other checks.
+    /// </summary>
+    static void print_unreadable_binaries(const std::vector<std::string>& errors)
+    {
+        System::print2(System::Color::warning, "The following files could not be read as binaries:\n\n");
+        for (const std::string& error : errors)
+        {
+            System::print2("    ", error, "\n");
+        }
+        System::print2("\n");
+    }
+
     static LintStatus check_dll_architecture(const std::string& expected_architecture,
                                              const std::vector<fs::path>& files)
     {
         std::vector<FileAndArch> binaries_with_invalid_architecture;
+        std::vector<std::string> unreadable_binaries;
 
         for (const fs::path& file : files)
         {
@@ -407,30 +442,39 @@ namespace vcpkg::PostBuildLint
                                file.extension() == ".dll",
                                "The file extension was not .dll: %s",
                                file.generic_string());
-            const CoffFileReader::DllInfo info = CoffFileReader::read_dll(file);
-            const std::string actual_architecture = get_actual_architecture(info.machine_type);
+        }
 
+        const auto infos =
+            inspect_in_parallel<ExpectedT<CoffFileReader::DllInfo, std::string>>(files, CoffFileReader::read_dll);
+        for (size_t i = 0; i < files.size(); ++i)
+        {
+            const auto info = infos[i].get();
+            if (!info)
+            {
+                unreadable_binaries.push_back(infos[i].error());
+                continue;
+            }
+
+            const std::string actual_architecture = get_actual_architecture(info->machine_type);
             if (expected_architecture != actual_architecture)
             {
-                binaries_with_invalid_architecture.push_back({file, actual_architecture});
+                binaries_with_invalid_architecture.push_back({files[i], actual_architecture});
             }
         }
 
+        if (!unreadable_binaries.empty()) print_unreadable_binaries(unreadable_binaries);
         if (!binaries_with_invalid_architecture.empty())
-        {
             print_invalid_architecture_files(expected_architecture, binaries_with_invalid_architecture);
-            return LintStatus::ERROR_DETECTED;
-        }
 
-        return LintStatus::SUCCESS;
+        return unreadable_binaries.empty() && binaries_with_invalid_architecture.empty() ? LintStatus::SUCCESS
+                                                                                          : LintStatus::ERROR_DETECTED;
     }
-#endif
 
     static LintStatus check_lib_architecture(const std::string& expected_architecture,
                                              const std::vector<fs::path>& files)
     {
-#if defined(_WIN32)
         std::vector<FileAndArch> binaries_with_invalid_architecture;
+        std::vector<std::string> unreadable_binaries;
 
         for (const fs::path& file : files)
         {
@@ -438,32 +482,169 @@ namespace vcpkg::PostBuildLint
                                file.extension() == ".lib",
                                "The file extension was not .lib: %s",
                                file.generic_string());
-            CoffFileReader::LibInfo info = CoffFileReader::read_lib(file);
+        }
+
+        const auto infos =
+            inspect_in_parallel<ExpectedT<CoffFileReader::LibInfo, std::string>>(files, CoffFileReader::read_lib);
+        for (size_t i = 0; i < files.size(); ++i)
+        {
+            const auto info = infos[i].get();
+            if (!info)
+            {
+                unreadable_binaries.push_back(infos[i].error());
+                continue;
+            }
 
             // This is zero for folly's debug library
             // TODO: Why?
-            if (info.machine_types.size() == 0) return LintStatus::SUCCESS;
+            if (info->machine_types.size() == 0) continue;
 
-            Checks::check_exit(VCPKG_LINE_INFO,
-                               info.machine_types.size() == 1,
-                               "Found more than 1 architecture in file %s",
-                               file.generic_string());
+            if (info->machine_types.size() != 1)
+            {
+                unreadable_binaries.push_back(
+                    Strings::concat("Found more than 1 architecture in file ", files[i].generic_string()));
+                continue;
+            }
 
-            const std::string actual_architecture = get_actual_architecture(info.machine_types.at(0));
+            const std::string actual_architecture = get_actual_architecture(info->machine_types.at(0));
             if (expected_architecture != actual_architecture)
             {
-                binaries_with_invalid_architecture.push_back({file, actual_architecture});
+                binaries_with_invalid_architecture.push_back({files[i], actual_architecture});
+            }
+        }
+
+        if (!unreadable_binaries.empty()) print_unreadable_binaries(unreadable_binaries);
+        if (!binaries_with_invalid_architecture.empty())
+            print_invalid_architecture_files(expected_architecture, binaries_with_invalid_architecture);
+
+        return unreadable_binaries.empty() && binaries_with_invalid_architecture.empty() ? LintStatus::SUCCESS
+                                                                                          : LintStatus::ERROR_DETECTED;
+    }
+
+    /// <summary>
+    /// Shared objects and static archives below relative_dir. Links like libz.so -> libz.so.1 are left out, so each
+    /// library is looked at once.
+    /// </summary>
+    static std::vector<fs::path> elf_libraries_below(const PackageTree& tree, const std::string& relative_dir)
+    {
+        std::vector<fs::path> libraries;
+        for (auto&& entry : tree.entries())
+        {
+            if (entry.is_directory || entry.is_symlink) continue;
+            if (entry.file_class != FileClass::SHARED_OBJECT && entry.file_class != FileClass::STATIC_ARCHIVE) continue;
+            if (Strings::starts_with(entry.relative_path, relative_dir + '/')) libraries.push_back(entry.path);
+        }
+        return libraries;
+    }
+
+    struct ElfLibrary
+    {
+        std::vector<uint16_t> machines;
+        Optional<ElfFileReader::ElfInfo> elf;
+    };
+
+    static ElfLibrary read_elf_library(const fs::path& file)
+    {
+        ElfLibrary library;
+        if (file.extension() == ".a")
+        {
+            auto maybe_machines = ElfFileReader::read_archive_machines(file);
+            if (auto machines = maybe_machines.get()) library.machines = std::move(*machines);
+        }
+        else
+        {
+            library.elf = ElfFileReader::read_elf(file);
+            if (auto elf = library.elf.get()) library.machines.push_back(elf->machine);
+        }
+        return library;
+    }
+
+    struct FileAndSearchPath
+    {
+        fs::path file;
+        std::string search_path;
+    };
+
+    static LintStatus check_elf_libraries(const std::string& expected_architecture,
+                                          const std::vector<fs::path>& libraries,
+                                          const fs::path& package_dir,
+                                          const Build::BuildPolicies& policies)
+    {
+        const auto infos = inspect_in_parallel<ElfLibrary>(libraries, read_elf_library);
+
+        std::vector<FileAndArch> binaries_with_invalid_architecture;
+        std::vector<FileAndSearchPath> absolute_search_paths;
+        std::vector<fs::path> missing_sonames;
+        for (size_t i = 0; i < libraries.size(); ++i)
+        {
+            for (const uint16_t machine : infos[i].machines)
+            {
+                const std::string actual_architecture = ElfFileReader::to_architecture(machine);
+                if (expected_architecture != actual_architecture)
+                {
+                    binaries_with_invalid_architecture.push_back({libraries[i], actual_architecture});
+                    break;
+                }
+            }
+
+            const auto elf = infos[i].elf.get();
+            if (!elf || elf->type != ElfFileReader::ElfType::SHARED_OBJECT) continue;
+
+            if (!policies.is_enabled(BuildPolicy::ALLOW_ABSOLUTE_RPATH))
+            {
+                for (auto&& search_path : elf->search_paths)
+                {
+                    if (Strings::starts_with(search_path, "/"))
+                    {
+                        absolute_search_paths.push_back({libraries[i], search_path});
+                    }
+                }
+            }
+
+            // Plugins in subdirectories are loaded by path and need no SONAME
+            const auto dir = libraries[i].parent_path();
+            if (!policies.is_enabled(BuildPolicy::ALLOW_MISSING_SONAME) && !elf->soname.has_value() &&
+                (dir == package_dir / "lib" || dir == package_dir / "debug" / "lib"))
+            {
+                missing_sonames.push_back(libraries[i]);
             }
         }
 
         if (!binaries_with_invalid_architecture.empty())
         {
             print_invalid_architecture_files(expected_architecture, binaries_with_invalid_architecture);
-            return LintStatus::ERROR_DETECTED;
         }
-#endif
-        Util::unused(expected_architecture, files);
-        return LintStatus::SUCCESS;
+
+        if (!absolute_search_paths.empty())
+        {
+            System::print2(System::Color::warning,
+                           "The following shared objects search absolute paths for their dependencies, which will "
+                           "not exist where the package is installed:\n\n");
+            for (const FileAndSearchPath& leak : absolute_search_paths)
+            {
+                System::print2("    ", leak.file.u8string(), ": ", leak.search_path, "\n");
+            }
+            System::print2("\n");
+            System::print2(System::Color::warning,
+                           "Use paths relative to $ORIGIN instead, or pass -DCMAKE_SKIP_INSTALL_RPATH=ON. If the "
+                           "paths are meant to be absolute, set VCPKG_POLICY_ALLOW_ABSOLUTE_RPATH to enabled in the "
+                           "portfile.\n\n");
+        }
+
+        if (!missing_sonames.empty())
+        {
+            System::print2(System::Color::warning,
+                           "The following shared objects have no SONAME, so programs linking to them will look for "
+                           "them by the path they were linked from:\n");
+            Files::print_paths(missing_sonames);
+            System::print2(System::Color::warning,
+                           "If they are only ever loaded by path, set VCPKG_POLICY_ALLOW_MISSING_SONAME to enabled in "
+                           "the portfile.\n\n");
+        }
+
+        const bool has_errors =
+            !binaries_with_invalid_architecture.empty() || !absolute_search_paths.empty() || !missing_sonames.empty();
+        return has_errors ? LintStatus::ERROR_DETECTED : LintStatus::SUCCESS;
     }
 
     static LintStatus check_no_dlls_present(const std::vector<fs::path>& dlls)
@@ -533,18 +714,18 @@ namespace vcpkg::PostBuildLint
         return LintStatus::SUCCESS;
     }
 
-    static LintStatus check_bin_folders_are_not_present_in_static_build(const Files::Filesystem& fs,
+    static LintStatus check_bin_folders_are_not_present_in_static_build(const PackageTree& tree,
                                                                         const fs::path& package_dir)
     {
         const fs::path bin = package_dir / "bin";
         const fs::path debug_bin = package_dir / "debug" / "bin";
 
-        if (!fs.exists(bin) && !fs.exists(debug_bin))
+        if (!tree.exists("bin") && !tree.exists("debug/bin"))
         {
             return LintStatus::SUCCESS;
         }
 
-        if (fs.exists(bin))
+        if (tree.exists("bin"))
         {
             System::printf(System::Color::warning,
                            R"(There should be no bin\ directory in a static build, but %s is present.)"
@@ -552,7 +733,7 @@ namespace vcpkg::PostBuildLint
                            bin.u8string());
         }
 
-        if (fs.exists(debug_bin))
+        if (tree.exists("debug/bin"))
         {
             System::printf(System::Color::warning,
                            R"(There should be no debug\bin\ directory in a static build, but %s is present.)"
@@ -575,17 +756,13 @@ namespace vcpkg::PostBuildLint
         return LintStatus::ERROR_DETECTED;
     }
 
-    static LintStatus check_no_empty_folders(const Files::Filesystem& fs, const fs::path& dir)
+    static LintStatus check_no_empty_folders(const PackageTree& tree)
     {
-        std::vector<fs::path> empty_directories = fs.get_files_recursive(dir);
-
-        Util::erase_remove_if(empty_directories, [&fs](const fs::path& current) {
-            return !fs.is_directory(current) || !fs.is_empty(current);
-        });
+        const std::vector<fs::path> empty_directories = tree.empty_directories();
 
         if (!empty_directories.empty())
         {
-            System::print2(System::Color::warning, "There should be no empty directories in ", dir.u8string(), "\n");
+            System::print2(System::Color::warning, "There should be no empty directories in ", tree.package_dir().u8string(), "\n");
             System::print2("The following empty directories were found:\n");
             Files::print_paths(empty_directories);
             System::print2(
@@ -620,22 +797,14 @@ namespace vcpkg::PostBuildLint
 
         std::vector<BuildTypeAndFile> libs_with_invalid_crt;
 
-        for (const fs::path& lib : libs)
+        const auto outputs = run_dumpbin(dumpbin_exe, "/directives", libs);
+        for (size_t i = 0; i < libs.size(); ++i)
         {
-            const std::string cmd_line =
-                Strings::format(R"("%s" /directives "%s")", dumpbin_exe.u8string(), lib.u8string());
-            System::ExitCodeAndOutput ec_data = System::cmd_execute_and_capture_output(cmd_line);
-            Checks::check_exit(VCPKG_LINE_INFO,
-                               ec_data.exit_code == 0,
-                               "Running command:\n   %s\n failed with message:\n%s",
-                               cmd_line,
-                               ec_data.output);
-
             for (const BuildType& bad_build_type : bad_build_types)
             {
-                if (std::regex_search(ec_data.output.cbegin(), ec_data.output.cend(), bad_build_type.crt_regex()))
+                if (std::regex_search(outputs[i].cbegin(), outputs[i].cend(), bad_build_type.crt_regex()))
                 {
-                    libs_with_invalid_crt.push_back({lib, bad_build_type});
+                    libs_with_invalid_crt.push_back({libs[i], bad_build_type});
                     break;
                 }
             }
@@ -646,7 +815,7 @@ namespace vcpkg::PostBuildLint
             System::printf(System::Color::warning,
                            "Expected %s crt linkage, but the following libs had invalid crt linkage:\n\n",
                            expected_build_type.to_string());
-            for (const BuildTypeAndFile btf : libs_with_invalid_crt)
+            for (const BuildTypeAndFile& btf : libs_with_invalid_crt)
             {
                 System::printf("    %s: %s\n", btf.file.generic_string(), btf.build_type.to_string());
             }
@@ -675,17 +844,14 @@ namespace vcpkg::PostBuildLint
 
         std::vector<OutdatedDynamicCrtAndFile> dlls_with_outdated_crt;
 
-        for (const fs::path& dll : dlls)
+        const auto outputs = run_dumpbin(dumpbin_exe, "/dependents", dlls);
+        for (size_t i = 0; i < dlls.size(); ++i)
         {
-            const auto cmd_line = Strings::format(R"("%s" /dependents "%s")", dumpbin_exe.u8string(), dll.u8string());
-            System::ExitCodeAndOutput ec_data = System::cmd_execute_and_capture_output(cmd_line);
-            Checks::check_exit(VCPKG_LINE_INFO, ec_data.exit_code == 0, "Running command:\n   %s\n failed", cmd_line);
-
             for (const OutdatedDynamicCrt& outdated_crt : get_outdated_dynamic_crts(pre_build_info.platform_toolset))
             {
-                if (std::regex_search(ec_data.output.cbegin(), ec_data.output.cend(), outdated_crt.regex))
+                if (std::regex_search(outputs[i].cbegin(), outputs[i].cend(), outdated_crt.regex))
                 {
-                    dlls_with_outdated_crt.push_back({dll, outdated_crt});
+                    dlls_with_outdated_crt.push_back({dlls[i], outdated_crt});
                     break;
                 }
             }
@@ -694,7 +860,7 @@ namespace vcpkg::PostBuildLint
         if (!dlls_with_outdated_crt.empty())
         {
             System::print2(System::Color::warning, "Detected outdated dynamic CRT in the following files:\n\n");
-            for (const OutdatedDynamicCrtAndFile btf : dlls_with_outdated_crt)
+            for (const OutdatedDynamicCrtAndFile& btf : dlls_with_outdated_crt)
             {
                 System::print2("    ", btf.file.u8string(), ": ", btf.outdated_crt.name, "\n");
             }
@@ -708,23 +874,19 @@ namespace vcpkg::PostBuildLint
         return LintStatus::SUCCESS;
     }
 
-    static LintStatus check_no_files_in_dir(const Files::Filesystem& fs, const fs::path& dir)
+    static LintStatus check_no_files_in_dir(const PackageTree& tree, const fs::path& package_dir, StringView dir)
     {
-        std::vector<fs::path> misplaced_files = fs.get_files_non_recursive(dir);
-        Util::erase_remove_if(misplaced_files, [&fs](const fs::path& path) {
+        std::vector<fs::path> misplaced_files = tree.files_directly_in(dir);
+        Util::erase_remove_if(misplaced_files, [](const fs::path& path) {
             const std::string filename = path.filename().generic_string();
-            if (Strings::case_insensitive_ascii_equals(filename, "CONTROL") ||
-                Strings::case_insensitive_ascii_equals(filename, "BUILD_INFO"))
-            {
-                return true;
-            }
-
-            return fs.is_directory(path);
+            return Strings::case_insensitive_ascii_equals(filename, "CONTROL") ||
+                   Strings::case_insensitive_ascii_equals(filename, "BUILD_INFO");
         });
 
         if (!misplaced_files.empty())
         {
-            System::print2(System::Color::warning, "The following files are placed in\n", dir.u8string(), ":\n");
+            const fs::path full_dir = dir.size() == 0 ? package_dir : package_dir / fs::u8path(dir.to_string());
+            System::print2(System::Color::warning, "The following files are placed in\n", full_dir.u8string(), ":\n");
             Files::print_paths(misplaced_files);
             System::print2(System::Color::warning, "Files cannot be present in those directories.\n\n");
             return LintStatus::ERROR_DETECTED;
@@ -753,27 +915,25 @@ namespace vcpkg::PostBuildLint
             return error_count;
         }
 
-        error_count += check_for_files_in_include_directory(fs, build_info.policies, package_dir);
-        error_count += check_for_files_in_debug_include_directory(fs, package_dir);
-        error_count += check_for_files_in_debug_share_directory(fs, package_dir);
-        error_count += check_folder_lib_cmake(fs, package_dir, spec);
-        error_count += check_for_misplaced_cmake_files(fs, package_dir, spec);
-        error_count += check_folder_debug_lib_cmake(fs, package_dir, spec);
-        error_count += check_for_dlls_in_lib_dir(fs, package_dir);
-        error_count += check_for_dlls_in_lib_dir(fs, package_dir / "debug");
+        const PackageTree tree = PackageTree::scan(fs, package_dir);
+
+        error_count += check_for_files_in_include_directory(tree, build_info.policies);
+        error_count += check_for_files_in_debug_include_directory(tree);
+        error_count += check_for_files_in_debug_share_directory(tree);
+        error_count += check_folder_lib_cmake(tree, spec);
+        error_count += check_for_misplaced_cmake_files(tree, spec);
+        error_count += check_folder_debug_lib_cmake(tree, spec);
+        error_count += check_for_dlls_in_lib_dir(tree, "lib");
+        error_count += check_for_dlls_in_lib_dir(tree, "debug/lib");
         error_count += check_for_copyright_file(fs, spec, paths);
-        error_count += check_for_exes(fs, package_dir);
-        error_count += check_for_exes(fs, package_dir / "debug");
+        error_count += check_for_exes(tree, "bin");
+        error_count += check_for_exes(tree, "debug/bin");
 
         const fs::path debug_lib_dir = package_dir / "debug" / "lib";
         const fs::path release_lib_dir = package_dir / "lib";
-        const fs::path debug_bin_dir = package_dir / "debug" / "bin";
-        const fs::path release_bin_dir = package_dir / "bin";
 
-        std::vector<fs::path> debug_libs = fs.get_files_recursive(debug_lib_dir);
-        Util::erase_remove_if(debug_libs, not_extension_pred(fs, ".lib"));
-        std::vector<fs::path> release_libs = fs.get_files_recursive(release_lib_dir);
-        Util::erase_remove_if(release_libs, not_extension_pred(fs, ".lib"));
+        const std::vector<fs::path> debug_libs = tree.files_below("debug/lib", FileClass::LIB);
+        const std::vector<fs::path> release_libs = tree.files_below("lib", FileClass::LIB);
 
         if (!pre_build_info.build_type)
             error_count += check_matching_debug_and_release_binaries(debug_libs, release_libs);
@@ -786,10 +946,23 @@ namespace vcpkg::PostBuildLint
             error_count += check_lib_architecture(pre_build_info.target_architecture, libs);
         }
 
-        std::vector<fs::path> debug_dlls = fs.get_files_recursive(debug_bin_dir);
-        Util::erase_remove_if(debug_dlls, not_extension_pred(fs, ".dll"));
-        std::vector<fs::path> release_dlls = fs.get_files_recursive(release_bin_dir);
-        Util::erase_remove_if(release_dlls, not_extension_pred(fs, ".dll"));
+        {
+            const std::vector<fs::path> debug_elf_libs = elf_libraries_below(tree, "debug/lib");
+            const std::vector<fs::path> release_elf_libs = elf_libraries_below(tree, "lib");
+
+            if (!pre_build_info.build_type)
+                error_count += check_matching_debug_and_release_binaries(debug_elf_libs, release_elf_libs);
+
+            std::vector<fs::path> elf_libs;
+            elf_libs.insert(elf_libs.cend(), debug_elf_libs.cbegin(), debug_elf_libs.cend());
+            elf_libs.insert(elf_libs.cend(), release_elf_libs.cbegin(), release_elf_libs.cend());
+
+            error_count += check_elf_libraries(
+                pre_build_info.target_architecture, elf_libs, package_dir, build_info.policies);
+        }
+
+        const std::vector<fs::path> debug_dlls = tree.files_below("debug/bin", FileClass::DLL);
+        const std::vector<fs::path> release_dlls = tree.files_below("bin", FileClass::DLL);
 
         switch (build_info.library_linkage)
         {
@@ -815,9 +988,7 @@ namespace vcpkg::PostBuildLint
                         check_outdated_crt_linkage_of_dlls(dlls, toolset.dumpbin, build_info, pre_build_info);
                 }
 
-#if defined(_WIN32)
                 error_count += check_dll_architecture(pre_build_info.target_architecture, dlls);
-#endif
                 break;
             }
             case Build::LinkageType::STATIC:
@@ -826,7 +997,7 @@ namespace vcpkg::PostBuildLint
                 dlls.insert(dlls.end(), debug_dlls.begin(), debug_dlls.end());
                 error_count += check_no_dlls_present(dlls);
 
-                error_count += check_bin_folders_are_not_present_in_static_build(fs, package_dir);
+                error_count += check_bin_folders_are_not_present_in_static_build(tree, package_dir);
 
                 if (!toolset.dumpbin.empty())
                 {
@@ -847,9 +1018,9 @@ namespace vcpkg::PostBuildLint
             default: Checks::unreachable(VCPKG_LINE_INFO);
         }
 
-        error_count += check_no_empty_folders(fs, package_dir);
-        error_count += check_no_files_in_dir(fs, package_dir);
-        error_count += check_no_files_in_dir(fs, package_dir / "debug");
+        error_count += check_no_empty_folders(tree);
+        error_count += check_no_files_in_dir(tree, package_dir, "");
+        error_count += check_no_files_in_dir(tree, package_dir, "debug");
 
         return error_count;
     }
@@ -0,0 +1,138 @@
+#include "pch.h"
+
+#include <vcpkg/base/strings.h>
+#include <vcpkg/base/util.h>
+#include <vcpkg/postbuildlint.packagetree.h>
+
+namespace vcpkg::PostBuildLint
+{
+    static FileClass classify(const fs::path& path)
+    {
+        const auto extension = path.extension();
+        if (extension == ".lib") return FileClass::LIB;
+        if (extension == ".dll") return FileClass::DLL;
+        if (extension == ".exe") return FileClass::EXE;
+        if (extension == ".cmake") return FileClass::CMAKE;
+        if (extension == ".ifc") return FileClass::IFC;
+        if (extension == ".a") return FileClass::STATIC_ARCHIVE;
+        if (extension == ".so" || path.filename().u8string().find(".so.") != std::string::npos)
+            return FileClass::SHARED_OBJECT;
+        return FileClass::OTHER;
+    }
+
+    static bool is_below(const std::string& relative_path, StringView relative_dir)
+    {
+        return relative_path.size() > relative_dir.size() && Strings::starts_with(relative_path, relative_dir) &&
+               relative_path[relative_dir.size()] == '/';
+    }
+
+    static StringView parent_of(const std::string& relative_path)
+    {
+        const auto slash = relative_path.find_last_of('/');
+        if (slash == std::string::npos) return {};
+        return StringView{relative_path.data(), slash};
+    }
+
+    template<class Entries>
+    static auto find_entry(Entries& entries, StringView relative_path) -> decltype(&entries[0])
+    {
+        const std::string key = relative_path.to_string();
+        const auto it = std::lower_bound(
+            entries.begin(), entries.end(), key, [](const PackageTreeEntry& entry, const std::string& k) {
+                return entry.relative_path < k;
+            });
+        if (it == entries.end() || it->relative_path != key) return nullptr;
+        return &*it;
+    }
+
+    PackageTree PackageTree::scan(const Files::Filesystem& fs, const fs::path& package_dir)
+    {
+        PackageTree tree;
+        tree.m_package_dir = package_dir;
+        const auto root = package_dir.generic_u8string();
+
+        fs.walk_directory(package_dir, [&](const Files::DirectoryEntry& walked) {
+            PackageTreeEntry entry;
+            entry.relative_path = walked.path.generic_u8string().substr(root.size());
+            while (!entry.relative_path.empty() && entry.relative_path.front() == '/')
+                entry.relative_path.erase(0, 1);
+
+            // The walk already knows each entry's type; only links need a stat to see what they point to
+            std::error_code ec;
+            entry.is_walked_directory = walked.type == fs::file_type::directory;
+            entry.is_symlink = fs::is_symlink(fs::file_status(walked.type));
+            entry.is_directory =
+                entry.is_walked_directory || (entry.is_symlink && fs::is_directory(fs.status(walked.path, ec)));
+            if (!entry.is_directory) entry.file_class = classify(walked.path);
+            // Only the binaries, which the checks go on to read anyway, are worth a stat for their size
+            if (entry.file_class != FileClass::OTHER && entry.file_class != FileClass::CMAKE &&
+                entry.file_class != FileClass::IFC)
+            {
+                entry.size = fs.file_size(walked.path, ec);
+            }
+
+            entry.path = walked.path;
+            tree.m_entries.push_back(std::move(entry));
+        });
+
+        Util::sort(tree.m_entries,
+                   [](const PackageTreeEntry& lhs, const PackageTreeEntry& rhs) {
+                       return lhs.relative_path < rhs.relative_path;
+                   });
+
+        for (auto&& entry : tree.m_entries)
+        {
+            const auto parent = parent_of(entry.relative_path);
+            if (parent.size() == 0) continue;
+            auto parent_entry = find_entry(tree.m_entries, parent);
+            if (parent_entry) ++parent_entry->child_count;
+        }
+
+        return tree;
+    }
+
+    bool PackageTree::exists(StringView relative_path) const
+    {
+        return find_entry(m_entries, relative_path) != nullptr;
+    }
+
+    bool PackageTree::is_empty_directory(StringView relative_path) const
+    {
+        const auto entry = find_entry(m_entries, relative_path);
+        return entry && entry->is_walked_directory && entry->child_count == 0;
+    }
+
+    std::vector<fs::path> PackageTree::files_below(StringView relative_dir, FileClass file_class) const
+    {
+        std::vector<fs::path> files;
+        for (auto&& entry : m_entries)
+        {
+            if (!entry.is_directory && entry.file_class == file_class && is_below(entry.relative_path, relative_dir))
+                files.push_back(entry.path);
+        }
+        return files;
+    }
+
+    std::vector<fs::path> PackageTree::files_directly_in(StringView relative_dir) const
+    {
+        std::vector<fs::path> files;
+        for (auto&& entry : m_entries)
+        {
+            if (entry.is_directory) continue;
+            const auto parent = parent_of(entry.relative_path);
+            if (parent.size() == relative_dir.size() && Strings::starts_with(entry.relative_path, relative_dir))
+                files.push_back(entry.path);
+        }
+        return files;
+    }
+
+    std::vector<fs::path> PackageTree::empty_directories() const
+    {
+        std::vector<fs::path> directories;
+        for (auto&& entry : m_entries)
+        {
+            if (entry.is_walked_directory && entry.child_count == 0) directories.push_back(entry.path);
+        }
+        return directories;
+    }
+}
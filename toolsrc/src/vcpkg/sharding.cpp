@@ -0,0 +1,237 @@
+#include "pch.h"
+
+#include <vcpkg/base/strings.h>
+#include <vcpkg/base/util.h>
+#include <vcpkg/sharding.h>
+
+#include <map>
+
+namespace vcpkg::Sharding
+{
+    static Optional<size_t> parse_positive(StringView text)
+    {
+        if (text.size() == 0 || text.size() > 9) return nullopt;
+        size_t value = 0;
+        for (char c : text)
+        {
+            if (c < '0' || c > '9') return nullopt;
+            value = value * 10 + static_cast<size_t>(c - '0');
+        }
+        if (value == 0) return nullopt;
+        return value;
+    }
+
+    Optional<ShardIndex> parse_shard(StringView text)
+    {
+        const auto slash = std::find(text.begin(), text.end(), '/');
+        if (slash == text.end()) return nullopt;
+
+        auto maybe_index = parse_positive(StringView{text.begin(), slash});
+        auto maybe_count = parse_positive(StringView{slash + 1, text.end()});
+        const auto index = maybe_index.get();
+        const auto count = maybe_count.get();
+        if (!index || !count || *index > *count) return nullopt;
+
+        return ShardIndex{*index - 1, *count};
+    }
+
+    /// <summary>
+    /// v followed by everything it depends on, directly or not.
+    /// </summary>
+    static std::vector<std::uint32_t> dependency_closure(const Graphs::CsrGraph& graph,
+                                                         std::uint32_t v,
+                                                         std::vector<std::uint32_t>& seen_at,
+                                                         std::uint32_t generation)
+    {
+        std::vector<std::uint32_t> closure{v};
+        seen_at[v] = generation;
+        for (size_t i = 0; i < closure.size(); ++i)
+        {
+            for (std::uint32_t dep : graph.adjacency_list(closure[i]))
+            {
+                if (seen_at[dep] == generation) continue;
+                seen_at[dep] = generation;
+                closure.push_back(dep);
+            }
+        }
+        return closure;
+    }
+
+    std::vector<size_t> assign_owners(const Graphs::CsrGraph& graph,
+                                      const std::vector<std::uint64_t>& costs,
+                                      size_t shard_count)
+    {
+        Checks::check_exit(VCPKG_LINE_INFO, shard_count > 0);
+
+        const auto& vertices = graph.vertex_list();
+        std::vector<std::uint32_t> seen_at(graph.vertex_bound(), 0);
+        std::vector<std::vector<std::uint32_t>> closures(graph.vertex_bound());
+        std::vector<std::uint64_t> closure_costs(graph.vertex_bound(), 0);
+        std::uint32_t generation = 0;
+        for (std::uint32_t v : vertices)
+        {
+            closures[v] = dependency_closure(graph, v, seen_at, ++generation);
+            for (std::uint32_t w : closures[v])
+                closure_costs[v] += costs[w];
+        }
+
+        auto order = vertices;
+        Util::sort(order, [&](std::uint32_t lhs, std::uint32_t rhs) {
+            if (closure_costs[lhs] != closure_costs[rhs]) return closure_costs[lhs] > closure_costs[rhs];
+            return lhs < rhs;
+        });
+
+        std::vector<size_t> owners(graph.vertex_bound(), 0);
+        std::vector<std::uint64_t> loads(shard_count, 0);
+        std::vector<std::vector<bool>> installs(shard_count, std::vector<bool>(graph.vertex_bound(), false));
+        for (std::uint32_t v : order)
+        {
+            size_t best_shard = 0;
+            std::uint64_t best_load = 0;
+            for (size_t shard = 0; shard < shard_count; ++shard)
+            {
+                std::uint64_t load = loads[shard];
+                for (std::uint32_t w : closures[v])
+                {
+                    if (!installs[shard][w]) load += costs[w];
+                }
+                if (shard == 0 || load < best_load)
+                {
+                    best_shard = shard;
+                    best_load = load;
+                }
+            }
+
+            owners[v] = best_shard;
+            loads[best_shard] = best_load;
+            for (std::uint32_t w : closures[v])
+                installs[best_shard][w] = true;
+        }
+
+        return owners;
+    }
+
+    std::vector<bool> shard_closure(const Graphs::CsrGraph& graph, const std::vector<size_t>& owners, size_t shard)
+    {
+        std::vector<bool> installs(graph.vertex_bound(), false);
+        std::vector<std::uint32_t> stack;
+        for (std::uint32_t v : graph.vertex_list())
+        {
+            if (owners[v] != shard || installs[v]) continue;
+
+            installs[v] = true;
+            stack.push_back(v);
+            while (!stack.empty())
+            {
+                const std::uint32_t u = stack.back();
+                stack.pop_back();
+                for (std::uint32_t dep : graph.adjacency_list(u))
+                {
+                    if (installs[dep]) continue;
+                    installs[dep] = true;
+                    stack.push_back(dep);
+                }
+            }
+        }
+        return installs;
+    }
+
+    static std::string::size_type find_attribute(const std::string& line, StringLiteral name, size_t& length)
+    {
+        const auto key = Strings::concat(' ', name, "=\"");
+        const auto start = line.find(key);
+        if (start == std::string::npos) return start;
+        const auto value_start = start + key.size();
+        const auto value_end = line.find('"', value_start);
+        if (value_end == std::string::npos) return value_end;
+        length = value_end - value_start;
+        return value_start;
+    }
+
+    static std::string get_attribute(const std::string& line, StringLiteral name)
+    {
+        size_t length = 0;
+        const auto start = find_attribute(line, name, length);
+        if (start == std::string::npos) return {};
+        return line.substr(start, length);
+    }
+
+    static std::string set_attribute(std::string line, StringLiteral name, const std::string& value)
+    {
+        size_t length = 0;
+        const auto start = find_attribute(line, name, length);
+        if (start != std::string::npos) line.replace(start, length, value);
+        return line;
+    }
+
+    static long long get_time(const std::string& line)
+    {
+        const auto time = get_attribute(line, "time");
+        return time.empty() ? 0 : std::atoll(time.c_str());
+    }
+
+    std::string merge_xunit(const std::vector<std::string>& documents)
+    {
+        struct Collection
+        {
+            std::string header;
+            long long time = 0;
+            std::vector<std::string> tests;
+        };
+
+        std::string assembly_header;
+        long long assembly_time = 0;
+        std::vector<std::string> collection_names;
+        std::map<std::string, Collection> collections;
+
+        for (auto&& document : documents)
+        {
+            Collection* current = nullptr;
+            for (auto&& line : Strings::split(document, "\n"))
+            {
+                if (!line.empty() && line.back() == '\r') line.pop_back();
+                const auto first = line.find_first_not_of(' ');
+                if (first == std::string::npos) continue;
+                const StringView trimmed{line.data() + first, line.data() + line.size()};
+
+                if (Strings::starts_with(trimmed, "<assembly "))
+                {
+                    if (assembly_header.empty()) assembly_header = line;
+                    assembly_time = std::max(assembly_time, get_time(line));
+                }
+                else if (Strings::starts_with(trimmed, "<collection "))
+                {
+                    const auto name = get_attribute(line, "name");
+                    auto emplaced = collections.emplace(name, Collection{});
+                    current = &emplaced.first->second;
+                    if (emplaced.second)
+                    {
+                        collection_names.push_back(name);
+                        current->header = line;
+                    }
+                    current->time = std::max(current->time, get_time(line));
+                }
+                else if (Strings::starts_with(trimmed, "<test ") && current)
+                {
+                    current->tests.push_back(line);
+                }
+            }
+        }
+
+        if (assembly_header.empty()) assembly_header = R"(  <assembly name="vcpkg" time="0">)";
+
+        std::string xml = "<assemblies>\n";
+        Strings::append(xml, set_attribute(assembly_header, "time", std::to_string(assembly_time)), '\n');
+        for (auto&& name : collection_names)
+        {
+            const auto& collection = collections.at(name);
+            Strings::append(xml, set_attribute(collection.header, "time", std::to_string(collection.time)), '\n');
+            for (auto&& test : collection.tests)
+                Strings::append(xml, test, '\n');
+            xml += "    </collection>\n";
+        }
+        xml += "  </assembly>\n"
+               "</assemblies>\n";
+        return xml;
+    }
+}
@@ -27,6 +27,7 @@ namespace vcpkg
         static const std::string VERSION = "Version";
         static const std::string HOMEPAGE = "Homepage";
         static const std::string TYPE = "Type";
+        static const std::string PEAK_MEMORY_MB = "Peak-Memory-Mb";
     }
 
     static Span<const std::string> get_list_of_valid_fields()
@@ -39,6 +40,7 @@ namespace vcpkg
             SourceParagraphFields::BUILD_DEPENDS,
             SourceParagraphFields::HOMEPAGE,
             SourceParagraphFields::TYPE,
+            SourceParagraphFields::PEAK_MEMORY_MB,
         };
 
         return valid_fields;
@@ -86,6 +88,20 @@ namespace vcpkg
             System::print2("Different source may be available for vcpkg. Use .\\bootstrap-vcpkg.bat to update.\n\n");
         }
 
+        for (auto&& error_info : error_info_list)
+        {
+            if (!error_info->invalid_fields.empty())
+            {
+                System::print2(System::Color::error,
+                               "Error: There are fields with invalid values in the control file of ",
+                               error_info->name,
+                               '\n');
+                System::print2("The following fields could not be parsed:\n\n    ",
+                               Strings::join("\n    ", error_info->invalid_fields),
+                               "\n\n");
+            }
+        }
+
         for (auto&& error_info : error_info_list)
         {
             if (!error_info->missing_fields.empty())
@@ -135,6 +151,15 @@ namespace vcpkg
         spgh->supports = parse_comma_list(parser.optional_field(SourceParagraphFields::SUPPORTS));
         spgh->default_features = parse_comma_list(parser.optional_field(SourceParagraphFields::DEFAULTFEATURES));
         spgh->type = Type::from_string(parser.optional_field(SourceParagraphFields::TYPE));
+        const auto peak_memory = parser.optional_field(SourceParagraphFields::PEAK_MEMORY_MB);
+        if (!peak_memory.empty())
+        {
+            if (peak_memory.size() <= 9 &&
+                std::all_of(peak_memory.begin(), peak_memory.end(), [](char c) { return c >= '0' && c <= '9'; }))
+                spgh->peak_memory_mb = std::stoull(peak_memory);
+            else
+                parser.invalid_field(SourceParagraphFields::PEAK_MEMORY_MB);
+        }
         auto err = parser.error_info(spgh->name);
         if (err)
             return err;
@@ -10,6 +10,7 @@
 #include <vcpkg/base/optional.h>
 #include <vcpkg/base/strings.h>
 #include <vcpkg/base/stringview.h>
+#include <vcpkg/base/system.h>
 #include <vcpkg/base/system.print.h>
 #include <vcpkg/base/system.process.h>
 #include <vcpkg/base/util.h>
@@ -119,12 +120,6 @@ namespace vcpkg
 #endif
     }
 
-    struct PathAndVersion
-    {
-        fs::path path;
-        std::string version;
-    };
-
     struct ToolProvider
     {
         virtual const std::string& tool_data_name() const = 0;
@@ -186,7 +181,11 @@ namespace vcpkg
         {
             System::print2("Downloading ", tool_name, "...\n");
             System::print2("  ", tool_data.url, " -> ", tool_data.download_path.u8string(), "\n");
-            Downloads::download_file(fs, tool_data.url, tool_data.download_path, tool_data.sha512);
+            Downloads::download_file(fs,
+                                     Downloads::DownloadStore::for_downloads_dir(paths.downloads),
+                                     tool_data.url,
+                                     tool_data.download_path,
+                                     tool_data.sha512);
         }
         else
         {
@@ -427,10 +426,164 @@ git version 2.17.1.windows.2
         }
     };
 
+    static constexpr StringLiteral PERSISTED_TOOLS_HEADER = "vcpkg-tool-cache v1";
+
+    // "<size> <mtime>" of a file, or nothing if it cannot be read
+    static Optional<std::string> stamp_of(const fs::path& path)
+    {
+        std::error_code ec;
+        const auto size = fs::stdfs::file_size(path, ec);
+        if (ec) return nullopt;
+        const auto mtime = fs::stdfs::last_write_time(path, ec);
+        if (ec) return nullopt;
+        return Strings::concat(size, ' ', static_cast<long long>(mtime.time_since_epoch().count()));
+    }
+
+    static std::string escape(const std::string& s)
+    {
+        std::string result;
+        for (const char c : s)
+        {
+            if (c == '\\')
+                result += "\\\\";
+            else if (c == '\t')
+                result += "\\t";
+            else if (c == '\n')
+                result += "\\n";
+            else if (c == '\r')
+                result += "\\r";
+            else
+                result += c;
+        }
+        return result;
+    }
+
+    static std::string unescape(const std::string& s)
+    {
+        std::string result;
+        for (size_t i = 0; i < s.size(); ++i)
+        {
+            if (s[i] != '\\' || i + 1 == s.size())
+            {
+                result += s[i];
+                continue;
+            }
+
+            const char c = s[++i];
+            result += c == 't' ? '\t' : c == 'n' ? '\n' : c == 'r' ? '\r' : c;
+        }
+        return result;
+    }
+
+    static std::vector<std::string> split_fields(const std::string& line)
+    {
+        std::vector<std::string> fields;
+        size_t start = 0;
+        for (size_t tab = line.find('\t'); tab != std::string::npos; tab = line.find('\t', start))
+        {
+            fields.push_back(unescape(line.substr(start, tab - start)));
+            start = tab + 1;
+        }
+        fields.push_back(unescape(line.substr(start)));
+        return fields;
+    }
+
+    PersistedTools PersistedTools::load(const Files::Filesystem& fs,
+                                        const fs::path& file,
+                                        const std::string& path_variable,
+                                        const fs::path& tools_xml)
+    {
+        PersistedTools result;
+        result.m_file = file;
+        result.m_context = Strings::concat(escape(path_variable), '\t', escape(stamp_of(tools_xml).value_or("")));
+
+        auto maybe_lines = fs.read_lines(file);
+        const auto lines = maybe_lines.get();
+        if (!lines || lines->size() < 2 || (*lines)[0] != PERSISTED_TOOLS_HEADER || (*lines)[1] != result.m_context)
+            return result;
+
+        // tool TAB path TAB stamp TAB version
+        for (auto it = lines->begin() + 2; it != lines->end(); ++it)
+        {
+            auto fields = split_fields(*it);
+            if (fields.size() != 4) continue;
+            result.m_entries[fields[0]] = Entry{{fs::u8path(fields[1]), std::move(fields[3])}, std::move(fields[2])};
+        }
+        return result;
+    }
+
+    Optional<PathAndVersion> PersistedTools::find(const std::string& tool) const
+    {
+        const auto it = m_entries.find(tool);
+        if (it == m_entries.end()) return nullopt;
+
+        const auto& entry = it->second;
+        auto maybe_stamp = stamp_of(entry.path_and_version.path);
+        const auto stamp = maybe_stamp.get();
+        if (!stamp || *stamp != entry.stamp) return nullopt;
+        return entry.path_and_version;
+    }
+
+    void PersistedTools::store(Files::Filesystem& fs, const std::string& tool, const PathAndVersion& path_and_version)
+    {
+        auto maybe_stamp = stamp_of(path_and_version.path);
+        const auto stamp = maybe_stamp.get();
+        if (!stamp) return;
+        m_entries[tool] = Entry{path_and_version, *stamp};
+
+        std::string contents = Strings::concat(PERSISTED_TOOLS_HEADER, '\n', m_context, '\n');
+        for (auto&& entry : m_entries)
+        {
+            Strings::append(contents,
+                            escape(entry.first),
+                            '\t',
+                            escape(entry.second.path_and_version.path.u8string()),
+                            '\t',
+                            escape(entry.second.stamp),
+                            '\t',
+                            escape(entry.second.path_and_version.version),
+                            '\n');
+        }
+
+        // Other vcpkg processes, possibly on other hosts sharing the tools directory, may be reading or writing it;
+        // failing to write it only costs the next run some time
+        std::error_code ec;
+        const auto temp_file = fs::path(m_file).concat(
+            Strings::concat('.', System::get_host_name(), '-', System::get_process_id(), ".tmp"));
+        fs.create_directories(m_file.parent_path(), ec);
+        fs.write_contents(temp_file, contents, ec);
+        if (!ec) fs.rename(temp_file, m_file, ec);
+        if (ec) fs.remove(temp_file, ec);
+    }
+
     struct ToolCacheImpl final : ToolCache
     {
         vcpkg::Cache<std::string, fs::path> path_only_cache;
         vcpkg::Cache<std::string, PathAndVersion> path_version_cache;
+        // Loaded on first use; both only under the mutex
+        mutable std::mutex persisted_tools_mutex;
+        mutable Optional<PersistedTools> persisted_tools;
+
+        PathAndVersion get_path_persisted(const VcpkgPaths& paths, const ToolProvider& provider) const
+        {
+            const auto& tool = provider.tool_data_name();
+            {
+                std::lock_guard<std::mutex> lock(persisted_tools_mutex);
+                if (!persisted_tools)
+                    persisted_tools = PersistedTools::load(paths.get_filesystem(),
+                                                           paths.tools / "tool-cache.txt",
+                                                           System::get_environment_variable("PATH").value_or(""),
+                                                           paths.scripts / "vcpkgTools.xml");
+                auto maybe_found = persisted_tools.get()->find(tool);
+                if (auto found = maybe_found.get()) return std::move(*found);
+            }
+
+            auto path_and_version = get_path(paths, provider);
+
+            std::lock_guard<std::mutex> lock(persisted_tools_mutex);
+            persisted_tools.get()->store(paths.get_filesystem(), tool, path_and_version);
+            return path_and_version;
+        }
 
         virtual const fs::path& get_tool_path(const VcpkgPaths& paths, const std::string& tool) const override
         {
@@ -456,7 +609,7 @@ git version 2.17.1.windows.2
                     {
                         return {"cmake", "0"};
                     }
-                    return get_path(paths, CMakeProvider());
+                    return get_path_persisted(paths, CMakeProvider());
                 }
                 if (tool == Tools::GIT)
                 {
@@ -464,7 +617,7 @@ git version 2.17.1.windows.2
                     {
                         return {"git", "0"};
                     }
-                    return get_path(paths, GitProvider());
+                    return get_path_persisted(paths, GitProvider());
                 }
                 if (tool == Tools::NINJA)
                 {
@@ -472,10 +625,10 @@ git version 2.17.1.windows.2
                     {
                         return {"ninja", "0"};
                     }
-                    return get_path(paths, NinjaProvider());
+                    return get_path_persisted(paths, NinjaProvider());
                 }
-                if (tool == Tools::NUGET) return get_path(paths, NuGetProvider());
-                if (tool == Tools::IFW_INSTALLER_BASE) return get_path(paths, IfwInstallerBaseProvider());
+                if (tool == Tools::NUGET) return get_path_persisted(paths, NuGetProvider());
+                if (tool == Tools::IFW_INSTALLER_BASE) return get_path_persisted(paths, IfwInstallerBaseProvider());
 
                 // For other tools, we simply always auto-download them.
                 auto maybe_tool_data = parse_tool_data_from_xml(paths, tool);
@@ -152,6 +152,25 @@ namespace vcpkg
                         arg.substr(sizeof("--x-scripts-root=") - 1), "--x-scripts-root", args.scripts_root_dir);
                     continue;
                 }
+                if (Strings::starts_with(arg, "--x-install-root="))
+                {
+                    parse_cojoined_value(
+                        arg.substr(sizeof("--x-install-root=") - 1), "--x-install-root", args.install_root_dir);
+                    continue;
+                }
+                if (Strings::starts_with(arg, "--x-packages-root="))
+                {
+                    parse_cojoined_value(
+                        arg.substr(sizeof("--x-packages-root=") - 1), "--x-packages-root", args.packages_root_dir);
+                    continue;
+                }
+                if (Strings::starts_with(arg, "--x-buildtrees-root="))
+                {
+                    parse_cojoined_value(arg.substr(sizeof("--x-buildtrees-root=") - 1),
+                                         "--x-buildtrees-root",
+                                         args.buildtrees_root_dir);
+                    continue;
+                }
                 if (arg == "--triplet")
                 {
                     ++arg_begin;
@@ -170,6 +189,21 @@ namespace vcpkg
                         arg.substr(sizeof("--overlay-triplets=") - 1), "--overlay-triplets", args.overlay_triplets);
                     continue;
                 }
+                if (arg == "--x-buildtrees-per-spec")
+                {
+                    parse_switch(true, "x-buildtrees-per-spec", args.buildtrees_per_spec);
+                    continue;
+                }
+                if (arg == "--x-cache-file-status")
+                {
+                    parse_switch(true, "x-cache-file-status", args.cache_file_status);
+                    continue;
+                }
+                if (arg == "--x-phase-timings")
+                {
+                    parse_switch(true, "x-phase-timings", args.phase_timings);
+                    continue;
+                }
                 if (arg == "--debug")
                 {
                     parse_switch(true, "debug", args.debug);
@@ -432,5 +466,23 @@ namespace vcpkg
         System::printf("    %-40s %s\n",
                        "--x-scripts-root=<path>",
                        "(Experimental) Specify the scripts directory to use instead of default vcpkg scripts directory");
+        System::printf("    %-40s %s\n",
+                       "--x-install-root=<path>",
+                       "(Experimental) Specify the installed directory to use instead of <vcpkg-root>/installed");
+        System::printf("    %-40s %s\n",
+                       "--x-packages-root=<path>",
+                       "(Experimental) Specify the packages directory to use instead of <vcpkg-root>/packages");
+        System::printf("    %-40s %s\n",
+                       "--x-buildtrees-root=<path>",
+                       "(Experimental) Specify the buildtrees directory to use instead of <vcpkg-root>/buildtrees");
+        System::printf("    %-40s %s\n",
+                       "--x-buildtrees-per-spec",
+                       "(Experimental) Build each package in buildtrees/<port>_<triplet> instead of buildtrees/<port>");
+        System::printf("    %-40s %s\n",
+                       "--x-cache-file-status",
+                       "(Experimental) Remember the status of each path instead of asking the filesystem again");
+        System::printf("    %-40s %s\n",
+                       "--x-phase-timings",
+                       "(Experimental) On exit, print the time spent in each phase of vcpkg's own work");
     }
 }
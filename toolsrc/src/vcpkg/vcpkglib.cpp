@@ -1,6 +1,7 @@
 #include "pch.h"
 
 #include <vcpkg/base/files.h>
+#include <vcpkg/base/phases.h>
 #include <vcpkg/base/strings.h>
 #include <vcpkg/base/util.h>
 #include <vcpkg/metrics.h>
@@ -37,17 +38,21 @@ namespace vcpkg
 
     StatusParagraphs database_load_check(const VcpkgPaths& paths)
     {
-        auto& fs = paths.get_filesystem();
+        return database_load_check(paths.get_filesystem(), paths.installed);
+    }
 
-        const auto updates_dir = paths.vcpkg_dir_updates;
+    StatusParagraphs database_load_check(Files::Filesystem& fs, const fs::path& installed)
+    {
+        const auto vcpkg_dir = installed / "vcpkg";
+        const auto updates_dir = vcpkg_dir / "updates";
 
         std::error_code ec;
-        fs.create_directory(paths.installed, ec);
-        fs.create_directory(paths.vcpkg_dir, ec);
-        fs.create_directory(paths.vcpkg_dir_info, ec);
+        fs.create_directory(installed, ec);
+        fs.create_directory(vcpkg_dir, ec);
+        fs.create_directory(vcpkg_dir / "info", ec);
         fs.create_directory(updates_dir, ec);
 
-        const fs::path& status_file = paths.vcpkg_dir_status_file;
+        const fs::path status_file = vcpkg_dir / "status";
         const fs::path status_file_old = status_file.parent_path() / "status-old";
         const fs::path status_file_new = status_file.parent_path() / "status-new";
 
@@ -60,6 +65,8 @@ namespace vcpkg
             // updates directory is empty, control file is up-to-date.
             return current_status_db;
         }
+
+        Phases::Scope phase_scope(Phases::Phase::STATUS_WRITES);
         for (auto&& file : update_files)
         {
             if (!fs.is_regular_file(file)) continue;
@@ -88,6 +95,7 @@ namespace vcpkg
 
     void write_update(const VcpkgPaths& paths, const StatusParagraph& p)
     {
+        Phases::Scope phase_scope(Phases::Phase::STATUS_WRITES);
         static int update_id = 0;
         auto& fs = paths.get_filesystem();
 
@@ -200,8 +208,14 @@ namespace vcpkg
     std::vector<StatusParagraphAndAssociatedFiles> get_installed_files(const VcpkgPaths& paths,
                                                                        const StatusParagraphs& status_db)
     {
-        auto& fs = paths.get_filesystem();
+        return get_installed_files(paths.get_filesystem(), paths.installed, status_db);
+    }
 
+    std::vector<StatusParagraphAndAssociatedFiles> get_installed_files(Files::Filesystem& fs,
+                                                                       const fs::path& installed,
+                                                                       const StatusParagraphs& status_db)
+    {
+        const auto info_dir = installed / "vcpkg" / "info";
         std::vector<StatusParagraphAndAssociatedFiles> installed_files;
 
         for (const std::unique_ptr<StatusParagraph>& pgh : status_db)
@@ -211,7 +225,7 @@ namespace vcpkg
                 continue;
             }
 
-            const fs::path listfile_path = paths.listfile_path(pgh->package);
+            const fs::path listfile_path = info_dir / (pgh->package.fullstem() + ".list");
             std::vector<std::string> installed_files_of_current_pgh =
                 fs.read_lines(listfile_path).value_or_exit(VCPKG_LINE_INFO);
             Strings::trim_all_and_remove_whitespace_strings(&installed_files_of_current_pgh);
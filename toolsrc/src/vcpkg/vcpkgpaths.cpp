@@ -8,6 +8,7 @@
 #include <vcpkg/commands.h>
 #include <vcpkg/metrics.h>
 #include <vcpkg/packagespec.h>
+#include <vcpkg/vcpkgcmdarguments.h>
 #include <vcpkg/vcpkgpaths.h>
 #include <vcpkg/visualstudio.h>
 
@@ -16,7 +17,7 @@ namespace vcpkg
     Expected<VcpkgPaths> VcpkgPaths::create(const fs::path& vcpkg_root_dir,
                                             const Optional<fs::path>& vcpkg_scripts_root_dir,
                                             const std::string& default_vs_path,
-                                            const std::vector<std::string>* triplets_dirs)
+                                            const VcpkgCmdArguments& args)
     {
         auto& fs = Files::get_real_filesystem();
         std::error_code ec;
@@ -27,6 +28,12 @@ namespace vcpkg
         }
 
         VcpkgPaths paths;
+        paths.original_cwd = fs::stdfs::current_path(ec);
+        if (ec)
+        {
+            return ec;
+        }
+
         paths.root = canonical_vcpkg_root_dir;
         paths.default_vs_path = default_vs_path;
 
@@ -36,8 +43,17 @@ namespace vcpkg
             Checks::exit_with_message(VCPKG_LINE_INFO, "Invalid vcpkg root directory: %s", paths.root.string());
         }
 
-        paths.packages = paths.root / "packages";
-        paths.buildtrees = paths.root / "buildtrees";
+        const auto root_or_override = [&](const std::unique_ptr<std::string>& override_dir, const char* default_dir) {
+            return override_dir ? paths.original_cwd / fs::u8path(*override_dir) : paths.root / default_dir;
+        };
+
+        paths.packages = root_or_override(args.packages_root_dir, "packages");
+        paths.buildtrees = root_or_override(args.buildtrees_root_dir, "buildtrees");
+        paths.buildtrees_per_spec = args.buildtrees_per_spec.value_or(false);
+        if (args.cache_file_status.value_or(false))
+        {
+            paths.m_file_status_cache = std::make_unique<Files::CachingFilesystem>(fs);
+        }
 
         const auto overriddenDownloadsPath = System::get_environment_variable("VCPKG_DOWNLOADS");
         if (auto odp = overriddenDownloadsPath.get())
@@ -65,7 +81,7 @@ namespace vcpkg
         }
 
         paths.ports = paths.root / "ports";
-        paths.installed = paths.root / "installed";
+        paths.installed = root_or_override(args.install_root_dir, "installed");
         paths.triplets = paths.root / "triplets";
 
         if (auto scripts_dir = vcpkg_scripts_root_dir.get())
@@ -95,14 +111,15 @@ namespace vcpkg
         paths.vcpkg_dir_status_file = paths.vcpkg_dir / "status";
         paths.vcpkg_dir_info = paths.vcpkg_dir / "info";
         paths.vcpkg_dir_updates = paths.vcpkg_dir / "updates";
+        paths.vcpkg_dir_history = paths.vcpkg_dir / "history";
 
         paths.ports_cmake = paths.scripts / "ports.cmake";
 
-        if (triplets_dirs)
+        if (auto triplets_dirs = args.overlay_triplets.get())
         {
             for (auto&& triplets_dir : *triplets_dirs)
             {
-                auto path = fs::u8path(triplets_dir);
+                auto path = paths.original_cwd / fs::u8path(triplets_dir);
                 Checks::check_exit(VCPKG_LINE_INFO,
                                    paths.get_filesystem().exists(path),
                                    "Error: Path does not exist '%s'",
@@ -117,6 +134,11 @@ namespace vcpkg
 
     fs::path VcpkgPaths::package_dir(const PackageSpec& spec) const { return this->packages / spec.dir(); }
 
+    fs::path VcpkgPaths::buildtrees_dir(const PackageSpec& spec) const
+    {
+        return this->buildtrees / (buildtrees_per_spec ? spec.dir() : spec.name());
+    }
+
     fs::path VcpkgPaths::build_info_file_path(const PackageSpec& spec) const
     {
         return this->package_dir(spec) / "BUILD_INFO";
@@ -171,13 +193,11 @@ namespace vcpkg
 
     const fs::path& VcpkgPaths::get_tool_exe(const std::string& tool) const
     {
-        if (!m_tool_cache) m_tool_cache = get_tool_cache();
-        return m_tool_cache->get_tool_path(*this, tool);
+        return m_tool_cache.get_lazy(get_tool_cache)->get_tool_path(*this, tool);
     }
     const std::string& VcpkgPaths::get_tool_version(const std::string& tool) const
     {
-        if (!m_tool_cache) m_tool_cache = get_tool_cache();
-        return m_tool_cache->get_tool_version(*this, tool);
+        return m_tool_cache.get_lazy(get_tool_cache)->get_tool_version(*this, tool);
     }
 
     const Toolset& VcpkgPaths::get_toolset(const Build::PreBuildInfo& prebuildinfo) const
@@ -251,5 +271,9 @@ namespace vcpkg
 #endif
     }
 
-    Files::Filesystem& VcpkgPaths::get_filesystem() const { return Files::get_real_filesystem(); }
+    Files::Filesystem& VcpkgPaths::get_filesystem() const
+    {
+        if (m_file_status_cache) return *m_file_status_cache;
+        return Files::get_real_filesystem();
+    }
 }